@@ -0,0 +1,441 @@
+#include "archive_index.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+
+#include "mapped_file.h"
+
+namespace {
+
+// ZIP record signatures and fixed sizes
+constexpr uint32_t ZIP_EOCD_SIGNATURE = 0x06054B50;
+constexpr uint32_t ZIP64_EOCD_LOCATOR_SIGNATURE = 0x07064B50;
+constexpr uint32_t ZIP64_EOCD_SIGNATURE = 0x06064B50;
+constexpr uint32_t ZIP_CENTRAL_HEADER_SIGNATURE = 0x02014B50;
+constexpr size_t ZIP_EOCD_SIZE = 22;
+constexpr size_t ZIP64_EOCD_LOCATOR_SIZE = 20;
+constexpr size_t ZIP64_EOCD_SIZE = 56;
+constexpr size_t ZIP_CENTRAL_HEADER_SIZE = 46;
+
+// The end-of-central-directory record may be followed by a comment of up to this many bytes
+constexpr size_t ZIP_MAX_COMMENT_SIZE = 0xFFFF;
+
+// Extra fields of a central directory header that carry what the fixed fields can't
+constexpr uint16_t ZIP64_EXTRA_ID = 0x0001;
+constexpr uint16_t EXTENDED_TIMESTAMP_EXTRA_ID = 0x5455;
+
+constexpr size_t TAR_BLOCK_SIZE = 512;
+
+// gzip header flags
+constexpr unsigned char GZIP_FEXTRA = 0x04;
+constexpr unsigned char GZIP_FNAME = 0x08;
+
+uint16_t read_le16(const unsigned char* data) { return static_cast<uint16_t>(data[0] | data[1] << 8); }
+
+uint32_t read_le32(const unsigned char* data) {
+  return static_cast<uint32_t>(data[0] | data[1] << 8 | data[2] << 16) | static_cast<uint32_t>(data[3]) << 24;
+}
+
+uint64_t read_le64(const unsigned char* data) {
+  return read_le32(data) | static_cast<uint64_t>(read_le32(data + 4)) << 32;
+}
+
+std::string get_extension(const std::string& path) {
+  std::string extension = std::filesystem::u8path(path).extension().u8string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(static_cast<int>(c))); });
+  return extension;
+}
+
+// Days from 1970-01-01 to a date of the proleptic Gregorian calendar
+int64_t days_from_civil(int64_t year, unsigned month, unsigned day) {
+  year -= month <= 2;
+  const int64_t era = (year >= 0 ? year : year - 399) / 400;
+  const unsigned year_of_era = static_cast<unsigned>(year - era * 400);
+  const unsigned day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  const unsigned day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+  return era * 146097 + static_cast<int64_t>(day_of_era) - 719468;
+}
+
+// MS-DOS dates carry no time zone, so they're read as UTC; 0 for the zeroed dates some tools write
+int64_t dos_time_to_unix(uint16_t time, uint16_t date) {
+  unsigned day = date & 0x1F;
+  unsigned month = (date >> 5) & 0x0F;
+  if (day == 0 || month == 0 || month > 12) {
+    return 0;
+  }
+  int64_t days = days_from_civil(1980 + (date >> 9), month, day);
+  return days * 86400 + (time >> 11) * 3600 + ((time >> 5) & 0x3F) * 60 + (time & 0x1F) * 2;
+}
+
+// Read the sizes and times a central directory header leaves to its extra fields
+void read_zip_extra_fields(const unsigned char* data, size_t size, bool has_zip64_size, ArchiveEntry& entry) {
+  size_t offset = 0;
+  while (size - offset >= 4) {
+    uint16_t id = read_le16(data + offset);
+    size_t length = std::min<size_t>(read_le16(data + offset + 2), size - offset - 4);
+    const unsigned char* field = data + offset + 4;
+    // The ZIP64 field holds the 64-bit values in a fixed order, the uncompressed size first
+    if (id == ZIP64_EXTRA_ID && has_zip64_size && length >= 8) {
+      entry.size = read_le64(field);
+    } else if (id == EXTENDED_TIMESTAMP_EXTRA_ID && length >= 5 && (field[0] & 0x01)) {
+      entry.last_modified = static_cast<int32_t>(read_le32(field + 1));
+    }
+    offset += 4 + length;
+  }
+}
+
+// Parse a numeric tar header field: octal digits padded with spaces or NULs, or, with the top bit of the first
+// byte set, the GNU base-256 form used for values octal can't hold. Negative values read as 0.
+uint64_t read_tar_number(const unsigned char* field, size_t length) {
+  if (field[0] & 0x80) {
+    if (field[0] & 0x40) {
+      return 0;
+    }
+    uint64_t value = field[0] & 0x3F;
+    for (size_t i = 1; i < length; i++) {
+      value = value << 8 | field[i];
+    }
+    return value;
+  }
+  size_t i = 0;
+  while (i < length && field[i] == ' ') {
+    i++;
+  }
+  uint64_t value = 0;
+  for (; i < length && field[i] >= '0' && field[i] <= '7'; i++) {
+    value = value * 8 + static_cast<uint64_t>(field[i] - '0');
+  }
+  return value;
+}
+
+// The checksum is the sum of the header bytes with the checksum field read as spaces. Some old tars summed
+// signed chars, so that sum is accepted too.
+bool is_tar_checksum_valid(const unsigned char* header) {
+  uint64_t stored = read_tar_number(header + 148, 8);
+  uint64_t unsigned_sum = 0;
+  int64_t signed_sum = 0;
+  for (size_t i = 0; i < TAR_BLOCK_SIZE; i++) {
+    unsigned char c = (i >= 148 && i < 156) ? ' ' : header[i];
+    unsigned_sum += c;
+    signed_sum += static_cast<signed char>(c);
+  }
+  return stored == unsigned_sum || static_cast<int64_t>(stored) == signed_sum;
+}
+
+// A string field, NUL-terminated unless it fills the field
+std::string read_tar_string(const unsigned char* field, size_t length) {
+  const void* end = std::memchr(field, 0, length);
+  size_t string_length = end ? static_cast<size_t>(static_cast<const unsigned char*>(end) - field) : length;
+  return std::string(reinterpret_cast<const char*>(field), string_length);
+}
+
+// What a pax extended header overrides in the header that follows it
+struct PaxOverrides {
+  std::string path;
+  uint64_t size = 0;
+  int64_t last_modified = 0;
+  bool has_size = false;
+  bool has_last_modified = false;
+};
+
+// Records are "<length> <key>=<value>\n", the length counting the whole record
+void read_pax_records(const unsigned char* data, size_t size, PaxOverrides& overrides) {
+  size_t offset = 0;
+  while (offset < size) {
+    size_t length = 0;
+    size_t cursor = offset;
+    while (cursor < size && data[cursor] >= '0' && data[cursor] <= '9') {
+      length = length * 10 + static_cast<size_t>(data[cursor] - '0');
+      cursor++;
+    }
+    if (cursor >= size || data[cursor] != ' ' || length <= cursor - offset + 1 || length > size - offset) {
+      return;
+    }
+    std::string record(reinterpret_cast<const char*>(data + cursor + 1), offset + length - cursor - 1);
+    if (!record.empty() && record.back() == '\n') {
+      record.pop_back();
+    }
+    size_t equals = record.find('=');
+    if (equals != std::string::npos) {
+      std::string key = record.substr(0, equals);
+      std::string value = record.substr(equals + 1);
+      if (key == "path") {
+        overrides.path = value;
+      } else if (key == "size") {
+        overrides.size = std::strtoull(value.c_str(), nullptr, 10);
+        overrides.has_size = true;
+      } else if (key == "mtime") {
+        // May have a fractional part, which is dropped
+        overrides.last_modified = std::strtoll(value.c_str(), nullptr, 10);
+        overrides.has_last_modified = true;
+      }
+    }
+    offset += length;
+  }
+}
+
+// Strip empty and "." components and turn backslashes, which some Windows tools write, into slashes. False for
+// paths with ".." components, which would escape the archive, and for paths left empty.
+bool normalize_entry_path(std::string& path) {
+  std::replace(path.begin(), path.end(), '\\', '/');
+  std::string normalized;
+  size_t start = 0;
+  while (start <= path.size()) {
+    size_t end = path.find('/', start);
+    if (end == std::string::npos) {
+      end = path.size();
+    }
+    std::string component = path.substr(start, end - start);
+    if (component == "..") {
+      return false;
+    }
+    if (!component.empty() && component != ".") {
+      normalized += (normalized.empty() ? "" : "/") + component;
+    }
+    start = end + 1;
+  }
+  path = std::move(normalized);
+  return !path.empty();
+}
+
+// Normalize paths, keep the last of duplicate entries, as extracting the archive would, add the directories
+// implied by the paths and sort the lot by path
+void finish_entries(std::vector<ArchiveEntry>& entries) {
+  std::map<std::string, ArchiveEntry> by_path;
+  for (auto& entry : entries) {
+    if (normalize_entry_path(entry.path)) {
+      std::string path = entry.path;
+      by_path[path] = std::move(entry);
+    }
+  }
+
+  std::vector<std::string> parents;
+  for (const auto& item : by_path) {
+    for (size_t slash = item.first.find('/'); slash != std::string::npos; slash = item.first.find('/', slash + 1)) {
+      parents.push_back(item.first.substr(0, slash));
+    }
+  }
+  for (auto& parent : parents) {
+    if (by_path.find(parent) == by_path.end()) {
+      ArchiveEntry directory;
+      directory.path = parent;
+      directory.is_directory = true;
+      by_path.emplace(std::move(parent), std::move(directory));
+    }
+  }
+
+  // Parents sort before their children, so a cut listing keeps the directories of what it keeps
+  entries.clear();
+  for (auto& item : by_path) {
+    if (entries.size() == MAX_ARCHIVE_ENTRIES) {
+      break;
+    }
+    entries.push_back(std::move(item.second));
+  }
+}
+
+}  // namespace
+
+bool has_archive_index(const std::string& extension) {
+  return extension == ".zip" || extension == ".tar" || extension == ".gz";
+}
+
+bool read_zip_entries(const unsigned char* data, size_t size, std::vector<ArchiveEntry>& entries) {
+  entries.clear();
+  if (size < ZIP_EOCD_SIZE) {
+    return false;
+  }
+
+  // Search back from the end for the record, past whatever comment follows it
+  size_t search_end = size - ZIP_EOCD_SIZE;
+  size_t search_start = search_end > ZIP_MAX_COMMENT_SIZE ? search_end - ZIP_MAX_COMMENT_SIZE : 0;
+  size_t eocd = SIZE_MAX;
+  for (size_t offset = search_end + 1; offset-- > search_start;) {
+    if (read_le32(data + offset) == ZIP_EOCD_SIGNATURE &&
+        read_le16(data + offset + 20) <= size - offset - ZIP_EOCD_SIZE) {
+      eocd = offset;
+      break;
+    }
+  }
+  if (eocd == SIZE_MAX) {
+    return false;
+  }
+
+  uint64_t entry_count = read_le16(data + eocd + 10);
+  uint64_t directory_size = read_le32(data + eocd + 12);
+  uint64_t directory_offset = read_le32(data + eocd + 16);
+  if (entry_count == 0xFFFF || directory_size == 0xFFFFFFFF || directory_offset == 0xFFFFFFFF) {
+    // Saturated fields mean a ZIP64 record holds the real values; a locator right before this one points at it
+    if (eocd < ZIP64_EOCD_LOCATOR_SIZE) {
+      return false;
+    }
+    const unsigned char* locator = data + eocd - ZIP64_EOCD_LOCATOR_SIZE;
+    uint64_t record = read_le64(locator + 8);
+    if (read_le32(locator) != ZIP64_EOCD_LOCATOR_SIGNATURE || size < ZIP64_EOCD_SIZE ||
+        record > size - ZIP64_EOCD_SIZE || read_le32(data + record) != ZIP64_EOCD_SIGNATURE) {
+      return false;
+    }
+    entry_count = read_le64(data + record + 32);
+    directory_size = read_le64(data + record + 40);
+    directory_offset = read_le64(data + record + 48);
+  }
+  if (directory_offset > size || directory_size > size - directory_offset) {
+    return false;
+  }
+
+  size_t offset = static_cast<size_t>(directory_offset);
+  size_t directory_end = offset + static_cast<size_t>(directory_size);
+  for (uint64_t i = 0; i < entry_count && entries.size() < MAX_ARCHIVE_ENTRIES; i++) {
+    if (directory_end - offset < ZIP_CENTRAL_HEADER_SIZE ||
+        read_le32(data + offset) != ZIP_CENTRAL_HEADER_SIGNATURE) {
+      return false;
+    }
+    const unsigned char* header = data + offset;
+    size_t name_length = read_le16(header + 28);
+    size_t extra_length = read_le16(header + 30);
+    size_t comment_length = read_le16(header + 32);
+    if (name_length + extra_length + comment_length > directory_end - offset - ZIP_CENTRAL_HEADER_SIZE) {
+      return false;
+    }
+
+    ArchiveEntry entry;
+    entry.path.assign(reinterpret_cast<const char*>(header + ZIP_CENTRAL_HEADER_SIZE), name_length);
+    entry.is_directory = !entry.path.empty() && (entry.path.back() == '/' || entry.path.back() == '\\');
+    entry.size = read_le32(header + 24);
+    entry.last_modified = dos_time_to_unix(read_le16(header + 12), read_le16(header + 14));
+    read_zip_extra_fields(header + ZIP_CENTRAL_HEADER_SIZE + name_length, extra_length, entry.size == 0xFFFFFFFF,
+                          entry);
+    if (entry.is_directory) {
+      entry.size = 0;
+    }
+    entries.push_back(std::move(entry));
+    offset += ZIP_CENTRAL_HEADER_SIZE + name_length + extra_length + comment_length;
+  }
+  return true;
+}
+
+bool read_tar_entries(const unsigned char* data, size_t size, std::vector<ArchiveEntry>& entries) {
+  entries.clear();
+  std::string long_name;
+  PaxOverrides pax;
+  size_t offset = 0;
+  while (size - offset >= TAR_BLOCK_SIZE && entries.size() < MAX_ARCHIVE_ENTRIES) {
+    const unsigned char* header = data + offset;
+    // Two zeroed blocks end the archive; one is enough to stop at
+    if (std::all_of(header, header + TAR_BLOCK_SIZE, [](unsigned char c) { return c == 0; })) {
+      return true;
+    }
+    if (!is_tar_checksum_valid(header)) {
+      return false;
+    }
+    offset += TAR_BLOCK_SIZE;
+
+    char type = static_cast<char>(header[156]);
+    uint64_t data_size = read_tar_number(header + 124, 12);
+    if (pax.has_size && type != 'x' && type != 'g') {
+      data_size = pax.size;
+    }
+    const unsigned char* content = data + offset;
+    size_t available = static_cast<size_t>(std::min<uint64_t>(data_size, size - offset));
+    uint64_t padded_size = (data_size + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+    bool is_truncated = padded_size > size - offset;
+    offset = is_truncated ? size : offset + static_cast<size_t>(padded_size);
+
+    // Headers that describe the next entry rather than being one
+    if (type == 'L') {
+      long_name = read_tar_string(content, available);
+      continue;
+    }
+    if (type == 'x') {
+      read_pax_records(content, available, pax);
+      continue;
+    }
+    if (type == 'g' || type == 'K') {
+      continue;
+    }
+
+    // Regular files and directories; links, devices and FIFOs aren't assets
+    if (type == '0' || type == '\0' || type == '7' || type == '5') {
+      ArchiveEntry entry;
+      if (!pax.path.empty()) {
+        entry.path = pax.path;
+      } else if (!long_name.empty()) {
+        entry.path = long_name;
+      } else {
+        std::string prefix = std::memcmp(header + 257, "ustar", 5) == 0 ? read_tar_string(header + 345, 155) : "";
+        std::string name = read_tar_string(header, 100);
+        entry.path = prefix.empty() ? name : prefix + "/" + name;
+      }
+      // Pre-POSIX tars mark directories only with a trailing slash
+      entry.is_directory = type == '5' || (!entry.path.empty() && entry.path.back() == '/');
+      entry.size = entry.is_directory ? 0 : data_size;
+      entry.last_modified =
+          pax.has_last_modified ? pax.last_modified : static_cast<int64_t>(read_tar_number(header + 136, 12));
+      entries.push_back(std::move(entry));
+    }
+    long_name.clear();
+    pax = PaxOverrides();
+  }
+  return true;
+}
+
+bool read_gzip_entries(const unsigned char* data, size_t size, const std::string& archive_name,
+                       std::vector<ArchiveEntry>& entries) {
+  entries.clear();
+  // Header, deflate method, and the CRC and size trailer
+  if (size < 18 || data[0] != 0x1F || data[1] != 0x8B || data[2] != 8) {
+    return false;
+  }
+
+  ArchiveEntry entry;
+  entry.last_modified = read_le32(data + 4);
+  entry.size = read_le32(data + size - 4);
+  unsigned char flags = data[3];
+  size_t offset = 10;
+  if (flags & GZIP_FEXTRA) {
+    offset += 2 + read_le16(data + offset);
+  }
+  if ((flags & GZIP_FNAME) && offset < size) {
+    const void* end = std::memchr(data + offset, 0, size - offset);
+    if (!end) {
+      return false;
+    }
+    entry.path.assign(reinterpret_cast<const char*>(data + offset), static_cast<const char*>(end));
+    // Only the name counts; some tools store the path the file was compressed from
+    size_t slash = entry.path.find_last_of("/\\");
+    if (slash != std::string::npos) {
+      entry.path.erase(0, slash + 1);
+    }
+  }
+  if (entry.path.empty()) {
+    std::string name = std::filesystem::u8path(archive_name).filename().u8string();
+    entry.path = get_extension(name) == ".gz" ? name.substr(0, name.size() - 3) : name;
+  }
+  entries.push_back(std::move(entry));
+  return true;
+}
+
+bool read_archive_entries(const std::string& path, MappedFile& file, std::vector<ArchiveEntry>& entries) {
+  entries.clear();
+  std::string extension = get_extension(path);
+  bool readable = false;
+  if (extension == ".zip") {
+    readable = read_zip_entries(file.data(), file.size(), entries);
+  } else if (extension == ".tar") {
+    // Only the header pages are touched, so no read-ahead advice: it would pull in the file data between them
+    readable = read_tar_entries(file.data(), file.size(), entries);
+  } else if (extension == ".gz") {
+    readable = read_gzip_entries(file.data(), file.size(), path, entries);
+  }
+  if (!readable) {
+    entries.clear();
+    return false;
+  }
+  finish_entries(entries);
+  return true;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class MappedFile;
+
+// Entries kept from one archive; a listing longer than this is cut off, so a hostile archive can't flood the index
+constexpr size_t MAX_ARCHIVE_ENTRIES = 100000;
+
+// A file or directory listed in an archive, read from its headers without extracting anything
+struct ArchiveEntry {
+  std::string path;           // Relative to the archive, '/'-separated, with no empty, "." or ".." components
+  uint64_t size = 0;          // Uncompressed size; for gzip only modulo 4 GiB, as the trailer stores it
+  int64_t last_modified = 0;  // Unix time, 0 when the archive doesn't record one
+  bool is_directory = false;
+};
+
+// Whether the contents of archives with this (lowercase) extension can be listed: .zip, .tar and .gz. 7z and
+// RAR headers are usually compressed themselves, so those stay opaque.
+bool has_archive_index(const std::string& extension);
+
+// Walk the central directory of a ZIP file, found from the end-of-central-directory record, with ZIP64 sizes
+// and offsets. Local headers and file data are never touched.
+bool read_zip_entries(const unsigned char* data, size_t size, std::vector<ArchiveEntry>& entries);
+
+// Step from header to header of a tar file, skipping over the file data. Reads ustar prefixes, GNU long names
+// and pax path and size records.
+bool read_tar_entries(const unsigned char* data, size_t size, std::vector<ArchiveEntry>& entries);
+
+// A gzip file holds one member: its name comes from the header, or is `archive_name` minus ".gz" when the
+// header has none, and its size from the trailer
+bool read_gzip_entries(const unsigned char* data, size_t size, const std::string& archive_name,
+                       std::vector<ArchiveEntry>& entries);
+
+// List the archive at `path`, mapped in `file`. Entries are sorted by path, later duplicates replace earlier
+// ones, and directories that are only implied by the paths below them are added.
+bool read_archive_entries(const std::string& path, MappedFile& file, std::vector<ArchiveEntry>& entries);
@@ -6,6 +6,23 @@
 #include <iostream>
 #include <sstream>
 
+#include "path_utils.h"
+
+// How long a statement waits for another connection's write lock before failing with SQLITE_BUSY
+constexpr int BUSY_TIMEOUT_MS = 5000;
+
+// Bind the key ranges of get_subtree_bounds(directory) to four parameters, starting at `first_index`
+void bind_subtree_bounds(sqlite3_stmt* stmt, int first_index,
+                         const std::string& directory) {
+  SubtreeBounds bounds = get_subtree_bounds(directory);
+  for (int i = 0; i < 2; i++) {
+    sqlite3_bind_text(stmt, first_index + 2 * i, bounds.lower[i].c_str(), -1,
+                      SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, first_index + 2 * i + 1, bounds.upper[i].c_str(),
+                      -1, SQLITE_TRANSIENT);
+  }
+}
+
 AssetDatabase::AssetDatabase() : db_(nullptr), is_open_(false) {}
 
 AssetDatabase::~AssetDatabase() { close(); }
@@ -17,7 +34,10 @@ bool AssetDatabase::initialize(const std::string& db_path) {
 
   // Ensure directory exists
   std::filesystem::path path(db_path);
-  std::filesystem::create_directories(path.parent_path());
+  if (path.has_parent_path()) {
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+  }
 
   int rc = sqlite3_open(db_path.c_str(), &db_);
   if (rc != SQLITE_OK) {
@@ -26,12 +46,15 @@ bool AssetDatabase::initialize(const std::string& db_path) {
   }
 
   is_open_ = true;
-  std::cout << "Database opened successfully: " << db_path << std::endl;
+  std::clog << "Database opened successfully: " << db_path << std::endl;
 
   // Enable foreign keys and WAL mode for better performance
   execute_sql("PRAGMA foreign_keys = ON");
   execute_sql("PRAGMA journal_mode = WAL");
 
+  // The app, the indexer daemon and the query tool may share the file; wait out each other's writes
+  sqlite3_busy_timeout(db_, BUSY_TIMEOUT_MS);
+
   return create_tables();
 }
 
@@ -171,6 +194,63 @@ bool AssetDatabase::delete_assets_by_directory(
   return success;
 }
 
+bool AssetDatabase::delete_assets_under_path(const std::string& directory_path) {
+  const std::string sql =
+      "DELETE FROM assets WHERE (full_path >= ?1 AND full_path < ?2) OR "
+      "(full_path >= ?3 AND full_path < ?4)";
+
+  sqlite3_stmt* stmt;
+  if (!prepare_statement(sql, &stmt)) {
+    return false;
+  }
+
+  bind_subtree_bounds(stmt, 1, directory_path);
+
+  int rc = sqlite3_step(stmt);
+  bool success = (rc == SQLITE_DONE);
+  if (!success) {
+    print_sqlite_error("deleting assets under path");
+  }
+
+  finalize_statement(stmt);
+  return success;
+}
+
+bool AssetDatabase::move_assets_under_path(
+    const std::string& old_directory, const std::string& new_directory,
+    const std::string& new_relative_directory) {
+  // Rewrite the prefix of every path below the directory in a single statement.
+  // The suffix is cut from the BLOB form so that ?3 counts bytes, not UTF-8 characters.
+  const std::string sql = R"(
+        UPDATE OR REPLACE assets SET
+        full_path = ?1 || CAST(substr(CAST(full_path AS BLOB), ?3) AS TEXT),
+        relative_path = ?2 || CAST(substr(CAST(full_path AS BLOB), ?3) AS TEXT),
+        updated_at = CURRENT_TIMESTAMP
+        WHERE (full_path >= ?4 AND full_path < ?5) OR
+              (full_path >= ?6 AND full_path < ?7)
+    )";
+
+  sqlite3_stmt* stmt;
+  if (!prepare_statement(sql, &stmt)) {
+    return false;
+  }
+
+  sqlite3_bind_text(stmt, 1, new_directory.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_text(stmt, 2, new_relative_directory.c_str(), -1,
+                    SQLITE_TRANSIENT);
+  sqlite3_bind_int(stmt, 3, static_cast<int>(old_directory.size()) + 1);
+  bind_subtree_bounds(stmt, 4, old_directory);
+
+  int rc = sqlite3_step(stmt);
+  bool success = (rc == SQLITE_DONE);
+  if (!success) {
+    print_sqlite_error("moving assets under path");
+  }
+
+  finalize_statement(stmt);
+  return success;
+}
+
 std::vector<FileInfo> AssetDatabase::get_all_assets() {
   const std::string sql = "SELECT * FROM assets ORDER BY relative_path";
   std::vector<FileInfo> assets;
@@ -24,6 +24,9 @@ public:
     bool update_asset(const FileInfo& file);
     bool delete_asset(const std::string& full_path);
     bool delete_assets_by_directory(const std::string& directory_path);
+    bool delete_assets_under_path(const std::string& directory_path);
+    bool move_assets_under_path(const std::string& old_directory, const std::string& new_directory,
+                                const std::string& new_relative_directory);
 
     // Query operations
     std::vector<FileInfo> get_all_assets();
@@ -58,3 +61,8 @@ private:
     // Error handling
     void print_sqlite_error(const std::string& operation);
 };
+
+// Bind the key ranges holding every full_path below `directory` (see get_subtree_bounds()) to the four
+// parameters of "(full_path >= ?N AND full_path < ?N+1) OR (full_path >= ?N+2 AND full_path < ?N+3)",
+// N being `first_index`. Shared with the metadata store's side tables.
+void bind_subtree_bounds(sqlite3_stmt* stmt, int first_index, const std::string& directory);
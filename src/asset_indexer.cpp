@@ -0,0 +1,387 @@
+#include "asset_indexer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <utility>
+
+#include "archive_index.h"
+#include "mapped_file.h"
+#include "metadata_store.h"
+
+std::vector<std::string> get_default_ignore_patterns() {
+  return {"**/.git/**", "**/.svn/**", "*.tmp", "~*", "*.blend1", "*.swp", ".DS_Store", "Thumbs.db"};
+}
+
+AssetIndexer::AssetIndexer(AssetDatabase& asset_database, FileWatcher& file_watcher)
+    : database(asset_database), watcher(file_watcher), archive_store(nullptr), should_stop(false) {}
+
+AssetIndexer::~AssetIndexer() { stop(); }
+
+size_t AssetIndexer::scan_root(int root_id) {
+  std::string root_path = watcher.get_root_path(root_id);
+  if (root_path.empty()) {
+    std::cerr << "Cannot scan unknown watch root " << root_id << '\n';
+    return 0;
+  }
+
+  std::vector<FileInfo> files = scan_directory(root_path);
+  remove_ignored_files(files, root_id);
+  add_archive_entries(files, root_id);
+
+  // Whatever was recorded under the root before may be stale; the scan is the truth from here on
+  database.delete_assets_under_path(root_path);
+  if (!files.empty() && !database.insert_assets_batch(files)) {
+    std::cerr << "Failed to index " << root_path << '\n';
+    return 0;
+  }
+
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  stats.scanned += files.size();
+  return files.size();
+}
+
+void AssetIndexer::set_batch_callback(IndexBatchCallback callback) { batch_callback = std::move(callback); }
+
+void AssetIndexer::set_archive_store(MetadataStore* store) { archive_store = store; }
+
+void AssetIndexer::start() {
+  if (thread.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    should_stop = false;
+  }
+  thread = std::thread(&AssetIndexer::run, this);
+}
+
+void AssetIndexer::push(const FileEvent& event) {
+  events.push(event);
+
+  // Taking the mutex orders the push before the applier's emptiness check, so the wakeup can't be lost
+  { std::lock_guard<std::mutex> lock(mutex); }
+  condition.notify_one();
+}
+
+void AssetIndexer::stop() {
+  if (!thread.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    should_stop = true;
+  }
+  condition.notify_one();
+  thread.join();
+}
+
+AssetIndexerStats AssetIndexer::get_stats() const {
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  return stats;
+}
+
+std::string AssetIndexer::get_root_path(int root_id) const {
+  std::string path = watcher.get_root_path(root_id);
+  return path.empty() ? watcher.get_watched_path() : path;
+}
+
+std::shared_ptr<const EventFilter> AssetIndexer::get_filter(int root_id) const {
+  std::shared_ptr<const EventFilter> filter = watcher.get_filter(root_id);
+  if (!filter) {
+    std::vector<int> root_ids = watcher.get_root_ids();
+    if (!root_ids.empty()) {
+      filter = watcher.get_filter(root_ids.front());
+    }
+  }
+  return filter;
+}
+
+// Path relative to the event's root, as stored by the initial scan
+std::string AssetIndexer::get_relative_path(const std::string& path, int root_id) const {
+  std::error_code ec;
+  std::filesystem::path relative = std::filesystem::relative(path, get_root_path(root_id), ec);
+  return ec ? path : relative.string();
+}
+
+// Build the database record for a path reported by the file watcher
+FileInfo AssetIndexer::make_file_info(const std::string& path, std::chrono::system_clock::time_point timestamp,
+                                      int root_id) const {
+  FileInfo file_info;
+  std::filesystem::path fs_path(path);
+  std::error_code ec;
+
+  file_info.name = fs_path.filename().string();
+  file_info.full_path = path;
+  file_info.relative_path = get_relative_path(path, root_id);
+  file_info.last_modified = timestamp;
+  file_info.is_directory = std::filesystem::is_directory(fs_path, ec);
+
+  if (file_info.is_directory) {
+    file_info.type = AssetType::Directory;
+  } else {
+    file_info.extension = fs_path.extension().string();
+    file_info.type = get_asset_type(file_info.extension);
+    uintmax_t size = std::filesystem::file_size(fs_path, ec);
+    file_info.size = ec ? 0 : size;
+  }
+  return file_info;
+}
+
+// Drop scanned entries the file watcher ignores, so scans and live updates agree
+void AssetIndexer::remove_ignored_files(std::vector<FileInfo>& files, int root_id) const {
+  std::shared_ptr<const EventFilter> filter = get_filter(root_id);
+  if (!filter) {
+    return;
+  }
+  files.erase(std::remove_if(files.begin(), files.end(),
+                             [&filter](const FileInfo& file) {
+                               return filter->excludes(file.relative_path, file.is_directory);
+                             }),
+              files.end());
+}
+
+bool AssetIndexer::is_indexed_archive(const FileInfo& file) const {
+  if (!archive_store || file.is_directory || file.type != AssetType::Archive) {
+    return false;
+  }
+  std::string extension = file.extension;
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(static_cast<int>(c))); });
+  return has_archive_index(extension);
+}
+
+// The listing of an archive, from the store while the archive is unchanged and from its headers otherwise
+bool AssetIndexer::list_archive(const std::string& path, std::vector<ArchiveEntry>& entries) {
+  entries.clear();
+  MappedFile file;
+  if (!file.open(path)) {
+    return false;
+  }
+  // Mapping only stats the file, so an unchanged archive costs no reads
+  uint64_t size = file.size();
+  int64_t last_write_time = file.get_last_write_time();
+  if (archive_store->is_archive_current(path, size, last_write_time)) {
+    return archive_store->load_archive(path, entries);
+  }
+
+  bool readable = read_archive_entries(path, file, entries);
+  archive_store->store_archive(path, size, last_write_time, readable ? &entries : nullptr);
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  stats.archives_listed++;
+  return readable;
+}
+
+// Build the records of an archive's entries, placed below the archive as if it were a directory
+void AssetIndexer::get_archive_entries(const FileInfo& archive, std::vector<FileInfo>& entries) {
+  std::vector<ArchiveEntry> listing;
+  if (!list_archive(archive.full_path, listing)) {
+    return;
+  }
+  std::filesystem::path archive_path(archive.full_path);
+  std::filesystem::path relative_archive_path(archive.relative_path);
+  for (const auto& entry : listing) {
+    std::filesystem::path entry_path = std::filesystem::u8path(entry.path).make_preferred();
+    FileInfo file_info;
+    file_info.name = entry_path.filename().string();
+    file_info.full_path = (archive_path / entry_path).string();
+    file_info.relative_path = (relative_archive_path / entry_path).string();
+    file_info.size = entry.size;
+    file_info.last_modified = entry.last_modified > 0
+                                  ? std::chrono::system_clock::from_time_t(static_cast<time_t>(entry.last_modified))
+                                  : archive.last_modified;
+    file_info.is_directory = entry.is_directory;
+    if (file_info.is_directory) {
+      file_info.type = AssetType::Directory;
+    } else {
+      file_info.extension = entry_path.extension().string();
+      file_info.type = get_asset_type(file_info.extension);
+    }
+    entries.push_back(std::move(file_info));
+  }
+}
+
+// Append the entries of the archives among `files`, minus what the root's ignore rules drop
+void AssetIndexer::add_archive_entries(std::vector<FileInfo>& files, int root_id) {
+  if (!archive_store) {
+    return;
+  }
+  std::vector<FileInfo> entries;
+  for (const auto& file : files) {
+    if (is_indexed_archive(file)) {
+      get_archive_entries(file, entries);
+    }
+  }
+  remove_ignored_files(entries, root_id);
+  files.insert(files.end(), std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+}
+
+// Replace the indexed entries of an archive that was created or changed. The entries of the old listing are
+// removed one top-level path at a time rather than with the archive's subtree: a Remove of the archive itself
+// would make the metadata store forget the listing just stored.
+void AssetIndexer::reindex_archive(const FileInfo& archive, int root_id, std::vector<AssetChange>& changes) {
+  std::vector<ArchiveEntry> old_listing;
+  archive_store->load_archive(archive.full_path, old_listing);
+  std::filesystem::path archive_path(archive.full_path);
+  for (const auto& entry : old_listing) {
+    if (entry.path.find('/') == std::string::npos) {
+      AssetChange removed;
+      removed.type = AssetChangeType::Remove;
+      removed.old_path = (archive_path / std::filesystem::u8path(entry.path)).string();
+      changes.push_back(std::move(removed));
+    }
+  }
+  database.delete_assets_under_path(archive.full_path);
+
+  std::vector<FileInfo> entries;
+  get_archive_entries(archive, entries);
+  remove_ignored_files(entries, root_id);
+  if (!entries.empty()) {
+    database.insert_assets_batch(entries);
+  }
+  for (auto& entry : entries) {
+    AssetChange inserted;
+    inserted.type = AssetChangeType::Insert;
+    inserted.asset = std::move(entry);
+    changes.push_back(std::move(inserted));
+  }
+}
+
+// Apply an event to the database, recording the changes made. Events arrive already coalesced, so directory
+// events stand for the whole subtree.
+void AssetIndexer::apply(const FileEvent& event, std::vector<AssetChange>& changes) {
+  switch (event.type) {
+    case FileEventType::Created:
+    case FileEventType::Modified: {
+      // Directories are recorded by DirectoryCreated
+      if (std::filesystem::is_regular_file(event.path)) {
+        AssetChange change;
+        change.asset = make_file_info(event.path, event.timestamp, event.root_id);
+        auto existing_asset = database.get_asset_by_path(event.path);
+        if (existing_asset.full_path.empty()) {
+          change.type = AssetChangeType::Insert;
+          database.insert_asset(change.asset);
+        } else {
+          change.type = AssetChangeType::Update;
+          database.update_asset(change.asset);
+        }
+        FileInfo asset = change.asset;
+        changes.push_back(std::move(change));
+        if (is_indexed_archive(asset)) {
+          reindex_archive(asset, event.root_id, changes);
+        }
+      }
+      break;
+    }
+    case FileEventType::DirectoryCreated: {
+      // Index the new subtree in one batch, replacing whatever was recorded under that path before. Metadata of
+      // the old subtree is dropped here, before the listings of archives in the new one are stored; the Remove
+      // below can't do it, since it reaches the metadata store only after them.
+      database.delete_assets_under_path(event.path);
+      if (archive_store) {
+        archive_store->remove(event.path);
+      }
+
+      std::vector<FileInfo> files = scan_directory(event.path);
+      std::string relative_directory = get_relative_path(event.path, event.root_id);
+      for (auto& file : files) {
+        file.relative_path = (std::filesystem::path(relative_directory) / file.relative_path).string();
+      }
+      remove_ignored_files(files, event.root_id);
+      add_archive_entries(files, event.root_id);
+      files.push_back(make_file_info(event.path, event.timestamp, event.root_id));
+
+      database.insert_assets_batch(files);
+
+      // Drops what the UI still shows of the old subtree. The Insert of the directory that follows tells the
+      // metadata extractor to leave the store alone.
+      AssetChange removed;
+      removed.type = AssetChangeType::Remove;
+      removed.old_path = event.path;
+      changes.push_back(std::move(removed));
+      for (auto& file : files) {
+        AssetChange inserted;
+        inserted.type = AssetChangeType::Insert;
+        inserted.asset = std::move(file);
+        changes.push_back(std::move(inserted));
+      }
+      break;
+    }
+    case FileEventType::Deleted:
+    case FileEventType::DirectoryDeleted: {
+      // A plain Deleted may still be a directory we never saw being created
+      database.delete_asset(event.path);
+      database.delete_assets_under_path(event.path);
+
+      AssetChange change;
+      change.type = AssetChangeType::Remove;
+      change.old_path = event.path;
+      changes.push_back(std::move(change));
+      break;
+    }
+    case FileEventType::Renamed: {
+      database.delete_asset(event.old_path);
+
+      AssetChange change;
+      change.type = AssetChangeType::Move;
+      change.old_path = event.old_path;
+      if (std::filesystem::is_directory(event.path)) {
+        // Move the whole subtree with a single prefix rewrite
+        database.move_assets_under_path(event.old_path, event.path, get_relative_path(event.path, event.root_id));
+        change.asset = make_file_info(event.path, event.timestamp, event.root_id);
+        database.insert_asset(change.asset);
+      } else if (std::filesystem::is_regular_file(event.path)) {
+        // The indexed entries of an archive follow it
+        database.move_assets_under_path(event.old_path, event.path, get_relative_path(event.path, event.root_id));
+        change.asset = make_file_info(event.path, event.timestamp, event.root_id);
+        database.insert_asset(change.asset);
+      } else {
+        // Gone again before we got to it
+        database.delete_assets_under_path(event.old_path);
+        change.type = AssetChangeType::Remove;
+      }
+      changes.push_back(std::move(change));
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+// Applier thread: drains events as they come and reports each batch once it is applied
+void AssetIndexer::run() {
+  FileEvent event(FileEventType::Modified, "");
+  std::vector<AssetChange> changes;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      condition.wait(lock, [this] { return should_stop || !events.empty(); });
+      if (should_stop && events.empty()) {
+        break;
+      }
+    }
+
+    auto batch_start = std::chrono::steady_clock::now();
+    uint64_t applied = 0;
+    changes.clear();
+    while (events.pop(event)) {
+      apply(event, changes);
+      applied++;
+    }
+    if (applied == 0) {
+      continue;
+    }
+
+    if (batch_callback) {
+      batch_callback(applied, changes);
+    }
+
+    std::lock_guard<std::mutex> lock(stats_mutex);
+    stats.events_applied += applied;
+    stats.batches++;
+    stats.apply_time +=
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - batch_start);
+  }
+}
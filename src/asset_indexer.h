@@ -0,0 +1,106 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asset_database.h"
+#include "asset_index.h"
+#include "asset_store.h"
+#include "file_watcher.h"
+#include "mpsc_queue.h"
+
+struct ArchiveEntry;
+class MetadataStore;
+
+struct AssetIndexerStats {
+  uint64_t scanned = 0;          // Entries written by scan_root()
+  uint64_t events_applied = 0;   // Watcher events applied to the database
+  uint64_t batches = 0;          // Batches those events were applied in
+  uint64_t archives_listed = 0;  // Archives whose headers were read, rather than their listing taken from the store
+  std::chrono::microseconds apply_time{0};
+};
+
+// Editor backups, temp files and VCS metadata that never become assets
+std::vector<std::string> get_default_ignore_patterns();
+
+// Called on the applier thread after each batch of events has been applied, with the changes the batch made to
+// the asset table, in order. The callback may move the changes out.
+using IndexBatchCallback = std::function<void(uint64_t applied, std::vector<AssetChange>& changes)>;
+
+// Keeps the asset table current for the roots of a file watcher: scan_root() indexes a root in full, and the
+// watcher's events, handed over with push(), are applied on a thread of its own. Events are drained in batches
+// and the batch callback runs once per batch with the changes written, so an event storm costs one refresh per
+// batch rather than one per event, and a refresh only touches what changed. Has no GUI dependencies; the desktop
+// app and the headless daemon both build on it.
+//
+// The database and watcher must outlive the indexer. The database is written from the applier thread once
+// start() has been called, and must not be written from anywhere else until stop().
+class AssetIndexer {
+ public:
+  AssetIndexer(AssetDatabase& asset_database, FileWatcher& file_watcher);
+  ~AssetIndexer();
+
+  AssetIndexer(const AssetIndexer&) = delete;
+  AssetIndexer& operator=(const AssetIndexer&) = delete;
+
+  // Scan a root added to the watcher and replace whatever the database held below it, minus what the root's
+  // ignore rules drop. Call before start(). Returns the number of files and directories indexed.
+  size_t scan_root(int root_id);
+
+  void set_batch_callback(IndexBatchCallback callback);
+
+  // List the ZIP, tar and gzip archives found and index their entries as assets below them, so search finds
+  // what they hold without extracting anything. Listings are kept in `store` and only read again once the
+  // archive's size or modification time changes. Without a store, the default, archives stay opaque. The store
+  // must outlive the indexer; call before scan_root().
+  void set_archive_store(MetadataStore* store);
+
+  // Start applying events, including the ones pushed so far
+  void start();
+
+  // Queue a watcher event. Safe to call from any thread, e.g. straight from the watcher's callback.
+  void push(const FileEvent& event);
+
+  // Apply what is still queued, then stop the applier thread
+  void stop();
+
+  AssetIndexerStats get_stats() const;
+
+ private:
+  AssetDatabase& database;
+  FileWatcher& watcher;
+  IndexBatchCallback batch_callback;
+  MetadataStore* archive_store;
+  MpscQueue<FileEvent> events;
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool should_stop;
+  std::thread thread;
+  mutable std::mutex stats_mutex;
+  AssetIndexerStats stats;
+
+  // Root path and filter of the root an event belongs to. Events replayed from a trace may carry ids the
+  // watcher doesn't know, so those fall back to the first root.
+  std::string get_root_path(int root_id) const;
+  std::shared_ptr<const EventFilter> get_filter(int root_id) const;
+
+  std::string get_relative_path(const std::string& path, int root_id) const;
+  FileInfo make_file_info(const std::string& path, std::chrono::system_clock::time_point timestamp,
+                          int root_id) const;
+  void remove_ignored_files(std::vector<FileInfo>& files, int root_id) const;
+
+  bool is_indexed_archive(const FileInfo& file) const;
+  bool list_archive(const std::string& path, std::vector<ArchiveEntry>& entries);
+  void get_archive_entries(const FileInfo& archive, std::vector<FileInfo>& entries);
+  void add_archive_entries(std::vector<FileInfo>& files, int root_id);
+  void reindex_archive(const FileInfo& archive, int root_id, std::vector<AssetChange>& changes);
+
+  void apply(const FileEvent& event, std::vector<AssetChange>& changes);
+  void run();
+};
@@ -0,0 +1,285 @@
+// Command line queries against the asset database kept by the app or the indexer daemon. Results go to stdout,
+// one per line, and everything else to stderr, so the output can be piped.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "asset_database.h"
+#include "asset_index.h"
+#include "metadata_store.h"
+#include "search_filter.h"
+
+// Files of the same size are first told apart by a hash of this many leading bytes, so only files that are
+// likely copies are read in full
+constexpr size_t DUPLICATE_PREFIX_BYTES = 4096;
+
+constexpr size_t HASH_BUFFER_BYTES = 64 * 1024;
+
+const char* const USAGE =
+    "Usage: AssetQuery [--db FILE] COMMAND\n"
+    "  find [--fuzzy] [--limit N] TERM...  Paths matching every term, like the app's search box\n"
+    "  stats                               Asset counts and sizes by type\n"
+    "  dupes [--min-size BYTES]            Files with identical contents\n"
+    "  models [--min-triangles N] [--max-triangles N] [--min-vertices N] [--texture TERM] [--limit N]\n"
+    "                                      Models by extracted geometry, most triangles first\n";
+
+std::string format_size(uint64_t bytes) {
+  const char* units[] = {"B", "KB", "MB", "GB", "TB"};
+  double size = static_cast<double>(bytes);
+  int unit = 0;
+  while (size >= 1024.0 && unit < 4) {
+    size /= 1024.0;
+    unit++;
+  }
+  std::ostringstream out;
+  out << std::fixed << std::setprecision(unit == 0 ? 0 : 1) << size << ' ' << units[unit];
+  return out.str();
+}
+
+// 64-bit FNV-1a of the first `max_bytes` of a file. False if it can't be read.
+bool hash_file(const std::string& path, uint64_t max_bytes, uint64_t& hash) {
+  std::ifstream file(std::filesystem::u8path(path), std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  hash = 14695981039346656037ull;
+  std::vector<char> buffer(HASH_BUFFER_BYTES);
+  uint64_t remaining = max_bytes;
+  while (remaining > 0 && file) {
+    file.read(buffer.data(), static_cast<std::streamsize>(std::min<uint64_t>(buffer.size(), remaining)));
+    std::streamsize count = file.gcount();
+    for (std::streamsize i = 0; i < count; i++) {
+      hash = (hash ^ static_cast<unsigned char>(buffer[i])) * 1099511628211ull;
+    }
+    remaining -= static_cast<uint64_t>(count);
+    if (count == 0) {
+      break;
+    }
+  }
+  return !file.bad();
+}
+
+// Split files that share a size into groups that also share a hash of their first `max_bytes`. Files that
+// can't be read, and groups of one, are dropped.
+std::vector<std::vector<const FileInfo*>> split_by_hash(const std::vector<const FileInfo*>& files,
+                                                        uint64_t max_bytes) {
+  std::map<uint64_t, std::vector<const FileInfo*>> by_hash;
+  for (const FileInfo* file : files) {
+    uint64_t hash = 0;
+    if (hash_file(file->full_path, max_bytes, hash)) {
+      by_hash[hash].push_back(file);
+    } else {
+      std::cerr << "Could not read " << file->full_path << '\n';
+    }
+  }
+  std::vector<std::vector<const FileInfo*>> groups;
+  for (auto& entry : by_hash) {
+    if (entry.second.size() > 1) {
+      groups.push_back(std::move(entry.second));
+    }
+  }
+  return groups;
+}
+
+int run_find(AssetDatabase& database, const std::vector<std::string>& args) {
+  bool fuzzy = false;
+  size_t limit = 0;
+  std::string query;
+  for (size_t i = 0; i < args.size(); i++) {
+    if (args[i] == "--fuzzy") {
+      fuzzy = true;
+    } else if (args[i] == "--limit" && i + 1 < args.size() && std::atoll(args[i + 1].c_str()) > 0) {
+      limit = static_cast<size_t>(std::atoll(args[++i].c_str()));
+    } else {
+      query += (query.empty() ? "" : " ") + args[i];
+    }
+  }
+  if (query.empty()) {
+    std::cerr << USAGE;
+    return 1;
+  }
+
+  std::vector<FileInfo> assets = database.get_all_assets();
+  SearchFilter filter;
+  filter.set_mode(fuzzy ? SearchMode::Fuzzy : SearchMode::Substring);
+  filter.set_result_limit(limit);
+  filter.set_assets(assets);
+  filter.update(query);
+
+  const std::vector<size_t>& results = filter.get_results();
+  size_t shown = limit > 0 ? std::min(limit, results.size()) : results.size();
+  for (size_t i = 0; i < shown; i++) {
+    std::cout << assets[results[i]].full_path << '\n';
+  }
+  std::cerr << filter.get_match_count() << " match(es) among " << assets.size() << " asset(s)";
+  if (shown < filter.get_match_count()) {
+    std::cerr << ", showing " << shown;
+  }
+  std::cerr << '\n';
+  return 0;
+}
+
+int run_stats(AssetDatabase& database) {
+  const AssetType types[] = {AssetType::Texture, AssetType::Model,    AssetType::Sound,
+                             AssetType::Font,    AssetType::Shader,   AssetType::Document,
+                             AssetType::Archive, AssetType::Unknown, AssetType::Directory};
+  std::cout << "Assets: " << database.get_total_asset_count() << " (" << format_size(database.get_total_size())
+            << ")\n";
+  for (AssetType type : types) {
+    int count = database.get_asset_count_by_type(type);
+    if (count == 0) {
+      continue;
+    }
+    std::cout << "  " << std::left << std::setw(12) << get_asset_type_string(type) << std::right << std::setw(10)
+              << count;
+    if (type != AssetType::Directory) {
+      std::cout << std::setw(12) << format_size(database.get_size_by_type(type));
+    }
+    std::cout << '\n';
+  }
+  return 0;
+}
+
+int run_dupes(AssetDatabase& database, const std::vector<std::string>& args) {
+  uint64_t min_size = 1;
+  for (size_t i = 0; i < args.size(); i++) {
+    if (args[i] == "--min-size" && i + 1 < args.size() && std::atoll(args[i + 1].c_str()) >= 0) {
+      min_size = static_cast<uint64_t>(std::atoll(args[++i].c_str()));
+    } else {
+      std::cerr << USAGE;
+      return 1;
+    }
+  }
+
+  std::vector<FileInfo> assets = database.get_all_assets();
+  std::vector<const FileInfo*> files;
+  for (const auto& asset : assets) {
+    if (!asset.is_directory && asset.size >= std::max<uint64_t>(min_size, 1)) {
+      files.push_back(&asset);
+    }
+  }
+  std::sort(files.begin(), files.end(), [](const FileInfo* a, const FileInfo* b) {
+    return a->size != b->size ? a->size > b->size : a->full_path < b->full_path;
+  });
+
+  // Only files of equal size can be copies; of those, hash a prefix first and the whole file only if it matches
+  size_t group_count = 0;
+  uint64_t wasted_bytes = 0;
+  for (size_t begin = 0; begin < files.size();) {
+    size_t end = begin + 1;
+    while (end < files.size() && files[end]->size == files[begin]->size) {
+      end++;
+    }
+    if (end - begin > 1) {
+      std::vector<const FileInfo*> same_size(files.begin() + begin, files.begin() + end);
+      uint64_t size = files[begin]->size;
+      for (const auto& candidates : split_by_hash(same_size, DUPLICATE_PREFIX_BYTES)) {
+        auto groups = size <= DUPLICATE_PREFIX_BYTES ? std::vector<std::vector<const FileInfo*>>{candidates}
+                                                     : split_by_hash(candidates, size);
+        for (const auto& group : groups) {
+          std::cout << group.size() << " copies of " << format_size(size) << ":\n";
+          for (const FileInfo* file : group) {
+            std::cout << "  " << file->full_path << '\n';
+          }
+          group_count++;
+          wasted_bytes += size * (group.size() - 1);
+        }
+      }
+    }
+    begin = end;
+  }
+  std::cerr << group_count << " duplicate group(s), " << format_size(wasted_bytes) << " in redundant copies\n";
+  return 0;
+}
+
+int run_models(const std::string& database_path, const std::vector<std::string>& args) {
+  ModelQuery query;
+  for (size_t i = 0; i < args.size(); i++) {
+    bool has_count = i + 1 < args.size() && std::atoll(args[i + 1].c_str()) > 0;
+    if (args[i] == "--min-triangles" && has_count) {
+      query.min_triangles = static_cast<uint64_t>(std::atoll(args[++i].c_str()));
+    } else if (args[i] == "--max-triangles" && has_count) {
+      query.max_triangles = static_cast<uint64_t>(std::atoll(args[++i].c_str()));
+    } else if (args[i] == "--min-vertices" && has_count) {
+      query.min_vertices = static_cast<uint64_t>(std::atoll(args[++i].c_str()));
+    } else if (args[i] == "--limit" && has_count) {
+      query.limit = static_cast<size_t>(std::atoll(args[++i].c_str()));
+    } else if (args[i] == "--texture" && i + 1 < args.size()) {
+      query.texture = args[++i];
+    } else {
+      std::cerr << USAGE;
+      return 1;
+    }
+  }
+
+  MetadataStore store;
+  if (!store.initialize(database_path)) {
+    std::cerr << "Failed to open metadata store: " << database_path << '\n';
+    return 1;
+  }
+  std::vector<ModelRecord> models = store.find_models(query);
+  for (const auto& model : models) {
+    const ModelMetadata& metadata = model.metadata;
+    std::cout << model.full_path << '\t' << metadata.triangle_count << " tris\t" << metadata.vertex_count
+              << " verts\t" << metadata.material_count << " materials";
+    if (metadata.has_bounds) {
+      std::cout << "\t" << metadata.bounds_max[0] - metadata.bounds_min[0] << " x "
+                << metadata.bounds_max[1] - metadata.bounds_min[1] << " x "
+                << metadata.bounds_max[2] - metadata.bounds_min[2];
+    }
+    std::cout << '\n';
+  }
+  std::cerr << models.size() << " model(s)\n";
+  return 0;
+}
+
+int main(int argc, char* argv[]) {
+  std::string database_path = "db/assets.db";
+  int i = 1;
+  while (i < argc && std::string(argv[i]) == "--db" && i + 1 < argc) {
+    database_path = argv[i + 1];
+    i += 2;
+  }
+  if (i >= argc) {
+    std::cerr << USAGE;
+    return 1;
+  }
+  std::string command = argv[i];
+  std::vector<std::string> args(argv + i + 1, argv + argc);
+
+  // Opening creates a missing database, which would only ever answer with nothing
+  std::error_code ec;
+  if (!std::filesystem::exists(database_path, ec)) {
+    std::cerr << "No database at " << database_path << "; run the app or AssetIndexerDaemon first\n";
+    return 1;
+  }
+  AssetDatabase database;
+  if (!database.initialize(database_path)) {
+    std::cerr << "Failed to open database: " << database_path << '\n';
+    return 1;
+  }
+
+  if (command == "find") {
+    return run_find(database, args);
+  }
+  if (command == "stats") {
+    return run_stats(database);
+  }
+  if (command == "dupes") {
+    return run_dupes(database, args);
+  }
+  if (command == "models") {
+    return run_models(database_path, args);
+  }
+  std::cerr << "Unknown command: " << command << '\n' << USAGE;
+  return 1;
+}
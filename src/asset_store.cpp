@@ -0,0 +1,234 @@
+#include "asset_store.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "path_utils.h"
+
+namespace {
+
+// The list's order: by relative path, then by full path for assets from different roots
+bool is_before(const FileInfo& a, const FileInfo& b) {
+  int comparison = a.relative_path.compare(b.relative_path);
+  return comparison < 0 || (comparison == 0 && a.full_path < b.full_path);
+}
+
+bool starts_with(const std::string& text, const std::string& prefix) {
+  return text.size() >= prefix.size() && text.compare(0, prefix.size(), prefix) == 0;
+}
+
+}  // namespace
+
+AssetStore::AssetStore() : updated_in_place(0) {}
+
+void AssetStore::set_assets(std::vector<FileInfo> new_assets) {
+  assets = std::move(new_assets);
+  std::sort(assets.begin(), assets.end(), is_before);
+
+  slot_at.resize(assets.size());
+  position_of.resize(assets.size());
+  free_slots.clear();
+  slots_by_path.clear();
+  slots_by_path.reserve(assets.size());
+  for (size_t position = 0; position < assets.size(); position++) {
+    slot_at[position] = static_cast<uint32_t>(position);
+    position_of[position] = static_cast<uint32_t>(position);
+    slots_by_path.emplace(assets[position].full_path, static_cast<uint32_t>(position));
+  }
+}
+
+AssetListEdit AssetStore::apply(const std::vector<AssetChange>& changes) {
+  auto start = std::chrono::steady_clock::now();
+  removed_positions.clear();
+  pending.clear();
+  updated_in_place = 0;
+
+  std::vector<FileInfo> moved;
+  for (const AssetChange& change : changes) {
+    switch (change.type) {
+      case AssetChangeType::Insert:
+      case AssetChangeType::Update:
+        put(change.asset);
+        break;
+      case AssetChangeType::Remove:
+        remove_tree(change.old_path, nullptr);
+        break;
+      case AssetChangeType::Move: {
+        // Everything below the old path keeps its place relative to the moved asset
+        moved.clear();
+        remove_tree(change.old_path, &moved);
+        put(change.asset);
+        for (FileInfo& asset : moved) {
+          std::string rest = asset.full_path.substr(change.old_path.size());
+          asset.full_path = change.asset.full_path + rest;
+          asset.relative_path = change.asset.relative_path + rest;
+          put(asset);
+        }
+        break;
+      }
+    }
+  }
+
+  AssetListEdit edit;
+  edit.updated = updated_in_place;
+  if (!removed_positions.empty() || !pending.empty()) {
+    merge(edit);
+  }
+
+  stats.batches++;
+  stats.changes += changes.size();
+  stats.updated += edit.updated;
+  stats.inserted += edit.inserted.size();
+  stats.removed += edit.removed.size();
+  stats.apply_time +=
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  return edit;
+}
+
+const std::vector<FileInfo>& AssetStore::get_assets() const { return assets; }
+
+size_t AssetStore::find(const std::string& full_path) const {
+  auto slot = slots_by_path.find(full_path);
+  return slot == slots_by_path.end() ? npos : position_of[slot->second];
+}
+
+AssetStoreStats AssetStore::get_stats() const { return stats; }
+
+// Store a record: in place if its position doesn't change, otherwise it is merged in at the end of the batch
+void AssetStore::put(const FileInfo& asset) {
+  auto pending_asset = pending.find(asset.full_path);
+  if (pending_asset != pending.end()) {
+    pending_asset->second = asset;
+    return;
+  }
+
+  auto slot = slots_by_path.find(asset.full_path);
+  if (slot != slots_by_path.end()) {
+    size_t position = position_of[slot->second];
+    if (assets[position].relative_path == asset.relative_path) {
+      assets[position] = asset;
+      updated_in_place++;
+      return;
+    }
+    remove_position(position);
+  }
+  pending.emplace(asset.full_path, asset);
+}
+
+// Drop the asset at a position when the batch is merged. It can no longer be found by path from here on.
+void AssetStore::remove_position(size_t position) {
+  slots_by_path.erase(assets[position].full_path);
+  removed_positions.push_back(position);
+}
+
+// Remove the asset at `path` and everything below it, handing what was below to `moved` if it isn't null
+void AssetStore::remove_tree(const std::string& path, std::vector<FileInfo>* moved) {
+  for (auto it = pending.begin(); it != pending.end();) {
+    if (it->first == path || is_path_under(it->first, path)) {
+      if (moved && it->first != path) {
+        moved->push_back(std::move(it->second));
+      }
+      it = pending.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // Everything below a directory in the list sorts right after its relative path and a separator, so the
+  // subtree is one range per separator. Without the directory's own record, look through the whole list.
+  std::vector<size_t> below;
+  auto self = slots_by_path.find(path);
+  size_t self_position = self == slots_by_path.end() ? npos : position_of[self->second];
+  if (self_position != npos && !assets[self_position].relative_path.empty()) {
+    for (size_t i = 0; i < PATH_SEPARATOR_COUNT; i++) {
+      std::string relative_prefix = assets[self_position].relative_path + PATH_SEPARATORS[i];
+      auto first = std::lower_bound(assets.begin(), assets.end(), relative_prefix,
+                                    [](const FileInfo& asset, const std::string& bound) {
+                                      return asset.relative_path < bound;
+                                    });
+      for (auto it = first; it != assets.end() && starts_with(it->relative_path, relative_prefix); ++it) {
+        if (is_path_under(it->full_path, path)) {
+          below.push_back(static_cast<size_t>(it - assets.begin()));
+        }
+      }
+    }
+  } else {
+    for (size_t position = 0; position < assets.size(); position++) {
+      if (is_path_under(assets[position].full_path, path)) {
+        below.push_back(position);
+      }
+    }
+  }
+
+  for (size_t position : below) {
+    // Skip what this batch already removed
+    if (slots_by_path.count(assets[position].full_path) == 0) {
+      continue;
+    }
+    if (moved) {
+      moved->push_back(assets[position]);
+    }
+    remove_position(position);
+  }
+  if (self_position != npos) {
+    remove_position(self_position);
+  }
+}
+
+// Walk the list once, dropping the removed positions and merging the pending records in at their place
+void AssetStore::merge(AssetListEdit& edit) {
+  std::sort(removed_positions.begin(), removed_positions.end());
+
+  std::vector<FileInfo> inserts;
+  inserts.reserve(pending.size());
+  for (auto& entry : pending) {
+    inserts.push_back(std::move(entry.second));
+  }
+  pending.clear();
+  std::sort(inserts.begin(), inserts.end(), is_before);
+
+  size_t merged_size = assets.size() - removed_positions.size() + inserts.size();
+  std::vector<FileInfo> merged;
+  merged.reserve(merged_size);
+  std::vector<uint32_t> merged_slots;
+  merged_slots.reserve(merged_size);
+  edit.inserted.reserve(inserts.size());
+
+  size_t next_insert = 0;
+  auto insert_before = [&](const FileInfo* bound) {
+    for (; next_insert < inserts.size() && (!bound || is_before(inserts[next_insert], *bound)); next_insert++) {
+      uint32_t slot;
+      if (!free_slots.empty()) {
+        slot = free_slots.back();
+        free_slots.pop_back();
+      } else {
+        slot = static_cast<uint32_t>(position_of.size());
+        position_of.push_back(0);
+      }
+      slots_by_path[inserts[next_insert].full_path] = slot;
+      position_of[slot] = static_cast<uint32_t>(merged.size());
+      edit.inserted.push_back(merged.size());
+      merged_slots.push_back(slot);
+      merged.push_back(std::move(inserts[next_insert]));
+    }
+  };
+
+  size_t next_removed = 0;
+  for (size_t position = 0; position < assets.size(); position++) {
+    if (next_removed < removed_positions.size() && removed_positions[next_removed] == position) {
+      free_slots.push_back(slot_at[position]);
+      next_removed++;
+      continue;
+    }
+    insert_before(&assets[position]);
+    position_of[slot_at[position]] = static_cast<uint32_t>(merged.size());
+    merged_slots.push_back(slot_at[position]);
+    merged.push_back(std::move(assets[position]));
+  }
+  insert_before(nullptr);
+
+  assets.swap(merged);
+  slot_at.swap(merged_slots);
+  edit.removed.swap(removed_positions);
+  removed_positions.clear();
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "asset_index.h"
+
+enum class AssetChangeType {
+  Insert,  // A new asset; replaces one already at its path
+  Update,  // New metadata for an asset, e.g. after a save
+  Remove,  // The asset at old_path and everything below it are gone
+  Move     // The asset at old_path, and everything below it, now lives at asset.full_path
+};
+
+// One change to the asset table, as applied to the database by the indexer
+struct AssetChange {
+  AssetChangeType type = AssetChangeType::Update;
+  FileInfo asset;        // The record as stored; unused for Remove
+  std::string old_path;  // Full path, for Remove and Move
+};
+
+// How apply() changed the list, so indices over it can follow without rereading it
+struct AssetListEdit {
+  std::vector<size_t> removed;   // Positions in the old list, ascending
+  std::vector<size_t> inserted;  // Positions in the new list, ascending
+  size_t updated = 0;            // Assets replaced in place, at the same position
+};
+
+struct AssetStoreStats {
+  uint64_t batches = 0;
+  uint64_t changes = 0;
+  uint64_t updated = 0;  // Applied in place
+  uint64_t inserted = 0;
+  uint64_t removed = 0;
+  std::chrono::microseconds apply_time{0};
+};
+
+// The in-memory asset list the UI shows, sorted by relative path and then full path, kept current by applying
+// the indexer's changes rather than reloading the table. A hash map finds an asset's position by full path, so
+// an update, like a file being saved, is replaced in place without touching anything else. Inserts, removals
+// and moves in a batch are collected first and merged into the list in one pass, so a burst of them costs a
+// single walk over the list.
+//
+// Not thread safe: it belongs to the UI thread.
+class AssetStore {
+ public:
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  AssetStore();
+
+  // Replace the list, e.g. with the database's after the initial scan
+  void set_assets(std::vector<FileInfo> new_assets);
+
+  // Apply a batch of changes in order. The edit says which positions went away and which are new; positions
+  // that only moved along aren't listed.
+  AssetListEdit apply(const std::vector<AssetChange>& changes);
+
+  const std::vector<FileInfo>& get_assets() const;
+
+  // Position of the asset with this full path, or npos
+  size_t find(const std::string& full_path) const;
+
+  AssetStoreStats get_stats() const;
+
+ private:
+  std::vector<FileInfo> assets;
+  std::vector<uint32_t> slot_at;      // Slot of the asset at each position
+  std::vector<uint32_t> position_of;  // Position of the asset in each slot
+  std::vector<uint32_t> free_slots;
+  std::unordered_map<std::string, uint32_t> slots_by_path;  // Full path to slot, which outlives position shifts
+  AssetStoreStats stats;
+
+  // The batch being applied: positions dropped from the list, and records to merge in, by full path
+  std::vector<size_t> removed_positions;
+  std::unordered_map<std::string, FileInfo> pending;
+  size_t updated_in_place;
+
+  void put(const FileInfo& asset);
+  void remove_position(size_t position);
+  void remove_tree(const std::string& path, std::vector<FileInfo>* moved);
+  void merge(AssetListEdit& edit);
+};
@@ -0,0 +1,450 @@
+#include "audio_metadata.h"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#include "mapped_file.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIO_METADATA_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define AUDIO_METADATA_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// WAV format tags
+constexpr uint16_t WAVE_FORMAT_PCM = 1;
+constexpr uint16_t WAVE_FORMAT_IEEE_FLOAT = 3;
+constexpr uint16_t WAVE_FORMAT_EXTENSIBLE = 0xFFFE;
+
+// Ogg pages are at most this long, so the last one starts within this many bytes of the end
+constexpr size_t MAX_OGG_PAGE_SIZE = 27 + 255 + 255 * 255;
+
+// Opus streams always decode at 48 kHz, whatever rate the encoder was fed
+constexpr uint32_t OPUS_SAMPLE_RATE = 48000;
+
+// How far past any ID3v2 tag to look for the first MPEG audio frame, to skip junk some encoders leave there
+constexpr size_t MP3_SYNC_SEARCH_BYTES = 64 * 1024;
+
+// Samples converted to 16 bits at a time for formats the min/max kernel can't read directly
+constexpr size_t CONVERT_BLOCK_SAMPLES = 4096;
+
+uint16_t read_le16(const unsigned char* data) { return static_cast<uint16_t>(data[0] | data[1] << 8); }
+
+uint32_t read_le32(const unsigned char* data) {
+  return static_cast<uint32_t>(data[0] | data[1] << 8 | data[2] << 16) | static_cast<uint32_t>(data[3]) << 24;
+}
+
+uint64_t read_le64(const unsigned char* data) {
+  return read_le32(data) | static_cast<uint64_t>(read_le32(data + 4)) << 32;
+}
+
+uint32_t read_be32(const unsigned char* data) {
+  return static_cast<uint32_t>(data[0]) << 24 | static_cast<uint32_t>(data[1] << 16 | data[2] << 8 | data[3]);
+}
+
+// Size of the ID3v2 tag at the start of the file, 0 if there is none
+size_t get_id3v2_size(const unsigned char* data, size_t size) {
+  if (size < 10 || std::memcmp(data, "ID3", 3) != 0) {
+    return 0;
+  }
+  // The size is syncsafe, 7 bits per byte, and leaves out the header and the optional footer
+  size_t tag_size = static_cast<size_t>(data[6] & 0x7F) << 21 | static_cast<size_t>(data[7] & 0x7F) << 14 |
+                    static_cast<size_t>(data[8] & 0x7F) << 7 | static_cast<size_t>(data[9] & 0x7F);
+  return std::min(size, 10 + tag_size + ((data[5] & 0x10) ? 10 : 0));
+}
+
+// The 34 bytes of a FLAC STREAMINFO block, as found in native FLAC and in Ogg FLAC
+bool read_streaminfo(const unsigned char* info, AudioMetadata& metadata) {
+  metadata.codec = "FLAC";
+  metadata.sample_rate = static_cast<uint32_t>(info[10]) << 12 | static_cast<uint32_t>(info[11]) << 4 | info[12] >> 4;
+  metadata.channel_count = ((info[12] >> 1) & 0x7) + 1u;
+  metadata.bits_per_sample = (static_cast<uint32_t>(info[12] & 1) << 4 | info[13] >> 4) + 1u;
+  metadata.frame_count = static_cast<uint64_t>(info[13] & 0xF) << 32 | read_be32(info + 14);
+  return metadata.sample_rate > 0;
+}
+
+// Smallest and largest of `count` little-endian 16-bit samples, folded into `low` and `high`
+void accumulate_min_max(const unsigned char* samples, size_t count, int& low, int& high) {
+  size_t i = 0;
+#if defined(AUDIO_METADATA_SSE2)
+  if (count >= 8) {
+    __m128i lows = _mm_set1_epi16(SHRT_MAX);
+    __m128i highs = _mm_set1_epi16(SHRT_MIN);
+    for (; i + 8 <= count; i += 8) {
+      __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i * 2));
+      lows = _mm_min_epi16(lows, values);
+      highs = _mm_max_epi16(highs, values);
+    }
+    alignas(16) int16_t lanes[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes), lows);
+    _mm_store_si128(reinterpret_cast<__m128i*>(lanes + 8), highs);
+    for (int lane = 0; lane < 8; lane++) {
+      low = std::min<int>(low, lanes[lane]);
+      high = std::max<int>(high, lanes[lane + 8]);
+    }
+  }
+#elif defined(AUDIO_METADATA_NEON)
+  if (count >= 8) {
+    int16x8_t lows = vdupq_n_s16(SHRT_MAX);
+    int16x8_t highs = vdupq_n_s16(SHRT_MIN);
+    for (; i + 8 <= count; i += 8) {
+      int16x8_t values = vreinterpretq_s16_u8(vld1q_u8(samples + i * 2));
+      lows = vminq_s16(lows, values);
+      highs = vmaxq_s16(highs, values);
+    }
+    int16_t lanes[16];
+    vst1q_s16(lanes, lows);
+    vst1q_s16(lanes + 8, highs);
+    for (int lane = 0; lane < 8; lane++) {
+      low = std::min<int>(low, lanes[lane]);
+      high = std::max<int>(high, lanes[lane + 8]);
+    }
+  }
+#endif
+  for (; i < count; i++) {
+    int value = static_cast<int16_t>(read_le16(samples + i * 2));
+    low = std::min(low, value);
+    high = std::max(high, value);
+  }
+}
+
+// Convert `count` samples to little-endian 16-bit ones, keeping the most significant bits
+void convert_to_16_bit(const PcmSamples& format, const unsigned char* samples, size_t count, unsigned char* out) {
+  size_t bytes_per_sample = format.bits_per_sample / 8;
+  for (size_t i = 0; i < count; i++) {
+    const unsigned char* sample = samples + i * bytes_per_sample;
+    int value = 0;
+    if (format.is_float) {
+      float real;
+      uint32_t bits = read_le32(sample);
+      std::memcpy(&real, &bits, sizeof(real));
+      // Clipped samples beyond +-1 are clamped, and NaN fails every comparison and stays zero
+      if (real >= 1.0f) {
+        value = SHRT_MAX;
+      } else if (real <= -1.0f) {
+        value = -SHRT_MAX;
+      } else if (real == real) {
+        value = static_cast<int>(real * SHRT_MAX);
+      }
+    } else if (bytes_per_sample == 1) {
+      value = (sample[0] - 128) * 256;
+    } else {
+      value = static_cast<int16_t>(read_le16(sample + bytes_per_sample - 2));
+    }
+    out[i * 2] = static_cast<unsigned char>(value & 0xFF);
+    out[i * 2 + 1] = static_cast<unsigned char>((value >> 8) & 0xFF);
+  }
+}
+
+// An MPEG audio frame header
+struct MpegFrame {
+  int version = 0;  // 1, 2, or 25 for MPEG 2.5
+  int layer = 0;
+  uint32_t bit_rate = 0;
+  uint32_t sample_rate = 0;
+  uint32_t channel_count = 0;
+  uint32_t samples_per_frame = 0;
+  size_t length = 0;
+};
+
+bool read_mpeg_frame(const unsigned char* header, MpegFrame& frame) {
+  static const uint16_t BIT_RATES[5][15] = {
+      {0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448},  // MPEG 1 layer I
+      {0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384},     // MPEG 1 layer II
+      {0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320},      // MPEG 1 layer III
+      {0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256},     // MPEG 2 and 2.5 layer I
+      {0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160},          // MPEG 2 and 2.5 layers II, III
+  };
+  static const uint32_t SAMPLE_RATES[3] = {44100, 48000, 32000};
+
+  if (header[0] != 0xFF || (header[1] & 0xE0) != 0xE0) {
+    return false;
+  }
+  int version_bits = (header[1] >> 3) & 0x3;
+  int layer_bits = (header[1] >> 1) & 0x3;
+  int bit_rate_index = header[2] >> 4;
+  int sample_rate_index = (header[2] >> 2) & 0x3;
+  if (version_bits == 1 || layer_bits == 0 || bit_rate_index == 0 || bit_rate_index == 15 || sample_rate_index == 3) {
+    return false;
+  }
+  frame.version = version_bits == 3 ? 1 : version_bits == 2 ? 2 : 25;
+  frame.layer = 4 - layer_bits;
+  int table = frame.version == 1 ? frame.layer - 1 : frame.layer == 1 ? 3 : 4;
+  frame.bit_rate = BIT_RATES[table][bit_rate_index] * 1000u;
+  frame.sample_rate = SAMPLE_RATES[sample_rate_index] / (frame.version == 1 ? 1 : frame.version == 2 ? 2 : 4);
+  frame.channel_count = (header[3] >> 6) == 3 ? 1 : 2;
+  frame.samples_per_frame = frame.layer == 1 ? 384 : frame.layer == 2 || frame.version == 1 ? 1152 : 576;
+  size_t padding = (header[2] >> 1) & 0x1;
+  if (frame.layer == 1) {
+    frame.length = (12 * frame.bit_rate / frame.sample_rate + padding) * 4;
+  } else {
+    frame.length = frame.samples_per_frame / 8 * frame.bit_rate / frame.sample_rate + padding;
+  }
+  return true;
+}
+
+std::string get_extension(const std::string& path) {
+  std::string extension = std::filesystem::u8path(path).extension().u8string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(static_cast<int>(c))); });
+  return extension;
+}
+
+}  // namespace
+
+bool has_audio_metadata(const std::string& extension) {
+  return extension == ".wav" || extension == ".flac" || extension == ".ogg" || extension == ".mp3";
+}
+
+bool read_wav_metadata(const unsigned char* data, size_t size, AudioMetadata& metadata, PcmSamples* samples) {
+  if (size < 12 || std::memcmp(data, "RIFF", 4) != 0 || std::memcmp(data + 8, "WAVE", 4) != 0) {
+    return false;
+  }
+  bool has_format = false;
+  uint16_t format_tag = 0;
+  uint32_t byte_rate = 0;
+  uint16_t block_align = 0;
+  uint32_t container_bits = 0;
+  uint64_t fact_frames = 0;
+  size_t position = 12;
+  while (position + 8 <= size) {
+    const unsigned char* chunk = data + position;
+    size_t chunk_size = read_le32(chunk + 4);
+    size_t body = position + 8;
+    if (std::memcmp(chunk, "fmt ", 4) == 0 && chunk_size >= 16 && body + 16 <= size) {
+      has_format = true;
+      format_tag = read_le16(data + body);
+      metadata.channel_count = read_le16(data + body + 2);
+      metadata.sample_rate = read_le32(data + body + 4);
+      byte_rate = read_le32(data + body + 8);
+      block_align = read_le16(data + body + 12);
+      container_bits = read_le16(data + body + 14);
+      metadata.bits_per_sample = container_bits;
+      // The extensible format keeps the real tag at the start of its subformat GUID
+      if (format_tag == WAVE_FORMAT_EXTENSIBLE && chunk_size >= 40 && body + 26 <= size) {
+        uint16_t valid_bits = read_le16(data + body + 18);
+        metadata.bits_per_sample = valid_bits > 0 ? valid_bits : container_bits;
+        format_tag = read_le16(data + body + 24);
+      }
+    } else if (std::memcmp(chunk, "fact", 4) == 0 && chunk_size >= 4 && body + 4 <= size) {
+      fact_frames = read_le32(data + body);
+    } else if (std::memcmp(chunk, "data", 4) == 0 && has_format) {
+      // Files still being written, or written by streaming encoders, may claim more data than they hold
+      uint64_t data_size = std::min<uint64_t>(chunk_size, size - body);
+      bool is_pcm = format_tag == WAVE_FORMAT_PCM || format_tag == WAVE_FORMAT_IEEE_FLOAT;
+      if (is_pcm && block_align > 0) {
+        metadata.frame_count = data_size / block_align;
+      } else if (fact_frames > 0) {
+        metadata.frame_count = fact_frames;
+      } else if (byte_rate > 0) {
+        metadata.frame_count = data_size * metadata.sample_rate / byte_rate;
+      }
+
+      if (format_tag == WAVE_FORMAT_PCM) {
+        metadata.codec = "PCM";
+      } else if (format_tag == WAVE_FORMAT_IEEE_FLOAT) {
+        metadata.codec = "Float";
+      } else {
+        char tag[8];
+        std::snprintf(tag, sizeof(tag), "0x%04X", format_tag);
+        metadata.codec = tag;
+      }
+
+      bool readable = format_tag == WAVE_FORMAT_PCM
+                          ? container_bits == 8 || container_bits == 16 || container_bits == 24 || container_bits == 32
+                          : format_tag == WAVE_FORMAT_IEEE_FLOAT && container_bits == 32;
+      if (samples && readable && metadata.channel_count > 0 &&
+          block_align == metadata.channel_count * container_bits / 8) {
+        samples->data = data + body;
+        samples->frame_count = metadata.frame_count;
+        samples->channel_count = metadata.channel_count;
+        samples->bits_per_sample = container_bits;
+        samples->is_float = format_tag == WAVE_FORMAT_IEEE_FLOAT;
+      }
+      return metadata.sample_rate > 0 && metadata.channel_count > 0;
+    }
+    // Chunks are padded to an even size
+    if (chunk_size > size - body) {
+      break;
+    }
+    position = body + chunk_size + (chunk_size & 1);
+  }
+  return false;
+}
+
+bool read_flac_metadata(const unsigned char* data, size_t size, AudioMetadata& metadata) {
+  size_t start = get_id3v2_size(data, size);
+  // STREAMINFO is required to be the first metadata block
+  if (size - start < 8 + 34 || std::memcmp(data + start, "fLaC", 4) != 0 || (data[start + 4] & 0x7F) != 0) {
+    return false;
+  }
+  return read_streaminfo(data + start + 8, metadata);
+}
+
+bool read_ogg_metadata(const unsigned char* data, size_t size, AudioMetadata& metadata) {
+  if (size < 27 || std::memcmp(data, "OggS", 4) != 0) {
+    return false;
+  }
+  size_t segment_count = data[26];
+  size_t payload = 27 + segment_count;
+  if (payload > size) {
+    return false;
+  }
+  size_t packet_size = 0;
+  for (size_t i = 0; i < segment_count; i++) {
+    packet_size += data[27 + i];
+    if (data[27 + i] < 255) {
+      break;
+    }
+  }
+  packet_size = std::min(packet_size, size - payload);
+  const unsigned char* packet = data + payload;
+  uint32_t serial = read_le32(data + 14);
+
+  uint64_t pre_skip = 0;
+  if (packet_size >= 16 && std::memcmp(packet, "\x01vorbis", 7) == 0) {
+    metadata.codec = "Vorbis";
+    metadata.channel_count = packet[11];
+    metadata.sample_rate = read_le32(packet + 12);
+  } else if (packet_size >= 19 && std::memcmp(packet, "OpusHead", 8) == 0) {
+    metadata.codec = "Opus";
+    metadata.channel_count = packet[9];
+    metadata.sample_rate = OPUS_SAMPLE_RATE;
+    pre_skip = read_le16(packet + 10);
+  } else if (packet_size >= 13 + 4 + 34 && std::memcmp(packet, "\x7F" "FLAC", 5) == 0 &&
+             std::memcmp(packet + 9, "fLaC", 4) == 0) {
+    // Ogg FLAC's first packet wraps the native signature and STREAMINFO block
+    if (!read_streaminfo(packet + 13 + 4, metadata)) {
+      return false;
+    }
+  } else {
+    return false;
+  }
+
+  // Search back for the last page of this stream; its granule position is the number of samples decoded by its
+  // end. Pages that finish no packet have a granule position of -1.
+  size_t lowest = size > MAX_OGG_PAGE_SIZE ? size - MAX_OGG_PAGE_SIZE : 0;
+  for (size_t position = size - 27 + 1; position-- > lowest;) {
+    if (std::memcmp(data + position, "OggS", 4) != 0 ||
+        read_le32(data + position + 14) != serial) {
+      continue;
+    }
+    uint64_t granule = read_le64(data + position + 6);
+    if (granule != UINT64_MAX) {
+      metadata.frame_count = granule > pre_skip ? granule - pre_skip : 0;
+      break;
+    }
+  }
+  return metadata.sample_rate > 0 && metadata.channel_count > 0;
+}
+
+bool read_mp3_metadata(const unsigned char* data, size_t size, AudioMetadata& metadata) {
+  size_t start = get_id3v2_size(data, size);
+  size_t search_end = std::min(size, start + MP3_SYNC_SEARCH_BYTES + 4);
+  // A frame header counts when the next frame follows where it says, which rules out most false syncs in junk
+  MpegFrame frame;
+  size_t position = start;
+  for (; position + 4 <= search_end; position++) {
+    if (data[position] != 0xFF || !read_mpeg_frame(data + position, frame)) {
+      continue;
+    }
+    size_t next = position + frame.length;
+    MpegFrame next_frame;
+    if (next + 4 > size || (read_mpeg_frame(data + next, next_frame) && next_frame.layer == frame.layer &&
+                            next_frame.sample_rate == frame.sample_rate)) {
+      break;
+    }
+  }
+  if (position + 4 > search_end) {
+    return false;
+  }
+
+  const char* codecs[] = {"MP1", "MP2", "MP3"};
+  metadata.codec = codecs[frame.layer - 1];
+  metadata.sample_rate = frame.sample_rate;
+  metadata.channel_count = frame.channel_count;
+  metadata.bits_per_sample = 0;
+
+  // The Xing (VBR) or Info (CBR) header sits after the side information, VBRI at a fixed offset
+  size_t side_info = frame.version == 1 ? (frame.channel_count == 1 ? 17 : 32) : (frame.channel_count == 1 ? 9 : 17);
+  size_t xing = position + 4 + side_info;
+  size_t vbri = position + 4 + 32;
+  if (xing + 12 <= size && (std::memcmp(data + xing, "Xing", 4) == 0 || std::memcmp(data + xing, "Info", 4) == 0) &&
+      (read_be32(data + xing + 4) & 0x1)) {
+    metadata.frame_count = static_cast<uint64_t>(read_be32(data + xing + 8)) * frame.samples_per_frame;
+  } else if (vbri + 18 <= size && std::memcmp(data + vbri, "VBRI", 4) == 0) {
+    metadata.frame_count = static_cast<uint64_t>(read_be32(data + vbri + 14)) * frame.samples_per_frame;
+  } else {
+    size_t end = size >= 128 && std::memcmp(data + size - 128, "TAG", 3) == 0 ? size - 128 : size;
+    uint64_t audio_bytes = end > position ? end - position : 0;
+    metadata.frame_count = audio_bytes * 8 * frame.sample_rate / frame.bit_rate;
+  }
+  return true;
+}
+
+void compute_waveform(const PcmSamples& samples, size_t column_count, std::vector<int8_t>& waveform) {
+  waveform.clear();
+  if (!samples.data || samples.frame_count == 0 || samples.channel_count == 0 || column_count == 0) {
+    return;
+  }
+  size_t columns = static_cast<size_t>(std::min<uint64_t>(column_count, samples.frame_count));
+  size_t bytes_per_sample = samples.bits_per_sample / 8;
+  bool is_direct = bytes_per_sample == 2 && !samples.is_float;
+  unsigned char converted[CONVERT_BLOCK_SAMPLES * 2];
+  waveform.reserve(columns * 2);
+
+  // Channels are interleaved, so each column is one contiguous run of samples and its envelope covers them all
+  for (size_t column = 0; column < columns; column++) {
+    uint64_t begin = samples.frame_count * column / columns * samples.channel_count;
+    uint64_t end = samples.frame_count * (column + 1) / columns * samples.channel_count;
+    int low = SHRT_MAX;
+    int high = SHRT_MIN;
+    if (is_direct) {
+      accumulate_min_max(samples.data + begin * 2, static_cast<size_t>(end - begin), low, high);
+    } else {
+      for (uint64_t block = begin; block < end; block += CONVERT_BLOCK_SAMPLES) {
+        size_t count = static_cast<size_t>(std::min<uint64_t>(CONVERT_BLOCK_SAMPLES, end - block));
+        convert_to_16_bit(samples, samples.data + block * bytes_per_sample, count, converted);
+        accumulate_min_max(converted, count, low, high);
+      }
+    }
+    // 32767 / 258 is 127, and -32768 / 258 rounds towards zero to -127
+    waveform.push_back(static_cast<int8_t>(low / 258));
+    waveform.push_back(static_cast<int8_t>(high / 258));
+  }
+}
+
+bool read_audio_metadata(const std::string& path, MappedFile& file, AudioMetadata& metadata) {
+  metadata = AudioMetadata();
+  std::string extension = get_extension(path);
+  if (extension == ".flac") {
+    return read_flac_metadata(file.data(), file.size(), metadata);
+  }
+  if (extension == ".ogg") {
+    return read_ogg_metadata(file.data(), file.size(), metadata);
+  }
+  if (extension == ".mp3") {
+    return read_mp3_metadata(file.data(), file.size(), metadata);
+  }
+  if (extension != ".wav") {
+    return false;
+  }
+
+  PcmSamples samples;
+  if (!read_wav_metadata(file.data(), file.size(), metadata, &samples)) {
+    return false;
+  }
+  if (samples.data) {
+    file.advise_sequential();
+    compute_waveform(samples, WAVEFORM_COLUMN_COUNT, metadata.waveform);
+  }
+  return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class MappedFile;
+
+// Columns of the waveform summary, about one per pixel of a grid tile
+constexpr size_t WAVEFORM_COLUMN_COUNT = 160;
+
+// What the container headers of a sound file say about its stream, read without decoding it
+struct AudioMetadata {
+  std::string codec;  // "PCM", "Float", "FLAC", "Vorbis", "Opus", "MP3", or the WAV format tag in hex
+  uint32_t sample_rate = 0;
+  uint32_t channel_count = 0;
+  uint32_t bits_per_sample = 0;  // 0 for lossy codecs
+  uint64_t frame_count = 0;      // Samples per channel, estimated for MP3 files without a frame count
+  // Minimum and maximum of each column over all channels, -127 to 127, interleaved as min, max, min, max. Empty
+  // unless the samples are PCM or float that can be read straight from the file.
+  std::vector<int8_t> waveform;
+
+  double get_duration() const { return sample_rate > 0 ? static_cast<double>(frame_count) / sample_rate : 0.0; }
+};
+
+// Interleaved PCM or float samples stored uncompressed in a file
+struct PcmSamples {
+  const unsigned char* data = nullptr;
+  uint64_t frame_count = 0;
+  uint32_t channel_count = 0;
+  uint32_t bits_per_sample = 0;  // 8 (unsigned), 16, 24 or 32, little-endian
+  bool is_float = false;         // 32-bit IEEE floats
+};
+
+// Whether metadata can be read from sound files with this (lowercase) extension: .wav, .flac, .ogg and .mp3
+bool has_audio_metadata(const std::string& extension);
+
+// Read the fmt and data chunks of a RIFF WAVE file. `samples` gets the sample data when it is PCM or float.
+bool read_wav_metadata(const unsigned char* data, size_t size, AudioMetadata& metadata, PcmSamples* samples);
+
+// Read the STREAMINFO block of a FLAC file
+bool read_flac_metadata(const unsigned char* data, size_t size, AudioMetadata& metadata);
+
+// Read the identification header of an Ogg Vorbis or Opus stream, and the length from the granule position of
+// its last page, which is found by searching back from the end
+bool read_ogg_metadata(const unsigned char* data, size_t size, AudioMetadata& metadata);
+
+// Read the first MPEG audio frame header after any ID3v2 tag, and the frame count from a Xing, Info or VBRI
+// header when there is one; without it the stream is taken to be constant bit rate
+bool read_mp3_metadata(const unsigned char* data, size_t size, AudioMetadata& metadata);
+
+// Reduce the samples to `column_count` min/max pairs, streaming through them once
+void compute_waveform(const PcmSamples& samples, size_t column_count, std::vector<int8_t>& waveform);
+
+// Read the metadata of the sound at `path`, mapped in `file`, and the waveform when the file holds PCM
+bool read_audio_metadata(const std::string& path, MappedFile& file, AudioMetadata& metadata);
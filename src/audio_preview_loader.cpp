@@ -0,0 +1,69 @@
+#include "audio_preview_loader.h"
+
+#include "metadata_store.h"
+
+AudioPreviewLoader::AudioPreviewLoader(MetadataStore& metadata_store) : store(metadata_store), should_stop(false) {}
+
+AudioPreviewLoader::~AudioPreviewLoader() { stop(); }
+
+void AudioPreviewLoader::set_result_callback(std::function<void()> callback) { result_callback = std::move(callback); }
+
+void AudioPreviewLoader::start() {
+  if (worker.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    should_stop = false;
+  }
+  worker = std::thread(&AudioPreviewLoader::worker_loop, this);
+}
+
+void AudioPreviewLoader::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    should_stop = true;
+    queue.clear();
+    queued.clear();
+  }
+  queue_condition.notify_all();
+  if (worker.joinable()) {
+    worker.join();
+  }
+}
+
+void AudioPreviewLoader::request(const std::string& path) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!queued.insert(path).second) {
+      return;
+    }
+    queue.push_back(path);
+  }
+  queue_condition.notify_one();
+}
+
+bool AudioPreviewLoader::poll(AudioPreviewResult& result) { return completions.pop(result); }
+
+void AudioPreviewLoader::worker_loop() {
+  while (true) {
+    AudioPreviewResult result;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      queue_condition.wait(lock, [this] { return should_stop || !queue.empty(); });
+      if (should_stop) {
+        return;
+      }
+      result.path = std::move(queue.front());
+      queue.pop_front();
+      // A request made from here on loads the path again, so metadata stored meanwhile isn't missed
+      queued.erase(result.path);
+    }
+
+    result.found = store.is_open() && store.load_audio(result.path, result.metadata);
+    completions.push(std::move(result));
+    if (result_callback) {
+      result_callback();
+    }
+  }
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+
+#include "audio_metadata.h"
+#include "mpsc_queue.h"
+
+class MetadataStore;
+
+// A sound's stored metadata, handed back to the main thread to draw its tile
+struct AudioPreviewResult {
+  std::string path;
+  bool found = false;  // Whether the store has metadata for the path; `metadata` is empty otherwise
+  AudioMetadata metadata;
+};
+
+// Loads sound metadata and waveforms from the metadata store on a background thread, so drawing a sound tile
+// never waits on a database read. The main thread requests the paths it wants to show and polls for the loads
+// that finished, as it does with thumbnails. A path requested again while still queued is loaded once.
+//
+// The store must outlive the loader. All methods except the constructor and destructor are meant to be called
+// from the main thread.
+class AudioPreviewLoader {
+ public:
+  explicit AudioPreviewLoader(MetadataStore& metadata_store);
+  ~AudioPreviewLoader();
+
+  AudioPreviewLoader(const AudioPreviewLoader&) = delete;
+  AudioPreviewLoader& operator=(const AudioPreviewLoader&) = delete;
+
+  // Called on the worker thread after each finished load, e.g. to wake a main loop waiting for events.
+  // Must be set before start().
+  void set_result_callback(std::function<void()> callback);
+
+  void start();
+
+  // Stop once the running load finishes; what is still queued is dropped
+  void stop();
+
+  // Ask for the metadata of `path` to be loaded, e.g. again after the extractor stored new metadata for it
+  void request(const std::string& path);
+
+  // Take the next finished load
+  bool poll(AudioPreviewResult& result);
+
+ private:
+  MetadataStore& store;
+  std::function<void()> result_callback;
+  std::thread worker;
+
+  std::mutex mutex;
+  std::condition_variable queue_condition;
+  std::deque<std::string> queue;
+  std::unordered_set<std::string> queued;  // Paths in `queue`
+  bool should_stop;
+
+  MpscQueue<AudioPreviewResult> completions;
+
+  void worker_loop();
+};
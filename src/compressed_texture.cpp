@@ -0,0 +1,759 @@
+#include "compressed_texture.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+// Textures larger than this on a side are taken for corrupt headers
+constexpr int MAX_TEXTURE_SIZE = 1 << 16;
+constexpr int MAX_LEVEL_COUNT = 17;
+
+// DDS: "DDS " followed by a 124-byte header, and a 20-byte DX10 header if the FourCC says so
+constexpr size_t DDS_HEADER_SIZE = 4 + 124;
+constexpr size_t DDS_DX10_HEADER_SIZE = 20;
+constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+constexpr uint32_t DDPF_FOURCC = 0x4;
+constexpr uint32_t DDPF_RGB = 0x40;
+constexpr uint32_t DDSCAPS2_VOLUME = 0x200000;
+
+// KTX 1: a 12-byte identifier and 13 32-bit fields, then key/value data and the levels, each led by its size
+constexpr size_t KTX_HEADER_SIZE = 64;
+constexpr unsigned char KTX_IDENTIFIER[12] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+constexpr uint32_t KTX_ENDIANNESS = 0x04030201;
+constexpr uint32_t KTX_ENDIANNESS_SWAPPED = 0x01020304;
+
+// BC7 modes: subsets, partition bits, rotation bits, index selection bits, color bits, alpha bits, p-bits per
+// endpoint, p-bits per subset, index bits and secondary index bits
+struct Bc7Mode {
+  int subsets;
+  int partition_bits;
+  int rotation_bits;
+  int index_selection_bits;
+  int color_bits;
+  int alpha_bits;
+  int endpoint_pbits;
+  int shared_pbits;
+  int index_bits;
+  int secondary_index_bits;
+};
+
+constexpr Bc7Mode BC7_MODES[8] = {
+    {3, 4, 0, 0, 4, 0, 1, 0, 3, 0}, {2, 6, 0, 0, 6, 0, 0, 1, 3, 0}, {3, 6, 0, 0, 5, 0, 0, 0, 2, 0},
+    {2, 6, 0, 0, 7, 0, 1, 0, 2, 0}, {1, 0, 2, 1, 5, 6, 0, 0, 2, 3}, {1, 0, 2, 0, 7, 8, 0, 0, 2, 2},
+    {1, 0, 0, 0, 7, 7, 1, 0, 4, 0}, {2, 6, 0, 0, 5, 5, 1, 0, 2, 0},
+};
+
+// Two-subset partitions as masks of the texels in subset 1
+constexpr uint16_t BC7_PARTITIONS_2[64] = {
+    0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8,
+    0xFF00, 0xFFF0, 0xF000, 0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110,
+    0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C, 0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696,
+    0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660, 0x0272, 0x04E4, 0x4E40, 0x2720,
+    0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+};
+
+// Three-subset partitions as the subset of each texel
+constexpr uint8_t BC7_PARTITIONS_3[64][16] = {
+    {0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 1, 2, 2, 2, 2}, {0, 0, 0, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 2, 0, 0, 1, 2, 2, 1, 1, 2, 2, 1, 1}, {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 1, 0, 1, 1, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2}, {0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 2, 2},
+    {0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1}, {0, 0, 1, 1, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1},
+    {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2}, {0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2},
+    {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2},
+    {0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2, 0, 1, 1, 2}, {0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2, 0, 1, 2, 2},
+    {0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2, 1, 2, 2, 2}, {0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0, 2, 2, 2, 0},
+    {0, 0, 0, 1, 0, 0, 1, 1, 0, 1, 1, 2, 1, 1, 2, 2}, {0, 1, 1, 1, 0, 0, 1, 1, 2, 0, 0, 1, 2, 2, 0, 0},
+    {0, 0, 0, 0, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2}, {0, 0, 2, 2, 0, 0, 2, 2, 0, 0, 2, 2, 1, 1, 1, 1},
+    {0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2, 0, 2, 2, 2}, {0, 0, 0, 1, 0, 0, 0, 1, 2, 2, 2, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2}, {0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 1, 0, 2, 2, 1, 0},
+    {0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1, 0, 0, 0, 0}, {0, 0, 1, 2, 0, 0, 1, 2, 1, 1, 2, 2, 2, 2, 2, 2},
+    {0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1, 0, 1, 1, 0}, {0, 0, 0, 0, 0, 1, 1, 0, 1, 2, 2, 1, 1, 2, 2, 1},
+    {0, 0, 2, 2, 1, 1, 0, 2, 1, 1, 0, 2, 0, 0, 2, 2}, {0, 1, 1, 0, 0, 1, 1, 0, 2, 0, 0, 2, 2, 2, 2, 2},
+    {0, 0, 1, 1, 0, 1, 2, 2, 0, 1, 2, 2, 0, 0, 1, 1}, {0, 0, 0, 0, 2, 0, 0, 0, 2, 2, 1, 1, 2, 2, 2, 1},
+    {0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 2, 2, 2}, {0, 2, 2, 2, 0, 0, 2, 2, 0, 0, 1, 2, 0, 0, 1, 1},
+    {0, 0, 1, 1, 0, 0, 1, 2, 0, 0, 2, 2, 0, 2, 2, 2}, {0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0, 0, 1, 2, 0},
+    {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0}, {0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0},
+    {0, 1, 2, 0, 2, 0, 1, 2, 1, 2, 0, 1, 0, 1, 2, 0}, {0, 0, 1, 1, 2, 2, 0, 0, 1, 1, 2, 2, 0, 0, 1, 1},
+    {0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 0, 0, 0, 0, 1, 1}, {0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2},
+    {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1}, {0, 0, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2, 1, 1, 2, 2},
+    {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 2, 2, 0, 0, 1, 1}, {0, 2, 2, 0, 1, 2, 2, 1, 0, 2, 2, 0, 1, 2, 2, 1},
+    {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 0, 1, 0, 1}, {0, 0, 0, 0, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1, 2, 1},
+    {0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 0, 1, 2, 2, 2, 2}, {0, 2, 2, 2, 0, 1, 1, 1, 0, 2, 2, 2, 0, 1, 1, 1},
+    {0, 0, 0, 2, 1, 1, 1, 2, 0, 0, 0, 2, 1, 1, 1, 2}, {0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2, 2, 1, 1, 2},
+    {0, 2, 2, 2, 0, 1, 1, 1, 0, 1, 1, 1, 0, 2, 2, 2}, {0, 0, 0, 2, 1, 1, 1, 2, 1, 1, 1, 2, 0, 0, 0, 2},
+    {0, 1, 1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2}, {0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2, 2, 1, 1, 2},
+    {0, 1, 1, 0, 0, 1, 1, 0, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 0, 2, 2, 0, 0, 1, 1, 0, 0, 1, 1, 0, 0, 2, 2},
+    {0, 0, 2, 2, 1, 1, 2, 2, 1, 1, 2, 2, 0, 0, 2, 2}, {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 1, 1, 2},
+    {0, 0, 0, 2, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 1}, {0, 2, 2, 2, 1, 2, 2, 2, 0, 2, 2, 2, 1, 2, 2, 2},
+    {0, 1, 0, 1, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2}, {0, 1, 1, 1, 2, 0, 1, 1, 2, 2, 0, 1, 2, 2, 2, 0},
+};
+
+// Texels whose index drops its top bit: the anchor of subset 1 in two-subset partitions, and of subsets 1 and 2
+// in three-subset ones. Texel 0 anchors subset 0 in every partition.
+constexpr uint8_t BC7_ANCHORS_2[64] = {
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 2,  8,  2,  2,  8,  8,  15, 2,  8,  2,  2,
+    8,  8,  2,  2,  15, 15, 6,  8,  2,  8,  15, 15, 2,  8,  2,  2,  2,  15, 15, 6,  6,  2,  6,  8,  15, 15, 2,  2,
+    15, 15, 15, 15, 15, 2,  2,  15,
+};
+constexpr uint8_t BC7_ANCHORS_3_SECOND[64] = {
+    3,  3,  15, 15, 8,  3,  15, 15, 8,  8,  6,  6,  6,  5,  3,  3,  3,  3,  8,  15, 3,  3,  6,  10, 5,  8,  8,  6,
+    8,  5,  15, 15, 8,  15, 3,  5,  6,  10, 8,  15, 15, 3,  15, 5,  15, 15, 15, 15, 3,  15, 5,  5,  5,  8,  5,  10,
+    5,  10, 8,  13, 15, 12, 3,  3,
+};
+constexpr uint8_t BC7_ANCHORS_3_THIRD[64] = {
+    15, 8,  8,  3,  15, 15, 3,  8,  15, 15, 15, 15, 15, 15, 15, 8,  15, 8,  15, 3,  15, 8,  15, 8,  3,  15, 6,  10,
+    15, 15, 10, 8,  15, 3,  15, 10, 10, 8,  9,  10, 6,  15, 8,  15, 3,  6,  6,  8,  15, 3,  15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 3,  15, 15, 8,
+};
+
+// Interpolation weights out of 64, by index size
+constexpr int BC7_WEIGHTS_2[4] = {0, 21, 43, 64};
+constexpr int BC7_WEIGHTS_3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+constexpr int BC7_WEIGHTS_4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+uint32_t read_u32(const unsigned char* data) {
+  return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+         static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+}
+
+uint32_t swap_u32(uint32_t value) {
+  return (value >> 24) | ((value >> 8) & 0xFF00) | ((value << 8) & 0xFF0000) | (value << 24);
+}
+
+constexpr uint32_t make_fourcc(char a, char b, char c, char d) {
+  return static_cast<uint32_t>(a) | static_cast<uint32_t>(b) << 8 | static_cast<uint32_t>(c) << 16 |
+         static_cast<uint32_t>(d) << 24;
+}
+
+bool is_block_format(TextureFormat format) {
+  switch (format) {
+    case TextureFormat::RGBA8:
+    case TextureFormat::BGRA8:
+    case TextureFormat::RGB8:
+    case TextureFormat::BGR8:
+      return false;
+    default:
+      return true;
+  }
+}
+
+size_t get_texel_bytes(TextureFormat format) {
+  switch (format) {
+    case TextureFormat::RGB8:
+    case TextureFormat::BGR8:
+      return 3;
+    case TextureFormat::BC1:
+    case TextureFormat::BC4:
+    case TextureFormat::BC4Signed:
+      return 8;  // Per block
+    case TextureFormat::BC2:
+    case TextureFormat::BC3:
+    case TextureFormat::BC5:
+    case TextureFormat::BC5Signed:
+    case TextureFormat::BC7:
+      return 16;  // Per block
+    default:
+      return 4;
+  }
+}
+
+// Bytes per row of pixels or blocks, padded to `row_alignment`
+size_t get_row_pitch(TextureFormat format, int width, size_t row_alignment) {
+  size_t units = is_block_format(format) ? static_cast<size_t>((width + 3) / 4) : static_cast<size_t>(width);
+  size_t pitch = units * get_texel_bytes(format);
+  return (pitch + row_alignment - 1) / row_alignment * row_alignment;
+}
+
+size_t get_row_count(TextureFormat format, int height) {
+  return is_block_format(format) ? static_cast<size_t>((height + 3) / 4) : static_cast<size_t>(height);
+}
+
+int get_level_size(int size, int level) { return std::max(size >> level, 1); }
+
+// Smallest level whose larger side still covers `min_size`
+int select_level(int width, int height, int level_count, int min_size) {
+  int selected = 0;
+  if (min_size <= 0) {
+    return selected;
+  }
+  for (int level = 1; level < level_count; level++) {
+    if (std::max(get_level_size(width, level), get_level_size(height, level)) < min_size) {
+      break;
+    }
+    selected = level;
+  }
+  return selected;
+}
+
+bool read_at(std::ifstream& file, uint64_t offset, unsigned char* data, size_t size) {
+  file.seekg(static_cast<std::streamoff>(offset));
+  file.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(size));
+  return static_cast<size_t>(file.gcount()) == size;
+}
+
+bool is_valid_size(int width, int height, int level_count) {
+  return width > 0 && height > 0 && width <= MAX_TEXTURE_SIZE && height <= MAX_TEXTURE_SIZE && level_count > 0 &&
+         level_count <= MAX_LEVEL_COUNT;
+}
+
+bool get_dxgi_format(uint32_t dxgi_format, TextureFormat& format) {
+  switch (dxgi_format) {
+    case 28:  // R8G8B8A8_UNORM
+    case 29:  // R8G8B8A8_UNORM_SRGB
+      format = TextureFormat::RGBA8;
+      return true;
+    case 87:  // B8G8R8A8_UNORM
+    case 91:  // B8G8R8A8_UNORM_SRGB
+      format = TextureFormat::BGRA8;
+      return true;
+    case 71:  // BC1_UNORM
+    case 72:  // BC1_UNORM_SRGB
+      format = TextureFormat::BC1;
+      return true;
+    case 74:  // BC2_UNORM
+    case 75:  // BC2_UNORM_SRGB
+      format = TextureFormat::BC2;
+      return true;
+    case 77:  // BC3_UNORM
+    case 78:  // BC3_UNORM_SRGB
+      format = TextureFormat::BC3;
+      return true;
+    case 80:  // BC4_UNORM
+      format = TextureFormat::BC4;
+      return true;
+    case 81:  // BC4_SNORM
+      format = TextureFormat::BC4Signed;
+      return true;
+    case 83:  // BC5_UNORM
+      format = TextureFormat::BC5;
+      return true;
+    case 84:  // BC5_SNORM
+      format = TextureFormat::BC5Signed;
+      return true;
+    case 98:  // BC7_UNORM
+    case 99:  // BC7_UNORM_SRGB
+      format = TextureFormat::BC7;
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool get_dds_fourcc_format(uint32_t fourcc, TextureFormat& format) {
+  if (fourcc == make_fourcc('D', 'X', 'T', '1')) {
+    format = TextureFormat::BC1;
+  } else if (fourcc == make_fourcc('D', 'X', 'T', '2') || fourcc == make_fourcc('D', 'X', 'T', '3')) {
+    format = TextureFormat::BC2;
+  } else if (fourcc == make_fourcc('D', 'X', 'T', '4') || fourcc == make_fourcc('D', 'X', 'T', '5')) {
+    format = TextureFormat::BC3;
+  } else if (fourcc == make_fourcc('A', 'T', 'I', '1') || fourcc == make_fourcc('B', 'C', '4', 'U')) {
+    format = TextureFormat::BC4;
+  } else if (fourcc == make_fourcc('B', 'C', '4', 'S')) {
+    format = TextureFormat::BC4Signed;
+  } else if (fourcc == make_fourcc('A', 'T', 'I', '2') || fourcc == make_fourcc('B', 'C', '5', 'U')) {
+    format = TextureFormat::BC5;
+  } else if (fourcc == make_fourcc('B', 'C', '5', 'S')) {
+    format = TextureFormat::BC5Signed;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// Uncompressed DDS formats are described by channel masks; only the common byte orders are understood
+bool get_dds_rgb_format(const unsigned char* pixel_format, TextureFormat& format) {
+  uint32_t flags = read_u32(pixel_format + 4);
+  uint32_t bit_count = read_u32(pixel_format + 12);
+  uint32_t red_mask = read_u32(pixel_format + 16);
+  uint32_t blue_mask = read_u32(pixel_format + 24);
+  if (!(flags & DDPF_RGB)) {
+    return false;
+  }
+  if (bit_count == 32 && red_mask == 0x000000FF && blue_mask == 0x00FF0000) {
+    format = TextureFormat::RGBA8;
+  } else if (bit_count == 32 && red_mask == 0x00FF0000 && blue_mask == 0x000000FF) {
+    format = TextureFormat::BGRA8;
+  } else if (bit_count == 24 && red_mask == 0x000000FF && blue_mask == 0x00FF0000) {
+    format = TextureFormat::RGB8;
+  } else if (bit_count == 24 && red_mask == 0x00FF0000 && blue_mask == 0x000000FF) {
+    format = TextureFormat::BGR8;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool read_dds_level(std::ifstream& file, int min_size, TextureLevel& level) {
+  unsigned char header[DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE];
+  if (!read_at(file, 0, header, DDS_HEADER_SIZE) || read_u32(header) != make_fourcc('D', 'D', 'S', ' ') ||
+      read_u32(header + 4) != 124) {
+    return false;
+  }
+  uint32_t flags = read_u32(header + 8);
+  int height = static_cast<int>(read_u32(header + 12));
+  int width = static_cast<int>(read_u32(header + 16));
+  int depth = static_cast<int>(read_u32(header + 24));
+  int level_count = (flags & DDSD_MIPMAPCOUNT) ? static_cast<int>(read_u32(header + 28)) : 1;
+  const unsigned char* pixel_format = header + 4 + 72;
+  uint32_t caps2 = read_u32(header + 4 + 108);
+  if (level_count == 0) {
+    level_count = 1;
+  }
+  bool is_volume = (caps2 & DDSCAPS2_VOLUME) && depth > 1;
+
+  TextureFormat format = TextureFormat::RGBA8;
+  uint64_t offset = DDS_HEADER_SIZE;
+  uint32_t fourcc = read_u32(pixel_format + 8);
+  if ((read_u32(pixel_format + 4) & DDPF_FOURCC) && fourcc == make_fourcc('D', 'X', '1', '0')) {
+    if (!read_at(file, DDS_HEADER_SIZE, header + DDS_HEADER_SIZE, DDS_DX10_HEADER_SIZE) ||
+        !get_dxgi_format(read_u32(header + DDS_HEADER_SIZE), format)) {
+      return false;
+    }
+    offset += DDS_DX10_HEADER_SIZE;
+  } else if (read_u32(pixel_format + 4) & DDPF_FOURCC) {
+    if (!get_dds_fourcc_format(fourcc, format)) {
+      return false;
+    }
+  } else if (!get_dds_rgb_format(pixel_format, format)) {
+    return false;
+  }
+  if (!is_valid_size(width, height, level_count)) {
+    return false;
+  }
+
+  // Levels are stored largest first, each with all the slices of a volume; the first image of a cube map or
+  // array comes before the others
+  int selected = select_level(width, height, level_count, min_size);
+  for (int i = 0; i < selected; i++) {
+    size_t slices = is_volume ? static_cast<size_t>(get_level_size(depth, i)) : 1;
+    offset += get_row_pitch(format, get_level_size(width, i), 1) *
+              get_row_count(format, get_level_size(height, i)) * slices;
+  }
+
+  level.format = format;
+  level.width = get_level_size(width, selected);
+  level.height = get_level_size(height, selected);
+  level.level = selected;
+  level.level_count = level_count;
+  level.row_pitch = get_row_pitch(format, level.width, 1);
+  level.data.resize(level.row_pitch * get_row_count(format, level.height));
+  return read_at(file, offset, level.data.data(), level.data.size());
+}
+
+bool get_ktx_format(uint32_t gl_type, uint32_t gl_format, uint32_t internal_format, TextureFormat& format) {
+  switch (internal_format) {
+    case 0x83F0:  // COMPRESSED_RGB_S3TC_DXT1
+    case 0x83F1:  // COMPRESSED_RGBA_S3TC_DXT1
+    case 0x8C4C:  // COMPRESSED_SRGB_S3TC_DXT1
+    case 0x8C4D:  // COMPRESSED_SRGB_ALPHA_S3TC_DXT1
+      format = TextureFormat::BC1;
+      return true;
+    case 0x83F2:  // COMPRESSED_RGBA_S3TC_DXT3
+    case 0x8C4E:  // COMPRESSED_SRGB_ALPHA_S3TC_DXT3
+      format = TextureFormat::BC2;
+      return true;
+    case 0x83F3:  // COMPRESSED_RGBA_S3TC_DXT5
+    case 0x8C4F:  // COMPRESSED_SRGB_ALPHA_S3TC_DXT5
+      format = TextureFormat::BC3;
+      return true;
+    case 0x8DBB:  // COMPRESSED_RED_RGTC1
+      format = TextureFormat::BC4;
+      return true;
+    case 0x8DBC:  // COMPRESSED_SIGNED_RED_RGTC1
+      format = TextureFormat::BC4Signed;
+      return true;
+    case 0x8DBD:  // COMPRESSED_RG_RGTC2
+      format = TextureFormat::BC5;
+      return true;
+    case 0x8DBE:  // COMPRESSED_SIGNED_RG_RGTC2
+      format = TextureFormat::BC5Signed;
+      return true;
+    case 0x8E8C:  // COMPRESSED_RGBA_BPTC_UNORM
+    case 0x8E8D:  // COMPRESSED_SRGB_ALPHA_BPTC_UNORM
+      format = TextureFormat::BC7;
+      return true;
+    default:
+      break;
+  }
+
+  constexpr uint32_t GL_UNSIGNED_BYTE_TYPE = 0x1401;
+  if (gl_type != GL_UNSIGNED_BYTE_TYPE) {
+    return false;
+  }
+  switch (gl_format) {
+    case 0x1908:  // RGBA
+      format = TextureFormat::RGBA8;
+      return true;
+    case 0x80E1:  // BGRA
+      format = TextureFormat::BGRA8;
+      return true;
+    case 0x1907:  // RGB
+      format = TextureFormat::RGB8;
+      return true;
+    case 0x80E0:  // BGR
+      format = TextureFormat::BGR8;
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool read_ktx_level(std::ifstream& file, int min_size, TextureLevel& level) {
+  unsigned char header[KTX_HEADER_SIZE];
+  if (!read_at(file, 0, header, KTX_HEADER_SIZE) || std::memcmp(header, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0) {
+    return false;
+  }
+  uint32_t endianness = read_u32(header + 12);
+  if (endianness != KTX_ENDIANNESS && endianness != KTX_ENDIANNESS_SWAPPED) {
+    return false;
+  }
+  bool swapped = endianness == KTX_ENDIANNESS_SWAPPED;
+  auto field = [&](const unsigned char* data) { return swapped ? swap_u32(read_u32(data)) : read_u32(data); };
+  uint32_t gl_type = field(header + 16);
+  uint32_t gl_format = field(header + 24);
+  uint32_t internal_format = field(header + 28);
+  int width = static_cast<int>(field(header + 36));
+  int height = std::max(static_cast<int>(field(header + 40)), 1);  // 0 for 1D textures
+  uint32_t array_elements = field(header + 48);
+  uint32_t faces = field(header + 52);
+  int level_count = std::max(static_cast<int>(field(header + 56)), 1);
+  uint32_t key_value_bytes = field(header + 60);
+
+  TextureFormat format = TextureFormat::RGBA8;
+  if (!get_ktx_format(gl_type, gl_format, internal_format, format) || !is_valid_size(width, height, level_count)) {
+    return false;
+  }
+
+  // Every level is led by its size, so the levels before the selected one are skipped by reading just that.
+  // Pixel rows are padded to 4 bytes, and so is each face of a cube map, whose size counts one face only.
+  int selected = select_level(width, height, level_count, min_size);
+  uint64_t offset = KTX_HEADER_SIZE + static_cast<uint64_t>(key_value_bytes);
+  for (int i = 0; i < selected; i++) {
+    unsigned char size_field[4];
+    if (!read_at(file, offset, size_field, sizeof(size_field))) {
+      return false;
+    }
+    uint64_t image_size = (field(size_field) + 3ull) & ~3ull;
+    offset += 4 + (faces == 6 && array_elements == 0 ? image_size * 6 : image_size);
+  }
+
+  level.format = format;
+  level.width = get_level_size(width, selected);
+  level.height = get_level_size(height, selected);
+  level.level = selected;
+  level.level_count = level_count;
+  level.row_pitch = get_row_pitch(format, level.width, is_block_format(format) ? 1 : 4);
+  level.data.resize(level.row_pitch * get_row_count(format, level.height));
+  return read_at(file, offset + 4, level.data.data(), level.data.size());
+}
+
+// Color endpoints of BC1-3, as 4 RGBA8 palette entries. Only BC1 has a transparent entry.
+void decode_color_block(const unsigned char* block, bool allow_transparent, unsigned char* texels) {
+  unsigned int colors[2] = {static_cast<unsigned int>(block[0] | block[1] << 8),
+                            static_cast<unsigned int>(block[2] | block[3] << 8)};
+  unsigned char palette[4][4];
+  for (int i = 0; i < 2; i++) {
+    unsigned int red = (colors[i] >> 11) & 0x1F;
+    unsigned int green = (colors[i] >> 5) & 0x3F;
+    unsigned int blue = colors[i] & 0x1F;
+    palette[i][0] = static_cast<unsigned char>(red << 3 | red >> 2);
+    palette[i][1] = static_cast<unsigned char>(green << 2 | green >> 4);
+    palette[i][2] = static_cast<unsigned char>(blue << 3 | blue >> 2);
+    palette[i][3] = 255;
+  }
+  bool has_transparent = allow_transparent && colors[0] <= colors[1];
+  for (int c = 0; c < 4; c++) {
+    if (has_transparent) {
+      palette[2][c] = static_cast<unsigned char>((palette[0][c] + palette[1][c]) / 2);
+      palette[3][c] = 0;
+    } else {
+      palette[2][c] = static_cast<unsigned char>((2 * palette[0][c] + palette[1][c]) / 3);
+      palette[3][c] = static_cast<unsigned char>((palette[0][c] + 2 * palette[1][c]) / 3);
+    }
+  }
+  palette[2][3] = 255;
+  palette[3][3] = has_transparent ? 0 : 255;
+
+  uint32_t indices = read_u32(block + 4);
+  for (int i = 0; i < 16; i++) {
+    std::memcpy(texels + i * 4, palette[(indices >> (2 * i)) & 3], 4);
+  }
+}
+
+// A BC3 alpha or BC4/BC5 channel block into one channel of the texels. Signed values are mapped to 0-255.
+void decode_channel_block(const unsigned char* block, bool is_signed, unsigned char* texels, int channel) {
+  int endpoints[2];
+  for (int i = 0; i < 2; i++) {
+    endpoints[i] = is_signed ? std::max(static_cast<int>(static_cast<int8_t>(block[i])), -127) : block[i];
+  }
+  int palette[8] = {endpoints[0], endpoints[1]};
+  if (endpoints[0] > endpoints[1]) {
+    for (int i = 1; i < 7; i++) {
+      palette[i + 1] = ((7 - i) * endpoints[0] + i * endpoints[1]) / 7;
+    }
+  } else {
+    for (int i = 1; i < 5; i++) {
+      palette[i + 1] = ((5 - i) * endpoints[0] + i * endpoints[1]) / 5;
+    }
+    palette[6] = is_signed ? -127 : 0;
+    palette[7] = is_signed ? 127 : 255;
+  }
+
+  uint64_t indices = 0;
+  for (int i = 0; i < 6; i++) {
+    indices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+  }
+  for (int i = 0; i < 16; i++) {
+    int value = palette[(indices >> (3 * i)) & 7];
+    texels[i * 4 + channel] = static_cast<unsigned char>(is_signed ? ((value + 127) * 255 + 127) / 254 : value);
+  }
+}
+
+// Blue of a unit normal from the red and green of a two-channel normal map
+unsigned char reconstruct_normal_z(unsigned char red, unsigned char green) {
+  float x = red / 127.5f - 1.0f;
+  float y = green / 127.5f - 1.0f;
+  float z = std::sqrt(std::max(0.0f, 1.0f - x * x - y * y));
+  return static_cast<unsigned char>(std::lround((z * 0.5f + 0.5f) * 255.0f));
+}
+
+// Reads a block's bits from the least significant bit of its first byte on
+class BlockBits {
+ public:
+  explicit BlockBits(const unsigned char* block_data) : data(block_data), position(0) {}
+
+  int read(int count) {
+    int value = 0;
+    for (int i = 0; i < count; i++, position++) {
+      value |= ((data[position >> 3] >> (position & 7)) & 1) << i;
+    }
+    return value;
+  }
+
+ private:
+  const unsigned char* data;
+  int position;
+};
+
+int bc7_interpolate(int first, int second, int index, int index_bits) {
+  const int* weights = index_bits == 2 ? BC7_WEIGHTS_2 : index_bits == 3 ? BC7_WEIGHTS_3 : BC7_WEIGHTS_4;
+  return ((64 - weights[index]) * first + weights[index] * second + 32) >> 6;
+}
+
+int expand_bits(int value, int bits) {
+  value <<= 8 - bits;
+  return value | (value >> bits);
+}
+
+void decode_bc7_block(const unsigned char* block, unsigned char* texels) {
+  int mode_index = 0;
+  while (mode_index < 8 && !((block[0] >> mode_index) & 1)) {
+    mode_index++;
+  }
+  if (mode_index == 8) {
+    std::memset(texels, 0, 64);  // Reserved mode: transparent black
+    return;
+  }
+  const Bc7Mode& mode = BC7_MODES[mode_index];
+  BlockBits bits(block);
+  bits.read(mode_index + 1);
+  int partition = bits.read(mode.partition_bits);
+  int rotation = bits.read(mode.rotation_bits);
+  int index_selection = bits.read(mode.index_selection_bits);
+
+  // Endpoints come channel by channel, then the p-bits that extend them by one bit
+  int endpoint_count = mode.subsets * 2;
+  int endpoints[6][4] = {};
+  for (int c = 0; c < 3; c++) {
+    for (int e = 0; e < endpoint_count; e++) {
+      endpoints[e][c] = bits.read(mode.color_bits);
+    }
+  }
+  for (int e = 0; e < endpoint_count && mode.alpha_bits > 0; e++) {
+    endpoints[e][3] = bits.read(mode.alpha_bits);
+  }
+  int pbits[6] = {};
+  if (mode.endpoint_pbits) {
+    for (int e = 0; e < endpoint_count; e++) {
+      pbits[e] = bits.read(1);
+    }
+  } else if (mode.shared_pbits) {
+    for (int s = 0; s < mode.subsets; s++) {
+      pbits[s * 2] = pbits[s * 2 + 1] = bits.read(1);
+    }
+  }
+  bool has_pbits = mode.endpoint_pbits || mode.shared_pbits;
+  for (int e = 0; e < endpoint_count; e++) {
+    for (int c = 0; c < 4; c++) {
+      int channel_bits = c < 3 ? mode.color_bits : mode.alpha_bits;
+      if (channel_bits == 0) {
+        endpoints[e][c] = 255;
+        continue;
+      }
+      if (has_pbits) {
+        endpoints[e][c] = endpoints[e][c] << 1 | pbits[e];
+        channel_bits++;
+      }
+      endpoints[e][c] = expand_bits(endpoints[e][c], channel_bits);
+    }
+  }
+
+  int subsets[16] = {};
+  for (int i = 0; i < 16; i++) {
+    if (mode.subsets == 2) {
+      subsets[i] = (BC7_PARTITIONS_2[partition] >> i) & 1;
+    } else if (mode.subsets == 3) {
+      subsets[i] = BC7_PARTITIONS_3[partition][i];
+    }
+  }
+  auto is_anchor = [&](int texel) {
+    return texel == 0 || (mode.subsets == 2 && texel == BC7_ANCHORS_2[partition]) ||
+           (mode.subsets == 3 && (texel == BC7_ANCHORS_3_SECOND[partition] ||
+                                  texel == BC7_ANCHORS_3_THIRD[partition]));
+  };
+  int indices[16];
+  int secondary_indices[16] = {};
+  for (int i = 0; i < 16; i++) {
+    indices[i] = bits.read(mode.index_bits - (is_anchor(i) ? 1 : 0));
+  }
+  for (int i = 0; i < 16 && mode.secondary_index_bits > 0; i++) {
+    secondary_indices[i] = bits.read(mode.secondary_index_bits - (i == 0 ? 1 : 0));
+  }
+
+  for (int i = 0; i < 16; i++) {
+    const int* first = endpoints[subsets[i] * 2];
+    const int* second = endpoints[subsets[i] * 2 + 1];
+    int color_index = indices[i];
+    int color_index_bits = mode.index_bits;
+    int alpha_index = indices[i];
+    int alpha_index_bits = mode.index_bits;
+    if (mode.secondary_index_bits > 0) {
+      // Modes 4 and 5 index color and alpha separately; the index selection bit swaps the two sets
+      bool swap = index_selection != 0;
+      color_index = swap ? secondary_indices[i] : indices[i];
+      color_index_bits = swap ? mode.secondary_index_bits : mode.index_bits;
+      alpha_index = swap ? indices[i] : secondary_indices[i];
+      alpha_index_bits = swap ? mode.index_bits : mode.secondary_index_bits;
+    }
+    unsigned char* texel = texels + i * 4;
+    for (int c = 0; c < 3; c++) {
+      texel[c] = static_cast<unsigned char>(bc7_interpolate(first[c], second[c], color_index, color_index_bits));
+    }
+    texel[3] = static_cast<unsigned char>(bc7_interpolate(first[3], second[3], alpha_index, alpha_index_bits));
+    if (rotation > 0) {
+      std::swap(texel[3], texel[rotation - 1]);
+    }
+  }
+}
+
+}  // namespace
+
+bool is_container_texture(const std::string& path) {
+  std::string extension = std::filesystem::u8path(path).extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(static_cast<int>(c))); });
+  return extension == ".dds" || extension == ".ktx";
+}
+
+bool read_texture_level(const std::string& path, int min_size, TextureLevel& level) {
+  std::ifstream file(std::filesystem::u8path(path), std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  unsigned char magic[4];
+  if (!read_at(file, 0, magic, sizeof(magic))) {
+    return false;
+  }
+  if (read_u32(magic) == make_fourcc('D', 'D', 'S', ' ')) {
+    return read_dds_level(file, min_size, level);
+  }
+  return read_ktx_level(file, min_size, level);
+}
+
+bool decode_texture_level(const TextureLevel& level, std::vector<unsigned char>& pixels) {
+  size_t width = static_cast<size_t>(level.width);
+  size_t height = static_cast<size_t>(level.height);
+  if (level.data.size() < level.row_pitch * get_row_count(level.format, level.height)) {
+    return false;
+  }
+  pixels.resize(width * height * 4);
+
+  if (!is_block_format(level.format)) {
+    size_t texel_bytes = get_texel_bytes(level.format);
+    bool is_bgr = level.format == TextureFormat::BGRA8 || level.format == TextureFormat::BGR8;
+    for (size_t y = 0; y < height; y++) {
+      const unsigned char* src = level.data.data() + y * level.row_pitch;
+      unsigned char* dst = pixels.data() + y * width * 4;
+      for (size_t x = 0; x < width; x++, src += texel_bytes, dst += 4) {
+        dst[0] = src[is_bgr ? 2 : 0];
+        dst[1] = src[1];
+        dst[2] = src[is_bgr ? 0 : 2];
+        dst[3] = texel_bytes == 4 ? src[3] : 255;
+      }
+    }
+    return true;
+  }
+
+  // Blocks cover 4x4 texels; those of edge blocks beyond the image are dropped
+  size_t block_bytes = get_texel_bytes(level.format);
+  unsigned char texels[64];
+  for (size_t block_y = 0; block_y < (height + 3) / 4; block_y++) {
+    const unsigned char* block = level.data.data() + block_y * level.row_pitch;
+    for (size_t block_x = 0; block_x < (width + 3) / 4; block_x++, block += block_bytes) {
+      decode_block(level.format, block, texels);
+      size_t rows = std::min<size_t>(4, height - block_y * 4);
+      size_t columns = std::min<size_t>(4, width - block_x * 4);
+      for (size_t row = 0; row < rows; row++) {
+        std::memcpy(pixels.data() + ((block_y * 4 + row) * width + block_x * 4) * 4, texels + row * 16, columns * 4);
+      }
+    }
+  }
+  return true;
+}
+
+bool decode_block(TextureFormat format, const unsigned char* block, unsigned char* texels) {
+  switch (format) {
+    case TextureFormat::BC1:
+      decode_color_block(block, true, texels);
+      return true;
+    case TextureFormat::BC2:
+      decode_color_block(block + 8, false, texels);
+      for (int i = 0; i < 16; i++) {
+        int alpha = (block[i / 2] >> (4 * (i % 2))) & 0xF;
+        texels[i * 4 + 3] = static_cast<unsigned char>(alpha * 17);
+      }
+      return true;
+    case TextureFormat::BC3:
+      decode_color_block(block + 8, false, texels);
+      decode_channel_block(block, false, texels, 3);
+      return true;
+    case TextureFormat::BC4:
+    case TextureFormat::BC4Signed:
+      decode_channel_block(block, format == TextureFormat::BC4Signed, texels, 0);
+      for (int i = 0; i < 16; i++) {
+        texels[i * 4 + 1] = texels[i * 4 + 2] = texels[i * 4];
+        texels[i * 4 + 3] = 255;
+      }
+      return true;
+    case TextureFormat::BC5:
+    case TextureFormat::BC5Signed:
+      decode_channel_block(block, format == TextureFormat::BC5Signed, texels, 0);
+      decode_channel_block(block + 8, format == TextureFormat::BC5Signed, texels, 1);
+      for (int i = 0; i < 16; i++) {
+        texels[i * 4 + 2] = reconstruct_normal_z(texels[i * 4], texels[i * 4 + 1]);
+        texels[i * 4 + 3] = 255;
+      }
+      return true;
+    case TextureFormat::BC7:
+      decode_bc7_block(block, texels);
+      return true;
+    default:
+      return false;
+  }
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Pixel formats of DDS and KTX files that can be shown as thumbnails. BC6H is HDR and isn't among them, so
+// such files fail to load like other undecodable images.
+enum class TextureFormat {
+  RGBA8,
+  BGRA8,
+  RGB8,
+  BGR8,
+  BC1,
+  BC2,
+  BC3,
+  BC4,
+  BC4Signed,
+  BC5,  // Shown as a normal map, with blue reconstructed from red and green
+  BC5Signed,
+  BC7,
+};
+
+// One mip level of a texture, as stored in its file
+struct TextureLevel {
+  TextureFormat format = TextureFormat::RGBA8;
+  int width = 0;
+  int height = 0;
+  int level = 0;  // Index in the mip chain, 0 being the full-size image
+  int level_count = 0;
+  size_t row_pitch = 0;  // Bytes per row of pixels, or per row of 4x4 blocks
+  std::vector<unsigned char> data;
+};
+
+// Whether `path` is a DDS or KTX file, which stb_image can't decode
+bool is_container_texture(const std::string& path);
+
+// Read the smallest mip level of a DDS or KTX file whose larger side is at least `min_size`, the full-size one
+// if none is or `min_size` is 0. Only the headers and that level are read, so for a thumbnail of a texture with
+// a full mip chain most of the file is skipped. For cube maps and arrays this is the level of the first image.
+bool read_texture_level(const std::string& path, int min_size, TextureLevel& level);
+
+// Decode a level to tightly packed RGBA8
+bool decode_texture_level(const TextureLevel& level, std::vector<unsigned char>& pixels);
+
+// Decode one 4x4 block of a BCn format to 16 RGBA8 texels, row by row. Returns false for other formats.
+bool decode_block(TextureFormat format, const unsigned char* block, unsigned char* texels);
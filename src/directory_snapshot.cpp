@@ -0,0 +1,373 @@
+#include "directory_snapshot.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <utility>
+
+#include "path_utils.h"
+
+namespace fs = std::filesystem;
+
+// Read size, mtime and kind of a directory entry. Returns false if it vanished in the meantime.
+static bool read_entry(const fs::directory_entry& entry, SnapshotEntry& out) {
+  std::error_code ec;
+  if (!entry.exists(ec)) {
+    return false;
+  }
+  out.is_directory = entry.is_directory(ec);
+
+  out.size = 0;
+  if (!out.is_directory) {
+    uintmax_t size = entry.file_size(ec);
+    out.size = ec ? 0 : size;
+  }
+
+  auto write_time = entry.last_write_time(ec);
+  out.last_write_time = ec ? 0 : static_cast<int64_t>(write_time.time_since_epoch().count());
+  return true;
+}
+
+static bool is_same_or_under(const std::string& path, const std::string& directory) {
+  return path == directory || is_path_under(path, directory);
+}
+
+static FileEventType created_type(bool is_directory) {
+  return is_directory ? FileEventType::DirectoryCreated : FileEventType::Created;
+}
+
+static FileEventType deleted_type(bool is_directory) {
+  return is_directory ? FileEventType::DirectoryDeleted : FileEventType::Deleted;
+}
+
+// Compare a recorded entry with the one on disk and append the raw events that explain the difference
+static void diff_entry(const std::string& path, const SnapshotEntry& recorded, const SnapshotEntry& current,
+                       std::vector<SnapshotChange>& changes) {
+  if (current.is_directory != recorded.is_directory) {
+    changes.push_back({deleted_type(recorded.is_directory), path, recorded.is_directory});
+    changes.push_back({created_type(current.is_directory), path, current.is_directory});
+  } else if (!recorded.is_directory &&
+             (current.size != recorded.size || current.last_write_time != recorded.last_write_time)) {
+    changes.push_back({FileEventType::Modified, path, false});
+  }
+}
+
+void DirectorySnapshot::set_filter(const EventFilter* new_filter) { filter = new_filter; }
+
+void DirectorySnapshot::capture(const std::string& root_path) {
+  root = root_path;
+  entries = scan(root);
+}
+
+bool DirectorySnapshot::is_excluded(const std::string& path, bool is_directory) const {
+  if (!filter || path.size() <= root.size()) {
+    return false;
+  }
+  return filter->excludes(path.substr(root.size() + 1), is_directory);
+}
+
+std::map<std::string, SnapshotEntry> DirectorySnapshot::scan(const std::string& directory) const {
+  std::map<std::string, SnapshotEntry> result;
+  std::error_code ec;
+
+  SnapshotEntry root_entry;
+  if (!read_entry(fs::directory_entry(directory, ec), root_entry)) {
+    return result;
+  }
+  result[directory] = root_entry;
+  if (!root_entry.is_directory) {
+    return result;
+  }
+
+  for (auto it = fs::recursive_directory_iterator(directory, ec); !ec && it != fs::recursive_directory_iterator();
+       it.increment(ec)) {
+    SnapshotEntry entry;
+    if (!read_entry(*it, entry)) continue;
+
+    std::string path = it->path().string();
+    if (is_excluded(path, entry.is_directory)) {
+      if (entry.is_directory) {
+        it.disable_recursion_pending();
+      }
+      continue;
+    }
+    result[path] = entry;
+  }
+  return result;
+}
+
+std::vector<SnapshotChange> DirectorySnapshot::resync_subtree(const std::string& directory) {
+  std::vector<SnapshotChange> changes;
+  std::map<std::string, SnapshotEntry> fresh = scan(directory);
+
+  // Recorded entries that are gone or changed. Like a listing, a removed or added directory is reported once
+  // for its whole subtree, which is how the coalescer and the indexer treat directory events.
+  std::string removed_directory;
+  for (auto it = entries.lower_bound(directory);
+       it != entries.end() && it->first.compare(0, directory.size(), directory) == 0; ++it) {
+    if (!is_same_or_under(it->first, directory)) continue;
+    if (!removed_directory.empty() && is_path_under(it->first, removed_directory)) continue;
+
+    auto current = fresh.find(it->first);
+    if (current == fresh.end()) {
+      changes.push_back({deleted_type(it->second.is_directory), it->first, it->second.is_directory});
+    } else {
+      diff_entry(it->first, it->second, current->second, changes);
+    }
+    if (it->second.is_directory && (current == fresh.end() || !current->second.is_directory)) {
+      removed_directory = it->first;
+    }
+  }
+
+  // Entries that appeared; a path whose type changed was reported by diff_entry()
+  std::string added_directory;
+  for (const auto& [path, entry] : fresh) {
+    if (!added_directory.empty() && is_path_under(path, added_directory)) continue;
+
+    auto recorded = entries.find(path);
+    if (recorded == entries.end()) {
+      changes.push_back({created_type(entry.is_directory), path, entry.is_directory});
+    }
+    if (entry.is_directory && (recorded == entries.end() || !recorded->second.is_directory)) {
+      added_directory = path;
+    }
+  }
+
+  entries.erase(directory);
+  erase_subtree(directory);
+  entries.insert(fresh.begin(), fresh.end());
+  return changes;
+}
+
+std::vector<SnapshotChange> DirectorySnapshot::resync_changed_directories(
+    const std::vector<std::string>& skip_subtrees) {
+  auto is_skipped = [&](const std::string& path) {
+    for (const auto& subtree : skip_subtrees) {
+      if (is_same_or_under(path, subtree)) return true;
+    }
+    return false;
+  };
+
+  // Only directories are stat'ed here, which is a small fraction of the tree
+  std::vector<std::string> changed_directories;
+  for (const auto& [path, entry] : entries) {
+    if (!entry.is_directory || is_skipped(path)) continue;
+
+    std::error_code ec;
+    auto write_time = fs::last_write_time(path, ec);
+    if (ec || static_cast<int64_t>(write_time.time_since_epoch().count()) != entry.last_write_time) {
+      changed_directories.push_back(path);
+    }
+  }
+
+  // Parents sort before their children, so a directory removed by its parent's listing is simply skipped
+  std::vector<SnapshotChange> changes;
+  for (const auto& directory : changed_directories) {
+    if (entries.find(directory) != entries.end()) {
+      list_directory(directory, changes);
+    }
+  }
+  return changes;
+}
+
+std::vector<SnapshotChange> DirectorySnapshot::resync(const std::vector<std::string>& subtrees) {
+  std::vector<SnapshotChange> changes;
+  for (const auto& subtree : subtrees) {
+    std::vector<SnapshotChange> subtree_changes = resync_subtree(subtree);
+    changes.insert(changes.end(), subtree_changes.begin(), subtree_changes.end());
+  }
+  std::vector<SnapshotChange> directory_changes = resync_changed_directories(subtrees);
+  changes.insert(changes.end(), directory_changes.begin(), directory_changes.end());
+  return changes;
+}
+
+void DirectorySnapshot::list_directory(const std::string& directory, std::vector<SnapshotChange>& changes) {
+  std::error_code ec;
+  SnapshotEntry self;
+  if (!read_entry(fs::directory_entry(directory, ec), self) || !self.is_directory) {
+    const SnapshotEntry recorded = entries[directory];
+    changes.push_back({deleted_type(recorded.is_directory), directory, recorded.is_directory});
+    entries.erase(directory);
+    erase_subtree(directory);
+    return;
+  }
+  entries[directory] = self;
+
+  std::map<std::string, SnapshotEntry> on_disk;
+  for (auto it = fs::directory_iterator(directory, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+    SnapshotEntry entry;
+    std::string path = it->path().string();
+    if (read_entry(*it, entry) && !is_excluded(path, entry.is_directory)) {
+      on_disk[path] = entry;
+    }
+  }
+
+  // Recorded direct children that are gone or changed
+  std::vector<std::string> removed;
+  for (auto it = entries.upper_bound(directory);
+       it != entries.end() && it->first.compare(0, directory.size(), directory) == 0; ++it) {
+    if (!is_path_under(it->first, directory) || parent_path_of(it->first) != directory) continue;
+
+    auto current = on_disk.find(it->first);
+    if (current == on_disk.end()) {
+      changes.push_back({deleted_type(it->second.is_directory), it->first, it->second.is_directory});
+      removed.push_back(it->first);
+    } else if (current->second.is_directory != it->second.is_directory) {
+      diff_entry(it->first, it->second, current->second, changes);
+      removed.push_back(it->first);
+    } else {
+      diff_entry(it->first, it->second, current->second, changes);
+      // Keep the recorded mtime of child directories so their own listing still notices the change
+      if (!current->second.is_directory) {
+        it->second = current->second;
+      }
+      on_disk.erase(current);
+    }
+  }
+
+  for (const auto& path : removed) {
+    entries.erase(path);
+    erase_subtree(path);
+  }
+
+  // Children that appeared; new directories are recorded with their whole subtree
+  for (const auto& [path, entry] : on_disk) {
+    if (entries.find(path) != entries.end()) continue;
+
+    bool replaced = false;
+    for (const auto& removed_path : removed) {
+      if (removed_path == path) {
+        replaced = true;
+        break;
+      }
+    }
+    if (!replaced) {
+      changes.push_back({created_type(entry.is_directory), path, entry.is_directory});
+    }
+
+    if (entry.is_directory) {
+      std::map<std::string, SnapshotEntry> subtree = scan(path);
+      entries.insert(subtree.begin(), subtree.end());
+    } else {
+      entries[path] = entry;
+    }
+  }
+}
+
+void DirectorySnapshot::apply(const FileEvent& event) {
+  switch (event.type) {
+    case FileEventType::Created:
+    case FileEventType::Modified:
+      refresh(event.path);
+      break;
+    case FileEventType::DirectoryCreated: {
+      erase_subtree(event.path);
+      std::map<std::string, SnapshotEntry> subtree = scan(event.path);
+      entries.insert(subtree.begin(), subtree.end());
+      break;
+    }
+    case FileEventType::Deleted:
+    case FileEventType::DirectoryDeleted:
+      entries.erase(event.path);
+      erase_subtree(event.path);
+      break;
+    case FileEventType::Renamed: {
+      // Carry a renamed directory's subtree over instead of scanning it again
+      std::vector<std::pair<std::string, SnapshotEntry>> moved;
+      for (auto it = entries.upper_bound(event.old_path);
+           it != entries.end() && it->first.compare(0, event.old_path.size(), event.old_path) == 0;) {
+        if (is_path_under(it->first, event.old_path)) {
+          moved.emplace_back(event.path + it->first.substr(event.old_path.size()), it->second);
+          it = entries.erase(it);
+        } else {
+          ++it;
+        }
+      }
+      entries.erase(event.old_path);
+      entries.insert(moved.begin(), moved.end());
+      refresh(event.path);
+
+      std::string old_parent = parent_path_of(event.old_path);
+      if (entries.find(old_parent) != entries.end()) {
+        refresh(old_parent);
+      }
+      break;
+    }
+  }
+
+  // Structural changes bump the parent's mtime; record it so the next resync doesn't list it for nothing
+  std::string parent = parent_path_of(event.path);
+  if (event.type != FileEventType::Modified && entries.find(parent) != entries.end()) {
+    refresh(parent);
+  }
+}
+
+bool DirectorySnapshot::is_directory(const std::string& path) const {
+  auto it = entries.find(path);
+  return it != entries.end() && it->second.is_directory;
+}
+
+std::vector<std::string> DirectorySnapshot::get_directories() const {
+  std::vector<std::string> directories;
+  for (const auto& [path, entry] : entries) {
+    if (entry.is_directory) {
+      directories.push_back(path);
+    }
+  }
+  return directories;
+}
+
+size_t DirectorySnapshot::size() const { return entries.size(); }
+
+void DirectorySnapshot::clear() {
+  entries.clear();
+  root.clear();
+}
+
+void DirectorySnapshot::erase_subtree(const std::string& directory) {
+  for (auto it = entries.upper_bound(directory);
+       it != entries.end() && it->first.compare(0, directory.size(), directory) == 0;) {
+    if (is_path_under(it->first, directory)) {
+      it = entries.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+void DirectorySnapshot::refresh(const std::string& path) {
+  std::error_code ec;
+  SnapshotEntry entry;
+  if (read_entry(fs::directory_entry(path, ec), entry)) {
+    entries[path] = entry;
+  } else {
+    entries.erase(path);
+    erase_subtree(path);
+  }
+}
+
+std::vector<std::string> select_resync_subtrees(const std::string& root, const RecentDirectories& recent_directories,
+                                                std::chrono::steady_clock::time_point now,
+                                                std::chrono::milliseconds window, size_t max_subtrees) {
+  std::vector<std::string> subtrees;
+  for (const auto& [directory, last_activity] : recent_directories) {
+    if (now - last_activity <= window) {
+      subtrees.push_back(directory);
+    }
+  }
+
+  // Keep only the outermost directories; the subtree resync covers the rest
+  std::sort(subtrees.begin(), subtrees.end());
+  subtrees.erase(std::unique(subtrees.begin(), subtrees.end()), subtrees.end());
+  std::vector<std::string> outermost;
+  for (const auto& directory : subtrees) {
+    if (outermost.empty() || !is_path_under(directory, outermost.back())) {
+      outermost.push_back(directory);
+    }
+  }
+
+  // Nothing to go on, or too scattered to be worth it: fall back to the whole tree
+  if (outermost.empty() || outermost.size() > max_subtrees) {
+    return {root};
+  }
+  return outermost;
+}
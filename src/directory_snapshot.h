@@ -0,0 +1,76 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "event_filter.h"
+#include "file_watcher.h"
+
+// Recorded state of one path
+struct SnapshotEntry {
+  uint64_t size = 0;
+  int64_t last_write_time = 0;  // Raw file_time_type ticks, only compared for equality
+  bool is_directory = false;
+};
+
+// A difference between the recorded state and what is on disk, expressed as a raw watcher event
+struct SnapshotChange {
+  FileEventType type;
+  std::string path;
+  bool is_directory;
+};
+
+// Size/mtime snapshot of a watched tree, used to recover after the OS dropped notifications.
+// Kept up to date with the events the watcher delivers, so a resync only reports what was actually lost.
+class DirectorySnapshot {
+ public:
+  // Leave out paths the filter rejects, so a resync never reports them. Set before capture(); may be null.
+  void set_filter(const EventFilter* filter);
+
+  // Record every entry below root, root included
+  void capture(const std::string& root);
+
+  // Re-stat every entry of a subtree, record the new state and return what changed
+  std::vector<SnapshotChange> resync_subtree(const std::string& directory);
+
+  // Cheap pass over the rest of the tree: only directories whose own mtime changed are listed again.
+  // Creates, deletes and renames always touch the parent directory, so they are caught here;
+  // in-place modifications are only caught inside the subtrees passed to resync_subtree().
+  std::vector<SnapshotChange> resync_changed_directories(const std::vector<std::string>& skip_subtrees);
+
+  // Recover from dropped notifications: re-stat `subtrees` in full and list the changed directories elsewhere
+  std::vector<SnapshotChange> resync(const std::vector<std::string>& subtrees);
+
+  // Keep the recorded state in line with an event that was delivered to the callback
+  void apply(const FileEvent& event);
+
+  bool is_directory(const std::string& path) const;
+  std::vector<std::string> get_directories() const;
+  size_t size() const;
+  void clear();
+
+ private:
+  // Ordered so that a subtree is a contiguous range of keys
+  std::map<std::string, SnapshotEntry> entries;
+  std::string root;
+  const EventFilter* filter = nullptr;
+
+  bool is_excluded(const std::string& path, bool is_directory) const;
+  std::map<std::string, SnapshotEntry> scan(const std::string& directory) const;
+  void erase_subtree(const std::string& directory);
+  void refresh(const std::string& path);
+  void list_directory(const std::string& directory, std::vector<SnapshotChange>& changes);
+};
+
+// Directories that saw events, with when they last did, oldest first
+using RecentDirectories = std::deque<std::pair<std::string, std::chrono::steady_clock::time_point>>;
+
+// Pick the subtrees an overflow resync re-stats in full: the outermost of the directories active within `window`
+// of `now`. Falls back to the whole root when there is nothing to go on, or more than `max_subtrees` are left.
+std::vector<std::string> select_resync_subtrees(const std::string& root, const RecentDirectories& recent_directories,
+                                                std::chrono::steady_clock::time_point now,
+                                                std::chrono::milliseconds window, size_t max_subtrees);
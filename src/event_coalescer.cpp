@@ -0,0 +1,454 @@
+#include "event_coalescer.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "path_utils.h"
+
+static size_t path_depth(const std::string& path) {
+  return static_cast<size_t>(std::count_if(path.begin(), path.end(), is_path_separator));
+}
+
+static bool is_directory_operation(FileEventType type, bool is_directory) {
+  return is_directory || type == FileEventType::DirectoryCreated || type == FileEventType::DirectoryDeleted;
+}
+
+EventCoalescer::EventCoalescer(std::chrono::milliseconds timeout) : debounce_timeout(timeout), next_sequence(0) {}
+
+void EventCoalescer::add_known_directory(const std::string& path) { known_directories.insert(path); }
+
+bool EventCoalescer::is_known_directory(const std::string& path) const { return known_directories.count(path) > 0; }
+
+void EventCoalescer::push(FileEventType type, const std::string& path, const std::string& old_path, bool is_directory,
+                          Clock::time_point now) {
+  stats.events_received++;
+
+  if (type == FileEventType::Renamed) {
+    push_rename(path, old_path, is_directory, now);
+    return;
+  }
+
+  if (type == FileEventType::Deleted || type == FileEventType::DirectoryDeleted) {
+    if (type == FileEventType::DirectoryDeleted) {
+      known_directories.insert(path);
+    }
+    push_deletion(path, now);
+    return;
+  }
+
+  // Directories report a modification whenever their contents change; the children carry the real events
+  if (type == FileEventType::Modified && is_known_directory(path)) {
+    stats.events_subsumed++;
+    return;
+  }
+
+  touch_ancestors(path, now);
+
+  // A directory that is about to be scanned as a whole already covers this event
+  if (find_pending_new_directory(path) != nullptr) {
+    if (type == FileEventType::DirectoryCreated) {
+      known_directories.insert(path);
+    }
+    stats.events_subsumed++;
+    return;
+  }
+
+  if (type == FileEventType::DirectoryCreated) {
+    known_directories.insert(path);
+    drop_subtree(path, now);
+
+    auto it = pending_events.find(path);
+    if (it == pending_events.end()) {
+      insert_entry(path, FileEventType::DirectoryCreated, "", true, now);
+    } else {
+      // Whatever was there before gets replaced by a fresh scan of the new directory
+      it->second.type = FileEventType::DirectoryCreated;
+      it->second.old_path.clear();
+      it->second.is_directory = true;
+      it->second.last_activity = now;
+    }
+    return;
+  }
+
+  // Created or Modified on a file
+  auto it = pending_events.find(path);
+  if (it == pending_events.end()) {
+    insert_entry(path, type, "", false, now);
+    return;
+  }
+
+  PendingEntry& entry = it->second;
+  switch (entry.type) {
+    case FileEventType::Created:
+    case FileEventType::Modified:
+    case FileEventType::Renamed:
+      // The pending event already makes the consumer re-read the file
+      entry.last_activity = now;
+      break;
+    case FileEventType::Deleted:
+      // Deleted and created again, typically an editor's atomic save
+      entry.type = FileEventType::Modified;
+      entry.last_activity = now;
+      stats.events_cancelled++;
+      break;
+    case FileEventType::DirectoryCreated:
+    case FileEventType::DirectoryDeleted:
+      // A directory replaced by a file can't be expressed as one event
+      force_flush(path);
+      insert_entry(path, type, "", false, now);
+      break;
+  }
+}
+
+void EventCoalescer::push_deletion(const std::string& path, Clock::time_point now) {
+  touch_ancestors(path, now);
+
+  if (find_pending_new_directory(path) != nullptr) {
+    // Never reached the consumer, the pending scan will simply not find it
+    known_directories.erase(path);
+    stats.events_subsumed++;
+    return;
+  }
+
+  // A path with pending children is a directory even if we never saw it being created
+  bool is_directory = is_known_directory(path);
+  if (!is_directory) {
+    auto child = pending_events.upper_bound(path);
+    is_directory = child != pending_events.end() && is_path_under(child->first, path);
+  }
+
+  if (is_directory) {
+    drop_subtree(path, now);
+    auto dir = known_directories.lower_bound(path);
+    while (dir != known_directories.end() && dir->compare(0, path.size(), path) == 0) {
+      if (*dir == path || is_path_under(*dir, path)) {
+        dir = known_directories.erase(dir);
+      } else {
+        ++dir;
+      }
+    }
+  }
+
+  FileEventType deleted_type = is_directory ? FileEventType::DirectoryDeleted : FileEventType::Deleted;
+
+  auto it = pending_events.find(path);
+  if (it == pending_events.end()) {
+    insert_entry(path, deleted_type, "", is_directory, now);
+    return;
+  }
+
+  PendingEntry& entry = it->second;
+  switch (entry.type) {
+    case FileEventType::Created:
+    case FileEventType::DirectoryCreated:
+      // Created and deleted within the debounce window
+      pending_events.erase(it);
+      stats.events_cancelled++;
+      break;
+    case FileEventType::Renamed: {
+      // A -> B then B deleted is just A deleted
+      std::string old_path = entry.old_path;
+      bool was_directory = entry.is_directory;
+      pending_events.erase(it);
+      stats.events_cancelled++;
+      if (was_directory) {
+        known_directories.insert(old_path);
+      }
+      push_deletion(old_path, now);
+      break;
+    }
+    case FileEventType::Modified:
+    case FileEventType::Deleted:
+    case FileEventType::DirectoryDeleted:
+      entry.type = deleted_type;
+      entry.is_directory = is_directory;
+      entry.last_activity = now;
+      break;
+  }
+}
+
+void EventCoalescer::push_rename(const std::string& path, const std::string& old_path, bool is_directory,
+                                 Clock::time_point now) {
+  is_directory = is_directory || is_known_directory(old_path);
+
+  touch_ancestors(path, now);
+  touch_ancestors(old_path, now);
+
+  bool target_is_new = find_pending_new_directory(path) != nullptr;
+  bool source_is_new = find_pending_new_directory(old_path) != nullptr;
+
+  if (target_is_new) {
+    // Moved into a directory that will be scanned anyway, only the source needs to go away
+    stats.events_subsumed++;
+    if (!source_is_new) {
+      push_deletion(old_path, now);
+    }
+    if (is_directory) {
+      known_directories.insert(path);
+    }
+    return;
+  }
+
+  if (source_is_new) {
+    // The source was never reported, so for the consumer this is a plain creation
+    stats.events_subsumed++;
+    if (is_directory) {
+      known_directories.insert(path);
+      drop_subtree(path, now);
+      insert_entry(path, FileEventType::DirectoryCreated, "", true, now);
+    } else {
+      pending_events.erase(path);
+      insert_entry(path, FileEventType::Created, "", false, now);
+    }
+    return;
+  }
+
+  // Work out the net event for the new path from what was pending on the old one
+  bool emit = true;
+  FileEventType net_type = FileEventType::Renamed;
+  std::string net_old_path = old_path;
+
+  auto source = pending_events.find(old_path);
+  if (source != pending_events.end()) {
+    const PendingEntry& entry = source->second;
+    switch (entry.type) {
+      case FileEventType::Created:
+      case FileEventType::DirectoryCreated:
+        net_type = entry.type;
+        net_old_path.clear();
+        break;
+      case FileEventType::Renamed:
+        if (entry.old_path == path) {
+          // Renamed back to where it started
+          emit = !is_directory;
+          net_type = FileEventType::Modified;
+          net_old_path.clear();
+        } else {
+          net_old_path = entry.old_path;
+        }
+        break;
+      case FileEventType::Modified:
+      case FileEventType::Deleted:
+      case FileEventType::DirectoryDeleted:
+        break;
+    }
+    pending_events.erase(source);
+    stats.events_cancelled++;
+  }
+
+  if (is_directory) {
+    rekey_subtree(old_path, path);
+  }
+
+  auto target = pending_events.find(path);
+  if (target != pending_events.end()) {
+    // Whatever was pending on the target is overwritten by the rename
+    if (target->second.type == FileEventType::Renamed && target->second.old_path != old_path) {
+      std::string overwritten = target->second.old_path;
+      pending_events.erase(target);
+      push_deletion(overwritten, now);
+    } else {
+      pending_events.erase(target);
+    }
+    stats.events_cancelled++;
+  }
+
+  if (emit) {
+    insert_entry(path, net_type, net_old_path, is_directory, now);
+  } else {
+    stats.events_cancelled++;
+  }
+}
+
+void EventCoalescer::insert_entry(const std::string& path, FileEventType type, const std::string& old_path,
+                                  bool is_directory, Clock::time_point now) {
+  PendingEntry entry;
+  entry.type = type;
+  entry.old_path = old_path;
+  entry.is_directory = is_directory;
+  entry.sequence = next_sequence++;
+  entry.last_activity = now;
+  pending_events[path] = std::move(entry);
+}
+
+void EventCoalescer::force_flush(const std::string& path) {
+  auto it = pending_events.find(path);
+  if (it == pending_events.end()) return;
+
+  forced_events.push_back(make_event(it->first, it->second));
+  pending_events.erase(it);
+}
+
+void EventCoalescer::drop_subtree(const std::string& directory, Clock::time_point now) {
+  std::vector<std::string> moved_in_from;
+
+  auto it = pending_events.upper_bound(directory);
+  while (it != pending_events.end() && it->first.compare(0, directory.size(), directory) == 0) {
+    if (!is_path_under(it->first, directory)) {
+      ++it;
+      continue;
+    }
+    // Something moved into the subtree from outside still has to disappear from its old place
+    if (it->second.type == FileEventType::Renamed && !is_path_under(it->second.old_path, directory)) {
+      if (it->second.is_directory) {
+        known_directories.insert(it->second.old_path);
+      }
+      moved_in_from.push_back(it->second.old_path);
+    }
+    it = pending_events.erase(it);
+    stats.events_subsumed++;
+  }
+
+  for (const auto& old_path : moved_in_from) {
+    push_deletion(old_path, now);
+  }
+}
+
+void EventCoalescer::rekey_subtree(const std::string& old_directory, const std::string& new_directory) {
+  auto rebase = [&](const std::string& path) { return new_directory + path.substr(old_directory.size()); };
+
+  // Pending entries inside the directory move along with it
+  std::vector<std::pair<std::string, PendingEntry>> moved;
+  auto it = pending_events.upper_bound(old_directory);
+  while (it != pending_events.end() && it->first.compare(0, old_directory.size(), old_directory) == 0) {
+    if (is_path_under(it->first, old_directory)) {
+      moved.emplace_back(rebase(it->first), std::move(it->second));
+      it = pending_events.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  for (auto& [path, entry] : moved) {
+    pending_events[path] = std::move(entry);
+  }
+
+  // Renames out of the directory refer to where the consumer will find the file once the move is applied
+  for (auto& [path, entry] : pending_events) {
+    if (entry.type == FileEventType::Renamed && is_path_under(entry.old_path, old_directory)) {
+      entry.old_path = rebase(entry.old_path);
+    }
+  }
+
+  std::vector<std::string> moved_directories;
+  auto dir = known_directories.lower_bound(old_directory);
+  while (dir != known_directories.end() && dir->compare(0, old_directory.size(), old_directory) == 0) {
+    if (*dir == old_directory || is_path_under(*dir, old_directory)) {
+      moved_directories.push_back(rebase(*dir));
+      dir = known_directories.erase(dir);
+    } else {
+      ++dir;
+    }
+  }
+  known_directories.insert(moved_directories.begin(), moved_directories.end());
+}
+
+void EventCoalescer::touch_ancestors(const std::string& path, Clock::time_point now) {
+  for (std::string ancestor = parent_path_of(path); !ancestor.empty(); ancestor = parent_path_of(ancestor)) {
+    auto it = pending_events.find(ancestor);
+    if (it != pending_events.end()) {
+      it->second.last_activity = std::max(it->second.last_activity, now);
+    }
+  }
+}
+
+bool EventCoalescer::has_pending_ancestor(const std::string& path, Clock::time_point now) const {
+  for (std::string ancestor = parent_path_of(path); !ancestor.empty(); ancestor = parent_path_of(ancestor)) {
+    auto it = pending_events.find(ancestor);
+    if (it != pending_events.end() && !is_ready(it->second, now)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+const std::string* EventCoalescer::find_pending_new_directory(const std::string& path) const {
+  for (std::string ancestor = parent_path_of(path); !ancestor.empty(); ancestor = parent_path_of(ancestor)) {
+    auto it = pending_events.find(ancestor);
+    if (it != pending_events.end() && it->second.type == FileEventType::DirectoryCreated) {
+      return &it->first;
+    }
+  }
+  return nullptr;
+}
+
+bool EventCoalescer::is_ready(const PendingEntry& entry, Clock::time_point now) const {
+  return now - entry.last_activity >= debounce_timeout;
+}
+
+FileEvent EventCoalescer::make_event(const std::string& path, const PendingEntry& entry) const {
+  return FileEvent(entry.type, path, entry.old_path);
+}
+
+std::vector<FileEvent> EventCoalescer::flush_ready(Clock::time_point now) { return flush(now, false); }
+
+std::vector<FileEvent> EventCoalescer::flush_all() { return flush(Clock::now(), true); }
+
+std::vector<FileEvent> EventCoalescer::flush(Clock::time_point now, bool force) {
+  std::vector<FileEvent> events = std::move(forced_events);
+  forced_events.clear();
+
+  std::vector<std::map<std::string, PendingEntry>::iterator> batch;
+  for (auto it = pending_events.begin(); it != pending_events.end(); ++it) {
+    const PendingEntry& entry = it->second;
+    if (force) {
+      batch.push_back(it);
+      continue;
+    }
+    if (!is_ready(entry, now)) continue;
+    if (has_pending_ancestor(it->first, now)) continue;
+    if (entry.type == FileEventType::Renamed && has_pending_ancestor(entry.old_path, now)) continue;
+    batch.push_back(it);
+  }
+
+  // Directory operations go first, parents before children, so that the consumer has already moved or
+  // removed a subtree by the time the events inside it arrive
+  std::sort(batch.begin(), batch.end(), [](const auto& a, const auto& b) {
+    bool a_dir = is_directory_operation(a->second.type, a->second.is_directory);
+    bool b_dir = is_directory_operation(b->second.type, b->second.is_directory);
+    if (a_dir != b_dir) return a_dir;
+    if (a_dir) {
+      size_t a_depth = path_depth(a->first);
+      size_t b_depth = path_depth(b->first);
+      if (a_depth != b_depth) return a_depth < b_depth;
+    }
+    return a->second.sequence < b->second.sequence;
+  });
+
+  for (auto it : batch) {
+    events.push_back(make_event(it->first, it->second));
+    pending_events.erase(it);
+  }
+
+  stats.events_emitted += events.size();
+  return events;
+}
+
+void EventCoalescer::clear() {
+  pending_events.clear();
+  forced_events.clear();
+}
+
+EventCoalescer::Clock::time_point EventCoalescer::next_deadline(Clock::time_point now) const {
+  if (!forced_events.empty()) {
+    return now;
+  }
+  if (pending_events.empty()) {
+    return Clock::time_point::max();
+  }
+
+  // Entries that are already due but still pending are held by an ancestor, whose own deadline is later
+  Clock::time_point deadline = Clock::time_point::max();
+  for (const auto& [path, entry] : pending_events) {
+    Clock::time_point entry_deadline = entry.last_activity + debounce_timeout;
+    if (entry_deadline > now && entry_deadline < deadline) {
+      deadline = entry_deadline;
+    }
+  }
+  return deadline == Clock::time_point::max() ? now + debounce_timeout : deadline;
+}
+
+bool EventCoalescer::empty() const { return pending_events.empty() && forced_events.empty(); }
+
+size_t EventCoalescer::pending_count() const { return pending_events.size() + forced_events.size(); }
+
+const CoalescerStats& EventCoalescer::get_stats() const { return stats; }
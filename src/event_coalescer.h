@@ -0,0 +1,93 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "file_watcher.h"
+
+// Counters describing how much work the coalescer saved downstream
+struct CoalescerStats {
+  uint64_t events_received = 0;   // Raw events pushed by the OS backend
+  uint64_t events_emitted = 0;    // Net events handed to the callback
+  uint64_t events_cancelled = 0;  // Pairs that cancelled out (e.g. created then deleted)
+  uint64_t events_subsumed = 0;   // Events folded into a directory-level operation
+};
+
+// Reduces the raw event stream of a watched tree to the minimal net change per path.
+//
+// Rules applied per path:
+//   Created + Modified*      -> Created
+//   Created + Deleted        -> (nothing)
+//   Deleted + Created        -> Modified
+//   A -> B -> C              -> Renamed(C, old A)
+//   Created(A) + A -> B      -> Created(B)
+// Directory-level rules:
+//   DirectoryDeleted(D) drops every pending event under D; the consumer removes the subtree at once.
+//   DirectoryCreated(D) swallows every later event under D; the consumer scans the subtree once it settles.
+//   Renamed(D) moves the pending events under D along with it and is emitted before them.
+//
+// Events are emitted once their path has been idle for the debounce timeout. An entry is held back while
+// a pending directory operation above it (or above the path it was renamed from) has not settled yet.
+// Not thread-safe; the owner serializes access.
+class EventCoalescer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit EventCoalescer(std::chrono::milliseconds debounce_timeout = std::chrono::milliseconds(500));
+
+  // Register a directory that already exists, so a later plain Deleted on it becomes a subtree delete
+  void add_known_directory(const std::string& path);
+  bool is_known_directory(const std::string& path) const;
+
+  // Feed one raw event from the OS backend. `is_directory` is only consulted for renames.
+  void push(FileEventType type, const std::string& path, const std::string& old_path = "",
+            bool is_directory = false, Clock::time_point now = Clock::now());
+
+  // Net events whose debounce has expired, directory operations first
+  std::vector<FileEvent> flush_ready(Clock::time_point now = Clock::now());
+
+  // Net events for everything still pending, regardless of the debounce
+  std::vector<FileEvent> flush_all();
+
+  // When to call flush_ready() next, given that it was just called at `now`; time_point::max() when idle
+  Clock::time_point next_deadline(Clock::time_point now) const;
+
+  void clear();
+  bool empty() const;
+  size_t pending_count() const;
+  const CoalescerStats& get_stats() const;
+
+ private:
+  struct PendingEntry {
+    FileEventType type;
+    std::string old_path;  // Only meaningful for Renamed
+    bool is_directory;
+    uint64_t sequence;  // Order in which the entry was first seen
+    Clock::time_point last_activity;
+  };
+
+  // Ordered so that a subtree is a contiguous range of keys
+  std::map<std::string, PendingEntry> pending_events;
+  std::set<std::string> known_directories;
+  std::vector<FileEvent> forced_events;  // Entries that could not be merged and were emitted early
+  std::chrono::milliseconds debounce_timeout;
+  uint64_t next_sequence;
+  CoalescerStats stats;
+
+  std::vector<FileEvent> flush(Clock::time_point now, bool force);
+  void push_deletion(const std::string& path, Clock::time_point now);
+  void push_rename(const std::string& path, const std::string& old_path, bool is_directory, Clock::time_point now);
+  void insert_entry(const std::string& path, FileEventType type, const std::string& old_path, bool is_directory,
+                    Clock::time_point now);
+  void force_flush(const std::string& path);
+  void drop_subtree(const std::string& directory, Clock::time_point now);
+  void rekey_subtree(const std::string& old_directory, const std::string& new_directory);
+  void touch_ancestors(const std::string& path, Clock::time_point now);
+  bool has_pending_ancestor(const std::string& path, Clock::time_point now) const;
+  const std::string* find_pending_new_directory(const std::string& path) const;
+  bool is_ready(const PendingEntry& entry, Clock::time_point now) const;
+  FileEvent make_event(const std::string& path, const PendingEntry& entry) const;
+};
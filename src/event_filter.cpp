@@ -0,0 +1,226 @@
+#include "event_filter.h"
+
+// Separators are folded to '/' and ASCII letters to lowercase before comparing
+static char fold(char c) {
+  if (c == '\\') return '/';
+  if (c >= 'A' && c <= 'Z') return static_cast<char>(c - 'A' + 'a');
+  return c;
+}
+
+static std::string fold_string(const std::string& text) {
+  std::string result(text);
+  for (char& c : result) {
+    c = fold(c);
+  }
+  return result;
+}
+
+static bool equals_folded(const char* text, const std::string& literal) {
+  for (size_t i = 0; i < literal.size(); i++) {
+    if (fold(text[i]) != literal[i]) return false;
+  }
+  return true;
+}
+
+// Glob match of [p, pe) against [s, se). '*' and '?' never match a separator, '**' matches anything and
+// "**/" also matches zero directories.
+static bool match_glob(const char* p, const char* pe, const char* s, const char* se) {
+  while (p < pe) {
+    if (*p == '*') {
+      if (p + 1 < pe && p[1] == '*') {
+        p += 2;
+        if (p < pe && *p == '/' && match_glob(p + 1, pe, s, se)) {
+          return true;
+        }
+        for (const char* t = s;; ++t) {
+          if (match_glob(p, pe, t, se)) return true;
+          if (t == se) return false;
+        }
+      }
+
+      ++p;
+      for (const char* t = s;; ++t) {
+        if (match_glob(p, pe, t, se)) return true;
+        if (t == se || fold(*t) == '/') return false;
+      }
+    }
+
+    if (s == se) return false;
+    char c = fold(*s);
+    if (*p == '?' ? c == '/' : *p != c) return false;
+    ++p;
+    ++s;
+  }
+  return s == se;
+}
+
+static bool has_wildcard(const std::string& text) { return text.find_first_of("*?") != std::string::npos; }
+
+void EventFilter::set_extensions(const std::vector<std::string>& new_extensions) {
+  extensions.clear();
+  for (const auto& extension : new_extensions) {
+    if (extension.empty()) continue;
+    extensions.push_back(fold_string(extension[0] == '.' ? extension : "." + extension));
+  }
+}
+
+bool EventFilter::add_ignore_pattern(const std::string& pattern) {
+  std::string glob = fold_string(pattern);
+  while (!glob.empty() && glob[0] == '/') {
+    glob.erase(0, 1);  // Patterns are anchored at the root anyway
+  }
+  if (glob.empty()) {
+    return false;
+  }
+
+  CompiledRule rule;
+  rule.pattern = pattern;
+  rule.match_components = glob.find('/') == std::string::npos;
+  rule.kind = MatchKind::Glob;
+
+  // Most rules are a plain name, prefix or suffix; those skip the glob matcher
+  if (rule.match_components) {
+    if (!has_wildcard(glob)) {
+      rule.kind = MatchKind::Exact;
+    } else if (glob.size() > 1 && glob.front() == '*' && !has_wildcard(glob.substr(1))) {
+      rule.kind = MatchKind::Suffix;
+      glob.erase(0, 1);
+    } else if (glob.size() > 1 && glob.back() == '*' && !has_wildcard(glob.substr(0, glob.size() - 1))) {
+      rule.kind = MatchKind::Prefix;
+      glob.pop_back();
+    }
+  } else if (glob.size() > 3 && glob.compare(glob.size() - 3, 3, "/**") == 0) {
+    rule.self_glob = glob.substr(0, glob.size() - 3);
+  }
+  rule.glob = glob;
+
+  rules.push_back(rule);
+  rule_hits.emplace_back(0);
+  return true;
+}
+
+void EventFilter::clear() {
+  rules.clear();
+  rule_hits.clear();
+  extensions.clear();
+  extension_hits = 0;
+}
+
+bool EventFilter::empty() const { return rules.empty() && extensions.empty(); }
+
+bool EventFilter::matches_component(const CompiledRule& rule, const char* begin, const char* end) {
+  size_t length = static_cast<size_t>(end - begin);
+  switch (rule.kind) {
+    case MatchKind::Exact:
+      return length == rule.glob.size() && equals_folded(begin, rule.glob);
+    case MatchKind::Prefix:
+      return length >= rule.glob.size() && equals_folded(begin, rule.glob);
+    case MatchKind::Suffix:
+      return length >= rule.glob.size() && equals_folded(end - rule.glob.size(), rule.glob);
+    case MatchKind::Glob:
+      break;
+  }
+  return match_glob(rule.glob.data(), rule.glob.data() + rule.glob.size(), begin, end);
+}
+
+int EventFilter::find_matching_rule(const std::string& relative_path) const {
+  const char* begin = relative_path.data();
+  const char* end = begin + relative_path.size();
+
+  for (size_t i = 0; i < rules.size(); i++) {
+    const CompiledRule& rule = rules[i];
+
+    if (rule.match_components) {
+      const char* component = begin;
+      for (const char* c = begin;; ++c) {
+        if (c == end || *c == '/' || *c == '\\') {
+          if (c > component && matches_component(rule, component, c)) {
+            return static_cast<int>(i);
+          }
+          if (c == end) break;
+          component = c + 1;
+        }
+      }
+      continue;
+    }
+
+    const char* glob = rule.glob.data();
+    if (match_glob(glob, glob + rule.glob.size(), begin, end)) {
+      return static_cast<int>(i);
+    }
+    if (!rule.self_glob.empty()) {
+      const char* self_glob = rule.self_glob.data();
+      if (match_glob(self_glob, self_glob + rule.self_glob.size(), begin, end)) {
+        return static_cast<int>(i);
+      }
+    }
+  }
+  return -1;
+}
+
+bool EventFilter::excludes(const std::string& relative_path, bool is_directory) const {
+  return find_matching_rule(relative_path) >= 0 || (!is_directory && !has_allowed_extension(relative_path));
+}
+
+bool EventFilter::is_ignored(const std::string& relative_path) const {
+  int rule = find_matching_rule(relative_path);
+  if (rule < 0) {
+    return false;
+  }
+  rule_hits[static_cast<size_t>(rule)].fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+bool EventFilter::has_allowed_extension(const std::string& path) const {
+  if (extensions.empty()) {
+    return true;
+  }
+
+  // Extension of the last component, dot included
+  size_t dot = path.find_last_of(".\\/");
+  if (dot == std::string::npos || path[dot] != '.') {
+    return false;
+  }
+  size_t length = path.size() - dot;
+  for (const auto& extension : extensions) {
+    if (extension.size() == length && equals_folded(path.data() + dot, extension)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool EventFilter::is_extension_allowed(const std::string& path) const {
+  if (has_allowed_extension(path)) {
+    return true;
+  }
+  extension_hits.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+bool EventFilter::accepts(const std::string& relative_path, bool is_directory) const {
+  return !is_ignored(relative_path) && (is_directory || is_extension_allowed(relative_path));
+}
+
+RenameFilterResult EventFilter::filter_rename(const std::string& old_relative_path,
+                                              const std::string& new_relative_path, bool is_directory) const {
+  // Only a dropped destination counts as a hit; an ignored source just turns the rename into a creation
+  bool new_accepted = accepts(new_relative_path, is_directory);
+  bool old_accepted = !excludes(old_relative_path, is_directory);
+
+  if (old_accepted && new_accepted) return RenameFilterResult::Keep;
+  if (new_accepted) return RenameFilterResult::AsCreated;
+  if (old_accepted) return RenameFilterResult::AsDeleted;
+  return RenameFilterResult::Drop;
+}
+
+std::vector<FilterRuleStats> EventFilter::get_stats() const {
+  std::vector<FilterRuleStats> stats;
+  for (size_t i = 0; i < rules.size(); i++) {
+    stats.push_back({rules[i].pattern, rule_hits[i].load(std::memory_order_relaxed)});
+  }
+  if (!extensions.empty()) {
+    stats.push_back({"extension allow-list", extension_hits.load(std::memory_order_relaxed)});
+  }
+  return stats;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+// Number of events a filter rule dropped
+struct FilterRuleStats {
+  std::string rule;
+  uint64_t hits;
+};
+
+// What to forward for a rename once both of its sides went through the filter
+enum class RenameFilterResult {
+  Keep,       // Both sides are of interest
+  AsCreated,  // Moved in from an ignored path: report the new path as created
+  AsDeleted,  // Moved out to an ignored path: report the old path as deleted
+  Drop        // Neither side is of interest
+};
+
+// Compiled extension allow-list and glob ignore rules, applied by the platform backends before an event
+// reaches the coalescer. Paths are relative to the watched root and may use either separator; matching
+// is case-insensitive.
+//
+// Ignore rules follow .gitignore conventions:
+//   *.tmp, ~*, .DS_Store   No '/': matched against every component, so it also ignores a directory's contents
+//   **/.git/**             With '/': matched against the whole relative path. '*' and '?' stop at separators,
+//                          '**' crosses them. A trailing '/**' also matches the directory itself.
+//
+// Configure before watching starts; matching is const and safe from any thread.
+class EventFilter {
+ public:
+  // Only files with one of these extensions (".png" or "png") get through. Empty allows everything.
+  // Directories are never rejected by extension.
+  void set_extensions(const std::vector<std::string>& extensions);
+
+  // Returns false for an empty pattern
+  bool add_ignore_pattern(const std::string& pattern);
+
+  void clear();
+  bool empty() const;
+
+  // Event checks; a rejection counts as a hit for the rule responsible
+  bool is_ignored(const std::string& relative_path) const;
+  bool is_extension_allowed(const std::string& path) const;
+  bool accepts(const std::string& relative_path, bool is_directory) const;
+  RenameFilterResult filter_rename(const std::string& old_relative_path, const std::string& new_relative_path,
+                                   bool is_directory) const;
+
+  // Same decision as accepts() for tree walks (watch registration, snapshots, scans); not counted
+  bool excludes(const std::string& relative_path, bool is_directory) const;
+
+  // Hits per ignore rule in the order they were added, followed by the extension allow-list
+  std::vector<FilterRuleStats> get_stats() const;
+
+ private:
+  enum class MatchKind {
+    Exact,   // "Thumbs.db"
+    Prefix,  // "~*"
+    Suffix,  // "*.tmp"
+    Glob     // Anything else
+  };
+
+  struct CompiledRule {
+    std::string pattern;  // As given, for stats
+    MatchKind kind;
+    bool match_components;  // No '/' in the pattern
+    std::string glob;       // Lowercased, '/' separators; only the literal part for Exact/Prefix/Suffix
+    std::string self_glob;  // For patterns ending in "/**": the directory itself
+  };
+
+  std::vector<CompiledRule> rules;
+  std::vector<std::string> extensions;  // Lowercased, with the leading dot
+
+  // Hit counters live in a deque so they can be atomic and still grow while rules are added
+  mutable std::deque<std::atomic<uint64_t>> rule_hits;
+  mutable std::atomic<uint64_t> extension_hits{0};
+
+  int find_matching_rule(const std::string& relative_path) const;
+  bool has_allowed_extension(const std::string& path) const;
+  static bool matches_component(const CompiledRule& rule, const char* begin, const char* end);
+};
@@ -0,0 +1,439 @@
+#include "event_trace.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "event_coalescer.h"
+
+// File layout: the magic, a format version and the debounce timeout, followed by records. Each record is a kind
+// byte, the varint microseconds since the previous record, a varint root id and the fields of its kind.
+static const char TRACE_MAGIC[8] = {'A', 'I', 'T', 'R', 'A', 'C', 'E', '\0'};
+static constexpr uint64_t TRACE_VERSION = 1;
+
+// Paths longer than this are treated as corruption rather than allocated
+static constexpr uint64_t MAX_TRACE_PATH_LENGTH = 64 * 1024;
+
+static void write_varint(std::ostream& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.put(static_cast<char>((value & 0x7F) | 0x80));
+    value >>= 7;
+  }
+  out.put(static_cast<char>(value));
+}
+
+static bool read_varint(std::istream& in, uint64_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    int byte = in.get();
+    if (byte == std::char_traits<char>::eof()) {
+      return false;
+    }
+    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// A path is stored as the length it shares with `previous` and the remaining suffix
+static void write_path(std::ostream& out, const std::string& path, const std::string& previous) {
+  size_t shared = 0;
+  size_t limit = std::min(path.size(), previous.size());
+  while (shared < limit && path[shared] == previous[shared]) {
+    shared++;
+  }
+  write_varint(out, shared);
+  write_varint(out, path.size() - shared);
+  out.write(path.data() + shared, static_cast<std::streamsize>(path.size() - shared));
+}
+
+static bool read_path(std::istream& in, const std::string& previous, std::string& path) {
+  uint64_t shared = 0;
+  uint64_t suffix_length = 0;
+  if (!read_varint(in, shared) || !read_varint(in, suffix_length) || shared > previous.size() ||
+      suffix_length > MAX_TRACE_PATH_LENGTH) {
+    return false;
+  }
+  std::string suffix(static_cast<size_t>(suffix_length), '\0');
+  if (suffix_length > 0 && !in.read(&suffix[0], static_cast<std::streamsize>(suffix_length))) {
+    return false;
+  }
+  path = previous.substr(0, static_cast<size_t>(shared)) + suffix;
+  return true;
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+// EventTraceWriter
+
+EventTraceWriter::EventTraceWriter() : last_offset(0), record_count(0) {}
+
+EventTraceWriter::~EventTraceWriter() { close(); }
+
+bool EventTraceWriter::open(const std::string& file_path, std::chrono::milliseconds debounce_timeout) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (file.is_open()) {
+    file.close();
+  }
+  file.open(std::filesystem::u8path(file_path), std::ios::binary | std::ios::trunc);
+  if (!file) {
+    std::cerr << "Failed to open event trace for writing: " << file_path << '\n';
+    return false;
+  }
+
+  file.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+  write_varint(file, TRACE_VERSION);
+  write_varint(file, static_cast<uint64_t>(debounce_timeout.count()));
+  start_time = Clock::now();
+  last_offset = std::chrono::microseconds(0);
+  last_path.clear();
+  record_count = 0;
+  return true;
+}
+
+void EventTraceWriter::close() {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (file.is_open()) {
+    file.close();
+  }
+}
+
+bool EventTraceWriter::is_open() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return file.is_open();
+}
+
+void EventTraceWriter::add_root(int root_id, const std::string& path, Clock::time_point now) {
+  TraceRecord record;
+  record.kind = TraceRecordKind::RootAdded;
+  record.root_id = root_id;
+  record.path = path;
+  write_record(record, now);
+}
+
+void EventTraceWriter::add_known_directory(int root_id, const std::string& path, Clock::time_point now) {
+  TraceRecord record;
+  record.kind = TraceRecordKind::KnownDirectory;
+  record.root_id = root_id;
+  record.path = path;
+  write_record(record, now);
+}
+
+void EventTraceWriter::record_event(int root_id, FileEventType type, const std::string& path,
+                                    const std::string& old_path, bool is_directory, Clock::time_point now) {
+  TraceRecord record;
+  record.kind = TraceRecordKind::Event;
+  record.root_id = root_id;
+  record.type = type;
+  record.is_directory = is_directory;
+  record.path = path;
+  record.old_path = old_path;
+  write_record(record, now);
+}
+
+void EventTraceWriter::record_overflow(int root_id, Clock::time_point now) {
+  TraceRecord record;
+  record.kind = TraceRecordKind::Overflow;
+  record.root_id = root_id;
+  write_record(record, now);
+}
+
+void EventTraceWriter::remove_root(int root_id, Clock::time_point now) {
+  TraceRecord record;
+  record.kind = TraceRecordKind::RootRemoved;
+  record.root_id = root_id;
+  write_record(record, now);
+}
+
+uint64_t EventTraceWriter::get_record_count() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return record_count;
+}
+
+void EventTraceWriter::write_record(const TraceRecord& record, Clock::time_point now) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!file.is_open()) {
+    return;
+  }
+
+  // Records from different threads may carry slightly out-of-order times; keep the stream monotonic
+  auto offset = std::chrono::duration_cast<std::chrono::microseconds>(now - start_time);
+  offset = std::max(offset, last_offset);
+
+  file.put(static_cast<char>(record.kind));
+  write_varint(file, static_cast<uint64_t>((offset - last_offset).count()));
+  write_varint(file, static_cast<uint64_t>(record.root_id));
+  switch (record.kind) {
+    case TraceRecordKind::RootAdded:
+    case TraceRecordKind::KnownDirectory:
+      write_path(file, record.path, last_path);
+      last_path = record.path;
+      break;
+    case TraceRecordKind::Event:
+      file.put(static_cast<char>(record.type));
+      file.put(record.is_directory ? 1 : 0);
+      write_path(file, record.path, last_path);
+      write_path(file, record.old_path, record.path);
+      last_path = record.path;
+      break;
+    case TraceRecordKind::Overflow:
+    case TraceRecordKind::RootRemoved:
+      break;
+  }
+
+  last_offset = offset;
+  record_count++;
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+// EventTraceReader
+
+EventTraceReader::EventTraceReader() : debounce_timeout(0), last_offset(0), error(false) {}
+
+bool EventTraceReader::open(const std::string& file_path) {
+  close();
+  file.open(std::filesystem::u8path(file_path), std::ios::binary);
+  if (!file) {
+    std::cerr << "Failed to open event trace: " << file_path << '\n';
+    return false;
+  }
+
+  char magic[sizeof(TRACE_MAGIC)];
+  uint64_t version = 0;
+  uint64_t debounce_ms = 0;
+  if (!file.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), TRACE_MAGIC)) {
+    return fail("Not an event trace: " + file_path);
+  }
+  if (!read_varint(file, version) || version != TRACE_VERSION) {
+    return fail("Unsupported event trace version in " + file_path);
+  }
+  if (!read_varint(file, debounce_ms)) {
+    return fail("Truncated event trace header in " + file_path);
+  }
+  debounce_timeout = std::chrono::milliseconds(debounce_ms);
+  return true;
+}
+
+void EventTraceReader::close() {
+  if (file.is_open()) {
+    file.close();
+  }
+  file.clear();
+  debounce_timeout = std::chrono::milliseconds(0);
+  last_offset = std::chrono::microseconds(0);
+  last_path.clear();
+  error = false;
+}
+
+bool EventTraceReader::next(TraceRecord& record) {
+  if (error || !file.is_open()) {
+    return false;
+  }
+
+  int kind = file.get();
+  if (kind == std::char_traits<char>::eof()) {
+    return false;
+  }
+  if (kind < static_cast<int>(TraceRecordKind::RootAdded) || kind > static_cast<int>(TraceRecordKind::RootRemoved)) {
+    return fail("Unknown event trace record kind " + std::to_string(kind));
+  }
+
+  uint64_t delta = 0;
+  uint64_t root_id = 0;
+  if (!read_varint(file, delta) || !read_varint(file, root_id)) {
+    return fail("Truncated event trace record");
+  }
+
+  record = TraceRecord();
+  record.kind = static_cast<TraceRecordKind>(kind);
+  record.offset = last_offset + std::chrono::microseconds(delta);
+  record.root_id = static_cast<int>(root_id);
+  switch (record.kind) {
+    case TraceRecordKind::RootAdded:
+    case TraceRecordKind::KnownDirectory:
+      if (!read_path(file, last_path, record.path)) {
+        return fail("Truncated event trace path");
+      }
+      last_path = record.path;
+      break;
+    case TraceRecordKind::Event: {
+      int type = file.get();
+      int is_directory = file.get();
+      if (type < static_cast<int>(FileEventType::Created) || type > static_cast<int>(FileEventType::DirectoryDeleted) ||
+          (is_directory != 0 && is_directory != 1)) {
+        return fail("Malformed event trace record");
+      }
+      record.type = static_cast<FileEventType>(type);
+      record.is_directory = is_directory == 1;
+      if (!read_path(file, last_path, record.path) || !read_path(file, record.path, record.old_path)) {
+        return fail("Truncated event trace path");
+      }
+      last_path = record.path;
+      break;
+    }
+    case TraceRecordKind::Overflow:
+    case TraceRecordKind::RootRemoved:
+      break;
+  }
+
+  last_offset = record.offset;
+  return true;
+}
+
+bool EventTraceReader::has_error() const { return error; }
+
+std::chrono::milliseconds EventTraceReader::get_debounce_timeout() const { return debounce_timeout; }
+
+bool EventTraceReader::fail(const std::string& message) {
+  std::cerr << message << '\n';
+  error = true;
+  return false;
+}
+
+// ---------------------------------------------------------------------------------------------------------------
+// EventTracePlayer
+
+EventTracePlayer::EventTracePlayer() : stop_requested(false) {}
+
+bool EventTracePlayer::replay(const std::string& file_path, ReplaySpeed speed, const FileEventCallback& callback) {
+  using Clock = std::chrono::steady_clock;
+
+  EventTraceReader reader;
+  if (!reader.open(file_path)) {
+    return false;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stats = ReplayStats();
+  }
+
+  // Trace time is mapped onto a virtual steady clock starting at `base`; at original speed the wall clock is
+  // kept `wall_start - base` behind it
+  const Clock::time_point base = Clock::now();
+  const Clock::time_point wall_start = base;
+  std::map<int, std::unique_ptr<EventCoalescer>> coalescers;
+  Clock::time_point now = base;
+
+  // Deliver whatever settled by `now`, exactly like FileWatcher::timer_loop, and return the next deadline
+  auto flush_at = [&](Clock::time_point flush_time) {
+    Clock::time_point deadline = Clock::time_point::max();
+    for (auto& [root_id, coalescer] : coalescers) {
+      std::vector<FileEvent> events = coalescer->flush_ready(flush_time);
+      for (auto& event : events) {
+        event.root_id = root_id;
+        auto callback_start = Clock::now();
+        if (callback) {
+          callback(event);
+        }
+        auto callback_time = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - callback_start);
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.delivered_events++;
+        stats.callback_time += callback_time;
+      }
+      deadline = std::min(deadline, coalescer->next_deadline(flush_time));
+    }
+    return deadline;
+  };
+
+  // Run every debounce deadline that falls before `until`
+  auto advance_to = [&](Clock::time_point until) {
+    Clock::time_point deadline = flush_at(now);
+    while (deadline != Clock::time_point::max() && deadline <= until && !stop_requested) {
+      now = std::max(now, deadline);
+      if (speed == ReplaySpeed::Original && !wait_until(wall_start + (now - base))) {
+        return false;
+      }
+      deadline = flush_at(now);
+    }
+    return !stop_requested;
+  };
+
+  const std::chrono::milliseconds debounce_timeout = reader.get_debounce_timeout();
+  TraceRecord record;
+  while (!stop_requested && reader.next(record)) {
+    Clock::time_point record_time = base + record.offset;
+    if (!advance_to(record_time)) {
+      break;
+    }
+    now = std::max(now, record_time);
+    if (speed == ReplaySpeed::Original && !wait_until(wall_start + (now - base))) {
+      break;
+    }
+
+    auto it = coalescers.find(record.root_id);
+    switch (record.kind) {
+      case TraceRecordKind::RootAdded:
+        coalescers[record.root_id] = std::make_unique<EventCoalescer>(debounce_timeout);
+        break;
+      case TraceRecordKind::KnownDirectory:
+        if (it != coalescers.end()) {
+          it->second->add_known_directory(record.path);
+        }
+        break;
+      case TraceRecordKind::Event:
+        if (it != coalescers.end()) {
+          it->second->push(record.type, record.path, record.old_path, record.is_directory, now);
+          std::lock_guard<std::mutex> lock(mutex);
+          stats.raw_events++;
+        }
+        break;
+      case TraceRecordKind::Overflow: {
+        std::lock_guard<std::mutex> lock(mutex);
+        stats.overflows++;
+        break;
+      }
+      case TraceRecordKind::RootRemoved:
+        if (it != coalescers.end()) {
+          coalescers.erase(it);
+        }
+        break;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.records++;
+    stats.trace_duration = record.offset;
+  }
+
+  // Let everything still pending settle
+  if (!stop_requested && !reader.has_error()) {
+    advance_to(Clock::time_point::max());
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  stats.wall_time = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - wall_start);
+  return !reader.has_error();
+}
+
+void EventTracePlayer::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop_requested = true;
+  }
+  stop_condition.notify_all();
+}
+
+ReplayStats EventTracePlayer::get_stats() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return stats;
+}
+
+bool EventTracePlayer::wait_until(std::chrono::steady_clock::time_point wall_time) {
+  std::unique_lock<std::mutex> lock(mutex);
+  stop_condition.wait_until(lock, wall_time, [this] { return stop_requested.load(); });
+  return !stop_requested;
+}
+
+bool parse_replay_speed(const std::string& text, ReplaySpeed& speed) {
+  if (text == "original") {
+    speed = ReplaySpeed::Original;
+  } else if (text == "max") {
+    speed = ReplaySpeed::Max;
+  } else {
+    return false;
+  }
+  return true;
+}
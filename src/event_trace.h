@@ -0,0 +1,130 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+#include "file_watcher.h"
+
+// Kinds of records in a trace file
+enum class TraceRecordKind : uint8_t { RootAdded = 1, KnownDirectory, Event, Overflow, RootRemoved };
+
+// One entry of a trace. Which fields are meaningful depends on the kind:
+//   RootAdded       root_id, path (the root directory)
+//   KnownDirectory  root_id, path (a directory that existed when the root was watched)
+//   Event           root_id, type, path, old_path, is_directory (a raw event as reported by the backend)
+//   Overflow        root_id
+//   RootRemoved     root_id
+struct TraceRecord {
+  TraceRecordKind kind = TraceRecordKind::Event;
+  std::chrono::microseconds offset{0};  // Time since the trace was opened
+  int root_id = 0;
+  FileEventType type = FileEventType::Modified;
+  bool is_directory = false;
+  std::string path;
+  std::string old_path;
+};
+
+// Appends the raw event stream of a FileWatcher to a compact binary file, so a storm (a VCS sync, a large
+// export) can be replayed later against the same code. Times are stored as varint deltas and every path
+// only stores the suffix it does not share with the previous one. Thread-safe.
+class EventTraceWriter {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  EventTraceWriter();
+  ~EventTraceWriter();
+
+  // `debounce_timeout` is stored in the header so the replay coalesces with the same timeout
+  bool open(const std::string& file_path, std::chrono::milliseconds debounce_timeout);
+  void close();
+  bool is_open() const;
+
+  void add_root(int root_id, const std::string& path, Clock::time_point now = Clock::now());
+  void add_known_directory(int root_id, const std::string& path, Clock::time_point now = Clock::now());
+  void record_event(int root_id, FileEventType type, const std::string& path, const std::string& old_path,
+                    bool is_directory, Clock::time_point now = Clock::now());
+  void record_overflow(int root_id, Clock::time_point now = Clock::now());
+  void remove_root(int root_id, Clock::time_point now = Clock::now());
+
+  uint64_t get_record_count() const;
+
+ private:
+  mutable std::mutex mutex;
+  std::ofstream file;
+  Clock::time_point start_time;
+  std::chrono::microseconds last_offset;
+  std::string last_path;
+  uint64_t record_count;
+
+  void write_record(const TraceRecord& record, Clock::time_point now);
+};
+
+// Reads a trace file written by EventTraceWriter, one record at a time
+class EventTraceReader {
+ public:
+  EventTraceReader();
+
+  bool open(const std::string& file_path);
+  void close();
+
+  // Returns false at the end of the trace or on a malformed record; has_error() tells them apart
+  bool next(TraceRecord& record);
+  bool has_error() const;
+
+  std::chrono::milliseconds get_debounce_timeout() const;
+
+ private:
+  std::ifstream file;
+  std::chrono::milliseconds debounce_timeout;
+  std::chrono::microseconds last_offset;
+  std::string last_path;
+  bool error;
+
+  bool fail(const std::string& message);
+};
+
+enum class ReplaySpeed {
+  Original,  // Sleep between records as long as they were apart when recorded
+  Max        // Run the debounce on a virtual clock, without sleeping
+};
+
+struct ReplayStats {
+  uint64_t records = 0;           // Records read from the trace
+  uint64_t raw_events = 0;        // Event records fed to the coalescers
+  uint64_t delivered_events = 0;  // Net events handed to the callback
+  uint64_t overflows = 0;         // Overflows seen while recording; they are counted, not resynced
+  std::chrono::microseconds trace_duration{0};  // Span of the recording
+  std::chrono::microseconds wall_time{0};       // How long the replay took
+  std::chrono::microseconds callback_time{0};   // Time spent inside the callback
+};
+
+// Feeds a trace through one EventCoalescer per root the way FileWatcher's timer thread does and delivers
+// the net events to a callback. Both speeds fire the debounce at the same trace times, so they deliver the
+// same events in the same order; only the pacing differs.
+class EventTracePlayer {
+ public:
+  EventTracePlayer();
+
+  // Blocks until the trace is exhausted or stop() is called. Returns false if the trace can't be read.
+  bool replay(const std::string& file_path, ReplaySpeed speed, const FileEventCallback& callback);
+
+  // Ends a running replay early, or makes the next one return right away; safe to call from any thread
+  void stop();
+
+  ReplayStats get_stats() const;
+
+ private:
+  mutable std::mutex mutex;
+  std::condition_variable stop_condition;
+  std::atomic<bool> stop_requested;
+  ReplayStats stats;
+
+  bool wait_until(std::chrono::steady_clock::time_point wall_time);
+};
+
+// Parses "original" or "max"
+bool parse_replay_speed(const std::string& text, ReplaySpeed& speed);
@@ -1,26 +1,79 @@
 #include "file_watcher.h"
 
+#include <algorithm>
+#include <filesystem>
 #include <iostream>
 
+#include "directory_snapshot.h"
+#include "event_coalescer.h"
+#include "event_trace.h"
+#include "path_utils.h"
+
 // Platform-specific factory functions
 #ifdef _WIN32
 std::unique_ptr<FileWatcherImpl> create_windows_file_watcher_impl();
+#elif defined(__linux__)
+std::unique_ptr<FileWatcherImpl> create_linux_file_watcher_impl();
 #else
-// For non-Windows platforms, we'll need to implement a different solution
-// For now, this will cause a compilation error on non-Windows
-#error "FileWatcher only supports Windows at this time"
+// For other platforms, we'll need to implement a different solution
+// For now, this will cause a compilation error on them
+#error "FileWatcher only supports Windows and Linux at this time"
 #endif
 
 std::unique_ptr<FileWatcherImpl> create_file_watcher_impl() {
 #ifdef _WIN32
   std::cout << "Using native Windows file watcher\n";
   return create_windows_file_watcher_impl();
+#elif defined(__linux__)
+  std::cout << "Using native Linux (inotify) file watcher\n";
+  return create_linux_file_watcher_impl();
 #else
   return nullptr;
 #endif
 }
 
-FileWatcher::FileWatcher() : p_impl(nullptr) {
+// State of one watched root. The coalescer, recent directories and resync flag are guarded by
+// FileWatcher::mutex; the snapshot is only touched from the timer thread once the root is watched.
+struct FileWatcher::WatchRoot {
+  int id;
+  std::string path;
+  EventFilter filter;
+  EventCoalescer coalescer;
+  DirectorySnapshot snapshot;
+
+  // Overflow recovery
+  RecentDirectories recent_directories;
+  bool resync_requested;
+  std::atomic<uint64_t> overflow_count;
+  std::atomic<uint64_t> resync_count;
+  std::atomic<uint64_t> resync_changes;
+
+  WatchRoot(const std::string& root_path, const WatchRootOptions& options)
+      : id(0),
+        path(root_path),
+        coalescer(std::chrono::milliseconds(DEBOUNCE_TIMEOUT_MS)),
+        resync_requested(false),
+        overflow_count(0),
+        resync_count(0),
+        resync_changes(0) {
+    filter.set_extensions(options.extensions);
+    for (const auto& pattern : options.ignore_patterns) {
+      if (!filter.add_ignore_pattern(pattern)) {
+        std::cerr << "Ignoring empty file watcher ignore pattern\n";
+      }
+    }
+    snapshot.set_filter(&filter);
+  }
+};
+
+FileWatcher::FileWatcher()
+    : p_impl(nullptr),
+      polling_interval(0),
+      is_watching_flag(false),
+      buffer_size(DEFAULT_BUFFER_SIZE),
+      next_root_id(1),
+      timer_should_stop(false),
+      timer_idle(false) {
   p_impl = create_file_watcher_impl();
   if (!p_impl) {
     std::cerr << "No file watcher implementation available\n";
@@ -29,29 +82,413 @@ FileWatcher::FileWatcher() : p_impl(nullptr) {
 
 FileWatcher::~FileWatcher() { stop_watching(); }
 
-bool FileWatcher::start_watching(const std::string& path, FileEventCallback callback) {
+bool FileWatcher::start_watching(const std::string& path, FileEventCallback cb) {
+  if (!start(cb)) {
+    return false;
+  }
+  if (add_root(path, default_options) < 0) {
+    stop_watching();
+    return false;
+  }
+  return true;
+}
+
+bool FileWatcher::start(FileEventCallback cb) {
   if (!p_impl) {
     std::cerr << "No file watcher implementation available\n";
     return false;
   }
+  if (is_watching_flag.load()) {
+    std::cerr << "File watcher is already running\n";
+    return false;
+  }
 
-  watched_path = path;
+  callback = cb;
+  p_impl->set_buffer_size(buffer_size);
+  bool started = p_impl->start(
+      [this](int root_id, FileEventType type, const std::string& event_path, const std::string& old_path,
+             bool is_directory) { on_raw_event(root_id, type, event_path, old_path, is_directory); },
+      [this](int root_id) { on_overflow(root_id); });
+  if (!started) {
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    timer_should_stop = false;
+    timer_idle = false;
+  }
   is_watching_flag = true;
+  timer_thread = std::thread(&FileWatcher::timer_loop, this);
+
+  // Watch the roots that were added before starting
+  std::vector<std::shared_ptr<WatchRoot>> added_roots;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& [id, root] : roots) {
+      added_roots.push_back(root);
+    }
+  }
+  for (const auto& root : added_roots) {
+    if (!watch_root(*root)) {
+      std::lock_guard<std::mutex> lock(mutex);
+      roots.erase(root->id);
+    }
+  }
+  return true;
+}
+
+int FileWatcher::add_root(const std::string& path, const WatchRootOptions& options) {
+  std::error_code ec;
+  if (!std::filesystem::is_directory(std::filesystem::u8path(path), ec)) {
+    std::cerr << "Cannot watch, not a directory: " << path << '\n';
+    return -1;
+  }
+
+  auto root = std::make_shared<WatchRoot>(path, options);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    root->id = next_root_id++;
+    roots[root->id] = root;
+  }
+
+  if (is_watching_flag.load() && !watch_root(*root)) {
+    std::lock_guard<std::mutex> lock(mutex);
+    roots.erase(root->id);
+    return -1;
+  }
+  return root->id;
+}
+
+bool FileWatcher::watch_root(WatchRoot& root) {
+  // Record the tree as it is now, minus what the filter drops. The snapshot is what an overflow resync is
+  // diffed against, and its directories let the coalescer report deleting one as a single subtree operation.
+  root.snapshot.capture(root.path);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (trace_writer) {
+      trace_writer->add_root(root.id, root.path);
+    }
+    for (const auto& directory : root.snapshot.get_directories()) {
+      root.coalescer.add_known_directory(directory);
+      if (trace_writer) {
+        trace_writer->add_known_directory(root.id, directory);
+      }
+    }
+  }
+  return p_impl->add_root(root.id, root.path, &root.filter);
+}
+
+bool FileWatcher::remove_root(int root_id) {
+  // The backend reads the root's filter until its remove_root() returns, so the root is kept alive until then
+  std::shared_ptr<WatchRoot> removed;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = roots.find(root_id);
+    if (it == roots.end()) {
+      return false;
+    }
+    removed = std::move(it->second);
+    roots.erase(it);
+    if (trace_writer) {
+      trace_writer->remove_root(root_id);
+    }
+  }
+
+  // Events still in flight for the root find no entry and are dropped
+  if (is_watching_flag.load()) {
+    p_impl->remove_root(root_id);
+  }
+  return true;
+}
 
-  return p_impl->start_watching(path, callback);
+std::vector<int> FileWatcher::get_root_ids() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<int> ids;
+  for (const auto& [id, root] : roots) {
+    ids.push_back(id);
+  }
+  return ids;
+}
+
+std::string FileWatcher::get_root_path(int root_id) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = roots.find(root_id);
+  return it != roots.end() ? it->second->path : std::string();
 }
 
 void FileWatcher::stop_watching() {
   if (p_impl) {
-    p_impl->stop_watching();
+    p_impl->stop();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    timer_should_stop = true;
   }
+  timer_condition.notify_all();
+  if (timer_thread.joinable()) {
+    timer_thread.join();
+  }
+
+  // Drop events that did not settle before we stopped
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    roots.clear();
+  }
+
   is_watching_flag = false;
 }
 
-bool FileWatcher::is_watching() const { return is_watching_flag && p_impl && p_impl->is_watching(); }
+bool FileWatcher::is_watching() const { return is_watching_flag && p_impl && p_impl->is_running(); }
 
-std::string FileWatcher::get_watched_path() const { return watched_path; }
+std::string FileWatcher::get_watched_path() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return roots.empty() ? std::string() : roots.begin()->second->path;
+}
+
+void FileWatcher::set_file_extensions(const std::vector<std::string>& extensions) {
+  default_options.extensions = extensions;
+}
 
-void FileWatcher::set_file_extensions(const std::vector<std::string>& extensions) { file_extensions = extensions; }
+void FileWatcher::add_ignore_pattern(const std::string& pattern) { default_options.ignore_patterns.push_back(pattern); }
 
 void FileWatcher::set_polling_interval(int milliseconds) { polling_interval = milliseconds; }
+
+void FileWatcher::set_buffer_size(size_t bytes) {
+  buffer_size = bytes;
+  if (p_impl) {
+    p_impl->set_buffer_size(bytes);
+  }
+}
+
+// Add the counters of one root to a total
+static void add_root_stats(const CoalescerStats& coalescer_stats, uint64_t overflow_count, uint64_t resync_count,
+                           uint64_t resync_changes, FileWatcherStats& stats) {
+  stats.raw_events += coalescer_stats.events_received;
+  stats.emitted_events += coalescer_stats.events_emitted;
+  stats.cancelled_events += coalescer_stats.events_cancelled;
+  stats.subsumed_events += coalescer_stats.events_subsumed;
+  stats.overflow_count += overflow_count;
+  stats.resync_count += resync_count;
+  stats.resync_changes += resync_changes;
+}
+
+FileWatcherStats FileWatcher::get_stats() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  FileWatcherStats stats;
+  for (const auto& [id, root] : roots) {
+    add_root_stats(root->coalescer.get_stats(), root->overflow_count, root->resync_count, root->resync_changes,
+                   stats);
+  }
+  return stats;
+}
+
+FileWatcherStats FileWatcher::get_root_stats(int root_id) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  FileWatcherStats stats;
+  auto it = roots.find(root_id);
+  if (it != roots.end()) {
+    const WatchRoot& root = *it->second;
+    add_root_stats(root.coalescer.get_stats(), root.overflow_count, root.resync_count, root.resync_changes, stats);
+  }
+  return stats;
+}
+
+std::shared_ptr<const EventFilter> FileWatcher::get_filter(int root_id) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = roots.find(root_id);
+  if (it == roots.end()) {
+    return nullptr;
+  }
+  // Shares ownership of the root, so the filter stays valid after the root is removed
+  return std::shared_ptr<const EventFilter>(it->second, &it->second->filter);
+}
+
+std::vector<FilterRuleStats> FileWatcher::get_filter_stats(int root_id) const {
+  std::shared_ptr<const EventFilter> filter = get_filter(root_id);
+  return filter ? filter->get_stats() : std::vector<FilterRuleStats>();
+}
+
+bool FileWatcher::start_trace(const std::string& file_path) {
+  if (is_watching_flag.load()) {
+    std::cerr << "Event tracing has to be started before the file watcher\n";
+    return false;
+  }
+
+  auto writer = std::make_unique<EventTraceWriter>();
+  if (!writer->open(file_path, std::chrono::milliseconds(DEBOUNCE_TIMEOUT_MS))) {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  trace_writer = std::move(writer);
+  return true;
+}
+
+void FileWatcher::stop_trace() {
+  std::unique_ptr<EventTraceWriter> writer;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    writer = std::move(trace_writer);
+  }
+  if (writer) {
+    std::cout << "Event trace closed with " << writer->get_record_count() << " record(s)\n";
+  }
+}
+
+void FileWatcher::on_raw_event(int root_id, FileEventType type, const std::string& path, const std::string& old_path,
+                               bool is_directory) {
+  auto now = std::chrono::steady_clock::now();
+  bool wake_timer = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = roots.find(root_id);
+    if (it == roots.end()) {
+      return;
+    }
+
+    WatchRoot& root = *it->second;
+    record_activity(root, path, now);
+    if (!old_path.empty()) {
+      record_activity(root, old_path, now);
+    }
+    root.coalescer.push(type, path, old_path, is_directory, now);
+    if (trace_writer) {
+      trace_writer->record_event(root_id, type, path, old_path, is_directory, now);
+    }
+
+    // A waiting timer already has a deadline no later than this event's, so only an idle one needs waking
+    wake_timer = timer_idle;
+    timer_idle = false;
+  }
+  if (wake_timer) {
+    timer_condition.notify_one();
+  }
+}
+
+void FileWatcher::on_overflow(int root_id) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = roots.find(root_id);
+    if (it == roots.end()) {
+      return;
+    }
+    it->second->overflow_count++;
+    it->second->resync_requested = true;
+    if (trace_writer) {
+      trace_writer->record_overflow(root_id);
+    }
+  }
+  timer_condition.notify_one();
+}
+
+// Remember which directories saw events recently; after an overflow those are the likely victims
+void FileWatcher::record_activity(WatchRoot& root, const std::string& path, std::chrono::steady_clock::time_point now) {
+  std::string directory = parent_path_of(path);
+  if (directory.empty()) {
+    return;
+  }
+  auto& recent_directories = root.recent_directories;
+  if (!recent_directories.empty() && recent_directories.back().first == directory) {
+    recent_directories.back().second = now;
+    return;
+  }
+
+  recent_directories.emplace_back(directory, now);
+  if (recent_directories.size() > RECENT_DIRECTORY_LIMIT) {
+    recent_directories.pop_front();
+  }
+}
+
+std::vector<std::string> FileWatcher::collect_active_subtrees(WatchRoot& root,
+                                                              std::chrono::steady_clock::time_point now) {
+  std::vector<std::string> subtrees =
+      select_resync_subtrees(root.path, root.recent_directories, now,
+                             std::chrono::milliseconds(RESYNC_ACTIVITY_WINDOW_MS), MAX_RESYNC_SUBTREES);
+  root.recent_directories.clear();
+  return subtrees;
+}
+
+// Recover from dropped notifications. Recently active subtrees are re-stat'ed in full; elsewhere only
+// directories whose mtime moved are listed again. The differences are fed back through the coalescer.
+void FileWatcher::resync(WatchRoot& root) {
+  std::vector<std::string> subtrees;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    subtrees = collect_active_subtrees(root, std::chrono::steady_clock::now());
+  }
+
+  std::vector<SnapshotChange> changes = root.snapshot.resync(subtrees);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& change : changes) {
+      root.coalescer.push(change.type, change.path, "", change.is_directory);
+    }
+  }
+
+  root.resync_count++;
+  root.resync_changes += changes.size();
+  std::cout << "File watcher overflow in " << root.path << ": resynced " << subtrees.size() << " subtree(s), found "
+            << changes.size() << " change(s)\n";
+}
+
+// Delivers settled events for every root. Sleeps until the earliest deadline across all roots, or until a
+// raw event arrives while nothing is pending, so wakeups don't grow with the number of roots.
+void FileWatcher::timer_loop() {
+  using Clock = std::chrono::steady_clock;
+
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!timer_should_stop) {
+    std::vector<std::shared_ptr<WatchRoot>> roots_to_resync;
+    for (const auto& [id, root] : roots) {
+      if (root->resync_requested) {
+        root->resync_requested = false;
+        roots_to_resync.push_back(root);
+      }
+    }
+    if (!roots_to_resync.empty()) {
+      lock.unlock();
+      for (const auto& root : roots_to_resync) {
+        resync(*root);
+      }
+      lock.lock();
+      continue;
+    }
+
+    Clock::time_point now = Clock::now();
+    Clock::time_point deadline = Clock::time_point::max();
+    std::vector<std::pair<std::shared_ptr<WatchRoot>, std::vector<FileEvent>>> ready;
+    for (const auto& [id, root] : roots) {
+      std::vector<FileEvent> events = root->coalescer.flush_ready(now);
+      if (!events.empty()) {
+        ready.emplace_back(root, std::move(events));
+      }
+      deadline = std::min(deadline, root->coalescer.next_deadline(now));
+    }
+
+    if (!ready.empty()) {
+      // Deliver outside the lock so the callback can take its time without stalling the backend
+      lock.unlock();
+      for (auto& [root, events] : ready) {
+        for (auto& event : events) {
+          event.root_id = root->id;
+          root->snapshot.apply(event);
+          if (callback) {
+            callback(event);
+          }
+        }
+      }
+      lock.lock();
+      continue;
+    }
+
+    if (deadline == Clock::time_point::max()) {
+      timer_idle = true;
+      timer_condition.wait(lock);
+      timer_idle = false;
+    } else {
+      timer_condition.wait_until(lock, deadline);
+    }
+  }
+}
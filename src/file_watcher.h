@@ -1,13 +1,21 @@
 #pragma once
 #include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
+#include "event_filter.h"
+
 // Forward declarations for platform-specific implementations
 class FileWatcherImpl;
+class EventTraceWriter;
 
 // Event types for file system changes
 enum class FileEventType { Created, Modified, Deleted, Renamed, DirectoryCreated, DirectoryDeleted };
@@ -18,51 +26,158 @@ struct FileEvent {
   std::string path;
   std::string old_path;  // For rename events
   std::chrono::system_clock::time_point timestamp;
+  int root_id;  // Root the event belongs to, as returned by FileWatcher::add_root()
 
   FileEvent(FileEventType t, const std::string& p, const std::string& old = "")
-      : type(t), path(p), old_path(old), timestamp(std::chrono::system_clock::now()) {}
+      : type(t), path(p), old_path(old), timestamp(std::chrono::system_clock::now()), root_id(0) {}
 };
 
 // Callback type for file events
 using FileEventCallback = std::function<void(const FileEvent&)>;
 
-// Main file watcher class
+// Callback type for raw, undebounced events reported by a platform backend.
+// `is_directory` is only required to be accurate for Renamed; deletions of directories may arrive as Deleted.
+using RawFileEventCallback = std::function<void(int root_id, FileEventType type, const std::string& path,
+                                                const std::string& old_path, bool is_directory)>;
+
+// Called by a platform backend when the OS dropped notifications for a root (its queue or our buffer overflowed)
+using WatcherOverflowCallback = std::function<void(int root_id)>;
+
+// Counters describing the event stream of a watcher
+struct FileWatcherStats {
+  uint64_t raw_events = 0;        // Events reported by the OS backend
+  uint64_t emitted_events = 0;    // Net events delivered to the callback after coalescing
+  uint64_t cancelled_events = 0;  // Events that cancelled each other out
+  uint64_t subsumed_events = 0;   // Events folded into a directory-level operation
+  uint64_t overflow_count = 0;    // Times the OS reported dropped notifications
+  uint64_t resync_count = 0;      // Resyncs run to recover from an overflow
+  uint64_t resync_changes = 0;    // Changes found by those resyncs
+};
+
+// Per-root filtering
+struct WatchRootOptions {
+  std::vector<std::string> extensions;       // Only report files with these extensions; empty reports all
+  std::vector<std::string> ignore_patterns;  // Globs such as "**/.git/**", "*.tmp" or "~*"
+};
+
+// Main file watcher class. Any number of roots share one OS-level event loop and one delivery thread,
+// so the thread count does not grow with the number of roots. Roots must not overlap.
 class FileWatcher {
  public:
   FileWatcher();
   ~FileWatcher();
 
-  // Start watching a directory
+  // Start watching a directory, filtered with the options set through set_file_extensions/add_ignore_pattern
   bool start_watching(const std::string& path, FileEventCallback callback);
 
-  // Stop watching
+  // Start the event loop for the roots added so far and any added later
+  bool start(FileEventCallback callback);
+
+  // Add a root, at any time. Before start() it is only recorded; afterwards it is watched right away.
+  // Returns its id (always positive), or -1 if the directory can't be watched.
+  int add_root(const std::string& path, const WatchRootOptions& options = WatchRootOptions());
+
+  // Stop watching a root and drop its pending events. Events already being delivered may still arrive.
+  bool remove_root(int root_id);
+
+  std::vector<int> get_root_ids() const;
+  std::string get_root_path(int root_id) const;
+
+  // Stop watching and forget all roots
   void stop_watching();
 
   // Check if currently watching
   bool is_watching() const;
 
-  // Get the watched path
+  // Get the path of the first root
   std::string get_watched_path() const;
 
-  // Add file extensions to filter (optional)
+  // Only report files with these extensions (optional). Applies to the root added by start_watching.
   void set_file_extensions(const std::vector<std::string>& extensions);
 
+  // Drop events for paths matching a glob such as "**/.git/**", "*.tmp" or "~*" before they are debounced.
+  // Applies to the root added by start_watching.
+  void add_ignore_pattern(const std::string& pattern);
+
   // Set polling interval for fallback mode (in milliseconds)
   void set_polling_interval(int milliseconds);
 
+  // Set the size of the buffer the OS writes notifications into (applies to roots watched afterwards)
+  void set_buffer_size(size_t bytes);
+
+  // Snapshot of the event counters, summed over all roots or for one root
+  FileWatcherStats get_stats() const;
+  FileWatcherStats get_root_stats(int root_id) const;
+
+  // The compiled extension and ignore rules of a root, e.g. to apply them to a manual scan. Null if unknown.
+  // Stays valid after the root is removed.
+  std::shared_ptr<const EventFilter> get_filter(int root_id) const;
+
+  // Events dropped per filter rule of a root
+  std::vector<FilterRuleStats> get_filter_stats(int root_id) const;
+
+  // Record the raw event stream of every root into a trace file that EventTracePlayer can replay.
+  // Must be called before start(), so the trace sees each root's initial directories.
+  bool start_trace(const std::string& file_path);
+  void stop_trace();
+
  private:
+  struct WatchRoot;
+
   std::unique_ptr<FileWatcherImpl> p_impl;
-  std::string watched_path;
-  std::vector<std::string> file_extensions;
+  WatchRootOptions default_options;
   int polling_interval;
   std::atomic<bool> is_watching_flag;
+  FileEventCallback callback;
+  size_t buffer_size;
+
+  // Roots and their coalescers; raw events are coalesced per root and delivered from the timer thread once
+  // they settle. The timer sleeps until the earliest deadline of any root, so idle roots cost no wakeups.
+  std::map<int, std::shared_ptr<WatchRoot>> roots;
+  int next_root_id;
+  mutable std::mutex mutex;
+  std::condition_variable timer_condition;
+  std::thread timer_thread;
+  bool timer_should_stop;
+  bool timer_idle;  // Waiting without a deadline; the next raw event has to wake it
+  std::unique_ptr<EventTraceWriter> trace_writer;  // Guarded by mutex
+
+  // Timer configuration
+  static constexpr int DEBOUNCE_TIMEOUT_MS = 500;
+  static constexpr size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+  // Resync configuration: directories active this recently are re-stat'ed in full after an overflow
+  static constexpr int RESYNC_ACTIVITY_WINDOW_MS = 2000;
+  static constexpr size_t RECENT_DIRECTORY_LIMIT = 256;
+  static constexpr size_t MAX_RESYNC_SUBTREES = 16;
+
+  bool watch_root(WatchRoot& root);
+  void on_raw_event(int root_id, FileEventType type, const std::string& path, const std::string& old_path,
+                    bool is_directory);
+  void on_overflow(int root_id);
+  void record_activity(WatchRoot& root, const std::string& path, std::chrono::steady_clock::time_point now);
+  std::vector<std::string> collect_active_subtrees(WatchRoot& root, std::chrono::steady_clock::time_point now);
+  void resync(WatchRoot& root);
+  void timer_loop();
 };
 
-// Platform-specific implementation base class
+// Platform-specific implementation base class. One instance runs a single event loop for all roots.
 class FileWatcherImpl {
  public:
   virtual ~FileWatcherImpl() = default;
-  virtual bool start_watching(const std::string& path, FileEventCallback callback) = 0;
-  virtual void stop_watching() = 0;
-  virtual bool is_watching() const = 0;
+
+  // Start the event loop thread; roots are added afterwards
+  virtual bool start(RawFileEventCallback callback, WatcherOverflowCallback overflow_callback) = 0;
+
+  // Stop the event loop and drop all roots
+  virtual void stop() = 0;
+  virtual bool is_running() const = 0;
+
+  // Safe to call from any thread while running. Events for a root may arrive before add_root() returns.
+  // `filter` may be null and must outlive the root.
+  virtual bool add_root(int root_id, const std::string& path, const EventFilter* filter) = 0;
+  virtual void remove_root(int root_id) = 0;
+
+  // Applies to roots added afterwards
+  virtual void set_buffer_size(size_t bytes) = 0;
 };
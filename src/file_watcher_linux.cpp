@@ -0,0 +1,409 @@
+#include <limits.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "file_watcher.h"
+
+// All roots share one inotify descriptor, serviced by a single thread
+class LinuxFileWatcher : public FileWatcherImpl {
+ private:
+  struct WatchRoot {
+    std::string path;
+    const EventFilter* filter;
+  };
+
+  // inotify watches a single directory, so every directory of every root has its own descriptor
+  struct Watch {
+    int root_id;
+    std::string path;
+  };
+
+  int inotify_fd;
+  int wake_fd;
+  std::thread watch_thread;
+  std::atomic<bool> should_stop;
+  std::atomic<bool> is_running_flag;
+  RawFileEventCallback callback;
+  WatcherOverflowCallback overflow_callback;
+
+  // Buffer for reading notifications. The kernel queue itself is bounded by
+  // /proc/sys/fs/inotify/max_queued_events; when it fills up we get IN_Q_OVERFLOW.
+  std::vector<char> buffer;
+  size_t buffer_size;
+
+  // Roots are added and removed from any thread while the loop services them
+  std::mutex roots_mutex;
+  std::unordered_map<int, WatchRoot> roots;
+  std::unordered_map<int, Watch> watches;
+
+  // IN_MOVED_FROM waiting for the IN_MOVED_TO with the same cookie
+  uint32_t pending_move_cookie;
+  std::string pending_move_path;
+  bool pending_move_is_directory;
+  int pending_move_root_id;
+
+  static constexpr uint32_t WATCH_MASK = IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB |
+                                         IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK;
+
+ public:
+  LinuxFileWatcher()
+      : inotify_fd(-1),
+        wake_fd(-1),
+        should_stop(false),
+        is_running_flag(false),
+        buffer_size(64 * 1024),
+        pending_move_cookie(0),
+        pending_move_is_directory(false),
+        pending_move_root_id(0) {}
+
+  ~LinuxFileWatcher() { stop(); }
+
+  bool start(RawFileEventCallback cb, WatcherOverflowCallback overflow_cb) override {
+    if (is_running_flag.load()) {
+      std::cerr << "File watcher is already running\n";
+      return false;
+    }
+
+    callback = cb;
+    overflow_callback = overflow_cb;
+    buffer.assign(buffer_size, 0);
+
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) {
+      std::cerr << "Failed to initialize inotify: " << std::strerror(errno) << '\n';
+      return false;
+    }
+
+    // Used to wake the watch thread up when stopping
+    wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd < 0) {
+      std::cerr << "Failed to create eventfd: " << std::strerror(errno) << '\n';
+      close(inotify_fd);
+      inotify_fd = -1;
+      return false;
+    }
+
+    should_stop = false;
+    is_running_flag = true;
+    pending_move_path.clear();
+
+    // Start watching thread
+    watch_thread = std::thread(&LinuxFileWatcher::watch_loop, this);
+    return true;
+  }
+
+  void stop() override {
+    if (!is_running_flag.load()) return;
+
+    should_stop = true;
+
+    // Signal the eventfd to wake up the thread
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0) {
+      std::cerr << "Failed to wake file watcher thread: " << std::strerror(errno) << '\n';
+    }
+
+    // Wait for the thread to finish
+    if (watch_thread.joinable()) {
+      watch_thread.join();
+    }
+
+    // Closing the inotify descriptor removes all of its watches
+    close(inotify_fd);
+    close(wake_fd);
+    inotify_fd = wake_fd = -1;
+    roots.clear();
+    watches.clear();
+
+    is_running_flag = false;
+  }
+
+  bool is_running() const override { return is_running_flag.load(); }
+
+  bool add_root(int root_id, const std::string& path, const EventFilter* filter) override {
+    if (!is_running_flag.load()) {
+      return false;
+    }
+
+    std::lock_guard<std::mutex> lock(roots_mutex);
+    roots[root_id] = {path, filter};
+    if (!add_watch_recursive(root_id, path)) {
+      std::cerr << "Failed to watch directory: " << path << '\n';
+      roots.erase(root_id);
+      return false;
+    }
+
+    std::cout << "Started watching directory: " << path << '\n';
+    return true;
+  }
+
+  void remove_root(int root_id) override {
+    std::lock_guard<std::mutex> lock(roots_mutex);
+    auto root = roots.find(root_id);
+    if (root == roots.end()) return;
+
+    for (auto it = watches.begin(); it != watches.end();) {
+      if (it->second.root_id == root_id) {
+        inotify_rm_watch(inotify_fd, it->first);
+        it = watches.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    if (pending_move_root_id == root_id) {
+      pending_move_path.clear();
+    }
+
+    std::cout << "Stopped watching directory: " << root->second.path << '\n';
+    roots.erase(root);
+  }
+
+  void set_buffer_size(size_t bytes) override {
+    buffer_size = std::max<size_t>(bytes, sizeof(inotify_event) + NAME_MAX + 1);
+  }
+
+ private:
+  bool add_watch(int root_id, const std::string& directory) {
+    int wd = inotify_add_watch(inotify_fd, directory.c_str(), WATCH_MASK);
+    if (wd < 0) {
+      // ENOSPC means /proc/sys/fs/inotify/max_user_watches is exhausted
+      std::cerr << "inotify_add_watch failed for " << directory << ": " << std::strerror(errno) << '\n';
+      return false;
+    }
+    watches[wd] = {root_id, directory};
+    return true;
+  }
+
+  bool add_watch_recursive(int root_id, const std::string& directory) {
+    if (!add_watch(root_id, directory)) {
+      return false;
+    }
+
+    // Ignored directories get no watch at all, so nothing below them ever reaches us
+    const WatchRoot& root = roots[root_id];
+    std::error_code ec;
+    for (auto it = std::filesystem::recursive_directory_iterator(directory, ec);
+         !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+      if (!it->is_directory(ec) || it->is_symlink(ec)) continue;
+
+      std::string subdirectory = it->path().string();
+      if (root.filter && root.filter->excludes(relative_path(root, subdirectory), true)) {
+        it.disable_recursion_pending();
+      } else {
+        add_watch(root_id, subdirectory);
+      }
+    }
+    return true;
+  }
+
+  void remove_watches_under(const std::string& directory) {
+    for (auto it = watches.begin(); it != watches.end();) {
+      if (it->second.path == directory || is_under(it->second.path, directory)) {
+        inotify_rm_watch(inotify_fd, it->first);
+        it = watches.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  void rename_watches_under(const std::string& old_directory, const std::string& new_directory) {
+    for (auto& [wd, watch] : watches) {
+      if (watch.path == old_directory || is_under(watch.path, old_directory)) {
+        watch.path = new_directory + watch.path.substr(old_directory.size());
+      }
+    }
+  }
+
+  static bool is_under(const std::string& path, const std::string& directory) {
+    return path.size() > directory.size() && path[directory.size()] == '/' &&
+           path.compare(0, directory.size(), directory) == 0;
+  }
+
+  static std::string relative_path(const WatchRoot& root, const std::string& path) {
+    return path.size() > root.path.size() ? path.substr(root.path.size() + 1) : std::string();
+  }
+
+  static bool accepts(const WatchRoot& root, const std::string& path, bool is_directory) {
+    return !root.filter || root.filter->accepts(relative_path(root, path), is_directory);
+  }
+
+  void report_created(int root_id, const std::string& path, bool is_directory) {
+    if (is_directory) {
+      // Watch the new subtree before reporting it; the consumer scans it, so files that were
+      // created before the watch existed are still picked up
+      add_watch_recursive(root_id, path);
+      callback(root_id, FileEventType::DirectoryCreated, path, "", true);
+    } else {
+      callback(root_id, FileEventType::Created, path, "", false);
+    }
+  }
+
+  void watch_loop() {
+    pollfd fds[2];
+    fds[0].fd = inotify_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = wake_fd;
+    fds[1].events = POLLIN;
+
+    while (!should_stop.load()) {
+      // Wait for either a change notification or stop signal
+      int ready = poll(fds, 2, -1);
+      if (ready < 0) {
+        if (errno == EINTR) continue;
+        std::cerr << "poll failed: " << std::strerror(errno) << '\n';
+        break;
+      }
+
+      if (should_stop.load()) {
+        break;
+      }
+
+      if (fds[0].revents & POLLIN) {
+        read_events();
+      }
+    }
+  }
+
+  void read_events() {
+    std::lock_guard<std::mutex> lock(roots_mutex);
+    while (true) {
+      ssize_t length = read(inotify_fd, buffer.data(), buffer.size());
+      if (length <= 0) {
+        // EAGAIN: drained for now
+        break;
+      }
+
+      size_t offset = 0;
+      while (offset < static_cast<size_t>(length)) {
+        const auto* event = reinterpret_cast<const inotify_event*>(buffer.data() + offset);
+        process_event(*event);
+        offset += sizeof(inotify_event) + event->len;
+      }
+    }
+
+    // A move whose destination never showed up left the watched tree
+    flush_pending_move();
+  }
+
+  void report_overflow() {
+    // The queue is shared, so every root may have lost events
+    std::cerr << "inotify queue overflowed, changes were dropped\n";
+    flush_pending_move();
+    if (overflow_callback) {
+      for (const auto& [root_id, root] : roots) {
+        overflow_callback(root_id);
+      }
+    }
+  }
+
+  void flush_pending_move() {
+    if (pending_move_path.empty()) return;
+
+    if (pending_move_is_directory) {
+      remove_watches_under(pending_move_path);
+    }
+    auto root = roots.find(pending_move_root_id);
+    if (root != roots.end() && accepts(root->second, pending_move_path, pending_move_is_directory)) {
+      callback(pending_move_root_id, FileEventType::Deleted, pending_move_path, "", pending_move_is_directory);
+    }
+    pending_move_path.clear();
+  }
+
+  void process_event(const inotify_event& event) {
+    if (event.mask & IN_Q_OVERFLOW) {
+      report_overflow();
+      return;
+    }
+
+    if (event.mask & IN_IGNORED) {
+      // The watched directory was deleted or moved out
+      watches.erase(event.wd);
+      return;
+    }
+
+    auto watch = watches.find(event.wd);
+    if (watch == watches.end() || event.len == 0) {
+      // Events about the watched directory itself are reported by its parent
+      return;
+    }
+    int root_id = watch->second.root_id;
+    const WatchRoot& root = roots[root_id];
+
+    // Filter and forward the raw event; debouncing and coalescing happen in FileWatcher
+    std::string full_path = watch->second.path + "/" + event.name;
+    bool is_directory = (event.mask & IN_ISDIR) != 0;
+
+    // A move between two roots is reported as a delete in one and a create in the other
+    if ((event.mask & IN_MOVED_TO) && !pending_move_path.empty() && event.cookie == pending_move_cookie &&
+        pending_move_root_id == root_id) {
+      process_move(root_id, pending_move_path, full_path, is_directory);
+      pending_move_path.clear();
+      return;
+    }
+    flush_pending_move();
+
+    if (event.mask & IN_MOVED_FROM) {
+      pending_move_cookie = event.cookie;
+      pending_move_path = full_path;
+      pending_move_is_directory = is_directory;
+      pending_move_root_id = root_id;
+    } else if (event.mask & (IN_CREATE | IN_MOVED_TO)) {
+      if (accepts(root, full_path, is_directory)) {
+        report_created(root_id, full_path, is_directory);
+      }
+    } else if (event.mask & IN_DELETE) {
+      if (accepts(root, full_path, is_directory)) {
+        callback(root_id, is_directory ? FileEventType::DirectoryDeleted : FileEventType::Deleted, full_path, "",
+                 is_directory);
+      }
+    } else if (event.mask & (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB)) {
+      if (!is_directory && accepts(root, full_path, false)) {
+        callback(root_id, FileEventType::Modified, full_path, "", false);
+      }
+    }
+  }
+
+  void process_move(int root_id, const std::string& old_path, const std::string& new_path, bool is_directory) {
+    const WatchRoot& root = roots[root_id];
+    RenameFilterResult result =
+        root.filter
+            ? root.filter->filter_rename(relative_path(root, old_path), relative_path(root, new_path), is_directory)
+            : RenameFilterResult::Keep;
+    switch (result) {
+      case RenameFilterResult::Keep:
+        if (is_directory) {
+          rename_watches_under(old_path, new_path);
+        }
+        callback(root_id, FileEventType::Renamed, new_path, old_path, is_directory);
+        break;
+      case RenameFilterResult::AsCreated:
+        report_created(root_id, new_path, is_directory);
+        break;
+      case RenameFilterResult::AsDeleted:
+        if (is_directory) {
+          remove_watches_under(old_path);
+        }
+        callback(root_id, FileEventType::Deleted, old_path, "", is_directory);
+        break;
+      case RenameFilterResult::Drop:
+        break;
+    }
+  }
+};
+
+// Factory function for Linux implementation
+std::unique_ptr<FileWatcherImpl> create_linux_file_watcher_impl() { return std::make_unique<LinuxFileWatcher>(); }
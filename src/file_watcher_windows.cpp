@@ -3,262 +3,265 @@
 #include <algorithm>
 #include <atomic>
 #include <chrono>
-#include <condition_variable>
 #include <filesystem>
 #include <iostream>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 #include "file_watcher.h"
 
-// Structure to track pending file events
-struct PendingFileEvent {
-  FileEventType original_type;
-  std::string path;
-  std::string old_path;  // For rename events
-  std::chrono::steady_clock::time_point last_activity;
-  bool is_active;
-
-  PendingFileEvent() : original_type(FileEventType::Modified), is_active(false) {}
-
-  PendingFileEvent(FileEventType type, const std::string& p, const std::string& old = "")
-      : original_type(type), path(p), old_path(old), last_activity(std::chrono::steady_clock::now()), is_active(true) {}
-};
-
+// All roots share one I/O completion port, serviced by a single thread
 class WindowsFileWatcher : public FileWatcherImpl {
  private:
-  HANDLE h_directory;
-  HANDLE h_event;
+  struct WatchRoot {
+    int id;
+    std::string path;
+    const EventFilter* filter;
+    HANDLE h_directory;
+    OVERLAPPED overlapped;
+
+    // Buffer for file change notifications. DWORD elements keep it aligned as ReadDirectoryChangesW requires.
+    // The kernel allocates a buffer of the same size for changes that arrive between two reads; when that
+    // fills up, the read completes with zero bytes. Network shares cap it at 64KB.
+    std::vector<DWORD> buffer;
+
+    bool read_pending;  // A ReadDirectoryChangesW is in flight; its completion must arrive before we free it
+    bool closing;       // Cancelled by remove_root(); freed when the aborted read completes
+
+    // FILE_ACTION_RENAMED_OLD_NAME waiting for its FILE_ACTION_RENAMED_NEW_NAME
+    std::string pending_rename_old_path;
+    std::string pending_rename_old_name;  // Relative to the root, for the filter
+  };
+
+  // Completion key that asks the loop to exit; roots use their id, which is always positive
+  static constexpr ULONG_PTR STOP_KEY = 0;
+
+  HANDLE h_port;
   std::thread watch_thread;
-  std::atomic<bool> should_stop;
-  std::atomic<bool> is_watching_flag;
-  FileEventCallback callback;
-  std::string watched_path;
+  std::atomic<bool> is_running_flag;
+  RawFileEventCallback callback;
+  WatcherOverflowCallback overflow_callback;
+  size_t buffer_size;
 
-  // Buffer for file change notifications
-  char buffer[4096];
-  DWORD bytes_returned;
+  // Roots are added and removed from any thread while the loop services them
+  std::mutex roots_mutex;
+  std::unordered_map<int, std::unique_ptr<WatchRoot>> roots;
 
-  // Timer-based event tracking
-  std::unordered_map<std::string, PendingFileEvent> pending_events;
-  std::mutex pending_events_mutex;
-  std::thread timer_thread;
-  std::atomic<bool> timer_should_stop;
+ public:
+  WindowsFileWatcher() : h_port(nullptr), is_running_flag(false), buffer_size(64 * 1024) {}
 
-  // Timer configuration
-  static constexpr int DEBOUNCE_TIMEOUT_MS = 500;
+  ~WindowsFileWatcher() { stop(); }
 
- public:
-  WindowsFileWatcher()
-      : h_directory(INVALID_HANDLE_VALUE),
-        h_event(INVALID_HANDLE_VALUE),
-        should_stop(false),
-        is_watching_flag(false),
-        timer_should_stop(false) {}
-
-  ~WindowsFileWatcher() { stop_watching(); }
-
-  bool start_watching(const std::string& path, FileEventCallback cb) override {
-    if (is_watching_flag.load()) {
-      std::cerr << "Already watching a directory\n";
+  bool start(RawFileEventCallback cb, WatcherOverflowCallback overflow_cb) override {
+    if (is_running_flag.load()) {
+      std::cerr << "File watcher is already running\n";
       return false;
     }
 
-    watched_path = path;
     callback = cb;
+    overflow_callback = overflow_cb;
 
-    // Create event for signaling
-    h_event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
-    if (h_event == nullptr) {
-      std::cerr << "Failed to create event: " << GetLastError() << '\n';
+    h_port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, nullptr, 0, 1);
+    if (h_port == nullptr) {
+      std::cerr << "Failed to create I/O completion port: " << GetLastError() << '\n';
       return false;
     }
 
-    // Open directory handle
-    h_directory = CreateFileW(std::wstring(path.begin(), path.end()).c_str(), FILE_LIST_DIRECTORY,
-                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
-                              FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
-
-    if (h_directory == INVALID_HANDLE_VALUE) {
-      std::cerr << "Failed to open directory: " << GetLastError() << '\n';
-      CloseHandle(h_event);
-      return false;
-    }
-
-    should_stop = false;
-    timer_should_stop = false;
-    is_watching_flag = true;
-
-    // Start watching thread
+    is_running_flag = true;
     watch_thread = std::thread(&WindowsFileWatcher::watch_loop, this);
-
-    // Start timer thread for processing pending events
-    timer_thread = std::thread(&WindowsFileWatcher::timer_loop, this);
-
-    std::cout << "Started watching directory: " << path << '\n';
     return true;
   }
 
-  void stop_watching() override {
-    if (!is_watching_flag.load()) return;
+  void stop() override {
+    if (!is_running_flag.load()) return;
 
-    should_stop = true;
-    timer_should_stop = true;
-
-    // Signal the event to wake up the thread
-    if (h_event != INVALID_HANDLE_VALUE) {
-      SetEvent(h_event);
-    }
-
-    // Wait for threads to finish
+    // Wake the loop up and wait for it to finish
+    PostQueuedCompletionStatus(h_port, 0, STOP_KEY, nullptr);
     if (watch_thread.joinable()) {
       watch_thread.join();
     }
 
-    if (timer_thread.joinable()) {
-      timer_thread.join();
-    }
-
-    // Clean up handles
-    if (h_directory != INVALID_HANDLE_VALUE) {
-      CloseHandle(h_directory);
-      h_directory = INVALID_HANDLE_VALUE;
+    // Cancel the reads still in flight and collect their completions before freeing the buffers
+    std::lock_guard<std::mutex> lock(roots_mutex);
+    for (auto& [id, root] : roots) {
+      if (root->read_pending) {
+        root->closing = true;
+        CancelIoEx(root->h_directory, &root->overlapped);
+      }
     }
-
-    if (h_event != INVALID_HANDLE_VALUE) {
-      CloseHandle(h_event);
-      h_event = INVALID_HANDLE_VALUE;
+    while (std::any_of(roots.begin(), roots.end(), [](const auto& entry) { return entry.second->read_pending; })) {
+      DWORD bytes_transferred = 0;
+      ULONG_PTR key = 0;
+      OVERLAPPED* overlapped = nullptr;
+      GetQueuedCompletionStatus(h_port, &bytes_transferred, &key, &overlapped, 1000);
+      if (overlapped == nullptr) {
+        std::cerr << "Timed out waiting for cancelled directory reads\n";
+        break;
+      }
+      auto it = roots.find(static_cast<int>(key));
+      if (it != roots.end()) {
+        it->second->read_pending = false;
+      }
     }
-
-    // Clear pending events
-    {
-      std::lock_guard<std::mutex> lock(pending_events_mutex);
-      pending_events.clear();
+    for (auto& [id, root] : roots) {
+      close_root(*root);
     }
+    roots.clear();
 
-    is_watching_flag = false;
-    std::cout << "Stopped watching directory: " << watched_path << '\n';
+    CloseHandle(h_port);
+    h_port = nullptr;
+    is_running_flag = false;
   }
 
-  bool is_watching() const override { return is_watching_flag.load(); }
-
- private:
-  void timer_loop() {
-    while (!timer_should_stop.load()) {
-      auto now = std::chrono::steady_clock::now();
-      std::vector<std::pair<std::string, PendingFileEvent>> events_to_process;
+  bool is_running() const override { return is_running_flag.load(); }
 
-      {
-        std::lock_guard<std::mutex> lock(pending_events_mutex);
-
-        for (auto it = pending_events.begin(); it != pending_events.end();) {
-          auto& pending = it->second;
+  bool add_root(int root_id, const std::string& path, const EventFilter* filter) override {
+    if (!is_running_flag.load()) {
+      return false;
+    }
 
-          if (!pending.is_active) {
-            // Event has been cancelled (e.g., file deleted)
-            it = pending_events.erase(it);
-            continue;
-          }
+    auto root = std::make_unique<WatchRoot>();
+    root->id = root_id;
+    root->path = path;
+    root->filter = filter;
+    root->overlapped = {};
+    root->buffer.assign((buffer_size + sizeof(DWORD) - 1) / sizeof(DWORD), 0);
+    root->read_pending = false;
+    root->closing = false;
 
-          auto time_since_activity =
-              std::chrono::duration_cast<std::chrono::milliseconds>(now - pending.last_activity).count();
+    // Open directory handle
+    root->h_directory = CreateFileW(std::filesystem::u8path(path).wstring().c_str(), FILE_LIST_DIRECTORY,
+                                    FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                    FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (root->h_directory == INVALID_HANDLE_VALUE) {
+      std::cerr << "Failed to open directory: " << GetLastError() << '\n';
+      return false;
+    }
 
-          if (time_since_activity >= DEBOUNCE_TIMEOUT_MS) {
-            // Event has timed out, store it for processing
-            events_to_process.push_back({it->first, pending});
-            it = pending_events.erase(it);
-          } else {
-            ++it;
-          }
-        }
-      }
+    if (CreateIoCompletionPort(root->h_directory, h_port, static_cast<ULONG_PTR>(root_id), 0) == nullptr) {
+      std::cerr << "Failed to associate directory with completion port: " << GetLastError() << '\n';
+      CloseHandle(root->h_directory);
+      return false;
+    }
 
-      // Process timed-out events
-      for (const auto& [path, pending] : events_to_process) {
-        if (callback) {
-          // Determine the final event type based on the original event
-          FileEventType final_type;
-          if (pending.original_type == FileEventType::Created) {
-            final_type = FileEventType::Created;
-          } else {
-            final_type = FileEventType::Modified;
-          }
+    // Reads on a handle bound to a completion port outlive the thread that issued them, so the first one
+    // can be issued from the caller's thread
+    std::lock_guard<std::mutex> lock(roots_mutex);
+    if (!issue_read(*root)) {
+      CloseHandle(root->h_directory);
+      return false;
+    }
+    roots[root_id] = std::move(root);
 
-          FileEvent event(final_type, path, pending.old_path);
-          callback(event);
-        }
-      }
+    std::cout << "Started watching directory: " << path << '\n';
+    return true;
+  }
 
-      // Sleep for a short interval before checking again
-      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  void remove_root(int root_id) override {
+    std::lock_guard<std::mutex> lock(roots_mutex);
+    auto it = roots.find(root_id);
+    if (it == roots.end()) return;
+
+    WatchRoot& root = *it->second;
+    std::cout << "Stopped watching directory: " << root.path << '\n';
+    if (root.read_pending) {
+      // The loop frees the root once the aborted read completes
+      root.closing = true;
+      CancelIoEx(root.h_directory, &root.overlapped);
+    } else {
+      close_root(root);
+      roots.erase(it);
     }
   }
 
-  void process_raw_file_event(FileEventType raw_type, const std::string& full_path, const std::string& old_path = "") {
-    std::lock_guard<std::mutex> lock(pending_events_mutex);
+  void set_buffer_size(size_t bytes) override { buffer_size = std::max<size_t>(bytes, 4096); }
 
-    // For Deleted and Renamed, process immediately
-    if (raw_type == FileEventType::Deleted || raw_type == FileEventType::Renamed) {
-      if (callback) {
-        FileEvent event(raw_type, full_path, old_path);
-        callback(event);
-      }
-      return;
+ private:
+  bool issue_read(WatchRoot& root) {
+    root.overlapped = {};
+    if (!ReadDirectoryChangesW(root.h_directory, root.buffer.data(),
+                               static_cast<DWORD>(root.buffer.size() * sizeof(DWORD)),
+                               TRUE,  // Watch subtree
+                               FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
+                                   FILE_NOTIFY_CHANGE_ATTRIBUTES | FILE_NOTIFY_CHANGE_SIZE |
+                                   FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_CREATION,
+                               nullptr, &root.overlapped, nullptr)) {
+      std::cerr << "ReadDirectoryChangesW failed: " << GetLastError() << '\n';
+      root.read_pending = false;
+      return false;
     }
+    root.read_pending = true;
+    return true;
+  }
 
-    auto it = pending_events.find(full_path);
-    if (it == pending_events.end()) {
-      // First event for this file, store all attributes
-      pending_events[full_path] = PendingFileEvent(raw_type, full_path, old_path);
-    } else {
-      // Only update last_activity and is_active
-      it->second.last_activity = std::chrono::steady_clock::now();
-      it->second.is_active = true;
-      // Optionally, update old_path for rename tracking if needed
+  static void close_root(WatchRoot& root) {
+    if (root.h_directory != INVALID_HANDLE_VALUE) {
+      CloseHandle(root.h_directory);
+      root.h_directory = INVALID_HANDLE_VALUE;
     }
   }
 
   void watch_loop() {
-    OVERLAPPED overlapped = {0};
-    overlapped.hEvent = h_event;
-
-    while (!should_stop.load()) {
-      // Start monitoring
-      if (!ReadDirectoryChangesW(h_directory, buffer, sizeof(buffer),
-                                 TRUE,  // Watch subtree
-                                 FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME |
-                                     FILE_NOTIFY_CHANGE_ATTRIBUTES | FILE_NOTIFY_CHANGE_SIZE |
-                                     FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_CREATION,
-                                 nullptr, &overlapped, nullptr)) {
-        std::cerr << "ReadDirectoryChangesW failed: " << GetLastError() << '\n';
+    while (true) {
+      // Wait for a completed read on any root, or the stop signal
+      DWORD bytes_transferred = 0;
+      ULONG_PTR key = 0;
+      OVERLAPPED* overlapped = nullptr;
+      BOOL ok = GetQueuedCompletionStatus(h_port, &bytes_transferred, &key, &overlapped, INFINITE);
+      DWORD error = ok ? ERROR_SUCCESS : GetLastError();
+
+      if (overlapped == nullptr) {
+        if (key != STOP_KEY) {
+          std::cerr << "GetQueuedCompletionStatus failed: " << error << '\n';
+        }
         break;
       }
 
-      // Wait for either a change notification or stop signal
-      DWORD wait_result = WaitForSingleObject(h_event, INFINITE);
+      std::lock_guard<std::mutex> lock(roots_mutex);
+      auto it = roots.find(static_cast<int>(key));
+      if (it == roots.end()) continue;
 
-      if (should_stop.load()) {
-        break;
+      WatchRoot& root = *it->second;
+      root.read_pending = false;
+      if (root.closing) {
+        close_root(root);
+        roots.erase(it);
+        continue;
       }
 
-      if (wait_result == WAIT_OBJECT_0) {
-        // Get the overlapped result
-        DWORD bytes_transferred;
-        if (GetOverlappedResult(h_directory, &overlapped, &bytes_transferred, FALSE)) {
-          process_file_changes(buffer, bytes_transferred);
-        }
+      if (error == ERROR_NOTIFY_ENUM_DIR || (error == ERROR_SUCCESS && bytes_transferred == 0)) {
+        // The kernel could not fit the changes into the buffer and discarded them
+        report_overflow(root);
+      } else if (error == ERROR_SUCCESS) {
+        process_file_changes(root, reinterpret_cast<const char*>(root.buffer.data()));
+      } else {
+        // Typically the root itself was deleted
+        std::cerr << "Directory read failed for " << root.path << ": " << error << '\n';
+        close_root(root);
+        roots.erase(it);
+        continue;
+      }
 
-        // Reset event for next iteration
-        ResetEvent(h_event);
+      if (!issue_read(root)) {
+        close_root(root);
+        roots.erase(it);
       }
     }
   }
 
-  void process_file_changes(const char* change_buffer, DWORD bytes_transferred) {
-    (void)bytes_transferred;  // Suppress unused parameter warning
+  void report_overflow(WatchRoot& root) {
+    std::cerr << "File change buffer overflowed, changes were dropped: " << root.path << '\n';
+    root.pending_rename_old_path.clear();
+    if (overflow_callback) {
+      overflow_callback(root.id);
+    }
+  }
 
+  void process_file_changes(WatchRoot& root, const char* change_buffer) {
+    const EventFilter* filter = root.filter;
     const FILE_NOTIFY_INFORMATION* p_notify = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(change_buffer);
 
     while (p_notify) {
@@ -267,34 +270,51 @@ class WindowsFileWatcher : public FileWatcherImpl {
       std::string file_name = wide_string_to_utf8(wide_name);
 
       // Create full path
-      std::string full_path = watched_path + "\\" + file_name;
+      std::string full_path = root.path + "\\" + file_name;
 
-      // Determine raw event type
-      FileEventType raw_event_type = FileEventType::Modified;  // Default
+      // Filter and forward the raw event; debouncing and coalescing happen in FileWatcher.
+      // Ignore rules are checked before anything touches the disk.
       switch (p_notify->Action) {
-        case FILE_ACTION_ADDED:
-          raw_event_type = FileEventType::Created;
+        case FILE_ACTION_ADDED: {
+          if (filter && filter->is_ignored(file_name)) break;
+          bool is_directory = is_directory_path(full_path);
+          if (filter && !is_directory && !filter->is_extension_allowed(file_name)) break;
+          callback(root.id, is_directory ? FileEventType::DirectoryCreated : FileEventType::Created, full_path, "",
+                   is_directory);
           break;
+        }
         case FILE_ACTION_REMOVED:
-          raw_event_type = FileEventType::Deleted;
-          break;
-        case FILE_ACTION_MODIFIED:
-          raw_event_type = FileEventType::Modified;
+          // The path is gone, so whether it was a directory is resolved by the coalescer. For the same reason
+          // only the ignore rules apply: a directory has no extension to check.
+          if (filter && filter->is_ignored(file_name)) break;
+          callback(root.id, FileEventType::Deleted, full_path, "", false);
           break;
         case FILE_ACTION_RENAMED_OLD_NAME:
-          // We'll handle rename in the next iteration
+          // The new name follows in the next notification
+          root.pending_rename_old_path = full_path;
+          root.pending_rename_old_name = file_name;
           break;
-        case FILE_ACTION_RENAMED_NEW_NAME:
-          raw_event_type = FileEventType::Renamed;
+        case FILE_ACTION_RENAMED_NEW_NAME: {
+          bool is_directory = is_directory_path(full_path);
+          if (root.pending_rename_old_path.empty()) {
+            // Moved in from outside the watched tree
+            if (filter && !filter->accepts(file_name, is_directory)) break;
+            callback(root.id, is_directory ? FileEventType::DirectoryCreated : FileEventType::Created, full_path,
+                     "", is_directory);
+          } else {
+            process_rename(root, full_path, file_name, is_directory);
+            root.pending_rename_old_path.clear();
+          }
           break;
+        }
+        case FILE_ACTION_MODIFIED:
         default:
-          raw_event_type = FileEventType::Modified;
+          // Directories are reported as modified when their contents change; the coalescer drops those anyway
+          if (filter && !filter->accepts(file_name, false)) break;
+          callback(root.id, FileEventType::Modified, full_path, "", false);
           break;
       }
 
-      // Process the raw event (will be debounced for Created/Modified)
-      process_raw_file_event(raw_event_type, full_path);
-
       // Move to next notification
       if (p_notify->NextEntryOffset == 0) {
         break;
@@ -304,6 +324,33 @@ class WindowsFileWatcher : public FileWatcherImpl {
     }
   }
 
+  void process_rename(const WatchRoot& root, const std::string& new_path, const std::string& new_name,
+                      bool is_directory) {
+    const std::string& old_path = root.pending_rename_old_path;
+    RenameFilterResult result = root.filter
+                                    ? root.filter->filter_rename(root.pending_rename_old_name, new_name, is_directory)
+                                    : RenameFilterResult::Keep;
+    switch (result) {
+      case RenameFilterResult::Keep:
+        callback(root.id, FileEventType::Renamed, new_path, old_path, is_directory);
+        break;
+      case RenameFilterResult::AsCreated:
+        callback(root.id, is_directory ? FileEventType::DirectoryCreated : FileEventType::Created, new_path, "",
+                 is_directory);
+        break;
+      case RenameFilterResult::AsDeleted:
+        callback(root.id, FileEventType::Deleted, old_path, "", is_directory);
+        break;
+      case RenameFilterResult::Drop:
+        break;
+    }
+  }
+
+  static bool is_directory_path(const std::string& path) {
+    std::error_code ec;
+    return std::filesystem::is_directory(std::filesystem::u8path(path), ec);
+  }
+
   // Helper function to convert wide string to UTF-8
   std::string wide_string_to_utf8(const std::wstring& wide_str) {
     if (wide_str.empty()) return std::string();
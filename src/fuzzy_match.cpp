@@ -0,0 +1,149 @@
+#include "fuzzy_match.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+// Scores follow fzf's: a match is worth 16, a gap costs 3 to open and 1 per extra character, and a consecutive
+// run earns at least what a gap would have cost
+constexpr int SCORE_MATCH = 16;
+constexpr int SCORE_GAP_START = -3;
+constexpr int SCORE_GAP_EXTENSION = -1;
+constexpr int BONUS_SEGMENT = 10;      // First character of a path segment
+constexpr int BONUS_BOUNDARY = 8;      // After '_', '-', '.' or a space, or the delimiter itself
+constexpr int BONUS_DIGIT_CHANGE = 7;  // Letter to digit or back, e.g. the 2 in "rock_lod2"
+constexpr int BONUS_CONSECUTIVE = -(SCORE_GAP_START + SCORE_GAP_EXTENSION);
+constexpr int BONUS_FIRST_CHARACTER_MULTIPLIER = 2;
+constexpr int BONUS_FILE_NAME = 2;   // Per term character, when the whole match is in the file name
+constexpr int BONUS_EXTENSION = 24;  // The term is the extension, with or without the dot
+
+namespace {
+
+enum class CharacterClass { Separator, Delimiter, Letter, Digit };
+
+CharacterClass classify(char c) {
+  if (c == '/' || c == '\\' || c == '\n') {
+    return CharacterClass::Separator;
+  }
+  if (c == '_' || c == '-' || c == '.' || c == ' ') {
+    return CharacterClass::Delimiter;
+  }
+  if (c >= '0' && c <= '9') {
+    return CharacterClass::Digit;
+  }
+  return CharacterClass::Letter;  // Including bytes of non-ASCII characters
+}
+
+int get_bonus(CharacterClass previous, CharacterClass current) {
+  if (current == CharacterClass::Separator || current == CharacterClass::Delimiter) {
+    return BONUS_BOUNDARY;
+  }
+  if (previous == CharacterClass::Separator) {
+    return BONUS_SEGMENT;
+  }
+  if (previous == CharacterClass::Delimiter) {
+    return BONUS_BOUNDARY;
+  }
+  if (previous != current) {
+    return BONUS_DIGIT_CHANGE;
+  }
+  return 0;
+}
+
+// Find a short window of `text` holding `term` as a subsequence: the earliest point where the whole term has
+// been seen, then back from there to the latest start
+bool find_window(std::string_view text, std::string_view term, size_t& begin, size_t& end) {
+  const char* position = text.data();
+  const char* text_end = text.data() + text.size();
+  for (char c : term) {
+    const void* found = std::memchr(position, c, text_end - position);
+    if (!found) {
+      return false;
+    }
+    position = static_cast<const char*>(found) + 1;
+  }
+  end = position - text.data();
+
+  size_t i = end;
+  size_t matched = term.size();
+  while (matched > 0) {
+    i--;
+    if (text[i] == term[matched - 1]) {
+      matched--;
+    }
+  }
+  begin = i;
+  return true;
+}
+
+int score_window(std::string_view text, std::string_view term, size_t begin, size_t end) {
+  int score = 0;
+  size_t matched = 0;
+  bool in_gap = false;
+  int consecutive = 0;
+  int first_bonus = 0;
+  CharacterClass previous = begin > 0 ? classify(text[begin - 1]) : CharacterClass::Separator;
+  for (size_t i = begin; i < end; i++) {
+    CharacterClass current = classify(text[i]);
+    if (matched < term.size() && text[i] == term[matched]) {
+      int bonus = get_bonus(previous, current);
+      if (consecutive == 0) {
+        first_bonus = bonus;
+      } else {
+        // A run keeps the bonus of its start, so "albedo" after '_' scores as a boundary match throughout
+        if (bonus >= BONUS_BOUNDARY && bonus > first_bonus) {
+          first_bonus = bonus;
+        }
+        bonus = std::max({bonus, first_bonus, BONUS_CONSECUTIVE});
+      }
+      score += SCORE_MATCH + (matched == 0 ? bonus * BONUS_FIRST_CHARACTER_MULTIPLIER : bonus);
+      in_gap = false;
+      consecutive++;
+      matched++;
+    } else {
+      score += in_gap ? SCORE_GAP_EXTENSION : SCORE_GAP_START;
+      in_gap = true;
+      consecutive = 0;
+      first_bonus = 0;
+    }
+    previous = current;
+  }
+  return score;
+}
+
+}  // namespace
+
+bool fuzzy_match(std::string_view key, std::string_view term, int& score) {
+  return fuzzy_match(key, get_key_layout(key), term, score);
+}
+
+bool fuzzy_match(std::string_view key, const KeyLayout& layout, std::string_view term, int& score) {
+  size_t begin = 0;
+  size_t end = 0;
+  if (term.empty()) {
+    score = 0;
+    return true;
+  }
+  if (!find_window(key, term, begin, end)) {
+    return false;
+  }
+  score = score_window(key, term, begin, end);
+
+  // The earliest match is often in a directory while the file name holds a better one
+  int file_name_bonus = BONUS_FILE_NAME * static_cast<int>(term.size());
+  if (begin >= layout.file_name_start && end <= layout.path_length) {
+    score += file_name_bonus;
+  } else {
+    std::string_view file_name = key.substr(layout.file_name_start, layout.path_length - layout.file_name_start);
+    if (find_window(file_name, term, begin, end)) {
+      size_t offset = layout.file_name_start;
+      score = std::max(score, score_window(key, term, offset + begin, offset + end) + file_name_bonus);
+    }
+  }
+
+  std::string_view extension = key.substr(layout.extension_start, layout.path_length - layout.extension_start);
+  if (!extension.empty() && (term == extension || term == extension.substr(1))) {
+    score += BONUS_EXTENSION;
+  }
+  return true;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <string_view>
+
+#include "search_index.h"
+
+// Score `term` as a fuzzy subsequence of `key`, in the style of fzf: every character of the term must appear in
+// the key in order, and the score rewards matches at word boundaries and path segments, consecutive runs,
+// matches in the file name and terms naming the extension, and penalizes gaps. Both must be lowercase; the
+// key is a search index key, whose first line is the asset's path.
+//
+// Returns false if the term isn't a subsequence of the key.
+bool fuzzy_match(std::string_view key, std::string_view term, int& score);
+
+// The same with the key's layout already known, as the search index keeps it
+bool fuzzy_match(std::string_view key, const KeyLayout& layout, std::string_view term, int& score);
@@ -0,0 +1,385 @@
+#include "image_resize.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_RESIZE_SSE2 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define IMAGE_RESIZE_AVX2_TARGET
+#else
+#define IMAGE_RESIZE_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define IMAGE_RESIZE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// Source pixels covering one destination pixel along an axis, with their normalized weights
+struct Contribution {
+  int first;
+  std::vector<float> weights;
+};
+
+std::vector<Contribution> box_contributions(int src_size, int dst_size) {
+  std::vector<Contribution> contributions(dst_size);
+  double scale = static_cast<double>(src_size) / dst_size;
+  for (int d = 0; d < dst_size; d++) {
+    double start = d * scale;
+    double end = (d + 1) * scale;
+    if (scale < 1.0) {
+      // Upscaling: a one pixel window centred on the sample point, which interpolates between neighbours
+      double center = (d + 0.5) * scale;
+      start = std::max(0.0, center - 0.5);
+      end = std::min(static_cast<double>(src_size), center + 0.5);
+    }
+    int first = std::min(static_cast<int>(std::floor(start)), src_size - 1);
+    int last = std::min(static_cast<int>(std::ceil(end)) - 1, src_size - 1);
+
+    Contribution& contribution = contributions[d];
+    contribution.first = first;
+    float total = 0.0f;
+    for (int s = first; s <= last; s++) {
+      float coverage = static_cast<float>(std::min<double>(s + 1, end) - std::max<double>(s, start));
+      contribution.weights.push_back(std::max(coverage, 0.0f));
+      total += contribution.weights.back();
+    }
+    for (float& weight : contribution.weights) {
+      weight /= total;
+    }
+  }
+  return contributions;
+}
+
+// sRGB-encoded byte to linear light, kept on the 0..255 scale so both paths share the vertical pass
+const float* srgb_to_linear_table() {
+  static const std::array<float, 256> table = [] {
+    std::array<float, 256> values{};
+    for (int i = 0; i < 256; i++) {
+      double c = i / 255.0;
+      double linear = c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+      values[i] = static_cast<float>(linear * 255.0);
+    }
+    return values;
+  }();
+  return table.data();
+}
+
+// Linear light on the 0..255 scale back to an sRGB-encoded byte. 4096 steps keep the dark end, where the
+// curve is steepest, within one output level.
+unsigned char linear_to_srgb(float value) {
+  static const std::array<unsigned char, 4096> table = [] {
+    std::array<unsigned char, 4096> values{};
+    for (int i = 0; i < 4096; i++) {
+      double linear = i / 4095.0;
+      double c = linear <= 0.0031308 ? linear * 12.92 : 1.055 * std::pow(linear, 1.0 / 2.4) - 0.055;
+      values[i] = static_cast<unsigned char>(std::clamp(c * 255.0 + 0.5, 0.0, 255.0));
+    }
+    return values;
+  }();
+  int index = static_cast<int>(value * (4095.0f / 255.0f) + 0.5f);
+  return table[std::clamp(index, 0, 4095)];
+}
+
+// One source row filtered horizontally into dst_width RGBA float pixels. `linear` is the sRGB-to-linear
+// table when filtering in linear light.
+using HorizontalKernel = void (*)(const unsigned char* src_row, const std::vector<Contribution>& columns,
+                                  const float* linear, float* out);
+
+// acc[i] += in[i] * weight
+using AccumulateKernel = void (*)(float* acc, const float* in, float weight, size_t count);
+
+// Round and clamp floats to bytes
+using StoreKernel = void (*)(const float* values, unsigned char* out, size_t count);
+
+struct Kernels {
+  const char* name;
+  HorizontalKernel horizontal;
+  HorizontalKernel horizontal_linear;
+  AccumulateKernel accumulate;
+  StoreKernel store;
+};
+
+template <bool Linear>
+void horizontal_scalar(const unsigned char* src_row, const std::vector<Contribution>& columns, const float* linear,
+                       float* out) {
+  for (const Contribution& column : columns) {
+    // Even and odd pixels are summed separately, in the same order as the SIMD kernels
+    float even[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    float odd[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    const unsigned char* pixel = src_row + static_cast<size_t>(column.first) * 4;
+    size_t count = column.weights.size();
+    for (size_t k = 0; k < count; k += 2, pixel += 8) {
+      for (int c = 0; c < 4; c++) {
+        float value = (Linear && c < 3) ? linear[pixel[c]] : static_cast<float>(pixel[c]);
+        even[c] += value * column.weights[k];
+      }
+      if (k + 1 < count) {
+        for (int c = 0; c < 4; c++) {
+          float value = (Linear && c < 3) ? linear[pixel[4 + c]] : static_cast<float>(pixel[4 + c]);
+          odd[c] += value * column.weights[k + 1];
+        }
+      }
+    }
+    for (int c = 0; c < 4; c++) {
+      out[c] = even[c] + odd[c];
+    }
+    out += 4;
+  }
+}
+
+void accumulate_scalar(float* acc, const float* in, float weight, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    acc[i] += in[i] * weight;
+  }
+}
+
+void store_scalar(const float* values, unsigned char* out, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    out[i] = static_cast<unsigned char>(std::min(255.0f, values[i] + 0.5f));
+  }
+}
+
+// Linear-light results go back through the sRGB curve; alpha was never converted
+void store_linear(const float* values, unsigned char* out, size_t count) {
+  for (size_t i = 0; i < count; i += 4) {
+    out[i] = linear_to_srgb(values[i]);
+    out[i + 1] = linear_to_srgb(values[i + 1]);
+    out[i + 2] = linear_to_srgb(values[i + 2]);
+    out[i + 3] = static_cast<unsigned char>(std::min(255.0f, values[i + 3] + 0.5f));
+  }
+}
+
+const Kernels SCALAR_KERNELS = {"scalar", horizontal_scalar<false>, horizontal_scalar<true>, accumulate_scalar,
+                                store_scalar};
+
+#if IMAGE_RESIZE_SSE2
+
+// Each pixel is one 4-lane vector, one lane per channel
+template <bool Linear>
+void horizontal_sse2(const unsigned char* src_row, const std::vector<Contribution>& columns, const float* linear,
+                     float* out) {
+  const __m128i zero = _mm_setzero_si128();
+  for (const Contribution& column : columns) {
+    // Two sums, for even and odd pixels, so consecutive additions don't wait on each other
+    __m128 even_sum = _mm_setzero_ps();
+    __m128 odd_sum = _mm_setzero_ps();
+    const unsigned char* pixel = src_row + static_cast<size_t>(column.first) * 4;
+    const float* weight = column.weights.data();
+    size_t count = column.weights.size();
+    size_t k = 0;
+    for (; k + 2 <= count; k += 2, pixel += 8) {
+      __m128 even;
+      __m128 odd;
+      if (Linear) {
+        even = _mm_set_ps(static_cast<float>(pixel[3]), linear[pixel[2]], linear[pixel[1]], linear[pixel[0]]);
+        odd = _mm_set_ps(static_cast<float>(pixel[7]), linear[pixel[6]], linear[pixel[5]], linear[pixel[4]]);
+      } else {
+        __m128i words = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixel)), zero);
+        even = _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+        odd = _mm_cvtepi32_ps(_mm_unpackhi_epi16(words, zero));
+      }
+      even_sum = _mm_add_ps(even_sum, _mm_mul_ps(even, _mm_set1_ps(weight[k])));
+      odd_sum = _mm_add_ps(odd_sum, _mm_mul_ps(odd, _mm_set1_ps(weight[k + 1])));
+    }
+    if (k < count) {
+      __m128 last;
+      if (Linear) {
+        last = _mm_set_ps(static_cast<float>(pixel[3]), linear[pixel[2]], linear[pixel[1]], linear[pixel[0]]);
+      } else {
+        int32_t bits;
+        std::memcpy(&bits, pixel, 4);
+        last = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(bits), zero), zero));
+      }
+      even_sum = _mm_add_ps(even_sum, _mm_mul_ps(last, _mm_set1_ps(weight[k])));
+    }
+    _mm_storeu_ps(out, _mm_add_ps(even_sum, odd_sum));
+    out += 4;
+  }
+}
+
+void accumulate_sse2(float* acc, const float* in, float weight, size_t count) {
+  const __m128 w = _mm_set1_ps(weight);
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(_mm_loadu_ps(in + i), w)));
+  }
+  accumulate_scalar(acc + i, in + i, weight, count - i);
+}
+
+void store_sse2(const float* values, unsigned char* out, size_t count) {
+  const __m128 half = _mm_set1_ps(0.5f);
+  size_t i = 0;
+  for (; i + 16 <= count; i += 16) {
+    __m128i a = _mm_cvttps_epi32(_mm_add_ps(_mm_loadu_ps(values + i), half));
+    __m128i b = _mm_cvttps_epi32(_mm_add_ps(_mm_loadu_ps(values + i + 4), half));
+    __m128i c = _mm_cvttps_epi32(_mm_add_ps(_mm_loadu_ps(values + i + 8), half));
+    __m128i d = _mm_cvttps_epi32(_mm_add_ps(_mm_loadu_ps(values + i + 12), half));
+    __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), bytes);
+  }
+  store_scalar(values + i, out + i, count - i);
+}
+
+IMAGE_RESIZE_AVX2_TARGET void accumulate_avx2(float* acc, const float* in, float weight, size_t count) {
+  const __m256 w = _mm256_set1_ps(weight);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    _mm256_storeu_ps(acc + i, _mm256_add_ps(_mm256_loadu_ps(acc + i), _mm256_mul_ps(_mm256_loadu_ps(in + i), w)));
+  }
+  accumulate_scalar(acc + i, in + i, weight, count - i);
+}
+
+bool cpu_has_avx2() {
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7) {
+    return false;
+  }
+  __cpuid(info, 1);
+  bool os_saves_ymm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 6) == 6;
+  __cpuidex(info, 7, 0);
+  return os_saves_ymm && (info[1] & (1 << 5)) != 0;
+#else
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+
+const Kernels SSE2_KERNELS = {"SSE2", horizontal_sse2<false>, horizontal_sse2<true>, accumulate_sse2, store_sse2};
+const Kernels AVX2_KERNELS = {"AVX2", horizontal_sse2<false>, horizontal_sse2<true>, accumulate_avx2, store_sse2};
+
+#elif IMAGE_RESIZE_NEON
+
+template <bool Linear>
+void horizontal_neon(const unsigned char* src_row, const std::vector<Contribution>& columns, const float* linear,
+                     float* out) {
+  for (const Contribution& column : columns) {
+    float32x4_t sum = vdupq_n_f32(0.0f);
+    const unsigned char* pixel = src_row + static_cast<size_t>(column.first) * 4;
+    float32x4_t odd_sum = vdupq_n_f32(0.0f);
+    for (size_t k = 0; k < column.weights.size(); k++) {
+      float32x4_t value;
+      if (Linear) {
+        float channels[4] = {linear[pixel[0]], linear[pixel[1]], linear[pixel[2]], static_cast<float>(pixel[3])};
+        value = vld1q_f32(channels);
+      } else {
+        uint32_t bits;
+        std::memcpy(&bits, pixel, 4);
+        uint16x8_t widened = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(bits)));
+        value = vcvtq_f32_u32(vmovl_u16(vget_low_u16(widened)));
+      }
+      // Even and odd pixels are summed separately, in the same order as the other kernels
+      if (k & 1) {
+        odd_sum = vaddq_f32(odd_sum, vmulq_n_f32(value, column.weights[k]));
+      } else {
+        sum = vaddq_f32(sum, vmulq_n_f32(value, column.weights[k]));
+      }
+      pixel += 4;
+    }
+    vst1q_f32(out, vaddq_f32(sum, odd_sum));
+    out += 4;
+  }
+}
+
+void accumulate_neon(float* acc, const float* in, float weight, size_t count) {
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    vst1q_f32(acc + i, vaddq_f32(vld1q_f32(acc + i), vmulq_n_f32(vld1q_f32(in + i), weight)));
+  }
+  accumulate_scalar(acc + i, in + i, weight, count - i);
+}
+
+void store_neon(const float* values, unsigned char* out, size_t count) {
+  const float32x4_t half = vdupq_n_f32(0.5f);
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    uint32x4_t a = vcvtq_u32_f32(vaddq_f32(vld1q_f32(values + i), half));
+    uint32x4_t b = vcvtq_u32_f32(vaddq_f32(vld1q_f32(values + i + 4), half));
+    vst1_u8(out + i, vqmovn_u16(vcombine_u16(vqmovn_u32(a), vqmovn_u32(b))));
+  }
+  store_scalar(values + i, out + i, count - i);
+}
+
+const Kernels NEON_KERNELS = {"NEON", horizontal_neon<false>, horizontal_neon<true>, accumulate_neon, store_neon};
+
+#endif
+
+const Kernels& best_kernels() {
+#if IMAGE_RESIZE_SSE2
+  static const Kernels& kernels = cpu_has_avx2() ? AVX2_KERNELS : SSE2_KERNELS;
+  return kernels;
+#elif IMAGE_RESIZE_NEON
+  return NEON_KERNELS;
+#else
+  return SCALAR_KERNELS;
+#endif
+}
+
+}  // namespace
+
+void resize_rgba8(const unsigned char* src, int src_width, int src_height, unsigned char* dst, int dst_width,
+                  int dst_height, const ResizeOptions& options) {
+  if (src_width <= 0 || src_height <= 0 || dst_width <= 0 || dst_height <= 0) {
+    return;
+  }
+
+  const Kernels& kernels = options.force_scalar ? SCALAR_KERNELS : best_kernels();
+  const float* linear = options.gamma_correct ? srgb_to_linear_table() : nullptr;
+  HorizontalKernel horizontal = linear ? kernels.horizontal_linear : kernels.horizontal;
+  std::vector<Contribution> columns = box_contributions(src_width, dst_width);
+  std::vector<Contribution> rows = box_contributions(src_height, dst_height);
+
+  // Source rows are filtered horizontally one at a time and accumulated straight into the destination row,
+  // so the working set is two rows of dst_width floats however large the source is. When downscaling, the
+  // only row shared by two destination rows is the boundary one, which stays in `filtered` for the next row.
+  size_t row_floats = static_cast<size_t>(dst_width) * 4;
+  std::vector<float> filtered(row_floats);
+  std::vector<float> accumulator(row_floats);
+  int filtered_row = -1;
+  for (int y = 0; y < dst_height; y++) {
+    const Contribution& row = rows[y];
+    std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+    for (size_t k = 0; k < row.weights.size(); k++) {
+      int src_y = row.first + static_cast<int>(k);
+      if (src_y != filtered_row) {
+        horizontal(src + static_cast<size_t>(src_y) * src_width * 4, columns, linear, filtered.data());
+        filtered_row = src_y;
+      }
+      kernels.accumulate(accumulator.data(), filtered.data(), row.weights[k], row_floats);
+    }
+
+    unsigned char* out = dst + static_cast<size_t>(y) * row_floats;
+    if (linear) {
+      store_linear(accumulator.data(), out, row_floats);
+    } else {
+      kernels.store(accumulator.data(), out, row_floats);
+    }
+  }
+}
+
+const char* get_resize_kernel_name() { return best_kernels().name; }
+
+void fit_within(int width, int height, int max_size, int& out_width, int& out_height) {
+  if (width <= max_size && height <= max_size) {
+    out_width = std::max(width, 1);
+    out_height = std::max(height, 1);
+    return;
+  }
+  if (width >= height) {
+    out_width = max_size;
+    out_height = std::max(1, static_cast<int>(std::lround(static_cast<double>(height) * max_size / width)));
+  } else {
+    out_height = max_size;
+    out_width = std::max(1, static_cast<int>(std::lround(static_cast<double>(width) * max_size / height)));
+  }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+struct ResizeOptions {
+  // Average in linear light instead of on the sRGB-encoded values, so fine light/dark detail doesn't darken
+  // when it's averaged away. Alpha is always averaged as is.
+  bool gamma_correct = false;
+
+  // Skip the SIMD kernels, for tests and benchmarks
+  bool force_scalar = false;
+};
+
+// Downscale an RGBA8 image with an area-averaging (box) filter: every destination pixel is the mean of the
+// source pixels it covers, weighted by coverage. Upscaling interpolates between neighbouring pixels.
+// Runs on AVX2, SSE2 or NEON when available; all kernels give the same result as the scalar one up to
+// rounding.
+void resize_rgba8(const unsigned char* src, int src_width, int src_height, unsigned char* dst, int dst_width,
+                  int dst_height, const ResizeOptions& options = ResizeOptions());
+
+// Name of the kernel resize_rgba8() picks on this CPU: "AVX2", "SSE2", "NEON" or "scalar"
+const char* get_resize_kernel_name();
+
+// Largest size with the aspect ratio of `width` x `height` that fits in `max_size` x `max_size`.
+// Never larger than the source; both sides are at least 1.
+void fit_within(int width, int height, int max_size, int& out_width, int& out_height);
@@ -0,0 +1,203 @@
+// Headless indexer: watches one or more roots and keeps the asset database current, without a window or GPU.
+// Runs until interrupted (Ctrl+C or SIGTERM), then applies what is still queued and exits.
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asset_database.h"
+#include "asset_indexer.h"
+#include "file_watcher.h"
+#include "metadata_extractor.h"
+#include "metadata_store.h"
+
+// How often the main thread checks for a stop request
+constexpr auto STOP_POLL_INTERVAL = std::chrono::milliseconds(200);
+
+// Seconds between progress reports unless --stats-interval says otherwise
+constexpr int DEFAULT_STATS_INTERVAL_S = 60;
+
+static std::atomic<bool> g_should_stop(false);
+
+static void on_stop_signal(int /*signal*/) { g_should_stop = true; }
+
+struct Options {
+  std::string database_path = "db/assets.db";
+  std::vector<std::string> roots;
+  std::vector<std::string> ignore_patterns = get_default_ignore_patterns();
+  int stats_interval_s = DEFAULT_STATS_INTERVAL_S;  // 0 only reports at exit
+};
+
+bool parse_options(int argc, char* argv[], Options& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--db" && has_value) {
+      options.database_path = argv[++i];
+    } else if (arg == "--ignore" && has_value) {
+      options.ignore_patterns.push_back(argv[++i]);
+    } else if (arg == "--stats-interval" && has_value && std::atoi(argv[i + 1]) >= 0) {
+      options.stats_interval_s = std::atoi(argv[++i]);
+    } else if (!arg.empty() && arg[0] != '-') {
+      options.roots.push_back(arg);
+    } else {
+      std::cerr << "Unknown or incomplete option: " << arg << '\n';
+      std::cerr << "Usage: AssetIndexerDaemon [--db FILE] [--ignore GLOB]... [--stats-interval SECONDS] [ROOT]...\n";
+      return false;
+    }
+  }
+  if (options.roots.empty()) {
+    options.roots.push_back("assets");
+  }
+  return true;
+}
+
+// Absolute, normalized and without a trailing separator, so paths in the database don't depend on the directory
+// the daemon was started from
+std::string normalize_root(const std::string& path) {
+  std::error_code ec;
+  std::filesystem::path absolute = std::filesystem::absolute(path, ec);
+  if (ec) {
+    return path;
+  }
+  absolute = absolute.lexically_normal();
+  if (!absolute.has_filename() && absolute.has_parent_path() && absolute != absolute.root_path()) {
+    absolute = absolute.parent_path();
+  }
+  return absolute.string();
+}
+
+// Whether `path` is `directory` or lies below it
+bool is_within(const std::string& path, const std::string& directory) {
+  if (path.compare(0, directory.size(), directory) != 0) {
+    return false;
+  }
+  return path.size() == directory.size() || path[directory.size()] == '/' || path[directory.size()] == '\\';
+}
+
+void print_stats(const AssetIndexerStats& indexer_stats, const FileWatcherStats& watcher_stats) {
+  std::cout << "Scanned " << indexer_stats.scanned << " path(s), applied " << indexer_stats.events_applied
+            << " event(s) in " << indexer_stats.batches << " batch(es), " << indexer_stats.apply_time.count() / 1000
+            << "ms, listed " << indexer_stats.archives_listed << " archive(s); watcher saw "
+            << watcher_stats.raw_events << " raw event(s), " << watcher_stats.overflow_count << " overflow(s), "
+            << watcher_stats.resync_count << " resync(s)\n";
+}
+
+void print_extractor_stats(const MetadataExtractorStats& stats) {
+  std::cout << "Extracted metadata from " << stats.extracted << " file(s), "
+            << stats.bytes / (1024 * 1024) << " MB in " << stats.extract_time.count() / 1000 << "ms of worker time; "
+            << stats.skipped << " already current, " << stats.failed << " failed\n";
+}
+
+int main(int argc, char* argv[]) {
+  Options options;
+  if (!parse_options(argc, argv, options)) {
+    return 1;
+  }
+
+  std::vector<std::string> roots;
+  for (const auto& root : options.roots) {
+    std::string normalized = normalize_root(root);
+    for (const auto& other : roots) {
+      if (is_within(normalized, other) || is_within(other, normalized)) {
+        std::cerr << "Roots must not overlap: " << other << " and " << normalized << '\n';
+        return 1;
+      }
+    }
+    roots.push_back(normalized);
+  }
+
+  AssetDatabase database;
+  if (!database.initialize(options.database_path)) {
+    std::cerr << "Failed to open database: " << options.database_path << '\n';
+    return 1;
+  }
+
+  // Metadata is a side table of the same file; without it the daemon still indexes
+  MetadataStore metadata_store;
+  if (!metadata_store.initialize(options.database_path)) {
+    std::cerr << "Model and sound metadata will not be extracted\n";
+  }
+  MetadataExtractor extractor(metadata_store);
+
+  FileWatcher watcher;
+  AssetIndexer indexer(database, watcher);
+  if (metadata_store.is_open()) {
+    indexer.set_archive_store(&metadata_store);
+  }
+  WatchRootOptions watch_options;
+  watch_options.ignore_patterns = options.ignore_patterns;
+  std::vector<int> root_ids;
+  for (const auto& root : roots) {
+    int root_id = watcher.add_root(root, watch_options);
+    if (root_id < 0) {
+      return 1;
+    }
+    root_ids.push_back(root_id);
+  }
+
+  // Watch before scanning, so nothing changed during the scan is missed. Events are only queued until the
+  // indexer starts, and applying them after the scan is harmless: each one re-reads the file system.
+  if (!watcher.start([&indexer](const FileEvent& event) { indexer.push(event); })) {
+    std::cerr << "Failed to start file watcher\n";
+    return 1;
+  }
+
+  auto scan_start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < roots.size(); i++) {
+    size_t indexed = indexer.scan_root(root_ids[i]);
+    std::cout << "Scanned " << indexed << " path(s) under " << roots[i] << '\n';
+  }
+  std::cout << "Initial scan took "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - scan_start)
+                   .count()
+            << "ms\n";
+  if (metadata_store.is_open()) {
+    extractor.enqueue(database.get_assets_by_type(AssetType::Model));
+    extractor.enqueue(database.get_assets_by_type(AssetType::Sound));
+    extractor.start();
+    indexer.set_batch_callback(
+        [&extractor](uint64_t /*applied*/, std::vector<AssetChange>& changes) { extractor.apply(changes); });
+  }
+  indexer.start();
+
+  std::signal(SIGINT, on_stop_signal);
+  std::signal(SIGTERM, on_stop_signal);
+  std::cout << "Watching " << roots.size() << " root(s); stop with Ctrl+C\n";
+
+  // Progress is only reported when something happened since the last report
+  auto next_report = std::chrono::steady_clock::now() + std::chrono::seconds(options.stats_interval_s);
+  uint64_t reported_events = 0;
+  while (!g_should_stop) {
+    std::this_thread::sleep_for(STOP_POLL_INTERVAL);
+    if (options.stats_interval_s > 0 && std::chrono::steady_clock::now() >= next_report) {
+      FileWatcherStats watcher_stats = watcher.get_stats();
+      if (watcher_stats.raw_events != reported_events) {
+        print_stats(indexer.get_stats(), watcher_stats);
+        reported_events = watcher_stats.raw_events;
+      }
+      next_report += std::chrono::seconds(options.stats_interval_s);
+    }
+  }
+
+  // The watcher forgets its roots, and their counters, when it stops
+  std::cout << "Stopping...\n";
+  FileWatcherStats watcher_stats = watcher.get_stats();
+  watcher.stop_watching();
+  indexer.stop();
+  extractor.stop();
+  print_stats(indexer.get_stats(), watcher_stats);
+  if (metadata_store.is_open()) {
+    print_extractor_stats(extractor.get_stats());
+  }
+  metadata_store.close();
+  database.close();
+  return 0;
+}
@@ -0,0 +1,696 @@
+#include "jpeg_decoder.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+
+namespace {
+
+constexpr int MAX_COMPONENTS = 3;
+constexpr int MAX_SAMPLING = 4;
+
+// Huffman codes up to this long are decoded with one table lookup
+constexpr int FAST_BITS = 9;
+
+// Images larger than this on a side are taken for corrupt headers
+constexpr int MAX_JPEG_SIZE = 1 << 16;
+
+// Natural (row-major) position of each coefficient in zigzag order
+constexpr uint8_t ZIGZAG[64] = {
+    0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,  12, 19, 26, 33, 40, 48,
+    41, 34, 27, 20, 13, 6,  7,  14, 21, 28, 35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23,
+    30, 37, 44, 51, 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+struct HuffmanTable {
+  bool defined = false;
+  std::array<uint16_t, 1 << FAST_BITS> fast{};  // Length << 8 | symbol for short codes, 0 for longer ones
+  std::array<int32_t, 17> max_code{};           // Largest code of each length, -1 if there is none
+  std::array<int32_t, 17> value_offset{};       // Added to a code to find its symbol
+  std::array<uint8_t, 256> symbols{};
+};
+
+struct Component {
+  int id = 0;
+  int h = 1;  // Sampling factors
+  int v = 1;
+  int quant_table = 0;
+  int dc_table = 0;
+  int ac_table = 0;
+  int predictor = 0;
+  int plane_width = 0;  // Of the reduced samples, in whole blocks
+  std::vector<unsigned char> plane;
+};
+
+struct Frame {
+  JpegInfo info;
+  bool has_frame = false;
+  int adobe_transform = -1;  // From an Adobe APP14 segment; 0 means the components are RGB
+  int restart_interval = 0;
+  std::array<std::array<uint16_t, 64>, 4> quant{};  // In natural order
+  std::array<HuffmanTable, 4> dc_tables;
+  std::array<HuffmanTable, 4> ac_tables;
+  std::array<Component, MAX_COMPONENTS> components;
+};
+
+uint32_t read_be16(const unsigned char* data) { return static_cast<uint32_t>(data[0] << 8 | data[1]); }
+
+// Reads the entropy-coded data of a scan, dropping stuffed zero bytes. At a marker it stops and feeds zeros.
+class BitReader {
+ public:
+  BitReader(const unsigned char* scan_data, size_t scan_size)
+      : data(scan_data), size(scan_size), position(0), buffer(0), count(0), at_marker(false) {}
+
+  // Keep at least 25 bits buffered
+  void fill() {
+    while (count <= 24) {
+      uint32_t byte = 0;
+      if (!at_marker && position < size) {
+        byte = data[position];
+        if (byte == 0xFF) {
+          unsigned char next = position + 1 < size ? data[position + 1] : 0;
+          if (next == 0) {
+            position += 2;
+          } else {
+            at_marker = true;
+            byte = 0;
+          }
+        } else {
+          position++;
+        }
+      }
+      buffer |= byte << (24 - count);
+      count += 8;
+    }
+  }
+
+  uint32_t peek(int bits) const { return buffer >> (32 - bits); }
+
+  void skip(int bits) {
+    buffer <<= bits;
+    count -= bits;
+  }
+
+  int get(int bits) {
+    fill();
+    int value = static_cast<int>(peek(bits));
+    skip(bits);
+    return value;
+  }
+
+  // Drop the bits left before a restart marker and step over it
+  void restart() {
+    buffer = 0;
+    count = 0;
+    while (position + 1 < size && !(data[position] == 0xFF && (data[position + 1] & 0xF8) == 0xD0)) {
+      position++;
+    }
+    position = std::min(position + 2, size);
+    at_marker = false;
+  }
+
+ private:
+  const unsigned char* data;
+  size_t size;
+  size_t position;
+  uint32_t buffer;  // Next bits, most significant first
+  int count;
+  bool at_marker;
+};
+
+bool build_huffman_table(const unsigned char* counts, const unsigned char* symbols, int total, HuffmanTable& table) {
+  table = HuffmanTable();
+  std::copy(symbols, symbols + total, table.symbols.begin());
+  int32_t code = 0;
+  int index = 0;
+  for (int length = 1; length <= 16; length++) {
+    table.value_offset[length] = index - code;
+    for (int i = 0; i < counts[length - 1]; i++, code++, index++) {
+      if (length <= FAST_BITS) {
+        int shift = FAST_BITS - length;
+        for (int fill = 0; fill < (1 << shift); fill++) {
+          table.fast[(code << shift) | fill] = static_cast<uint16_t>(length << 8 | symbols[index]);
+        }
+      }
+    }
+    table.max_code[length] = counts[length - 1] > 0 ? code - 1 : -1;
+    if (code > (1 << length)) {
+      return false;  // More codes than fit in this length
+    }
+    code <<= 1;
+  }
+  table.defined = true;
+  return true;
+}
+
+int decode_symbol(BitReader& bits, const HuffmanTable& table) {
+  bits.fill();
+  uint16_t entry = table.fast[bits.peek(FAST_BITS)];
+  if (entry != 0) {
+    bits.skip(entry >> 8);
+    return entry & 0xFF;
+  }
+  uint32_t code = bits.peek(16);
+  for (int length = FAST_BITS + 1; length <= 16; length++) {
+    int32_t prefix = static_cast<int32_t>(code >> (16 - length));
+    if (prefix <= table.max_code[length]) {
+      bits.skip(length);
+      return table.symbols[static_cast<size_t>(prefix + table.value_offset[length]) & 0xFF];
+    }
+  }
+  return -1;
+}
+
+// The signed value of an `bits`-bit magnitude category
+int extend(int value, int bits) { return value < (1 << (bits - 1)) ? value - (1 << bits) + 1 : value; }
+
+// Where an output pixel falls in a plane sampled at `sampling` of `max_sampling`: two neighbouring samples and
+// the weight of the second, out of 256
+struct SampleTap {
+  size_t first = 0;
+  size_t second = 0;
+  int weight = 0;
+};
+
+SampleTap make_tap(int index, int sampling, int max_sampling, int limit) {
+  SampleTap tap;
+  if (sampling == max_sampling) {
+    tap.first = tap.second = static_cast<size_t>(index);
+    return tap;
+  }
+  // Sample centers sit in the middle of the pixels they cover
+  double position = (index + 0.5) * sampling / max_sampling - 0.5;
+  double first = std::floor(position);
+  tap.first = static_cast<size_t>(std::clamp(static_cast<int>(first), 0, limit - 1));
+  tap.second = static_cast<size_t>(std::clamp(static_cast<int>(first) + 1, 0, limit - 1));
+  tap.weight = static_cast<int>(std::lround((position - first) * 256));
+  return tap;
+}
+
+// Inverse DCT basis for `size` outputs per block: c(u) / 2 * cos((2x + 1) * u * pi / (2 * size)), the 8-point
+// basis with its cosines stretched over fewer samples, so a block's average stays the same
+std::array<float, 64> make_idct_table(int size) {
+  const double pi = 3.14159265358979323846;
+  std::array<float, 64> table{};
+  for (int x = 0; x < size; x++) {
+    for (int u = 0; u < size; u++) {
+      double c = u == 0 ? std::sqrt(0.5) : 1.0;
+      double angle = (2 * x + 1) * u * pi / (2 * size);
+      table[static_cast<size_t>(x * size + u)] = static_cast<float>(c / 2 * std::cos(angle));
+    }
+  }
+  return table;
+}
+
+// Decode one block, keeping the coefficients of its lowest `size` x `size` frequencies, dequantized
+bool decode_block(BitReader& bits, const HuffmanTable& dc, const HuffmanTable& ac, const uint16_t* quant, int size,
+                  int& predictor, float* coefficients) {
+  int category = decode_symbol(bits, dc);
+  if (category < 0 || category > 11) {
+    return false;
+  }
+  if (category > 0) {
+    predictor += extend(bits.get(category), category);
+  }
+  std::fill(coefficients, coefficients + size * size, 0.0f);
+  coefficients[0] = static_cast<float>(predictor * quant[0]);
+
+  for (int k = 1; k < 64;) {
+    int symbol = decode_symbol(bits, ac);
+    if (symbol < 0) {
+      return false;
+    }
+    int run = symbol >> 4;
+    int category_bits = symbol & 0xF;
+    if (category_bits == 0) {
+      if (run != 15) {
+        break;  // End of block
+      }
+      k += 16;
+      continue;
+    }
+    k += run;
+    if (k > 63) {
+      return false;
+    }
+    int value = extend(bits.get(category_bits), category_bits);
+    int natural = ZIGZAG[k++];
+    int row = natural / 8;
+    int column = natural % 8;
+    if (row < size && column < size) {
+      coefficients[row * size + column] = static_cast<float>(value * quant[natural]);
+    }
+  }
+  return true;
+}
+
+// Inverse DCT of `size` x `size` coefficients into samples of a plane
+void inverse_dct(const float* coefficients, const std::array<float, 64>& table, int size, unsigned char* out,
+                 int stride) {
+  float rows[64];
+  for (int v = 0; v < size; v++) {
+    for (int x = 0; x < size; x++) {
+      float sum = 0.0f;
+      for (int u = 0; u < size; u++) {
+        sum += coefficients[v * size + u] * table[static_cast<size_t>(x * size + u)];
+      }
+      rows[v * size + x] = sum;
+    }
+  }
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      float sum = 128.0f;
+      for (int v = 0; v < size; v++) {
+        sum += rows[v * size + x] * table[static_cast<size_t>(y * size + v)];
+      }
+      out[y * stride + x] = static_cast<unsigned char>(std::clamp(std::lround(sum), 0L, 255L));
+    }
+  }
+}
+
+bool parse_frame_header(const unsigned char* segment, size_t length, bool is_baseline, Frame& frame) {
+  if (length < 6) {
+    return false;
+  }
+  JpegInfo& info = frame.info;
+  info.height = static_cast<int>(read_be16(segment + 1));
+  info.width = static_cast<int>(read_be16(segment + 3));
+  info.components = segment[5];
+  info.is_baseline = is_baseline && segment[0] == 8 && (info.components == 1 || info.components == 3);
+  if (info.width <= 0 || info.height <= 0 || info.width > MAX_JPEG_SIZE || info.height > MAX_JPEG_SIZE ||
+      length < 6 + static_cast<size_t>(info.components) * 3) {
+    return false;
+  }
+  for (int i = 0; i < info.components && i < MAX_COMPONENTS; i++) {
+    Component& component = frame.components[static_cast<size_t>(i)];
+    const unsigned char* spec = segment + 6 + i * 3;
+    component.id = spec[0];
+    component.h = spec[1] >> 4;
+    component.v = spec[1] & 0xF;
+    component.quant_table = spec[2] & 3;
+    if (component.h < 1 || component.h > MAX_SAMPLING || component.v < 1 || component.v > MAX_SAMPLING) {
+      info.is_baseline = false;
+    }
+  }
+  frame.has_frame = true;
+  return true;
+}
+
+bool parse_quant_tables(const unsigned char* segment, size_t length, Frame& frame) {
+  size_t position = 0;
+  while (position < length) {
+    int precision = segment[position] >> 4;
+    int id = segment[position] & 3;
+    size_t entry_size = precision ? 2 : 1;
+    if (position + 1 + 64 * entry_size > length) {
+      return false;
+    }
+    const unsigned char* values = segment + position + 1;
+    for (int i = 0; i < 64; i++) {
+      frame.quant[static_cast<size_t>(id)][ZIGZAG[i]] =
+          static_cast<uint16_t>(precision ? read_be16(values + i * 2) : values[i]);
+    }
+    position += 1 + 64 * entry_size;
+  }
+  return true;
+}
+
+bool parse_huffman_tables(const unsigned char* segment, size_t length, Frame& frame) {
+  size_t position = 0;
+  while (position + 17 <= length) {
+    int table_class = segment[position] >> 4;
+    int id = segment[position] & 3;
+    const unsigned char* counts = segment + position + 1;
+    int total = 0;
+    for (int i = 0; i < 16; i++) {
+      total += counts[i];
+    }
+    if (total > 256 || position + 17 + static_cast<size_t>(total) > length) {
+      return false;
+    }
+    HuffmanTable& table = table_class == 0 ? frame.dc_tables[static_cast<size_t>(id)]
+                                           : frame.ac_tables[static_cast<size_t>(id)];
+    if (!build_huffman_table(counts, segment + position + 17, total, table)) {
+      return false;
+    }
+    position += 17 + static_cast<size_t>(total);
+  }
+  return position == length;
+}
+
+// Decode the scan into per-component planes at 1/scale, then convert them to RGBA
+bool decode_scan(const unsigned char* data, size_t size, int scale, Frame& frame, std::vector<unsigned char>& pixels,
+                 int& width, int& height) {
+  const JpegInfo& info = frame.info;
+  int component_count = info.components;
+  if (component_count == 1) {
+    frame.components[0].h = frame.components[0].v = 1;  // A single component is never interleaved
+  }
+  int max_h = 1;
+  int max_v = 1;
+  for (int c = 0; c < component_count; c++) {
+    max_h = std::max(max_h, frame.components[static_cast<size_t>(c)].h);
+    max_v = std::max(max_v, frame.components[static_cast<size_t>(c)].v);
+  }
+  int mcus_x = (info.width + 8 * max_h - 1) / (8 * max_h);
+  int mcus_y = (info.height + 8 * max_v - 1) / (8 * max_v);
+  int block_size = 8 / scale;
+  for (int c = 0; c < component_count; c++) {
+    Component& component = frame.components[static_cast<size_t>(c)];
+    if (!frame.dc_tables[static_cast<size_t>(component.dc_table)].defined ||
+        !frame.ac_tables[static_cast<size_t>(component.ac_table)].defined) {
+      return false;
+    }
+    component.plane_width = mcus_x * component.h * block_size;
+    component.plane.assign(static_cast<size_t>(component.plane_width) * mcus_y * component.v * block_size, 0);
+    component.predictor = 0;
+  }
+
+  std::array<float, 64> table = make_idct_table(block_size);
+  float coefficients[64];
+  BitReader bits(data, size);
+  int mcu_count = mcus_x * mcus_y;
+  for (int mcu = 0; mcu < mcu_count; mcu++) {
+    if (frame.restart_interval > 0 && mcu > 0 && mcu % frame.restart_interval == 0) {
+      bits.restart();
+      for (int c = 0; c < component_count; c++) {
+        frame.components[static_cast<size_t>(c)].predictor = 0;
+      }
+    }
+    int mcu_x = mcu % mcus_x;
+    int mcu_y = mcu / mcus_x;
+    for (int c = 0; c < component_count; c++) {
+      Component& component = frame.components[static_cast<size_t>(c)];
+      for (int v = 0; v < component.v; v++) {
+        for (int h = 0; h < component.h; h++) {
+          if (!decode_block(bits, frame.dc_tables[static_cast<size_t>(component.dc_table)],
+                            frame.ac_tables[static_cast<size_t>(component.ac_table)],
+                            frame.quant[static_cast<size_t>(component.quant_table)].data(), block_size,
+                            component.predictor, coefficients)) {
+            return false;
+          }
+          size_t x = static_cast<size_t>((mcu_x * component.h + h) * block_size);
+          size_t y = static_cast<size_t>((mcu_y * component.v + v) * block_size);
+          inverse_dct(coefficients, table, block_size,
+                      component.plane.data() + y * static_cast<size_t>(component.plane_width) + x,
+                      component.plane_width);
+        }
+      }
+    }
+  }
+
+  // Subsampled components are interpolated between their two nearest samples, the way libjpeg's fancy
+  // upsampling does; the thumbnail is downscaled afterwards
+  width = (info.width + scale - 1) / scale;
+  height = (info.height + scale - 1) / scale;
+  pixels.resize(static_cast<size_t>(width) * height * 4);
+  const Component* planes = frame.components.data();
+  bool is_rgb = frame.adobe_transform == 0 || (planes[0].id == 'R' && planes[1].id == 'G' && planes[2].id == 'B');
+  std::array<std::vector<SampleTap>, MAX_COMPONENTS> column_taps;
+  for (int c = 0; c < component_count; c++) {
+    for (int x = 0; x < width; x++) {
+      column_taps[static_cast<size_t>(c)].push_back(make_tap(x, planes[c].h, max_h, planes[c].plane_width));
+    }
+  }
+  for (int y = 0; y < height; y++) {
+    unsigned char* out = pixels.data() + static_cast<size_t>(y) * width * 4;
+    SampleTap row_taps[MAX_COMPONENTS];
+    for (int c = 0; c < component_count; c++) {
+      int plane_height = static_cast<int>(planes[c].plane.size() / static_cast<size_t>(planes[c].plane_width));
+      row_taps[c] = make_tap(y, planes[c].v, max_v, plane_height);
+    }
+    for (int x = 0; x < width; x++, out += 4) {
+      int samples[MAX_COMPONENTS];
+      for (int c = 0; c < component_count; c++) {
+        const Component& component = planes[c];
+        const SampleTap& column = column_taps[static_cast<size_t>(c)][static_cast<size_t>(x)];
+        const SampleTap& row = row_taps[c];
+        const unsigned char* first = component.plane.data() + row.first * static_cast<size_t>(component.plane_width);
+        const unsigned char* second = component.plane.data() + row.second * static_cast<size_t>(component.plane_width);
+        int top = first[column.first] * (256 - column.weight) + first[column.second] * column.weight;
+        int bottom = second[column.first] * (256 - column.weight) + second[column.second] * column.weight;
+        samples[c] = (top * (256 - row.weight) + bottom * row.weight + 32768) >> 16;
+      }
+      if (component_count == 1) {
+        out[0] = out[1] = out[2] = static_cast<unsigned char>(samples[0]);
+      } else if (is_rgb) {
+        out[0] = static_cast<unsigned char>(samples[0]);
+        out[1] = static_cast<unsigned char>(samples[1]);
+        out[2] = static_cast<unsigned char>(samples[2]);
+      } else {
+        // YCbCr to RGB in 16.16 fixed point
+        int luma = samples[0] << 16;
+        int cb = samples[1] - 128;
+        int cr = samples[2] - 128;
+        out[0] = static_cast<unsigned char>(std::clamp((luma + 91881 * cr + 32768) >> 16, 0, 255));
+        out[1] = static_cast<unsigned char>(std::clamp((luma - 22554 * cb - 46802 * cr + 32768) >> 16, 0, 255));
+        out[2] = static_cast<unsigned char>(std::clamp((luma + 116130 * cb + 32768) >> 16, 0, 255));
+      }
+      out[3] = 255;
+    }
+  }
+  return true;
+}
+
+// Walk the segments up to the first scan and decode it at 1/`scale` into `pixels`, or with no `pixels` stop at
+// the frame header
+bool parse_jpeg(const unsigned char* data, size_t size, Frame& frame, int scale, std::vector<unsigned char>* pixels,
+                int* width, int* height) {
+  if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+    return false;
+  }
+  size_t position = 2;
+  while (position + 4 <= size) {
+    if (data[position] != 0xFF) {
+      return false;
+    }
+    unsigned char marker = data[position + 1];
+    if (marker == 0xFF) {
+      position++;  // Fill byte
+      continue;
+    }
+    position += 2;
+    if (marker == 0xD9) {
+      break;
+    }
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+      continue;
+    }
+    size_t length = read_be16(data + position);
+    if (length < 2 || position + length > size) {
+      return false;
+    }
+    const unsigned char* segment = data + position + 2;
+    size_t segment_length = length - 2;
+    position += length;
+
+    switch (marker) {
+      case 0xC0:  // Baseline
+      case 0xC1:  // Extended sequential, Huffman coded
+        if (!parse_frame_header(segment, segment_length, true, frame)) {
+          return false;
+        }
+        if (!pixels) {
+          return true;
+        }
+        break;
+      case 0xC2:  // Progressive
+      case 0xC3:  // Lossless
+      case 0xC5:
+      case 0xC6:
+      case 0xC7:
+      case 0xC9:  // Arithmetic coded
+      case 0xCA:
+      case 0xCB:
+      case 0xCD:
+      case 0xCE:
+      case 0xCF:
+        return parse_frame_header(segment, segment_length, false, frame) && !pixels;
+      case 0xC4:
+        if (!parse_huffman_tables(segment, segment_length, frame)) {
+          return false;
+        }
+        break;
+      case 0xDB:
+        if (!parse_quant_tables(segment, segment_length, frame)) {
+          return false;
+        }
+        break;
+      case 0xDD:
+        if (segment_length < 2) {
+          return false;
+        }
+        frame.restart_interval = static_cast<int>(read_be16(segment));
+        break;
+      case 0xEE:  // Adobe
+        if (segment_length >= 12 && std::equal(segment, segment + 5, "Adobe")) {
+          frame.adobe_transform = segment[11];
+        }
+        break;
+      case 0xDA: {  // Start of scan
+        if (!pixels || !frame.has_frame || !frame.info.is_baseline || segment_length < 1) {
+          return false;
+        }
+        // Only a single scan holding every component is decoded
+        int scan_components = segment[0];
+        if (scan_components != frame.info.components ||
+            segment_length < static_cast<size_t>(1 + scan_components * 2 + 3)) {
+          return false;
+        }
+        for (int i = 0; i < scan_components; i++) {
+          const unsigned char* spec = segment + 1 + i * 2;
+          Component* component = nullptr;
+          for (int c = 0; c < frame.info.components; c++) {
+            if (frame.components[static_cast<size_t>(c)].id == spec[0]) {
+              component = &frame.components[static_cast<size_t>(c)];
+            }
+          }
+          if (!component) {
+            return false;
+          }
+          component->dc_table = spec[1] >> 4 & 3;
+          component->ac_table = spec[1] & 3;
+        }
+        return decode_scan(data + position, size - position, scale, frame, *pixels, *width, *height);
+      }
+      default:
+        break;  // Application data and comments
+    }
+  }
+  return frame.has_frame && !pixels;
+}
+
+}  // namespace
+
+bool is_jpeg_file(const std::string& path) {
+  std::string extension = std::filesystem::u8path(path).extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(static_cast<int>(c))); });
+  return extension == ".jpg" || extension == ".jpeg";
+}
+
+bool read_jpeg_info(const unsigned char* data, size_t size, JpegInfo& info) {
+  Frame frame;
+  if (!parse_jpeg(data, size, frame, 1, nullptr, nullptr, nullptr)) {
+    return false;
+  }
+  info = frame.info;
+  return true;
+}
+
+int select_jpeg_scale(int width, int height, int max_size) {
+  if (max_size <= 0) {
+    return 1;
+  }
+  for (int scale : {8, 4, 2}) {
+    if (std::max((width + scale - 1) / scale, (height + scale - 1) / scale) >= max_size) {
+      return scale;
+    }
+  }
+  return 1;
+}
+
+bool decode_jpeg(const unsigned char* data, size_t size, int scale, std::vector<unsigned char>& pixels, int& width,
+                 int& height) {
+  if (scale != 1 && scale != 2 && scale != 4 && scale != 8) {
+    return false;
+  }
+  Frame frame;
+  return parse_jpeg(data, size, frame, scale, &pixels, &width, &height);
+}
+
+bool find_exif_thumbnail(const unsigned char* data, size_t size, size_t& offset, size_t& length) {
+  if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+    return false;
+  }
+  // EXIF sits in an APP1 segment near the start; stop at the first segment that isn't application data
+  size_t position = 2;
+  while (position + 4 <= size && data[position] == 0xFF && data[position + 1] >= 0xE0 && data[position + 1] <= 0xEF) {
+    unsigned char marker = data[position + 1];
+    size_t segment_length = read_be16(data + position + 2);
+    const unsigned char* segment = data + position + 4;
+    size_t segment_size = segment_length >= 2 ? segment_length - 2 : 0;
+    if (segment_length < 2 || position + 2 + segment_length > size) {
+      return false;
+    }
+    position += 2 + segment_length;
+    if (marker != 0xE1 || segment_size < 14 ||
+        !std::equal(segment, segment + 6, "Exif\0\0")) {
+      continue;
+    }
+
+    // A TIFF structure: IFD0 describes the image, IFD1 the thumbnail
+    const unsigned char* tiff = segment + 6;
+    size_t tiff_size = segment_size - 6;
+    bool little_endian = tiff[0] == 'I';
+    auto read16 = [&](size_t at) -> uint32_t {
+      return little_endian ? static_cast<uint32_t>(tiff[at] | tiff[at + 1] << 8) : read_be16(tiff + at);
+    };
+    auto read32 = [&](size_t at) -> uint32_t {
+      return little_endian ? read16(at) | read16(at + 2) << 16 : read16(at) << 16 | read16(at + 2);
+    };
+    size_t ifd0 = read32(4);
+    if (ifd0 + 2 > tiff_size) {
+      return false;
+    }
+    size_t next = ifd0 + 2 + static_cast<size_t>(read16(ifd0)) * 12;
+    if (next + 4 > tiff_size) {
+      return false;
+    }
+    size_t ifd1 = read32(next);
+    if (ifd1 == 0 || ifd1 + 2 > tiff_size) {
+      return false;
+    }
+    size_t thumbnail_offset = 0;
+    size_t thumbnail_length = 0;
+    size_t entry_count = read16(ifd1);
+    for (size_t i = 0; i < entry_count && ifd1 + 2 + (i + 1) * 12 <= tiff_size; i++) {
+      size_t entry = ifd1 + 2 + i * 12;
+      uint32_t tag = read16(entry);
+      if (tag == 0x0201) {  // JPEGInterchangeFormat
+        thumbnail_offset = read32(entry + 8);
+      } else if (tag == 0x0202) {  // JPEGInterchangeFormatLength
+        thumbnail_length = read32(entry + 8);
+      }
+    }
+    if (thumbnail_offset == 0 || thumbnail_length == 0 || thumbnail_offset + thumbnail_length > tiff_size) {
+      return false;
+    }
+    offset = static_cast<size_t>(tiff - data) + thumbnail_offset;
+    length = thumbnail_length;
+    return true;
+  }
+  return false;
+}
+
+bool decode_jpeg_thumbnail(const unsigned char* data, size_t size, int max_size, std::vector<unsigned char>& pixels,
+                           int& width, int& height) {
+  JpegInfo info;
+  if (max_size <= 0 || !read_jpeg_info(data, size, info)) {
+    return false;
+  }
+
+  // Cameras may letterbox the EXIF thumbnail to a fixed aspect ratio, so it is only used if the ratio matches
+  size_t offset = 0;
+  size_t length = 0;
+  JpegInfo embedded;
+  if (find_exif_thumbnail(data, size, offset, length) && read_jpeg_info(data + offset, length, embedded) &&
+      embedded.is_baseline && std::max(embedded.width, embedded.height) >= max_size) {
+    int64_t image_ratio = static_cast<int64_t>(info.width) * embedded.height;
+    int64_t embedded_ratio = static_cast<int64_t>(embedded.width) * info.height;
+    if (std::abs(image_ratio - embedded_ratio) * 50 <= image_ratio &&
+        decode_jpeg(data + offset, length, select_jpeg_scale(embedded.width, embedded.height, max_size), pixels,
+                    width, height)) {
+      return true;
+    }
+  }
+
+  int scale = select_jpeg_scale(info.width, info.height, max_size);
+  if (!info.is_baseline || scale == 1) {
+    return false;
+  }
+  return decode_jpeg(data, size, scale, pixels, width, height);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// What the frame header of a JPEG says
+struct JpegInfo {
+  int width = 0;
+  int height = 0;
+  int components = 0;
+  bool is_baseline = false;  // Sequential and Huffman coded with 8-bit samples, which decode_jpeg() handles
+};
+
+// Whether `path` has a JPEG extension
+bool is_jpeg_file(const std::string& path);
+
+// Read the frame header of a JPEG held in memory
+bool read_jpeg_info(const unsigned char* data, size_t size, JpegInfo& info);
+
+// Largest reduction of 8, 4 or 2 that keeps the larger side of a `width` x `height` image at least `max_size`,
+// or 1 if even halving it would go below
+int select_jpeg_scale(int width, int height, int max_size);
+
+// Decode a baseline JPEG to RGBA8 at 1/`scale` of its size, rounded up; `scale` is 1, 2, 4 or 8. Each 8x8 block
+// goes through an inverse DCT of only its lowest 8/`scale` x 8/`scale` frequencies, straight to the reduced
+// size, so a 1/8 decode needs the DC coefficients alone and never holds the full-size image. Grayscale, YCbCr
+// and RGB images with any chroma subsampling and restart intervals are handled; progressive, arithmetic-coded,
+// CMYK and 12-bit images aren't, and neither are baseline files split into several scans.
+bool decode_jpeg(const unsigned char* data, size_t size, int scale, std::vector<unsigned char>& pixels, int& width,
+                 int& height);
+
+// Find the JPEG thumbnail a camera embedded in the EXIF data, as an offset and length into `data`
+bool find_exif_thumbnail(const unsigned char* data, size_t size, size_t& offset, size_t& length);
+
+// Decode a thumbnail whose larger side is at least `max_size`: the EXIF thumbnail if it is that big and has the
+// image's aspect ratio, else the image at the largest reduction that still covers `max_size`. Returns false if
+// the image needs decoding at full size, or isn't baseline, leaving it to a general decoder.
+bool decode_jpeg_thumbnail(const unsigned char* data, size_t size, int max_size, std::vector<unsigned char>& pixels,
+                           int& width, int& height);
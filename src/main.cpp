@@ -7,12 +7,16 @@
 #include <algorithm>
 #include <atomic>
 #include <chrono>
-#include <filesystem>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <iterator>
 #include <map>
-#include <sstream>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <utility>
 
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
@@ -25,7 +29,23 @@
 
 #include "asset_database.h"
 #include "asset_index.h"
+#include "asset_indexer.h"
+#include "asset_store.h"
+#include "audio_preview_loader.h"
+#include "event_trace.h"
 #include "file_watcher.h"
+#include "image_resize.h"
+#include "metadata_extractor.h"
+#include "metadata_store.h"
+#include "mpsc_queue.h"
+#include "pixel_buffer_ring.h"
+#include "profiler.h"
+#include "search_filter.h"
+#include "texture_cache.h"
+#include "thumbnail_atlas.h"
+#include "thumbnail_cache.h"
+#include "thumbnail_loader.h"
+#include "upload_scheduler.h"
 
 // Include stb_image for PNG loading
 #define STB_IMAGE_IMPLEMENTATION
@@ -39,36 +59,181 @@ constexpr float SEARCH_BOX_HEIGHT = 60.0f;  // Increased from 40.0f
 constexpr float THUMBNAIL_SIZE = 180.0f;    // Increased from 120.0f
 constexpr float GRID_SPACING = 30.0f;       // Increased from 20.0f
 
+// Downscale thumbnails in linear light, so fine detail keeps its brightness
+constexpr bool GAMMA_CORRECT_THUMBNAILS = true;
+
+// Rows above and below the visible ones whose thumbnails are requested ahead, so they're ready when scrolled to
+constexpr int PREFETCH_ROWS = 2;
+
+// Fuzzy search ranks every match but only hands the grid this many, best first
+constexpr size_t FUZZY_RESULT_LIMIT = 5000;
+
+// GPU memory thumbnails may use unless --texture-budget-mb says otherwise. It's spent in whole atlas pages, at
+// least one, and each thumbnail is charged its share of a page.
+constexpr uint64_t DEFAULT_TEXTURE_BUDGET_MB = 128;
+
+// Time the main thread may spend per frame applying file events, so a storm can't stall the UI
+constexpr auto FRAME_EVENT_BUDGET = std::chrono::microseconds(2000);
+
+// When idle, the loop sleeps until input or a wakeup, or at most this long, so time-based state like the retry of a
+// failed decode still comes round. While the search box has focus it wakes often enough for the cursor to blink.
+constexpr double IDLE_WAIT_SECONDS = 2.0;
+constexpr double CURSOR_BLINK_WAIT_SECONDS = 0.2;
+
+// Frames drawn after each wakeup before the loop may sleep again, so the UI settles: a click shows its result a
+// frame later, and hover states follow the mouse
+constexpr int IDLE_SETTLE_FRAMES = 3;
+
+// Profiler overlay graphs, and where its Save button writes the frame history
+constexpr float PROFILER_GRAPH_WIDTH = 360.0f;
+constexpr float PROFILER_GRAPH_HEIGHT = 40.0f;
+const char *const PROFILE_SAVE_PATH = "profile.csv";
+
 // Color constants
 constexpr ImU32 BACKGROUND_COLOR = IM_COL32(242, 247, 255, 255);          // Light blue-gray background
 constexpr ImU32 FALLBACK_THUMBNAIL_COLOR = IM_COL32(242, 247, 255, 255);  // Same as background
+constexpr ImU32 LOADING_THUMBNAIL_COLOR = IM_COL32(224, 232, 245, 255);   // Placeholder while decoding
+constexpr ImU32 WAVEFORM_COLOR = IM_COL32(70, 130, 200, 255);             // Sound tiles' waveform
+constexpr ImU32 DURATION_TEXT_COLOR = IM_COL32(60, 70, 90, 255);          // Length drawn over the waveform
 
 // Global variables for search and UI state
 static char search_buffer[256] = "";
+static bool fuzzy_search = false;
+static bool show_profiler = false;  // Toggled with F3
 // static bool show_search_results = false;  // Unused variable
 // static unsigned int thumbnail_texture = 0; // Unused variable
 
-// Texture cache for loaded images
-struct TextureCacheEntry {
-  unsigned int texture_id;
-  std::string file_path;
-  bool is_loaded;
-  int width;
-  int height;
+// Streams atlas uploads through a persistently mapped buffer when --pbo-uploads is given and the driver can
+PixelBufferRing g_pixel_buffer_ring;
+
+// Atlas pages as GL textures
+class GlAtlasBackend : public AtlasBackend {
+ public:
+  unsigned int create_page(int size) override {
+    unsigned int texture_id = 0;
+    glGenTextures(1, &texture_id);
+    if (texture_id == 0) {
+      return 0;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    // Cleared so the padding between slots is transparent
+    std::vector<unsigned char> clear(static_cast<size_t>(size) * size * 4, 0);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, clear.data());
+    return texture_id;
+  }
+
+  void destroy_page(unsigned int texture_id) override { glDeleteTextures(1, &texture_id); }
 
-  TextureCacheEntry() : texture_id(0), is_loaded(false), width(0), height(0) {}
+  void upload(unsigned int texture_id, int x, int y, int width, int height, const unsigned char *pixels) override {
+    if (g_pixel_buffer_ring.upload(texture_id, x, y, width, height, pixels)) {
+      return;
+    }
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+  }
 };
 
 // Global variables
-std::vector<FileInfo> g_assets;
-std::vector<FileInfo> g_filtered_assets;
+AssetStore g_asset_store;
+SearchFilter g_search_filter;  // Indices into g_asset_store's list matching the search box
 std::atomic<bool> g_assets_updated(false);
 AssetDatabase g_database;
+
+// File events are handed off from the watcher thread: texture invalidations to the main (GL) thread,
+// database updates to the indexer's applier thread, which publishes the changes it made for the UI to apply
+MpscQueue<FileEvent> g_texture_events;
+std::mutex g_published_changes_mutex;
+std::vector<AssetChange> g_published_changes;  // Guarded by g_published_changes_mutex; ready when g_assets_updated
 FileWatcher g_file_watcher;
-unsigned int g_default_texture = 0;
+AssetIndexer g_indexer(g_database, g_file_watcher);
+int g_assets_root_id = -1;
+EventTracePlayer g_trace_player;
+
+// Times the stages of each frame and the threads feeding it, for the F3 overlay and --profile-dump
+Profiler g_profiler;
+
+// Lets other threads wake the main loop while it waits for events; set once GLFW is up and until the loop ends
+std::atomic<bool> g_wakeups_enabled(false);
+std::atomic<bool> g_wakeup_posted(false);  // Cleared by the main loop each time it wakes
+
+// Wake the main loop if it is waiting for events, because a file event, database change or decode needs a frame.
+// Safe from any thread; wakeups posted before the loop gets round to them collapse into one.
+void wake_main_loop() {
+  if (g_wakeups_enabled && !g_wakeup_posted.exchange(true)) {
+    glfwPostEmptyEvent();
+  }
+}
+
+// Texture cache. All thumbnails, including the icon for non-texture assets, are packed into a few atlas pages
+// so the grid draws with one texture bind per page instead of one per tile. The cache keeps them within a
+// memory budget and frees the slots of thumbnails that haven't been on screen for a while.
+GlAtlasBackend g_atlas_backend;
+ThumbnailAtlas g_thumbnail_atlas(g_atlas_backend, static_cast<int>(THUMBNAIL_SIZE));
+AtlasSlot g_default_thumbnail = INVALID_ATLAS_SLOT;
+TextureCache g_texture_cache(DEFAULT_TEXTURE_BUDGET_MB * 1024 * 1024);
+size_t g_atlas_page_budget = 1;  // Pages the texture budget pays for
+
+// What one thumbnail costs against the texture budget: its share of an atlas page, rounded up so the slots the
+// budget pays for never need more pages than it covers
+uint64_t get_atlas_slot_bytes() {
+  uint64_t slots = static_cast<uint64_t>(std::max(1, g_thumbnail_atlas.get_slots_per_page()));
+  return (g_thumbnail_atlas.get_page_bytes() + slots - 1) / slots;
+}
+
+// Set the GPU memory thumbnails may use. The atlas allocates whole pages, so the budget is rounded down to
+// pages, and the icon's slot comes out of it.
+void set_texture_budget(uint64_t budget_bytes) {
+  uint64_t page_bytes = g_thumbnail_atlas.get_page_bytes();
+  g_atlas_page_budget = static_cast<size_t>(std::max<uint64_t>(1, budget_bytes / page_bytes));
+  g_texture_cache.set_budget(g_atlas_page_budget * page_bytes - get_atlas_slot_bytes());
+}
+
+// A page goes back to the GPU only once it's empty, so evictions that leave a few thumbnails on each page can keep
+// more pages alive than the budget pays for. Empty the least used pages until it fits again; a page that
+// thumbnails on screen keep alive ends the trim until they scroll away.
+void trim_atlas_pages() {
+  while (g_thumbnail_atlas.get_page_count() > g_atlas_page_budget) {
+    uint32_t page = 0;
+    if (!g_thumbnail_atlas.get_least_used_page(page)) {
+      return;
+    }
+    size_t page_count = g_thumbnail_atlas.get_page_count();
+    g_texture_cache.evict_if(
+        [page](const CachedTexture &texture) { return g_thumbnail_atlas.get_page_of(texture.slot) == page; });
+    if (g_thumbnail_atlas.get_page_count() == page_count) {
+      return;
+    }
+  }
+}
+
+// Decodes textures in the background; the main thread only uploads the results. Thumbnails are kept on disk
+// between runs, so folders seen before need no decoding at all.
+ThumbnailLoader g_thumbnail_loader;
+ThumbnailCache g_thumbnail_cache;
+
+// Model and sound metadata is read from mapped files on background threads into side tables of the same database
+MetadataStore g_metadata_store;
+MetadataExtractor g_metadata_extractor(g_metadata_store);
+
+// Sound tiles draw the waveform the extractor stored. It is loaded from the store in the background and cached per
+// path, hits and misses alike, so drawing a tile is a lookup and scrolling through a folder of sounds reads
+// nothing. A path is loaded again when the extractor reports new metadata for it.
+struct AudioPreview {
+  bool found = false;  // False until the load finished, and after it if the store had nothing
+  AudioMetadata metadata;
+};
+std::unordered_map<std::string, AudioPreview> g_audio_previews;
+AudioPreviewLoader g_audio_preview_loader(g_metadata_store);
+std::mutex g_extracted_paths_mutex;
+std::vector<std::string> g_extracted_paths;
 
-// Texture cache
-std::unordered_map<std::string, TextureCacheEntry> g_texture_cache;
+// Finished decodes wait here until a frame has budget to upload them, tiles on screen first
+UploadScheduler g_upload_scheduler;
 
 bool load_roboto_font(ImGuiIO &io) {
   // Load embedded Roboto font from external/fonts directory
@@ -97,30 +262,22 @@ bool load_roboto_font(ImGuiIO &io) {
   return false;
 }
 
-// Function to load texture from file
-unsigned int load_texture(const char *filename) {
+// Load an icon into an atlas slot, downscaled to the thumbnail size
+AtlasSlot load_atlas_icon(const char *filename) {
   int width, height, channels;
   unsigned char *data = stbi_load(filename, &width, &height, &channels, 4);
   if (!data) {
     std::cerr << "Failed to load texture: " << filename << '\n';
-    return 0;
+    return INVALID_ATLAS_SLOT;
   }
 
-  unsigned int texture_id;
-  glGenTextures(1, &texture_id);
-  glBindTexture(GL_TEXTURE_2D, texture_id);
-
-  // Set texture parameters
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-  // Upload texture data
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-
+  int thumbnail_width, thumbnail_height;
+  fit_within(width, height, g_thumbnail_atlas.get_slot_size(), thumbnail_width, thumbnail_height);
+  std::vector<unsigned char> pixels(static_cast<size_t>(thumbnail_width) * thumbnail_height * 4);
+  resize_rgba8(data, width, height, pixels.data(), thumbnail_width, thumbnail_height);
   stbi_image_free(data);
-  return texture_id;
+
+  return g_thumbnail_atlas.allocate(pixels.data(), thumbnail_width, thumbnail_height);
 }
 
 // Function to calculate aspect-ratio-preserving dimensions
@@ -136,71 +293,147 @@ ImVec2 calculate_thumbnail_size(int original_width, int original_height, float m
   }
 }
 
-// Function to get or load texture for an asset
-unsigned int get_asset_texture(const FileInfo &asset) {
-  // For non-texture assets, return default texture
+// Function to get the atlas region holding an asset's thumbnail. Textures that aren't decoded yet are requested
+// from the thumbnail loader and have no region until the result has been uploaded. `priority` orders the upload
+// of a finished decode: 0 for tiles on screen, the row distance for prefetched ones.
+bool get_asset_thumbnail(const FileInfo &asset, AtlasRegion &region, int priority) {
+  // For non-texture assets, use the default icon
   if (asset.type != AssetType::Texture) {
-    return g_default_texture;
+    return g_thumbnail_atlas.get_region(g_default_thumbnail, region);
+  }
+
+  // Pending thumbnails are requested every frame they're wanted, which keeps the loader request alive, or marked
+  // for upload once decoded. Failed decodes are only requested again once the cache's retry delay has passed.
+  CachedTexture texture;
+  switch (g_texture_cache.lookup(asset.full_path, texture)) {
+    case TextureState::Loaded:
+      return g_thumbnail_atlas.get_region(texture.slot, region);
+    case TextureState::Pending:
+      if (!g_upload_scheduler.mark(asset.full_path, priority)) {
+        g_thumbnail_loader.request(asset.full_path);
+      }
+      return false;
+    case TextureState::Failed:
+      return false;
   }
+  return false;
+}
+
+// Uploads scheduled decodes into the atlas and the texture cache
+class AtlasUploader : public UploadBackend {
+ public:
+  uint64_t upload(ThumbnailResult &result) override {
+    if (result.pixels.empty()) {
+      std::cerr << "Failed to load texture: " << result.path << '\n';
+      g_texture_cache.insert_failure(result.path);
+      return 0;
+    }
 
-  // Check if texture is already cached
-  auto it = g_texture_cache.find(asset.full_path);
-  if (it != g_texture_cache.end()) {
-    if (it->second.is_loaded) {
-      return it->second.texture_id;
+    // Make room first so this thumbnail can reuse an evicted slot instead of growing the atlas
+    uint64_t slot_bytes = get_atlas_slot_bytes();
+    g_texture_cache.remove(result.path);
+    g_texture_cache.make_room(slot_bytes);
+    CachedTexture texture;
+    texture.slot = g_thumbnail_atlas.allocate(result.pixels.data(), result.width, result.height);
+    if (texture.slot == INVALID_ATLAS_SLOT) {
+      std::cerr << "No atlas slot for thumbnail: " << result.path << '\n';
+      g_texture_cache.insert_failure(result.path);
+      return 0;
     }
+    texture.width = result.width;
+    texture.height = result.height;
+    g_texture_cache.insert(result.path, texture, slot_bytes);
+    return result.pixels.size();
   }
+};
 
-  // Load the texture and get dimensions
-  int width, height, channels;
-  unsigned char *data = stbi_load(asset.full_path.c_str(), &width, &height, &channels, 4);
-  if (!data) {
-    std::cerr << "Failed to load texture: " << asset.full_path << '\n';
-    // Cache the failure
-    TextureCacheEntry &entry = g_texture_cache[asset.full_path];
-    entry.texture_id = 0;
-    entry.file_path = asset.full_path;
-    entry.is_loaded = false;
-    entry.width = 0;
-    entry.height = 0;
-    return 0;
-  }
-
-  unsigned int texture_id;
-  glGenTextures(1, &texture_id);
-  glBindTexture(GL_TEXTURE_2D, texture_id);
-
-  // Set texture parameters
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-  // Upload texture data
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+AtlasUploader g_atlas_uploader;
 
-  stbi_image_free(data);
+// Queue finished decodes and upload the ones the last frame drew or prefetched first, within the frame's budget;
+// the rest stay queued for the next frame
+void upload_decoded_thumbnails() {
+  ThumbnailResult result;
+  while (g_thumbnail_loader.poll(result)) {
+    g_upload_scheduler.push(std::move(result));
+  }
+  g_upload_scheduler.run(g_atlas_uploader);
+  g_pixel_buffer_ring.end_frame();
+}
 
-  // Cache the result
-  TextureCacheEntry &entry = g_texture_cache[asset.full_path];
-  entry.texture_id = texture_id;
-  entry.file_path = asset.full_path;
-  entry.is_loaded = true;
-  entry.width = width;
-  entry.height = height;
+// Runs on an extractor worker after it stored new metadata
+void on_metadata_extracted(const std::string &full_path) {
+  {
+    std::lock_guard<std::mutex> lock(g_extracted_paths_mutex);
+    g_extracted_paths.push_back(full_path);
+  }
+  wake_main_loop();
+}
 
-  return texture_id;
+// Reload the cached previews of paths the extractor has stored new metadata for since the last frame, keeping the
+// old ones on screen until then, and take in the loads that finished
+void refresh_audio_previews() {
+  std::vector<std::string> paths;
+  {
+    std::lock_guard<std::mutex> lock(g_extracted_paths_mutex);
+    paths.swap(g_extracted_paths);
+  }
+  for (const auto &path : paths) {
+    if (g_audio_previews.count(path) != 0) {
+      g_audio_preview_loader.request(path);
+    }
+  }
+
+  AudioPreviewResult result;
+  while (g_audio_preview_loader.poll(result)) {
+    AudioPreview &preview = g_audio_previews[result.path];
+    preview.found = result.found;
+    preview.metadata = std::move(result.metadata);
+  }
 }
 
-// Function to get cached texture dimensions
-bool get_texture_dimensions(const std::string &file_path, int &width, int &height) {
-  auto it = g_texture_cache.find(file_path);
-  if (it != g_texture_cache.end() && it->second.is_loaded) {
-    width = it->second.width;
-    height = it->second.height;
-    return true;
+// The cached preview of a sound; a path not seen before is requested from the loader and drawn without a
+// waveform until it arrives
+const AudioPreview &get_audio_preview(const FileInfo &asset) {
+  auto found = g_audio_previews.find(asset.full_path);
+  if (found == g_audio_previews.end()) {
+    if (g_metadata_store.is_open()) {
+      g_audio_preview_loader.request(asset.full_path);
+    }
+    found = g_audio_previews.emplace(asset.full_path, AudioPreview()).first;
   }
-  return false;
+  return found->second;
+}
+
+std::string format_duration(double seconds) {
+  char text[32];
+  if (seconds < 60.0) {
+    std::snprintf(text, sizeof(text), "%.2fs", seconds);
+  } else {
+    int whole = static_cast<int>(seconds);
+    std::snprintf(text, sizeof(text), "%d:%02d", whole / 60, whole % 60);
+  }
+  return text;
+}
+
+// One bar per waveform column from its minimum to its maximum, with the length in the corner
+void draw_waveform(const AudioMetadata &metadata, ImVec2 min, ImVec2 max) {
+  ImDrawList *draw_list = ImGui::GetWindowDrawList();
+  size_t columns = metadata.waveform.size() / 2;
+  float column_width = (max.x - min.x) / static_cast<float>(columns);
+  float center = (min.y + max.y) * 0.5f;
+  float scale = (max.y - min.y) * 0.4f / 127.0f;
+  for (size_t column = 0; column < columns; column++) {
+    float x = min.x + column_width * static_cast<float>(column);
+    float top = center - metadata.waveform[column * 2 + 1] * scale;
+    float bottom = center - metadata.waveform[column * 2] * scale;
+    // Silence still shows as a line
+    draw_list->AddRectFilled(ImVec2(x, top - 0.5f), ImVec2(x + std::max(column_width, 1.0f), bottom + 0.5f),
+                             WAVEFORM_COLOR);
+  }
+  std::string duration = format_duration(metadata.get_duration());
+  ImVec2 text_size = ImGui::CalcTextSize(duration.c_str());
+  draw_list->AddText(ImVec2(max.x - text_size.x - 6.0f, max.y - text_size.y - 4.0f), DURATION_TEXT_COLOR,
+                     duration.c_str());
 }
 
 // Function to truncate filename to specified length with ellipsis
@@ -211,151 +444,335 @@ std::string truncate_filename(const std::string &filename, size_t max_length = 2
   return filename.substr(0, max_length - 3) + "...";
 }
 
-// Function to convert string to lowercase for case-insensitive search
-std::string to_lowercase(const std::string &str) {
-  std::string result = str;
-  std::transform(result.begin(), result.end(), result.begin(), ::tolower);
-  return result;
-}
-
-// Function to check if asset matches search terms
-bool asset_matches_search(const FileInfo &asset, const std::string &search_query) {
-  if (search_query.empty()) {
-    return true;  // Show all assets when search is empty
+// Draw one grid tile: the thumbnail as a button, or a placeholder while it decodes, with the name below it.
+// Thumbnails go to the image channel of the window's draw list and everything else to channel 0, so after the
+// channels are merged the thumbnails of a page form one draw command.
+void draw_asset_tile(const FileInfo &asset, int index, ImVec2 position, int image_channel) {
+  ImGui::SetCursorPos(position);
+  ImGui::PushID(index);
+  ImGui::BeginGroup();
+
+  // Get the thumbnail for this asset
+  AtlasRegion region;
+  bool has_thumbnail = get_asset_thumbnail(asset, region, 0);
+  bool is_loading = !has_thumbnail && (g_thumbnail_loader.is_pending(asset.full_path) ||
+                                       g_upload_scheduler.is_queued(asset.full_path));
+
+  // Sounds with a stored waveform draw it in place of the icon
+  const AudioPreview *audio = asset.type == AssetType::Sound ? &get_audio_preview(asset) : nullptr;
+  bool has_waveform = audio && audio->found && !audio->metadata.waveform.empty();
+
+  // Calculate display size based on asset type
+  ImVec2 display_size(THUMBNAIL_SIZE, THUMBNAIL_SIZE);
+  if (asset.type == AssetType::Texture && has_thumbnail) {
+    // Thumbnails keep the image's aspect ratio
+    display_size = calculate_thumbnail_size(region.width, region.height, THUMBNAIL_SIZE);
   }
 
-  std::string query_lower = to_lowercase(search_query);
-  std::string name_lower = to_lowercase(asset.name);
-  std::string extension_lower = to_lowercase(asset.extension);
-  std::string path_lower = to_lowercase(asset.full_path);
+  // Create a fixed-size container for consistent layout
+  ImVec2 container_size(THUMBNAIL_SIZE,
+                        THUMBNAIL_SIZE + 40.0f);  // Extra space for text
+  ImVec2 container_pos = ImGui::GetCursorScreenPos();
+
+  // Draw background for the container (same as app background)
+  ImGui::GetWindowDrawList()->AddRectFilled(
+      container_pos, ImVec2(container_pos.x + container_size.x, container_pos.y + container_size.y),
+      BACKGROUND_COLOR);
+
+  // Calculate position to center the image vertically in the container
+  float image_y_offset = (container_size.y - display_size.y) * 0.5f;
+  ImVec2 image_pos(container_pos.x, container_pos.y + image_y_offset);
+
+  ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.f, 0.f, 0.f, 0.f));
+  ImGui::PushStyleColor(ImGuiCol_ButtonActive, ImVec4(0.f, 0.f, 0.f, 0.f));
+  ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.f, 0.f, 0.f, 0.3f));
+
+  // Display thumbnail image, laid out like an image button
+  if (has_thumbnail && !has_waveform) {
+    ImGui::SetCursorScreenPos(image_pos);
+    ImVec2 padding = ImGui::GetStyle().FramePadding;
+    if (ImGui::InvisibleButton("##Thumbnail", ImVec2(display_size.x + padding.x * 2, display_size.y + padding.y * 2))) {
+      std::cout << "Selected: " << asset.name << '\n';
+    }
+    ImDrawList *draw_list = ImGui::GetWindowDrawList();
+    ImVec2 image_min(ImGui::GetItemRectMin().x + padding.x, ImGui::GetItemRectMin().y + padding.y);
+    if (ImGui::IsItemHovered()) {
+      draw_list->AddRectFilled(ImGui::GetItemRectMin(), ImGui::GetItemRectMax(),
+                               ImGui::GetColorU32(ImGuiCol_ButtonHovered), ImGui::GetStyle().FrameRounding);
+    }
+    draw_list->ChannelsSetCurrent(image_channel);
+    ImVec2 image_max(image_min.x + display_size.x, image_min.y + display_size.y);
+    draw_list->AddImage((ImTextureID)(intptr_t)region.texture_id, image_min, image_max, ImVec2(region.u0, region.v0),
+                        ImVec2(region.u1, region.v1));
+    draw_list->ChannelsSetCurrent(0);
+  } else {
+    // Fallback: colored button if texture failed to load
+    ImGui::SetCursorScreenPos(image_pos);
+    ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, 8.0f);
+    if (ImGui::Button("##Thumbnail", display_size)) {
+      std::cout << "Selected: " << asset.name << '\n';
+    }
+    ImGui::PopStyleVar();
 
-  // Split search query into terms (space-separated)
-  std::vector<std::string> search_terms;
-  std::stringstream ss(query_lower);
-  std::string search_term;
-  while (ss >> search_term) {
-    if (!search_term.empty()) {
-      search_terms.push_back(search_term);
+    // Add a background to simulate thumbnail (same as app background), or a placeholder while decoding
+    ImGui::GetWindowDrawList()->AddRectFilled(ImGui::GetItemRectMin(), ImGui::GetItemRectMax(),
+                                              is_loading ? LOADING_THUMBNAIL_COLOR : FALLBACK_THUMBNAIL_COLOR,
+                                              is_loading ? 8.0f : 0.0f);
+    if (has_waveform) {
+      draw_waveform(audio->metadata, ImGui::GetItemRectMin(), ImGui::GetItemRectMax());
     }
   }
 
-  // All terms must match (AND logic)
-  for (const auto &term : search_terms) {
-    bool term_matches = name_lower.find(term) != std::string::npos || extension_lower.find(term) != std::string::npos ||
-                        path_lower.find(term) != std::string::npos;
+  // Stream details come from the stored header metadata, for lossy formats without a waveform too
+  if (audio && audio->found && ImGui::IsItemHovered()) {
+    const AudioMetadata &metadata = audio->metadata;
+    std::string bits = metadata.bits_per_sample > 0 ? ", " + std::to_string(metadata.bits_per_sample) + "-bit" : "";
+    ImGui::SetTooltip("%s, %s, %u Hz, %u channel(s)%s", metadata.codec.c_str(),
+                      format_duration(metadata.get_duration()).c_str(), metadata.sample_rate, metadata.channel_count,
+                      bits.c_str());
+  }
 
-    if (!term_matches) {
-      return false;
+  ImGui::PopStyleColor(3);
+
+  // Position text at the bottom of the container
+  ImGui::SetCursorScreenPos(ImVec2(container_pos.x, container_pos.y + THUMBNAIL_SIZE + 5.0f));
+
+  // Asset name below thumbnail
+  std::string truncated_name = truncate_filename(asset.name);
+  ImGui::SetCursorPosX(ImGui::GetCursorPosX() +
+                       (THUMBNAIL_SIZE - ImGui::CalcTextSize(truncated_name.c_str()).x) * 0.5f);
+  ImGui::TextWrapped("%s", truncated_name.c_str());
+
+  ImGui::EndGroup();
+  ImGui::PopID();
+}
+
+// Request thumbnails for the rows just outside [first_row, end_row), nearest rows first
+void prefetch_thumbnails(int first_row, int end_row, int columns, int row_count) {
+  const std::vector<size_t> &filtered = g_search_filter.get_results();
+  for (int distance = 1; distance <= PREFETCH_ROWS; distance++) {
+    for (int row : {end_row - 1 + distance, first_row - distance}) {
+      if (row < 0 || row >= row_count) {
+        continue;
+      }
+      size_t begin = static_cast<size_t>(row) * columns;
+      size_t end = std::min(begin + columns, filtered.size());
+      AtlasRegion region;
+      for (size_t i = begin; i < end; i++) {
+        get_asset_thumbnail(g_asset_store.get_assets()[filtered[i]], region, distance);
+      }
     }
   }
+}
 
-  return true;
+// Drop the cached texture of a path, and a decode waiting for upload, so it is reloaded the next time it is drawn
+void invalidate_texture(const std::string &path) {
+  g_texture_cache.remove(path);
+  g_upload_scheduler.remove(path);
 }
 
-// Function to filter assets based on search query
-void filter_assets(const std::string &search_query) {
-  g_filtered_assets.clear();
+// Drop the cached textures of everything below a directory
+void invalidate_textures_under(const std::string &directory) {
+  g_texture_cache.remove_under(directory);
+  g_upload_scheduler.remove_under(directory);
+}
 
-  for (const auto &asset : g_assets) {
-    if (asset_matches_search(asset, search_query)) {
-      g_filtered_assets.push_back(asset);
-    }
+// Drop the textures an event makes stale. Runs on the main thread, which owns the GL context and the cache.
+void apply_texture_invalidation(const FileEvent &event) {
+  switch (event.type) {
+    case FileEventType::Created:
+    case FileEventType::Modified:
+      // Clear texture cache entry for this file so it can be reloaded; a decode in flight may be stale
+      invalidate_texture(event.path);
+      g_thumbnail_loader.cancel(event.path);
+      break;
+    case FileEventType::DirectoryCreated:
+      invalidate_textures_under(event.path);
+      g_thumbnail_loader.cancel_under(event.path);
+      break;
+    case FileEventType::Deleted:
+    case FileEventType::DirectoryDeleted:
+      // Clear texture cache entries for the deleted path and anything below it
+      invalidate_texture(event.path);
+      invalidate_textures_under(event.path);
+      g_thumbnail_loader.cancel(event.path);
+      g_thumbnail_loader.cancel_under(event.path);
+      break;
+    case FileEventType::Renamed:
+      invalidate_texture(event.old_path);
+      invalidate_textures_under(event.old_path);
+      g_thumbnail_loader.cancel(event.old_path);
+      g_thumbnail_loader.cancel_under(event.old_path);
+      break;
+    default:
+      break;
   }
 }
 
-// File event callback function
+// File event callback function, called on the watcher's delivery thread. It only queues the event; nothing
+// here touches GL, the texture cache or the database.
 void on_file_event(const FileEvent &event) {
-  switch (event.type) {
-    case FileEventType::Created:
-      // Fall through to Modified case
-    case FileEventType::Modified: {
-      // Check if it's a file (not directory)
-      if (std::filesystem::is_regular_file(event.path)) {
-        // Clear texture cache entry for this file so it can be reloaded
-        auto cache_it = g_texture_cache.find(event.path);
-        if (cache_it != g_texture_cache.end()) {
-          // If there's an existing texture, delete it from OpenGL
-          if (cache_it->second.is_loaded && cache_it->second.texture_id != 0) {
-            glDeleteTextures(1, &cache_it->second.texture_id);
-          }
-          // Remove from cache
-          g_texture_cache.erase(cache_it);
-        }
+  g_texture_events.push(event);
+  g_indexer.push(event);
+  wake_main_loop();
+}
 
-        FileInfo file_info;
-        std::filesystem::path path(event.path);
-
-        file_info.name = path.filename().string();
-        file_info.extension = path.extension().string();
-        file_info.full_path = event.path;
-        file_info.relative_path = event.path;  // For now, use full path
-        file_info.size = std::filesystem::file_size(event.path);
-        file_info.last_modified = event.timestamp;
-        file_info.is_directory = false;
-        file_info.type = get_asset_type(file_info.extension);
-
-        // Insert or update in database
-        auto existing_asset = g_database.get_asset_by_path(event.path);
-        if (existing_asset.full_path.empty()) {
-          g_database.insert_asset(file_info);
-        } else {
-          g_database.update_asset(file_info);
-        }
-        g_assets_updated = true;
-      }
-      break;
+// Runs on the indexer's applier thread after each batch: hand the batch's changes to the UI, appending to any it
+// hasn't picked up yet, so an event storm costs one refresh per batch instead of one per event
+void publish_changes(uint64_t /*applied*/, std::vector<AssetChange> &changes) {
+  ProfileScope scope(&g_profiler, "DB publish");
+  if (g_metadata_store.is_open()) {
+    g_metadata_extractor.apply(changes);
+  }
+  {
+    std::lock_guard<std::mutex> lock(g_published_changes_mutex);
+    if (g_published_changes.empty()) {
+      g_published_changes.swap(changes);
+    } else {
+      std::move(changes.begin(), changes.end(), std::back_inserter(g_published_changes));
     }
-    case FileEventType::Deleted: {
-      // Clear texture cache entry for deleted file
-      auto cache_it = g_texture_cache.find(event.path);
-      if (cache_it != g_texture_cache.end()) {
-        if (cache_it->second.is_loaded && cache_it->second.texture_id != 0) {
-          glDeleteTextures(1, &cache_it->second.texture_id);
-        }
-        g_texture_cache.erase(cache_it);
-      }
+  }
+  g_assets_updated = true;
+  wake_main_loop();
+}
 
-      g_database.delete_asset(event.path);
-      g_assets_updated = true;
+// Apply queued texture invalidations on the main thread until the frame budget is spent; the rest waits for
+// the next frame
+void drain_texture_events() {
+  auto deadline = std::chrono::steady_clock::now() + FRAME_EVENT_BUDGET;
+  FileEvent event(FileEventType::Modified, "");
+  while (g_texture_events.pop(event)) {
+    apply_texture_invalidation(event);
+    if (std::chrono::steady_clock::now() >= deadline) {
       break;
     }
-    case FileEventType::Renamed: {
-      // Clear texture cache entry for old path
-      auto cache_it = g_texture_cache.find(event.old_path);
-      if (cache_it != g_texture_cache.end()) {
-        if (cache_it->second.is_loaded && cache_it->second.texture_id != 0) {
-          glDeleteTextures(1, &cache_it->second.texture_id);
-        }
-        g_texture_cache.erase(cache_it);
+  }
+}
+
+// Profiler overlay, toggled with F3: each stage's time per frame as a graph and as percentiles over the history,
+// so a hitch can be traced to the stage that caused it. Worker zones add up the time of every thread.
+void draw_profiler_overlay() {
+  ImGui::SetNextWindowPos(ImVec2(ImGui::GetIO().DisplaySize.x - 20.0f, 80.0f), ImGuiCond_FirstUseEver,
+                          ImVec2(1.0f, 0.0f));
+  ImGui::SetNextWindowBgAlpha(0.92f);
+  if (!ImGui::Begin("Profiler (F3)", &show_profiler, ImGuiWindowFlags_AlwaysAutoResize)) {
+    ImGui::End();
+    return;
+  }
+
+  ProfilerStats stats = g_profiler.get_stats();
+  ImGui::Text("%llu frame(s), %zu thread(s), %llu sample(s) dropped", static_cast<unsigned long long>(stats.frames),
+              stats.threads, static_cast<unsigned long long>(stats.dropped));
+
+  std::vector<ZoneStats> zones;
+  for (size_t zone = 0; zone < g_profiler.get_zone_count(); zone++) {
+    zones.push_back(g_profiler.get_zone_stats(zone));
+  }
+  if (ImGui::BeginTable("ProfilerZones", 6, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit)) {
+    for (const char *header : {"Zone (ms)", "Last", "p50", "p95", "p99", "Max"}) {
+      ImGui::TableSetupColumn(header);
+    }
+    ImGui::TableHeadersRow();
+    for (const ZoneStats &zone : zones) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(zone.name.c_str());
+      for (double value : {zone.last_ms, zone.p50_ms, zone.p95_ms, zone.p99_ms, zone.max_ms}) {
+        ImGui::TableNextColumn();
+        ImGui::Text("%.2f", value);
       }
+    }
+    ImGui::EndTable();
+  }
 
-      // Delete old entry and create new one
-      g_database.delete_asset(event.old_path);
+  // Each graph is scaled to its own worst frame, so short stages stay readable next to the frame time
+  for (size_t zone = 0; zone < zones.size(); zone++) {
+    std::vector<float> history = g_profiler.get_history(zone);
+    if (history.empty()) {
+      continue;
+    }
+    char overlay[64];
+    std::snprintf(overlay, sizeof(overlay), "%s  max %.2fms", zones[zone].name.c_str(), zones[zone].max_ms);
+    ImGui::PushID(static_cast<int>(zone));
+    ImGui::PlotLines("##History", history.data(), static_cast<int>(history.size()), 0, overlay, 0.0f,
+                     std::max(static_cast<float>(zones[zone].max_ms), 0.1f),
+                     ImVec2(PROFILER_GRAPH_WIDTH, PROFILER_GRAPH_HEIGHT));
+    ImGui::PopID();
+  }
 
-      if (std::filesystem::is_regular_file(event.path)) {
-        FileInfo file_info;
-        std::filesystem::path path(event.path);
+  if (ImGui::Button("Save CSV")) {
+    if (g_profiler.dump(PROFILE_SAVE_PATH)) {
+      std::cout << "Profile written to " << PROFILE_SAVE_PATH << '\n';
+    }
+  }
+  ImGui::End();
+}
 
-        file_info.name = path.filename().string();
-        file_info.extension = path.extension().string();
-        file_info.full_path = event.path;
-        file_info.relative_path = event.path;
-        file_info.size = std::filesystem::file_size(event.path);
-        file_info.last_modified = event.timestamp;
-        file_info.is_directory = false;
-        file_info.type = get_asset_type(file_info.extension);
+// Command line options
+struct Options {
+  std::string record_trace_path;  // Record the watcher's raw events into this file
+  std::string replay_trace_path;  // Feed this trace to the app instead of watching the assets directory
+  ReplaySpeed replay_speed = ReplaySpeed::Max;
+  uint64_t texture_budget_mb = DEFAULT_TEXTURE_BUDGET_MB;  // GPU memory for thumbnails
+  std::string profile_dump_path;                           // Write the profiler's frame history here on exit
+  bool continuous = false;  // Redraw at vsync rate even when nothing changes, instead of waiting for events
+  bool pbo_uploads = false;  // Stream thumbnail uploads through a persistently mapped pixel buffer
+};
 
-        g_database.insert_asset(file_info);
-        g_assets_updated = true;
-      }
-      break;
+bool parse_options(int argc, char *argv[], Options &options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--record-trace" && has_value) {
+      options.record_trace_path = argv[++i];
+    } else if (arg == "--replay-trace" && has_value) {
+      options.replay_trace_path = argv[++i];
+    } else if (arg == "--replay-speed" && has_value && parse_replay_speed(argv[i + 1], options.replay_speed)) {
+      i++;
+    } else if (arg == "--texture-budget-mb" && has_value && std::atoll(argv[i + 1]) > 0) {
+      options.texture_budget_mb = static_cast<uint64_t>(std::atoll(argv[++i]));
+    } else if (arg == "--profile-dump" && has_value) {
+      options.profile_dump_path = argv[++i];
+    } else if (arg == "--continuous") {
+      options.continuous = true;
+    } else if (arg == "--pbo-uploads") {
+      options.pbo_uploads = true;
+    } else {
+      std::cerr << "Unknown or incomplete option: " << arg << '\n';
+      std::cerr << "Usage: AssetInventory [--record-trace FILE] [--replay-trace FILE [--replay-speed original|max]]"
+                   " [--texture-budget-mb N] [--profile-dump FILE] [--continuous] [--pbo-uploads]\n";
+      return false;
     }
-    default:
-      break;
   }
+  if (!options.record_trace_path.empty() && !options.replay_trace_path.empty()) {
+    std::cerr << "--record-trace and --replay-trace can't be combined\n";
+    return false;
+  }
+  return true;
+}
+
+// Replays a recorded trace through the same callback the file watcher uses, on a thread of its own like the
+// watcher's delivery thread
+void replay_trace(const std::string &path, ReplaySpeed speed) {
+  std::cout << "Replaying event trace " << path << '\n';
+  if (!g_trace_player.replay(path, speed, on_file_event)) {
+    std::cerr << "Event trace replay failed: " << path << '\n';
+    return;
+  }
+
+  ReplayStats stats = g_trace_player.get_stats();
+  std::cout << "Event trace replayed: " << stats.raw_events << " raw event(s) -> " << stats.delivered_events
+            << " delivered, " << stats.overflows << " overflow(s); trace " << stats.trace_duration.count() / 1000
+            << "ms, replay " << stats.wall_time.count() / 1000 << "ms, callback " << stats.callback_time.count() / 1000
+            << "ms\n";
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+  Options options;
+  if (!parse_options(argc, argv, options)) {
+    return -1;
+  }
+
   // Initialize database
   std::cout << "Initializing database...\n";
   if (!g_database.initialize("db/assets.db")) {
@@ -363,27 +780,60 @@ int main() {
     return -1;
   }
 
+  // Thumbnails live in the same file and survive the cleanup below
+  if (!g_thumbnail_cache.initialize("db/assets.db")) {
+    std::cerr << "Warning: Thumbnail cache unavailable, thumbnails will be decoded every run\n";
+  }
+  if (!g_metadata_store.initialize("db/assets.db")) {
+    std::cerr << "Warning: Metadata store unavailable, model and sound metadata will not be extracted\n";
+  }
+
   // Clean database before starting (as requested)
   std::cout << "Cleaning database...\n";
   g_database.clear_all_assets();
 
-  // Create initial scan of assets directory
-  std::cout << "Performing initial asset scan...\n";
-  std::vector<FileInfo> initial_assets = scan_directory("assets");
-  if (!initial_assets.empty()) {
-    g_database.insert_assets_batch(initial_assets);
-    g_assets = g_database.get_all_assets();
-    g_filtered_assets = g_assets;  // Initialize filtered assets
+  // Register the assets directory; it is watched once the watcher starts, after the initial scan
+  WatchRootOptions watch_options;
+  watch_options.ignore_patterns = get_default_ignore_patterns();
+  g_assets_root_id = g_file_watcher.add_root("assets", watch_options);
+  if (g_assets_root_id < 0) {
+    std::cerr << "Failed to add assets directory to the file watcher\n";
+    return -1;
   }
 
-  // Start file watching
-  std::cout << "Starting file watcher...\n";
-  if (!g_file_watcher.start_watching("assets", on_file_event)) {
-    std::cerr << "Failed to start file watcher\n";
-    return -1;
+  // Create initial scan of assets directory; archive listings are cached beside the metadata
+  std::cout << "Performing initial asset scan...\n";
+  if (g_metadata_store.is_open()) {
+    g_indexer.set_archive_store(&g_metadata_store);
   }
+  g_indexer.scan_root(g_assets_root_id);
+  g_asset_store.set_assets(g_database.get_all_assets());
+  g_search_filter.set_result_limit(FUZZY_RESULT_LIMIT);
+  g_search_filter.set_assets(g_asset_store.get_assets());
+  if (g_metadata_store.is_open()) {
+    g_metadata_extractor.set_result_callback(on_metadata_extracted);
+    g_metadata_extractor.enqueue(g_database.get_assets_by_type(AssetType::Model));
+    g_metadata_extractor.enqueue(g_database.get_assets_by_type(AssetType::Sound));
+    g_metadata_extractor.start();
+    g_audio_preview_loader.set_result_callback(wake_main_loop);
+    g_audio_preview_loader.start();
+  }
+
+  // Start file watching, unless a recorded trace is replayed in its place. The root stays registered during a
+  // replay because relative paths and ignore rules come from it.
+  if (options.replay_trace_path.empty()) {
+    if (!options.record_trace_path.empty() && !g_file_watcher.start_trace(options.record_trace_path)) {
+      return -1;
+    }
 
-  std::cout << "File watcher started successfully\n";
+    std::cout << "Starting file watcher...\n";
+    if (!g_file_watcher.start(on_file_event) || g_file_watcher.get_root_path(g_assets_root_id).empty()) {
+      std::cerr << "Failed to start file watcher\n";
+      return -1;
+    }
+
+    std::cout << "File watcher started successfully\n";
+  }
 
   // Initialize GLFW
   if (!glfwInit()) {
@@ -401,6 +851,7 @@ int main() {
 
   glfwMakeContextCurrent(window);
   glfwSwapInterval(1);  // Enable vsync
+  g_wakeups_enabled = true;
 
   // Initialize Dear ImGui
   IMGUI_CHECKVERSION();
@@ -425,31 +876,97 @@ int main() {
   ImGui_ImplGlfw_InitForOpenGL(window, true);
   ImGui_ImplOpenGL3_Init("#version 330");
 
+  if (options.pbo_uploads && g_pixel_buffer_ring.initialize()) {
+    std::cout << "Streaming thumbnail uploads through a persistently mapped pixel buffer\n";
+  }
+
   // Load default texture (generic icon)
-  g_default_texture = load_texture("images/texture.png");
-  if (g_default_texture == 0) {
+  g_default_thumbnail = load_atlas_icon("images/texture.png");
+  if (g_default_thumbnail == INVALID_ATLAS_SLOT) {
     std::cerr << "Warning: Could not load default texture\n";
   }
+  g_texture_cache.set_release_callback([](const CachedTexture &texture) { g_thumbnail_atlas.free(texture.slot); });
+  set_texture_budget(options.texture_budget_mb * 1024 * 1024);
+
+  // Events queued since the watcher started are applied from here on
+  g_indexer.set_batch_callback(publish_changes);
+  g_indexer.start();
+  g_thumbnail_loader.set_thumbnail_size(static_cast<int>(THUMBNAIL_SIZE));
+  ResizeOptions resize_options;
+  resize_options.gamma_correct = GAMMA_CORRECT_THUMBNAILS;
+  g_thumbnail_loader.set_resize_options(resize_options);
+  std::cout << "Thumbnails downscaled with the " << get_resize_kernel_name() << " kernel\n";
+  if (g_thumbnail_cache.is_open()) {
+    g_thumbnail_loader.set_cache(&g_thumbnail_cache);
+  }
+  g_thumbnail_loader.set_profiler(&g_profiler);
+  g_thumbnail_loader.set_result_callback(wake_main_loop);
+  g_thumbnail_loader.start();
+
+  // Start the replay once the UI is up, so its refreshes are part of what is measured
+  std::thread replay_thread;
+  if (!options.replay_trace_path.empty()) {
+    replay_thread = std::thread(replay_trace, options.replay_trace_path, options.replay_speed);
+  }
 
-  // Main loop
+  // Main loop. Unless --continuous is given, it only draws while something changes: after input, a wakeup from
+  // another thread, or while an animation runs, and otherwise sleeps in glfwWaitEventsTimeout().
   double last_time = glfwGetTime();
+  int settle_frames = IDLE_SETTLE_FRAMES;  // Frames left to draw before the loop may sleep
+  uint64_t idle_waits = 0;
+  double idle_seconds = 0.0;
   while (!glfwWindowShouldClose(window)) {
+    bool has_work = g_assets_updated || !g_texture_events.empty() || g_thumbnail_loader.has_results() ||
+                    g_upload_scheduler.has_queued();
+    if (options.continuous || settle_frames > 0 || has_work) {
+      glfwPollEvents();
+    } else {
+      double wait_start = glfwGetTime();
+      glfwWaitEventsTimeout(io.WantTextInput ? CURSOR_BLINK_WAIT_SECONDS : IDLE_WAIT_SECONDS);
+      idle_seconds += glfwGetTime() - wait_start;
+      idle_waits++;
+      settle_frames = IDLE_SETTLE_FRAMES;
+    }
+    g_wakeup_posted = false;  // Work queued from here on posts a new wakeup
+    settle_frames = std::max(settle_frames - 1, 0);
+    g_profiler.begin_frame();
+
     double current_time = glfwGetTime();
     io.DeltaTime = (float)(current_time - last_time);
     last_time = current_time;
 
-    glfwPollEvents();
-
     // Start the Dear ImGui frame
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 
-    // Check if assets were updated and refresh the list
+    if (ImGui::IsKeyPressed(ImGuiKey_F3, false)) {
+      show_profiler = !show_profiler;
+    }
+
+    // Apply pending file events and finished decodes, then pick up the asset list the applier published
+    {
+      ProfileScope scope(&g_profiler, "Events");
+      drain_texture_events();
+    }
+    trim_atlas_pages();  // Before begin_frame(), while last frame's thumbnails are still pinned
+    g_texture_cache.begin_frame();  // Thumbnails uploaded from here on are pinned for this frame
+    {
+      ProfileScope scope(&g_profiler, "Upload");
+      upload_decoded_thumbnails();
+    }
+    refresh_audio_previews();
     if (g_assets_updated.exchange(false)) {
-      g_assets = g_database.get_all_assets();
-      // Re-apply current search filter to include new assets
-      filter_assets(search_buffer);
+      ProfileScope scope(&g_profiler, "DB refresh");
+      std::vector<AssetChange> changes;
+      {
+        std::lock_guard<std::mutex> lock(g_published_changes_mutex);
+        changes.swap(g_published_changes);
+      }
+      // Apply the changes in place and let the search index follow; the filter below only runs again if assets
+      // came or went
+      AssetListEdit edit = g_asset_store.apply(changes);
+      g_search_filter.splice_assets(g_asset_store.get_assets(), edit.removed, edit.inserted);
     }
 
     // Create main window
@@ -494,10 +1011,25 @@ int main() {
     ImGui::PopStyleVar();
     ImGui::PopItemWidth();
 
-    // Filter assets in real-time as user types
-    filter_assets(search_buffer);
+    // Fuzzy matching toggle, right of the capsule
+    ImGui::SetCursorPos(
+        ImVec2(search_x + SEARCH_BOX_WIDTH + 16, search_y + (SEARCH_BOX_HEIGHT - ImGui::GetFrameHeight()) * 0.5f));
+    ImGui::Checkbox("Fuzzy", &fuzzy_search);
+
+    // Filter as the user types; this is a no-op unless the query, the mode or the assets changed
+    g_search_filter.set_mode(fuzzy_search ? SearchMode::Fuzzy : SearchMode::Substring);
+    {
+      ProfileScope scope(&g_profiler, "Filter");
+      g_search_filter.update(search_buffer);
+    }
+    const std::vector<FileInfo> &assets = g_asset_store.get_assets();
+    const std::vector<size_t> &filtered_assets = g_search_filter.get_results();
 
     ImGui::Spacing();
+    if (g_search_filter.get_match_count() > filtered_assets.size()) {
+      ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "Showing the %zu best of %zu matches", filtered_assets.size(),
+                         g_search_filter.get_match_count());
+    }
     ImGui::Spacing();
 
     // Asset grid
@@ -510,90 +1042,48 @@ int main() {
     int columns = static_cast<int>((available_width + GRID_SPACING) / (THUMBNAIL_SIZE + GRID_SPACING));
     if (columns < 1) columns = 1;
 
-    // Display filtered assets in a proper grid
-    for (size_t i = 0; i < g_filtered_assets.size(); i++) {
-      // Calculate grid position
-      int row = static_cast<int>(i) / columns;
-      int col = static_cast<int>(i) % columns;
-
-      // Calculate absolute position for this grid item
-      float x_pos = col * (THUMBNAIL_SIZE + GRID_SPACING);
-      float y_pos = row * (THUMBNAIL_SIZE + GRID_SPACING);
-
-      // Set cursor to the calculated position
-      ImGui::SetCursorPos(ImVec2(x_pos, y_pos));
-
-      ImGui::BeginGroup();
-
-      // Get texture for this asset
-      unsigned int asset_texture = get_asset_texture(g_filtered_assets[i]);
-
-      // Calculate display size based on asset type
-      ImVec2 display_size(THUMBNAIL_SIZE, THUMBNAIL_SIZE);
-      if (g_filtered_assets[i].type == AssetType::Texture && asset_texture != 0) {
-        // Get texture dimensions and calculate aspect-ratio-preserving size
-        int width, height;
-        if (get_texture_dimensions(g_filtered_assets[i].full_path, width, height)) {
-          display_size = calculate_thumbnail_size(width, height, THUMBNAIL_SIZE);
+    // Display filtered assets in a proper grid. The clipper only hands out the rows in view and skips the rest
+    // by moving the cursor, so a frame costs the same with 200 assets or 200k. Only visible items and a few
+    // rows around them request their textures; requests for rows that scrolled away are dropped at the end of
+    // the frame.
+    float row_height = THUMBNAIL_SIZE + GRID_SPACING;
+    int row_count = static_cast<int>((filtered_assets.size() + columns - 1) / columns);
+    ImVec2 grid_origin = ImGui::GetCursorPos();
+    int first_visible_row = row_count;
+    int end_visible_row = 0;
+
+    {
+      ProfileScope scope(&g_profiler, "Grid");
+      g_thumbnail_loader.begin_frame();
+      ImDrawList *grid_draw_list = ImGui::GetWindowDrawList();
+      grid_draw_list->ChannelsSplit(2);
+      ImGuiListClipper clipper;
+      clipper.Begin(row_count, row_height);
+      while (clipper.Step()) {
+        first_visible_row = std::min(first_visible_row, clipper.DisplayStart);
+        end_visible_row = std::max(end_visible_row, clipper.DisplayEnd);
+        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+          for (int col = 0; col < columns; col++) {
+            size_t i = static_cast<size_t>(row) * columns + col;
+            if (i >= filtered_assets.size()) {
+              break;
+            }
+            ImVec2 position(grid_origin.x + col * (THUMBNAIL_SIZE + GRID_SPACING), grid_origin.y + row * row_height);
+            draw_asset_tile(assets[filtered_assets[i]], static_cast<int>(i), position, 1);
+          }
         }
       }
-
-      // Create a fixed-size container for consistent layout
-      ImVec2 container_size(THUMBNAIL_SIZE,
-                            THUMBNAIL_SIZE + 40.0f);  // Extra space for text
-      ImVec2 container_pos = ImGui::GetCursorScreenPos();
-
-      // Draw background for the container (same as app background)
-      ImGui::GetWindowDrawList()->AddRectFilled(
-          container_pos, ImVec2(container_pos.x + container_size.x, container_pos.y + container_size.y),
-          BACKGROUND_COLOR);
-
-      // Calculate position to center the image vertically in the container
-      float image_y_offset = (container_size.y - display_size.y) * 0.5f;
-      ImVec2 image_pos(container_pos.x, container_pos.y + image_y_offset);
-
-      ImGui::PushStyleColor(ImGuiCol_Button, ImVec4(0.f, 0.f, 0.f, 0.f));
-      ImGui::PushStyleColor(ImGuiCol_ButtonActive, ImVec4(0.f, 0.f, 0.f, 0.f));
-      ImGui::PushStyleColor(ImGuiCol_ButtonHovered, ImVec4(0.f, 0.f, 0.f, 0.3f));
-
-      // Display thumbnail image
-      if (asset_texture != 0) {
-        ImGui::SetCursorScreenPos(image_pos);
-        if (ImGui::ImageButton(("##Thumbnail" + std::to_string(i)).c_str(), (ImTextureID)(intptr_t)asset_texture,
-                               display_size)) {
-          std::cout << "Selected: " << g_filtered_assets[i].name << '\n';
-        }
-      } else {
-        // Fallback: colored button if texture failed to load
-        ImGui::SetCursorScreenPos(image_pos);
-        ImGui::PushStyleVar(ImGuiStyleVar_FrameRounding, 8.0f);
-        if (ImGui::Button(("##Thumbnail" + std::to_string(i)).c_str(), display_size)) {
-          std::cout << "Selected: " << g_filtered_assets[i].name << '\n';
-        }
-        ImGui::PopStyleVar();
-
-        // Add a background to simulate thumbnail (same as app background)
-        ImGui::GetWindowDrawList()->AddRectFilled(ImGui::GetItemRectMin(), ImGui::GetItemRectMax(),
-                                                  FALLBACK_THUMBNAIL_COLOR);
+      grid_draw_list->ChannelsMerge();
+      if (first_visible_row < end_visible_row) {
+        prefetch_thumbnails(first_visible_row, end_visible_row, columns, row_count);
       }
 
-      ImGui::PopStyleColor(3);
-
-      // Position text at the bottom of the container
-      ImGui::SetCursorScreenPos(ImVec2(container_pos.x, container_pos.y + THUMBNAIL_SIZE + 5.0f));
-
-      // Asset name below thumbnail
-      std::string truncated_name = truncate_filename(g_filtered_assets[i].name);
-      ImGui::SetCursorPosX(ImGui::GetCursorPosX() +
-                           (THUMBNAIL_SIZE - ImGui::CalcTextSize(truncated_name.c_str()).x) * 0.5f);
-      ImGui::TextWrapped("%s", truncated_name.c_str());
-
-      ImGui::EndGroup();
+      g_thumbnail_loader.end_frame();
     }
 
     // Show message if no assets found
-    if (g_filtered_assets.empty()) {
-      if (g_assets.empty()) {
+    if (filtered_assets.empty()) {
+      if (assets.empty()) {
         ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "No assets found. Add files to the 'assets' directory.");
       } else {
         ImGui::TextColored(ImVec4(0.5f, 0.5f, 0.5f, 1.0f), "No assets match your search.");
@@ -604,29 +1094,72 @@ int main() {
 
     ImGui::End();
 
+    if (show_profiler) {
+      draw_profiler_overlay();
+    }
+
     // Rendering
-    ImGui::Render();
-    int display_w, display_h;
-    glfwGetFramebufferSize(window, &display_w, &display_h);
-    glViewport(0, 0, display_w, display_h);
-    glClearColor(0.95f, 0.97f, 1.00f, 1.00f);
-    glClear(GL_COLOR_BUFFER_BIT);
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    {
+      ProfileScope scope(&g_profiler, "Render");
+      ImGui::Render();
+      int display_w, display_h;
+      glfwGetFramebufferSize(window, &display_w, &display_h);
+      glViewport(0, 0, display_w, display_h);
+      glClearColor(0.95f, 0.97f, 1.00f, 1.00f);
+      glClear(GL_COLOR_BUFFER_BIT);
+      ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    }
 
-    glfwSwapBuffers(window);
-  }
+    {
+      ProfileScope scope(&g_profiler, "Swap");  // Includes waiting for vsync
+      glfwSwapBuffers(window);
+    }
+    g_profiler.end_frame();
 
-  // Cleanup textures
-  for (auto &entry : g_texture_cache) {
-    if (entry.second.is_loaded && entry.second.texture_id != 0) {
-      glDeleteTextures(1, &entry.second.texture_id);
+    // Animations keep frames coming only while they run: the live graphs of the profiler overlay, and held
+    // mouse buttons, e.g. dragging the scrollbar
+    if (show_profiler || ImGui::IsAnyMouseDown()) {
+      settle_frames = std::max(settle_frames, 1);
     }
   }
-  g_texture_cache.clear();
+  g_wakeups_enabled = false;
+  std::cout << "Rendered " << g_profiler.get_stats().frames << " frame(s); idle for " << idle_seconds << "s in "
+            << idle_waits << " wait(s)\n";
 
-  if (g_default_texture != 0) {
-    glDeleteTextures(1, &g_default_texture);
+  // Cleanup textures
+  g_thumbnail_loader.stop();
+  ThumbnailCacheStats thumbnail_stats = g_thumbnail_cache.get_stats();
+  std::cout << "Thumbnails: " << thumbnail_stats.hits << " cache hit(s), " << g_thumbnail_loader.get_decoded_count()
+            << " decode(s), " << thumbnail_stats.evictions << " eviction(s), " << thumbnail_stats.total_bytes / 1024
+            << "KB cached\n";
+  g_thumbnail_cache.close();
+  TextureCacheStats texture_stats = g_texture_cache.get_stats();
+  std::cout << "Texture cache: " << texture_stats.hits << " hit(s), " << texture_stats.misses << " miss(es), "
+            << texture_stats.evictions << " eviction(s), " << texture_stats.failures << " failure(s), "
+            << texture_stats.bytes / (1024 * 1024) << "/" << texture_stats.budget / (1024 * 1024) << "MB; atlas "
+            << g_thumbnail_atlas.get_used_slot_count() << " slot(s) in " << g_thumbnail_atlas.get_page_count() << "/"
+            << g_atlas_page_budget << " page(s)\n";
+  UploadSchedulerStats upload_stats = g_upload_scheduler.get_stats();
+  std::cout << "Uploads: " << upload_stats.uploads << " thumbnail(s), " << upload_stats.bytes / (1024 * 1024)
+            << "MB (" << g_pixel_buffer_ring.get_streamed_bytes() / (1024 * 1024) << "MB streamed), "
+            << upload_stats.budget_frames << " frame(s) at the budget, " << upload_stats.dropped << " dropped\n";
+  g_texture_cache.clear();
+  g_thumbnail_atlas.clear();
+  g_pixel_buffer_ring.shutdown();
+  SearchIndexStats search_stats = g_search_filter.get_index_stats();
+  ZoneStats frame_stats = g_profiler.get_zone_stats(0);
+  std::cout << "Frame time over the last " << g_profiler.get_history(0).size() << " frame(s): p50 "
+            << frame_stats.p50_ms << "ms, p95 " << frame_stats.p95_ms << "ms, p99 " << frame_stats.p99_ms << "ms, max "
+            << frame_stats.max_ms << "ms\n";
+  if (!options.profile_dump_path.empty() && g_profiler.dump(options.profile_dump_path)) {
+    std::cout << "Profile written to " << options.profile_dump_path << '\n';
   }
+  std::cout << "Search index: " << search_stats.assets << " asset(s), " << search_stats.postings << " posting(s), "
+            << search_stats.key_bytes / 1024 << "KB of keys, " << search_stats.compactions << " compaction(s)\n";
+  AssetStoreStats store_stats = g_asset_store.get_stats();
+  std::cout << "Asset list: " << store_stats.changes << " change(s) in " << store_stats.batches << " batch(es), "
+            << store_stats.updated << " updated in place, " << store_stats.inserted << " inserted, "
+            << store_stats.removed << " removed, " << store_stats.apply_time.count() << "us applying\n";
 
   // Cleanup
   ImGui_ImplOpenGL3_Shutdown();
@@ -634,7 +1167,29 @@ int main() {
   ImGui::DestroyContext();
 
   // Stop file watcher and close database
+  for (const auto &rule : g_file_watcher.get_filter_stats(g_assets_root_id)) {
+    std::cout << "File watcher filter '" << rule.rule << "' dropped " << rule.hits << " event(s)\n";
+  }
   g_file_watcher.stop_watching();
+  g_file_watcher.stop_trace();
+  g_trace_player.stop();
+  if (replay_thread.joinable()) {
+    replay_thread.join();
+  }
+
+  // With no producers left, let the indexer finish what is queued
+  g_indexer.stop();
+  AssetIndexerStats indexer_stats = g_indexer.get_stats();
+  std::cout << "Applied " << indexer_stats.events_applied << " database update(s) in "
+            << indexer_stats.apply_time.count() / 1000 << "ms; listed " << indexer_stats.archives_listed
+            << " archive(s)\n";
+  g_metadata_extractor.stop();
+  g_audio_preview_loader.stop();
+  MetadataExtractorStats extractor_stats = g_metadata_extractor.get_stats();
+  std::cout << "Metadata: " << extractor_stats.extracted << " extracted, " << extractor_stats.skipped
+            << " already current, " << extractor_stats.failed << " failed, "
+            << extractor_stats.extract_time.count() / 1000 << "ms of worker time\n";
+  g_metadata_store.close();
   g_database.close();
 
   glfwDestroyWindow(window);
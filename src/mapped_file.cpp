@@ -0,0 +1,132 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#include <windows.h>
+
+#include <filesystem>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile()
+    : mapped_data(nullptr), mapped_size(0), last_write_time(0), file_handle(nullptr), mapping_handle(nullptr) {}
+
+bool MappedFile::open(const std::string& path) {
+  close();
+  HANDLE file = CreateFileW(std::filesystem::u8path(path).wstring().c_str(), GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size;
+  FILETIME write_time;
+  if (!GetFileSizeEx(file, &size) || !GetFileTime(file, nullptr, nullptr, &write_time)) {
+    CloseHandle(file);
+    return false;
+  }
+  file_handle = file;
+  mapped_size = static_cast<size_t>(size.QuadPart);
+  last_write_time = static_cast<int64_t>(static_cast<uint64_t>(write_time.dwHighDateTime) << 32 |
+                                         write_time.dwLowDateTime);
+  if (mapped_size == 0) {
+    return true;  // Empty files can't be mapped
+  }
+
+  mapping_handle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping_handle) {
+    close();
+    return false;
+  }
+  mapped_data = static_cast<const unsigned char*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+  if (!mapped_data) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void MappedFile::close() {
+  if (mapped_data) {
+    UnmapViewOfFile(mapped_data);
+  }
+  if (mapping_handle) {
+    CloseHandle(mapping_handle);
+  }
+  if (file_handle) {
+    CloseHandle(file_handle);
+  }
+  mapped_data = nullptr;
+  mapped_size = 0;
+  last_write_time = 0;
+  file_handle = nullptr;
+  mapping_handle = nullptr;
+}
+
+void MappedFile::advise_sequential() {}
+
+#else
+
+MappedFile::MappedFile() : mapped_data(nullptr), mapped_size(0), last_write_time(0) {}
+
+bool MappedFile::open(const std::string& path) {
+  close();
+  int descriptor = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (descriptor < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(descriptor, &info) != 0 || !S_ISREG(info.st_mode)) {
+    ::close(descriptor);
+    return false;
+  }
+  mapped_size = static_cast<size_t>(info.st_size);
+#ifdef __APPLE__
+  last_write_time = static_cast<int64_t>(info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+  last_write_time = static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+  if (mapped_size > 0) {
+    void* mapping = mmap(nullptr, mapped_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (mapping == MAP_FAILED) {
+      ::close(descriptor);
+      mapped_size = 0;
+      last_write_time = 0;
+      return false;
+    }
+    mapped_data = static_cast<const unsigned char*>(mapping);
+  }
+  // The mapping keeps the file alive
+  ::close(descriptor);
+  return true;
+}
+
+void MappedFile::close() {
+  if (mapped_data) {
+    munmap(const_cast<unsigned char*>(mapped_data), mapped_size);
+  }
+  mapped_data = nullptr;
+  mapped_size = 0;
+  last_write_time = 0;
+}
+
+void MappedFile::advise_sequential() {
+  if (mapped_data) {
+    madvise(const_cast<unsigned char*>(mapped_data), mapped_size, MADV_SEQUENTIAL);
+  }
+}
+
+#endif
+
+MappedFile::~MappedFile() { close(); }
+
+const unsigned char* MappedFile::data() const { return mapped_data; }
+
+size_t MappedFile::size() const { return mapped_size; }
+
+int64_t MappedFile::get_last_write_time() const { return last_write_time; }
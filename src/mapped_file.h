@@ -0,0 +1,36 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// A file mapped read-only into memory. Pages are only read from disk when first touched, so a parser that looks
+// at a header and skips the rest never reads the rest. Empty files open fine with a null data().
+class MappedFile {
+ public:
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool open(const std::string& path);
+  void close();
+
+  // Tell the OS the file will be read front to back, so it reads ahead aggressively and drops pages behind
+  void advise_sequential();
+
+  const unsigned char* data() const;
+  size_t size() const;
+
+  // Modification time of the open file, in the file system's native units
+  int64_t get_last_write_time() const;
+
+ private:
+  const unsigned char* mapped_data;
+  size_t mapped_size;
+  int64_t last_write_time;
+#ifdef _WIN32
+  void* file_handle;
+  void* mapping_handle;
+#endif
+};
@@ -0,0 +1,186 @@
+#include "metadata_extractor.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+#include "audio_metadata.h"
+#include "mapped_file.h"
+#include "model_metadata.h"
+
+MetadataExtractor::MetadataExtractor(MetadataStore& metadata_store, size_t count)
+    : store(metadata_store), worker_count(count), busy_count(0), should_stop(false) {
+  if (worker_count == 0) {
+    worker_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+}
+
+MetadataExtractor::~MetadataExtractor() { stop(); }
+
+void MetadataExtractor::set_result_callback(std::function<void(const std::string&)> callback) {
+  result_callback = std::move(callback);
+}
+
+void MetadataExtractor::start() {
+  if (!workers.empty()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    should_stop = false;
+  }
+  for (size_t i = 0; i < worker_count; i++) {
+    workers.emplace_back(&MetadataExtractor::worker_loop, this);
+  }
+}
+
+void MetadataExtractor::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    should_stop = true;
+    queue.clear();
+  }
+  queue_condition.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+  idle_condition.notify_all();
+}
+
+void MetadataExtractor::enqueue(const std::vector<FileInfo>& assets) {
+  size_t added = 0;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& asset : assets) {
+      if (asset.is_directory) {
+        continue;
+      }
+      bool is_model = has_model_metadata(asset.extension);
+      if (is_model || has_audio_metadata(asset.extension)) {
+        queue.push_back(Job{asset.full_path, is_model});
+        added++;
+      }
+    }
+  }
+  if (added == 1) {
+    queue_condition.notify_one();
+  } else if (added > 1) {
+    queue_condition.notify_all();
+  }
+}
+
+void MetadataExtractor::apply(const std::vector<AssetChange>& changes) {
+  // A Remove followed by an Insert of the same path in one batch replaces a subtree the indexer re-scanned, and
+  // the indexer already cleared the store below it. Removing it here would drop archive listings stored since.
+  std::unordered_map<std::string, size_t> last_insert;
+  for (size_t i = 0; i < changes.size(); i++) {
+    if (changes[i].type == AssetChangeType::Insert) {
+      last_insert[changes[i].asset.full_path] = i;
+    }
+  }
+
+  std::vector<FileInfo> changed;
+  for (size_t i = 0; i < changes.size(); i++) {
+    const AssetChange& change = changes[i];
+    switch (change.type) {
+      case AssetChangeType::Insert:
+      case AssetChangeType::Update:
+        changed.push_back(change.asset);
+        break;
+      case AssetChangeType::Remove: {
+        auto insert = last_insert.find(change.old_path);
+        if (insert == last_insert.end() || insert->second < i) {
+          store.remove(change.old_path);
+        }
+        break;
+      }
+      case AssetChangeType::Move:
+        store.move(change.old_path, change.asset.full_path);
+        break;
+    }
+  }
+  enqueue(changed);
+}
+
+void MetadataExtractor::wait_idle() {
+  std::unique_lock<std::mutex> lock(mutex);
+  idle_condition.wait(lock, [this] { return (queue.empty() && busy_count == 0) || workers.empty(); });
+}
+
+size_t MetadataExtractor::get_queued_count() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return queue.size();
+}
+
+MetadataExtractorStats MetadataExtractor::get_stats() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return stats;
+}
+
+void MetadataExtractor::worker_loop() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      queue_condition.wait(lock, [this] { return should_stop || !queue.empty(); });
+      if (should_stop) {
+        return;
+      }
+      job = std::move(queue.front());
+      queue.pop_front();
+      busy_count++;
+    }
+
+    extract(job);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      busy_count--;
+      if (!queue.empty() || busy_count > 0) {
+        continue;
+      }
+    }
+    idle_condition.notify_all();
+  }
+}
+
+void MetadataExtractor::extract(const Job& job) {
+  const std::string& path = job.full_path;
+  auto start = std::chrono::steady_clock::now();
+  MappedFile file;
+  if (!file.open(path)) {
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.failed++;
+    return;
+  }
+  // Mapping only stats the file, so checking the store afterwards costs no reads
+  uint64_t size = file.size();
+  int64_t last_write_time = file.get_last_write_time();
+  bool current = job.is_model ? store.is_model_current(path, size, last_write_time)
+                              : store.is_audio_current(path, size, last_write_time);
+  if (current) {
+    std::lock_guard<std::mutex> lock(mutex);
+    stats.skipped++;
+    return;
+  }
+
+  if (job.is_model) {
+    ModelMetadata metadata;
+    bool readable = read_model_metadata(path, file, metadata);
+    store.store_model(path, size, last_write_time, readable ? &metadata : nullptr);
+  } else {
+    AudioMetadata metadata;
+    bool readable = read_audio_metadata(path, file, metadata);
+    store.store_audio(path, size, last_write_time, readable ? &metadata : nullptr);
+  }
+  file.close();
+  if (result_callback) {
+    result_callback(path);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  stats.extracted++;
+  stats.bytes += size;
+  stats.extract_time +=
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asset_index.h"
+#include "asset_store.h"
+#include "metadata_store.h"
+
+struct MetadataExtractorStats {
+  uint64_t extracted = 0;  // Files read and stored, including ones that turned out unreadable
+  uint64_t skipped = 0;    // Already current in the store
+  uint64_t failed = 0;     // Gone or unmappable by the time a worker got to them
+  uint64_t bytes = 0;      // Size of the files extracted, most of which a header read never touches
+  std::chrono::microseconds extract_time{0};  // Summed over the workers
+};
+
+// Reads model and sound metadata on a pool of background threads and keeps the metadata store in step with the
+// asset table. Files are mapped rather than read, so a glTF, FBX or sound header costs only the pages it touches,
+// and an OBJ or the samples of a WAV waveform stream through the page cache; with a worker per core, extraction
+// keeps up with the disk. Files whose size and modification time the store already has are skipped, so a
+// restart only reads what changed.
+//
+// The store must outlive the extractor.
+class MetadataExtractor {
+ public:
+  // 0 picks a worker count from the number of cores
+  explicit MetadataExtractor(MetadataStore& metadata_store, size_t worker_count = 0);
+  ~MetadataExtractor();
+
+  MetadataExtractor(const MetadataExtractor&) = delete;
+  MetadataExtractor& operator=(const MetadataExtractor&) = delete;
+
+  // Called on a worker thread after new metadata for a path has been stored. Set before start().
+  void set_result_callback(std::function<void(const std::string& full_path)> callback);
+
+  void start();
+
+  // Stop once the running extractions finish; what is still queued is dropped
+  void stop();
+
+  // Queue the assets that have metadata to read, e.g. after the initial scan; the rest are ignored. Safe to call
+  // from any thread.
+  void enqueue(const std::vector<FileInfo>& assets);
+
+  // Follow a batch of the indexer's changes: new and changed models are queued, and removals and moves are
+  // applied to the store. Safe to call from any thread, e.g. the indexer's batch callback.
+  void apply(const std::vector<AssetChange>& changes);
+
+  // Block until the queue is empty and no worker is busy
+  void wait_idle();
+
+  size_t get_queued_count() const;
+  MetadataExtractorStats get_stats() const;
+
+ private:
+  MetadataStore& store;
+  size_t worker_count;
+  std::function<void(const std::string&)> result_callback;
+  std::vector<std::thread> workers;
+
+  mutable std::mutex mutex;
+  std::condition_variable queue_condition;
+  std::condition_variable idle_condition;
+  struct Job {
+    std::string full_path;
+    bool is_model;  // Otherwise a sound
+  };
+  std::deque<Job> queue;
+  size_t busy_count;
+  bool should_stop;
+  MetadataExtractorStats stats;
+
+  void worker_loop();
+  void extract(const Job& job);
+};
@@ -0,0 +1,540 @@
+#include "metadata_store.h"
+
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+#include "asset_database.h"
+
+// Texture paths of a model are stored in one column, separated by this
+static constexpr char TEXTURE_PATH_SEPARATOR = '\n';
+
+// Side tables that follow the assets they describe through removals and moves
+static const char* const METADATA_TABLES[] = {"model_metadata", "audio_metadata", "archive_metadata",
+                                              "archive_entries"};
+
+MetadataStore::MetadataStore()
+    : db_(nullptr),
+      current_stmt_(nullptr),
+      store_stmt_(nullptr),
+      audio_current_stmt_(nullptr),
+      store_audio_stmt_(nullptr),
+      load_audio_stmt_(nullptr),
+      archive_current_stmt_(nullptr) {}
+
+MetadataStore::~MetadataStore() { close(); }
+
+bool MetadataStore::initialize(const std::string& db_path) {
+  close();
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  std::filesystem::path path(db_path);
+  if (path.has_parent_path()) {
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+  }
+
+  if (sqlite3_open(db_path.c_str(), &db_) != SQLITE_OK) {
+    print_sqlite_error("opening metadata store");
+    sqlite3_close(db_);
+    db_ = nullptr;
+    return false;
+  }
+
+  // The asset database and thumbnail cache write to the same file from other connections
+  sqlite3_busy_timeout(db_, 5000);
+  execute_sql("PRAGMA journal_mode = WAL");
+  if (!create_tables()) {
+    sqlite3_close(db_);
+    db_ = nullptr;
+    return false;
+  }
+
+  const char* current_sql =
+      "SELECT 1 FROM model_metadata WHERE full_path = ? AND file_size = ? AND last_write_time = ?";
+  const char* store_sql = R"(
+        INSERT OR REPLACE INTO model_metadata
+        (full_path, file_size, last_write_time, is_valid, vertex_count, triangle_count, material_count,
+         min_x, min_y, min_z, max_x, max_y, max_z, texture_paths)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+    )";
+  const char* audio_current_sql =
+      "SELECT 1 FROM audio_metadata WHERE full_path = ? AND file_size = ? AND last_write_time = ?";
+  const char* store_audio_sql = R"(
+        INSERT OR REPLACE INTO audio_metadata
+        (full_path, file_size, last_write_time, is_valid, codec, sample_rate, channel_count, bits_per_sample,
+         frame_count, waveform)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?)
+    )";
+  const char* load_audio_sql = R"(
+        SELECT codec, sample_rate, channel_count, bits_per_sample, frame_count, waveform FROM audio_metadata
+        WHERE full_path = ? AND is_valid = 1
+    )";
+  const char* archive_current_sql =
+      "SELECT 1 FROM archive_metadata WHERE full_path = ? AND file_size = ? AND last_write_time = ?";
+  if (sqlite3_prepare_v2(db_, current_sql, -1, &current_stmt_, nullptr) != SQLITE_OK ||
+      sqlite3_prepare_v2(db_, store_sql, -1, &store_stmt_, nullptr) != SQLITE_OK ||
+      sqlite3_prepare_v2(db_, audio_current_sql, -1, &audio_current_stmt_, nullptr) != SQLITE_OK ||
+      sqlite3_prepare_v2(db_, store_audio_sql, -1, &store_audio_stmt_, nullptr) != SQLITE_OK ||
+      sqlite3_prepare_v2(db_, load_audio_sql, -1, &load_audio_stmt_, nullptr) != SQLITE_OK ||
+      sqlite3_prepare_v2(db_, archive_current_sql, -1, &archive_current_stmt_, nullptr) != SQLITE_OK) {
+    print_sqlite_error("preparing metadata store statements");
+    finalize_statements();
+    sqlite3_close(db_);
+    db_ = nullptr;
+    return false;
+  }
+  return true;
+}
+
+void MetadataStore::close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  finalize_statements();
+  if (db_) {
+    sqlite3_close(db_);
+    db_ = nullptr;
+  }
+}
+
+bool MetadataStore::is_open() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return db_ != nullptr;
+}
+
+bool MetadataStore::create_tables() {
+  const std::string create_table_sql = R"(
+        CREATE TABLE IF NOT EXISTS model_metadata (
+            full_path TEXT PRIMARY KEY,
+            file_size INTEGER NOT NULL,
+            last_write_time INTEGER NOT NULL,
+            is_valid INTEGER NOT NULL,
+            vertex_count INTEGER NOT NULL,
+            triangle_count INTEGER NOT NULL,
+            material_count INTEGER NOT NULL,
+            min_x REAL,
+            min_y REAL,
+            min_z REAL,
+            max_x REAL,
+            max_y REAL,
+            max_z REAL,
+            texture_paths TEXT NOT NULL
+        );
+
+        CREATE INDEX IF NOT EXISTS idx_model_metadata_triangle_count ON model_metadata(triangle_count);
+        CREATE INDEX IF NOT EXISTS idx_model_metadata_vertex_count ON model_metadata(vertex_count);
+
+        CREATE TABLE IF NOT EXISTS audio_metadata (
+            full_path TEXT PRIMARY KEY,
+            file_size INTEGER NOT NULL,
+            last_write_time INTEGER NOT NULL,
+            is_valid INTEGER NOT NULL,
+            codec TEXT NOT NULL,
+            sample_rate INTEGER NOT NULL,
+            channel_count INTEGER NOT NULL,
+            bits_per_sample INTEGER NOT NULL,
+            frame_count INTEGER NOT NULL,
+            waveform BLOB
+        );
+
+        CREATE TABLE IF NOT EXISTS archive_metadata (
+            full_path TEXT PRIMARY KEY,
+            file_size INTEGER NOT NULL,
+            last_write_time INTEGER NOT NULL,
+            is_valid INTEGER NOT NULL
+        );
+
+        -- Keyed by the archive's full_path, so removals and moves of the archive carry its entries along
+        CREATE TABLE IF NOT EXISTS archive_entries (
+            full_path TEXT NOT NULL,
+            entry_path TEXT NOT NULL,
+            size INTEGER NOT NULL,
+            last_modified INTEGER NOT NULL,
+            is_directory INTEGER NOT NULL,
+            PRIMARY KEY (full_path, entry_path)
+        );
+    )";
+  return execute_sql(create_table_sql);
+}
+
+void MetadataStore::finalize_statements() {
+  for (sqlite3_stmt** stmt :
+       {&current_stmt_, &store_stmt_, &audio_current_stmt_, &store_audio_stmt_, &load_audio_stmt_,
+        &archive_current_stmt_}) {
+    sqlite3_finalize(*stmt);
+    *stmt = nullptr;
+  }
+}
+
+bool MetadataStore::is_current(sqlite3_stmt* stmt, const std::string& full_path, uint64_t file_size,
+                               int64_t last_write_time) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!db_) {
+    return false;
+  }
+  sqlite3_reset(stmt);
+  sqlite3_bind_text(stmt, 1, full_path.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int64(stmt, 2, static_cast<sqlite3_int64>(file_size));
+  sqlite3_bind_int64(stmt, 3, last_write_time);
+  bool current = sqlite3_step(stmt) == SQLITE_ROW;
+  sqlite3_reset(stmt);
+  return current;
+}
+
+bool MetadataStore::is_model_current(const std::string& full_path, uint64_t file_size, int64_t last_write_time) {
+  return is_current(current_stmt_, full_path, file_size, last_write_time);
+}
+
+bool MetadataStore::is_audio_current(const std::string& full_path, uint64_t file_size, int64_t last_write_time) {
+  return is_current(audio_current_stmt_, full_path, file_size, last_write_time);
+}
+
+bool MetadataStore::is_archive_current(const std::string& full_path, uint64_t file_size, int64_t last_write_time) {
+  return is_current(archive_current_stmt_, full_path, file_size, last_write_time);
+}
+
+bool MetadataStore::store_model(const std::string& full_path, uint64_t file_size, int64_t last_write_time,
+                                const ModelMetadata* metadata) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!db_) {
+    return false;
+  }
+  ModelMetadata unreadable;
+  const ModelMetadata& stored = metadata ? *metadata : unreadable;
+  std::string texture_paths;
+  for (const auto& texture_path : stored.texture_paths) {
+    texture_paths += (texture_paths.empty() ? "" : std::string(1, TEXTURE_PATH_SEPARATOR)) + texture_path;
+  }
+
+  sqlite3_reset(store_stmt_);
+  sqlite3_bind_text(store_stmt_, 1, full_path.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int64(store_stmt_, 2, static_cast<sqlite3_int64>(file_size));
+  sqlite3_bind_int64(store_stmt_, 3, last_write_time);
+  sqlite3_bind_int(store_stmt_, 4, metadata ? 1 : 0);
+  sqlite3_bind_int64(store_stmt_, 5, static_cast<sqlite3_int64>(stored.vertex_count));
+  sqlite3_bind_int64(store_stmt_, 6, static_cast<sqlite3_int64>(stored.triangle_count));
+  sqlite3_bind_int64(store_stmt_, 7, stored.material_count);
+  for (int axis = 0; axis < 3; axis++) {
+    if (stored.has_bounds) {
+      sqlite3_bind_double(store_stmt_, 8 + axis, stored.bounds_min[axis]);
+      sqlite3_bind_double(store_stmt_, 11 + axis, stored.bounds_max[axis]);
+    } else {
+      sqlite3_bind_null(store_stmt_, 8 + axis);
+      sqlite3_bind_null(store_stmt_, 11 + axis);
+    }
+  }
+  sqlite3_bind_text(store_stmt_, 14, texture_paths.c_str(), -1, SQLITE_TRANSIENT);
+  bool success = sqlite3_step(store_stmt_) == SQLITE_DONE;
+  sqlite3_reset(store_stmt_);
+  sqlite3_clear_bindings(store_stmt_);
+  if (!success) {
+    print_sqlite_error("storing model metadata");
+  }
+  return success;
+}
+
+bool MetadataStore::store_audio(const std::string& full_path, uint64_t file_size, int64_t last_write_time,
+                                const AudioMetadata* metadata) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!db_) {
+    return false;
+  }
+  AudioMetadata unreadable;
+  const AudioMetadata& stored = metadata ? *metadata : unreadable;
+
+  sqlite3_reset(store_audio_stmt_);
+  sqlite3_bind_text(store_audio_stmt_, 1, full_path.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int64(store_audio_stmt_, 2, static_cast<sqlite3_int64>(file_size));
+  sqlite3_bind_int64(store_audio_stmt_, 3, last_write_time);
+  sqlite3_bind_int(store_audio_stmt_, 4, metadata ? 1 : 0);
+  sqlite3_bind_text(store_audio_stmt_, 5, stored.codec.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int64(store_audio_stmt_, 6, stored.sample_rate);
+  sqlite3_bind_int64(store_audio_stmt_, 7, stored.channel_count);
+  sqlite3_bind_int64(store_audio_stmt_, 8, stored.bits_per_sample);
+  sqlite3_bind_int64(store_audio_stmt_, 9, static_cast<sqlite3_int64>(stored.frame_count));
+  if (stored.waveform.empty()) {
+    sqlite3_bind_null(store_audio_stmt_, 10);
+  } else {
+    sqlite3_bind_blob(store_audio_stmt_, 10, stored.waveform.data(), static_cast<int>(stored.waveform.size()),
+                      SQLITE_TRANSIENT);
+  }
+  bool success = sqlite3_step(store_audio_stmt_) == SQLITE_DONE;
+  sqlite3_reset(store_audio_stmt_);
+  sqlite3_clear_bindings(store_audio_stmt_);
+  if (!success) {
+    print_sqlite_error("storing audio metadata");
+  }
+  return success;
+}
+
+bool MetadataStore::load_audio(const std::string& full_path, AudioMetadata& metadata) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!db_) {
+    return false;
+  }
+  sqlite3_reset(load_audio_stmt_);
+  sqlite3_bind_text(load_audio_stmt_, 1, full_path.c_str(), -1, SQLITE_TRANSIENT);
+  bool found = sqlite3_step(load_audio_stmt_) == SQLITE_ROW;
+  if (found) {
+    const unsigned char* codec = sqlite3_column_text(load_audio_stmt_, 0);
+    metadata.codec = codec ? reinterpret_cast<const char*>(codec) : "";
+    metadata.sample_rate = static_cast<uint32_t>(sqlite3_column_int64(load_audio_stmt_, 1));
+    metadata.channel_count = static_cast<uint32_t>(sqlite3_column_int64(load_audio_stmt_, 2));
+    metadata.bits_per_sample = static_cast<uint32_t>(sqlite3_column_int64(load_audio_stmt_, 3));
+    metadata.frame_count = static_cast<uint64_t>(sqlite3_column_int64(load_audio_stmt_, 4));
+    const int8_t* waveform = static_cast<const int8_t*>(sqlite3_column_blob(load_audio_stmt_, 5));
+    metadata.waveform.assign(waveform, waveform + (waveform ? sqlite3_column_bytes(load_audio_stmt_, 5) : 0));
+  }
+  sqlite3_reset(load_audio_stmt_);
+  return found;
+}
+
+bool MetadataStore::store_archive(const std::string& full_path, uint64_t file_size, int64_t last_write_time,
+                                  const std::vector<ArchiveEntry>* entries) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!db_) {
+    return false;
+  }
+  sqlite3_stmt* delete_stmt = nullptr;
+  sqlite3_stmt* listing_stmt = nullptr;
+  sqlite3_stmt* entry_stmt = nullptr;
+  bool success = sqlite3_prepare_v2(db_, "DELETE FROM archive_entries WHERE full_path = ?", -1, &delete_stmt,
+                                    nullptr) == SQLITE_OK &&
+                 sqlite3_prepare_v2(db_,
+                                    "INSERT OR REPLACE INTO archive_metadata (full_path, file_size, "
+                                    "last_write_time, is_valid) VALUES (?, ?, ?, ?)",
+                                    -1, &listing_stmt, nullptr) == SQLITE_OK &&
+                 sqlite3_prepare_v2(db_,
+                                    "INSERT OR REPLACE INTO archive_entries (full_path, entry_path, size, "
+                                    "last_modified, is_directory) VALUES (?, ?, ?, ?, ?)",
+                                    -1, &entry_stmt, nullptr) == SQLITE_OK;
+  if (!success) {
+    print_sqlite_error("preparing archive listing statements");
+  }
+
+  // One transaction, so a listing of thousands of entries is a single commit
+  success = success && execute_sql("BEGIN TRANSACTION");
+  if (success) {
+    sqlite3_bind_text(delete_stmt, 1, full_path.c_str(), -1, SQLITE_TRANSIENT);
+    success = sqlite3_step(delete_stmt) == SQLITE_DONE;
+
+    sqlite3_bind_text(listing_stmt, 1, full_path.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(listing_stmt, 2, static_cast<sqlite3_int64>(file_size));
+    sqlite3_bind_int64(listing_stmt, 3, last_write_time);
+    sqlite3_bind_int(listing_stmt, 4, entries ? 1 : 0);
+    success = success && sqlite3_step(listing_stmt) == SQLITE_DONE;
+
+    sqlite3_bind_text(entry_stmt, 1, full_path.c_str(), -1, SQLITE_TRANSIENT);
+    for (size_t i = 0; success && entries && i < entries->size(); i++) {
+      const ArchiveEntry& entry = (*entries)[i];
+      sqlite3_reset(entry_stmt);
+      sqlite3_bind_text(entry_stmt, 2, entry.path.c_str(), -1, SQLITE_TRANSIENT);
+      sqlite3_bind_int64(entry_stmt, 3, static_cast<sqlite3_int64>(entry.size));
+      sqlite3_bind_int64(entry_stmt, 4, entry.last_modified);
+      sqlite3_bind_int(entry_stmt, 5, entry.is_directory ? 1 : 0);
+      success = sqlite3_step(entry_stmt) == SQLITE_DONE;
+    }
+    if (!success) {
+      print_sqlite_error("storing archive listing");
+    }
+    execute_sql(success ? "COMMIT" : "ROLLBACK");
+  }
+  sqlite3_finalize(delete_stmt);
+  sqlite3_finalize(listing_stmt);
+  sqlite3_finalize(entry_stmt);
+  return success;
+}
+
+bool MetadataStore::load_archive(const std::string& full_path, std::vector<ArchiveEntry>& entries) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries.clear();
+  sqlite3_stmt* stmt = nullptr;
+  // The listing row is joined in so that an empty archive can be told apart from a listing that was never stored
+  const char* sql = R"(
+        SELECT e.entry_path, e.size, e.last_modified, e.is_directory FROM archive_metadata m
+        LEFT JOIN archive_entries e ON e.full_path = m.full_path
+        WHERE m.full_path = ? AND m.is_valid = 1 ORDER BY e.entry_path
+    )";
+  if (!db_ || sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+    print_sqlite_error("preparing archive listing lookup");
+    return false;
+  }
+  sqlite3_bind_text(stmt, 1, full_path.c_str(), -1, SQLITE_TRANSIENT);
+  bool found = false;
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    found = true;
+    if (sqlite3_column_type(stmt, 0) == SQLITE_NULL) {
+      continue;
+    }
+    ArchiveEntry entry;
+    entry.path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+    entry.size = static_cast<uint64_t>(sqlite3_column_int64(stmt, 1));
+    entry.last_modified = sqlite3_column_int64(stmt, 2);
+    entry.is_directory = sqlite3_column_int(stmt, 3) != 0;
+    entries.push_back(std::move(entry));
+  }
+  sqlite3_finalize(stmt);
+  return found;
+}
+
+// Fill a record from the columns full_path, vertex_count, triangle_count, material_count, min_x to max_z and
+// texture_paths, in that order
+static void read_model_row(sqlite3_stmt* stmt, ModelRecord& record) {
+  record.full_path = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+  ModelMetadata& metadata = record.metadata;
+  metadata.vertex_count = static_cast<uint64_t>(sqlite3_column_int64(stmt, 1));
+  metadata.triangle_count = static_cast<uint64_t>(sqlite3_column_int64(stmt, 2));
+  metadata.material_count = static_cast<uint32_t>(sqlite3_column_int64(stmt, 3));
+  metadata.has_bounds = sqlite3_column_type(stmt, 4) != SQLITE_NULL;
+  for (int axis = 0; axis < 3; axis++) {
+    metadata.bounds_min[axis] = static_cast<float>(sqlite3_column_double(stmt, 4 + axis));
+    metadata.bounds_max[axis] = static_cast<float>(sqlite3_column_double(stmt, 7 + axis));
+  }
+  const unsigned char* text = sqlite3_column_text(stmt, 10);
+  std::istringstream texture_paths(text ? reinterpret_cast<const char*>(text) : "");
+  std::string texture_path;
+  while (std::getline(texture_paths, texture_path, TEXTURE_PATH_SEPARATOR)) {
+    metadata.texture_paths.push_back(texture_path);
+  }
+}
+
+static const char* const MODEL_COLUMNS =
+    "m.full_path, m.vertex_count, m.triangle_count, m.material_count, m.min_x, m.min_y, m.min_z, m.max_x, "
+    "m.max_y, m.max_z, m.texture_paths";
+
+bool MetadataStore::load_model(const std::string& full_path, ModelMetadata& metadata) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  sqlite3_stmt* stmt = nullptr;
+  std::string sql = std::string("SELECT ") + MODEL_COLUMNS + " FROM model_metadata m WHERE m.full_path = ? AND " +
+                    "m.is_valid = 1";
+  if (!db_ || sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    print_sqlite_error("preparing model metadata lookup");
+    return false;
+  }
+  sqlite3_bind_text(stmt, 1, full_path.c_str(), -1, SQLITE_TRANSIENT);
+  bool found = sqlite3_step(stmt) == SQLITE_ROW;
+  if (found) {
+    ModelRecord record;
+    read_model_row(stmt, record);
+    metadata = std::move(record.metadata);
+  }
+  sqlite3_finalize(stmt);
+  return found;
+}
+
+std::vector<ModelRecord> MetadataStore::find_models(const ModelQuery& query) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<ModelRecord> records;
+
+  // Metadata outlives its assets while the app isn't running, so only paths still in the asset table count.
+  // The triangle range and the ordering both come from the triangle count index.
+  std::string sql = std::string("SELECT ") + MODEL_COLUMNS +
+                    " FROM model_metadata m JOIN assets a ON a.full_path = m.full_path WHERE m.is_valid = 1";
+  if (query.min_triangles > 0) {
+    sql += " AND m.triangle_count >= :min_triangles";
+  }
+  if (query.max_triangles > 0) {
+    sql += " AND m.triangle_count <= :max_triangles";
+  }
+  if (query.min_vertices > 0) {
+    sql += " AND m.vertex_count >= :min_vertices";
+  }
+  if (!query.texture.empty()) {
+    sql += " AND instr(lower(m.texture_paths), lower(:texture)) > 0";
+  }
+  sql += " ORDER BY m.triangle_count DESC";
+  if (query.limit > 0) {
+    sql += " LIMIT :limit";
+  }
+
+  sqlite3_stmt* stmt = nullptr;
+  if (!db_ || sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+    print_sqlite_error("preparing model query");
+    return records;
+  }
+  auto bind_count = [stmt](const char* name, uint64_t value) {
+    int index = sqlite3_bind_parameter_index(stmt, name);
+    if (index > 0) {
+      sqlite3_bind_int64(stmt, index, static_cast<sqlite3_int64>(value));
+    }
+  };
+  bind_count(":min_triangles", query.min_triangles);
+  bind_count(":max_triangles", query.max_triangles);
+  bind_count(":min_vertices", query.min_vertices);
+  bind_count(":limit", query.limit);
+  int texture_index = sqlite3_bind_parameter_index(stmt, ":texture");
+  if (texture_index > 0) {
+    sqlite3_bind_text(stmt, texture_index, query.texture.c_str(), -1, SQLITE_TRANSIENT);
+  }
+
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    records.emplace_back();
+    read_model_row(stmt, records.back());
+  }
+  sqlite3_finalize(stmt);
+  return records;
+}
+
+bool MetadataStore::remove(const std::string& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool success = db_ != nullptr;
+  for (const char* table : METADATA_TABLES) {
+    std::string sql =
+        std::string("DELETE FROM ") + table +
+        " WHERE full_path = ?1 OR (full_path >= ?2 AND full_path < ?3) OR (full_path >= ?4 AND full_path < ?5)";
+    sqlite3_stmt* stmt = nullptr;
+    if (!db_ || sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+      print_sqlite_error("preparing metadata removal");
+      return false;
+    }
+    sqlite3_bind_text(stmt, 1, path.c_str(), -1, SQLITE_TRANSIENT);
+    bind_subtree_bounds(stmt, 2, path);
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+      print_sqlite_error("removing metadata");
+      success = false;
+    }
+    sqlite3_finalize(stmt);
+  }
+  return success;
+}
+
+bool MetadataStore::move(const std::string& old_path, const std::string& new_path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool success = db_ != nullptr;
+  for (const char* table : METADATA_TABLES) {
+    // As in AssetDatabase::move_assets_under_path(), the suffix is cut from the BLOB form so ?2 counts bytes
+    std::string sql = std::string("UPDATE OR REPLACE ") + table +
+                      " SET full_path = ?1 || CAST(substr(CAST(full_path AS BLOB), ?2) AS TEXT)"
+                      " WHERE full_path = ?3 OR (full_path >= ?4 AND full_path < ?5) OR"
+                      " (full_path >= ?6 AND full_path < ?7)";
+    sqlite3_stmt* stmt = nullptr;
+    if (!db_ || sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+      print_sqlite_error("preparing metadata move");
+      return false;
+    }
+    sqlite3_bind_text(stmt, 1, new_path.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, static_cast<int>(old_path.size()) + 1);
+    sqlite3_bind_text(stmt, 3, old_path.c_str(), -1, SQLITE_TRANSIENT);
+    bind_subtree_bounds(stmt, 4, old_path);
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+      print_sqlite_error("moving metadata");
+      success = false;
+    }
+    sqlite3_finalize(stmt);
+  }
+  return success;
+}
+
+bool MetadataStore::execute_sql(const std::string& sql) {
+  char* error_msg = nullptr;
+  int rc = sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &error_msg);
+  if (rc != SQLITE_OK) {
+    std::cerr << "SQL error: " << (error_msg ? error_msg : sqlite3_errmsg(db_)) << '\n';
+    sqlite3_free(error_msg);
+    return false;
+  }
+  return true;
+}
+
+void MetadataStore::print_sqlite_error(const std::string& operation) {
+  std::cerr << "SQLite error during " << operation << ": " << (db_ ? sqlite3_errmsg(db_) : "no connection") << '\n';
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <sqlite3.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "archive_index.h"
+#include "audio_metadata.h"
+#include "model_metadata.h"
+
+// Which models find_models() returns; zero bounds are unset
+struct ModelQuery {
+  uint64_t min_triangles = 0;
+  uint64_t max_triangles = 0;
+  uint64_t min_vertices = 0;
+  std::string texture;  // Substring of a referenced texture path
+  size_t limit = 0;
+};
+
+struct ModelRecord {
+  std::string full_path;
+  ModelMetadata metadata;
+};
+
+// Metadata extracted from asset files, in side tables of the asset database file keyed by full path and
+// validated against the file's size and modification time like the thumbnail cache. Triangle and vertex counts
+// are indexed, so range queries such as "over a million triangles" don't scan the table. Sounds are stored with
+// their waveform summary, so drawing a folder of them needs no decoding, and archives with their listing, so an
+// unchanged archive is never opened again. Uses its own connection and is safe to
+// call from several threads.
+class MetadataStore {
+ public:
+  MetadataStore();
+  ~MetadataStore();
+
+  MetadataStore(const MetadataStore&) = delete;
+  MetadataStore& operator=(const MetadataStore&) = delete;
+
+  bool initialize(const std::string& db_path);
+  void close();
+  bool is_open() const;
+
+  // Whether metadata, or a failed attempt at it, is stored for exactly this size and modification time
+  bool is_model_current(const std::string& full_path, uint64_t file_size, int64_t last_write_time);
+  bool is_audio_current(const std::string& full_path, uint64_t file_size, int64_t last_write_time);
+  bool is_archive_current(const std::string& full_path, uint64_t file_size, int64_t last_write_time);
+
+  // Store the metadata of a file, or with null `metadata` that it couldn't be read, so it isn't retried until
+  // the file changes
+  bool store_model(const std::string& full_path, uint64_t file_size, int64_t last_write_time,
+                   const ModelMetadata* metadata);
+  bool store_audio(const std::string& full_path, uint64_t file_size, int64_t last_write_time,
+                   const AudioMetadata* metadata);
+  bool store_archive(const std::string& full_path, uint64_t file_size, int64_t last_write_time,
+                     const std::vector<ArchiveEntry>* entries);
+
+  bool load_model(const std::string& full_path, ModelMetadata& metadata);
+
+  // Cheap enough to call from the UI thread for each sound tile that comes into view
+  bool load_audio(const std::string& full_path, AudioMetadata& metadata);
+
+  // The stored listing of an archive, sorted by entry path; false if none is stored or it couldn't be read
+  bool load_archive(const std::string& full_path, std::vector<ArchiveEntry>& entries);
+
+  // Models matching `query` that are still in the asset table, most triangles first
+  std::vector<ModelRecord> find_models(const ModelQuery& query);
+
+  // Forget the metadata of a path and everything below it
+  bool remove(const std::string& path);
+
+  // Follow a rename of a file or directory
+  bool move(const std::string& old_path, const std::string& new_path);
+
+ private:
+  mutable std::mutex mutex_;
+  sqlite3* db_;
+  sqlite3_stmt* current_stmt_;
+  sqlite3_stmt* store_stmt_;
+  sqlite3_stmt* audio_current_stmt_;
+  sqlite3_stmt* store_audio_stmt_;
+  sqlite3_stmt* load_audio_stmt_;
+  sqlite3_stmt* archive_current_stmt_;
+
+  bool create_tables();
+  void finalize_statements();
+  bool is_current(sqlite3_stmt* stmt, const std::string& full_path, uint64_t file_size, int64_t last_write_time);
+  bool execute_sql(const std::string& sql);
+  void print_sqlite_error(const std::string& operation);
+};
@@ -0,0 +1,737 @@
+#include "model_metadata.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <unordered_set>
+#include <utility>
+
+#include "mapped_file.h"
+
+namespace {
+
+// JSON nested deeper than this is taken for garbage rather than recursed into
+constexpr int MAX_JSON_DEPTH = 64;
+
+// FBX binary files start with this, then 0x1A 0x00 and a 32-bit version
+constexpr char FBX_MAGIC[] = "Kaydara FBX Binary  ";
+constexpr size_t FBX_HEADER_SIZE = 27;
+
+// From version 7.5 on, FBX node records use 64-bit offsets
+constexpr uint32_t FBX_WIDE_VERSION = 7500;
+
+constexpr uint32_t GLB_MAGIC = 0x46546C67;       // "glTF"
+constexpr uint32_t GLB_JSON_CHUNK = 0x4E4F534A;  // "JSON"
+
+// glTF primitive modes
+constexpr int GLTF_TRIANGLES = 4;
+constexpr int GLTF_TRIANGLE_STRIP = 5;
+constexpr int GLTF_TRIANGLE_FAN = 6;
+
+uint32_t read_le32(const unsigned char* data) {
+  return static_cast<uint32_t>(data[0] | data[1] << 8 | data[2] << 16) | static_cast<uint32_t>(data[3]) << 24;
+}
+
+uint64_t read_le64(const unsigned char* data) {
+  return read_le32(data) | static_cast<uint64_t>(read_le32(data + 4)) << 32;
+}
+
+bool is_space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+void add_unique(std::vector<std::string>& paths, std::string path) {
+  if (!path.empty() && std::find(paths.begin(), paths.end(), path) == paths.end()) {
+    paths.push_back(std::move(path));
+  }
+}
+
+void extend_bounds(ModelMetadata& metadata, const float* point_min, const float* point_max) {
+  for (int axis = 0; axis < 3; axis++) {
+    metadata.bounds_min[axis] = metadata.has_bounds ? std::min(metadata.bounds_min[axis], point_min[axis])
+                                                    : point_min[axis];
+    metadata.bounds_max[axis] = metadata.has_bounds ? std::max(metadata.bounds_max[axis], point_max[axis])
+                                                    : point_max[axis];
+  }
+  metadata.has_bounds = true;
+}
+
+// Whitespace-separated fields of one line, without copying
+class LineFields {
+ public:
+  LineFields(const char* begin, const char* end) : position(begin), line_end(end) {}
+
+  bool next(const char*& field, size_t& length) {
+    while (position < line_end && is_space(*position)) {
+      position++;
+    }
+    if (position == line_end) {
+      return false;
+    }
+    field = position;
+    while (position < line_end && !is_space(*position)) {
+      position++;
+    }
+    length = static_cast<size_t>(position - field);
+    return true;
+  }
+
+  // The rest of the line, trimmed
+  std::string rest() const {
+    const char* begin = position;
+    const char* end = line_end;
+    while (begin < end && is_space(*begin)) {
+      begin++;
+    }
+    while (end > begin && is_space(end[-1])) {
+      end--;
+    }
+    return std::string(begin, end);
+  }
+
+ private:
+  const char* position;
+  const char* line_end;
+};
+
+// Calls `visit(begin, end)` for each line; memchr finds the line ends with the library's vectorized search
+template <typename Visit>
+void for_each_line(const unsigned char* data, size_t size, Visit visit) {
+  const char* position = reinterpret_cast<const char*>(data);
+  const char* end = position + size;
+  while (position < end) {
+    const char* line_end = static_cast<const char*>(std::memchr(position, '\n', static_cast<size_t>(end - position)));
+    if (!line_end) {
+      line_end = end;
+    }
+    visit(position, line_end);
+    position = line_end + 1;
+  }
+}
+
+bool starts_with(const char* begin, const char* end, const char* keyword) {
+  size_t length = std::strlen(keyword);
+  return static_cast<size_t>(end - begin) > length && std::memcmp(begin, keyword, length) == 0 &&
+         is_space(begin[length]);
+}
+
+// A parsed JSON document, enough of one for a glTF header
+struct JsonValue {
+  enum class Type { Null, Boolean, Number, String, Array, Object };
+
+  Type type = Type::Null;
+  double number = 0.0;
+  std::string string;
+  std::vector<JsonValue> items;
+  std::vector<std::pair<std::string, JsonValue>> members;
+
+  const JsonValue* get(const char* key) const {
+    for (const auto& member : members) {
+      if (member.first == key) {
+        return &member.second;
+      }
+    }
+    return nullptr;
+  }
+
+  const JsonValue* at(double index) const {
+    if (type != Type::Array || index < 0 || index >= static_cast<double>(items.size())) {
+      return nullptr;
+    }
+    return &items[static_cast<size_t>(index)];
+  }
+
+  double get_number(const char* key, double fallback) const {
+    const JsonValue* value = get(key);
+    return value && value->type == Type::Number ? value->number : fallback;
+  }
+};
+
+class JsonParser {
+ public:
+  JsonParser(const char* begin, const char* end) : position(begin), text_end(end) {}
+
+  bool parse(JsonValue& value) { return parse_value(value, 0) && (skip_space(), position == text_end); }
+
+ private:
+  const char* position;
+  const char* text_end;
+
+  void skip_space() {
+    while (position < text_end && (*position == ' ' || *position == '\t' || *position == '\n' || *position == '\r')) {
+      position++;
+    }
+  }
+
+  bool consume(char c) {
+    skip_space();
+    if (position < text_end && *position == c) {
+      position++;
+      return true;
+    }
+    return false;
+  }
+
+  bool parse_literal(const char* literal) {
+    size_t length = std::strlen(literal);
+    if (static_cast<size_t>(text_end - position) < length || std::memcmp(position, literal, length) != 0) {
+      return false;
+    }
+    position += length;
+    return true;
+  }
+
+  bool parse_string(std::string& out) {
+    if (!consume('"')) {
+      return false;
+    }
+    while (position < text_end && *position != '"') {
+      char c = *position++;
+      if (c != '\\') {
+        out += c;
+        continue;
+      }
+      if (position == text_end) {
+        return false;
+      }
+      char escape = *position++;
+      switch (escape) {
+        case 'b':
+          out += '\b';
+          break;
+        case 'f':
+          out += '\f';
+          break;
+        case 'n':
+          out += '\n';
+          break;
+        case 'r':
+          out += '\r';
+          break;
+        case 't':
+          out += '\t';
+          break;
+        case 'u': {
+          unsigned int code = 0;
+          if (text_end - position < 4 || std::from_chars(position, position + 4, code, 16).ptr != position + 4) {
+            return false;
+          }
+          position += 4;
+          // Paths in glTF files are ASCII in practice; anything else is kept as UTF-8 without pairing surrogates
+          if (code < 0x80) {
+            out += static_cast<char>(code);
+          } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | code >> 6);
+            out += static_cast<char>(0x80 | (code & 0x3F));
+          } else {
+            out += static_cast<char>(0xE0 | code >> 12);
+            out += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+          }
+          break;
+        }
+        default:
+          out += escape;  // Quote, backslash and slash
+          break;
+      }
+    }
+    return consume('"');
+  }
+
+  bool parse_value(JsonValue& value, int depth) {
+    if (depth > MAX_JSON_DEPTH) {
+      return false;
+    }
+    skip_space();
+    if (position == text_end) {
+      return false;
+    }
+    switch (*position) {
+      case '{':
+        position++;
+        value.type = JsonValue::Type::Object;
+        if (consume('}')) {
+          return true;
+        }
+        do {
+          std::pair<std::string, JsonValue> member;
+          if (!parse_string(member.first) || !consume(':') || !parse_value(member.second, depth + 1)) {
+            return false;
+          }
+          value.members.push_back(std::move(member));
+        } while (consume(','));
+        return consume('}');
+      case '[':
+        position++;
+        value.type = JsonValue::Type::Array;
+        if (consume(']')) {
+          return true;
+        }
+        do {
+          value.items.emplace_back();
+          if (!parse_value(value.items.back(), depth + 1)) {
+            return false;
+          }
+        } while (consume(','));
+        return consume(']');
+      case '"':
+        value.type = JsonValue::Type::String;
+        return parse_string(value.string);
+      case 't':
+        value.type = JsonValue::Type::Boolean;
+        value.number = 1.0;
+        return parse_literal("true");
+      case 'f':
+        value.type = JsonValue::Type::Boolean;
+        return parse_literal("false");
+      case 'n':
+        return parse_literal("null");
+      default: {
+        value.type = JsonValue::Type::Number;
+        // from_chars doesn't take a leading plus, which JSON doesn't allow either
+        auto result = std::from_chars(position, text_end, value.number);
+        if (result.ec != std::errc()) {
+          return false;
+        }
+        position = result.ptr;
+        return true;
+      }
+    }
+  }
+};
+
+// Decode the %XX escapes of a URI
+std::string decode_uri(const std::string& uri) {
+  std::string path;
+  for (size_t i = 0; i < uri.size(); i++) {
+    unsigned int byte = 0;
+    if (uri[i] == '%' && i + 2 < uri.size() &&
+        std::from_chars(uri.data() + i + 1, uri.data() + i + 3, byte, 16).ptr == uri.data() + i + 3) {
+      path += static_cast<char>(byte);
+      i += 2;
+    } else {
+      path += uri[i];
+    }
+  }
+  return path;
+}
+
+bool read_gltf_json(const JsonValue& root, ModelMetadata& metadata) {
+  if (root.type != JsonValue::Type::Object) {
+    return false;
+  }
+  static const JsonValue empty;
+  const JsonValue* accessors = root.get("accessors");
+  accessors = accessors ? accessors : &empty;
+
+  if (const JsonValue* meshes = root.get("meshes")) {
+    for (const JsonValue& mesh : meshes->items) {
+      const JsonValue* primitives = mesh.get("primitives");
+      if (!primitives) {
+        continue;
+      }
+      for (const JsonValue& primitive : primitives->items) {
+        const JsonValue* attributes = primitive.get("attributes");
+        const JsonValue* position = attributes ? accessors->at(attributes->get_number("POSITION", -1)) : nullptr;
+        if (!position) {
+          continue;
+        }
+        double vertex_count = position->get_number("count", 0);
+        metadata.vertex_count += static_cast<uint64_t>(vertex_count);
+
+        const JsonValue* indices = accessors->at(primitive.get_number("indices", -1));
+        double index_count = indices ? indices->get_number("count", 0) : vertex_count;
+        int mode = static_cast<int>(primitive.get_number("mode", GLTF_TRIANGLES));
+        if (mode == GLTF_TRIANGLES) {
+          metadata.triangle_count += static_cast<uint64_t>(index_count) / 3;
+        } else if ((mode == GLTF_TRIANGLE_STRIP || mode == GLTF_TRIANGLE_FAN) && index_count >= 3) {
+          metadata.triangle_count += static_cast<uint64_t>(index_count) - 2;
+        }
+
+        const JsonValue* min = position->get("min");
+        const JsonValue* max = position->get("max");
+        if (min && max && min->items.size() == 3 && max->items.size() == 3) {
+          float point_min[3];
+          float point_max[3];
+          for (int axis = 0; axis < 3; axis++) {
+            point_min[axis] = static_cast<float>(min->items[static_cast<size_t>(axis)].number);
+            point_max[axis] = static_cast<float>(max->items[static_cast<size_t>(axis)].number);
+          }
+          extend_bounds(metadata, point_min, point_max);
+        }
+      }
+    }
+  }
+
+  if (const JsonValue* materials = root.get("materials")) {
+    metadata.material_count = static_cast<uint32_t>(materials->items.size());
+  }
+  // Images embedded in a buffer or as data URIs aren't separate files
+  if (const JsonValue* images = root.get("images")) {
+    for (const JsonValue& image : images->items) {
+      const JsonValue* uri = image.get("uri");
+      if (uri && uri->type == JsonValue::Type::String && uri->string.compare(0, 5, "data:") != 0) {
+        add_unique(metadata.texture_paths, decode_uri(uri->string));
+      }
+    }
+  }
+  return true;
+}
+
+// One node record of an FBX file. Its properties run from `properties` to `children`, and its nested nodes
+// from `children` to `end`.
+struct FbxNode {
+  std::string name;
+  uint32_t property_count = 0;
+  size_t properties = 0;
+  size_t children = 0;
+  size_t end = 0;
+};
+
+class FbxReader {
+ public:
+  FbxReader(const unsigned char* file_data, bool wide_records) : data(file_data), wide(wide_records) {}
+
+  // Read the node at `position` and move past it. False at the null record ending a list, or on corrupt data.
+  bool next(size_t& position, size_t list_end, FbxNode& node) const {
+    size_t header_size = wide ? 25 : 13;
+    if (position + header_size > list_end) {
+      return false;
+    }
+    const unsigned char* header = data + position;
+    uint64_t end = wide ? read_le64(header) : read_le32(header);
+    uint64_t property_count = wide ? read_le64(header + 8) : read_le32(header + 4);
+    uint64_t property_bytes = wide ? read_le64(header + 16) : read_le32(header + 8);
+    size_t name_length = header[header_size - 1];
+    if (end == 0) {
+      return false;
+    }
+    size_t properties = position + header_size + name_length;
+    if (end > list_end || end <= position || properties + property_bytes > end) {
+      return false;
+    }
+    node.name.assign(reinterpret_cast<const char*>(header + header_size), name_length);
+    node.property_count = static_cast<uint32_t>(property_count);
+    node.properties = properties;
+    node.children = properties + static_cast<size_t>(property_bytes);
+    node.end = static_cast<size_t>(end);
+    position = node.end;
+    return true;
+  }
+
+  // Find the property at `index`, returning its type code and the offset of its payload
+  bool find_property(const FbxNode& node, uint32_t index, char& type, size_t& payload) const {
+    size_t position = node.properties;
+    for (uint32_t i = 0; i < node.property_count && position < node.children; i++) {
+      type = static_cast<char>(data[position]);
+      payload = position + 1;
+      if (i == index) {
+        return true;
+      }
+      size_t length = 0;
+      switch (type) {
+        case 'C':
+          length = 1;
+          break;
+        case 'Y':
+          length = 2;
+          break;
+        case 'I':
+        case 'F':
+          length = 4;
+          break;
+        case 'D':
+        case 'L':
+          length = 8;
+          break;
+        case 'S':
+        case 'R':
+          if (payload + 4 > node.children) {
+            return false;
+          }
+          length = 4 + read_le32(data + payload);
+          break;
+        case 'f':
+        case 'd':
+        case 'l':
+        case 'i':
+        case 'b':
+          if (payload + 12 > node.children) {
+            return false;
+          }
+          length = 12 + read_le32(data + payload + 8);
+          break;
+        default:
+          return false;
+      }
+      position = payload + length;
+    }
+    return false;
+  }
+
+  bool get_string(const FbxNode& node, uint32_t index, std::string& value) const {
+    char type = 0;
+    size_t payload = 0;
+    if (!find_property(node, index, type, payload) || type != 'S' || payload + 4 > node.children) {
+      return false;
+    }
+    size_t length = read_le32(data + payload);
+    if (payload + 4 + length > node.children) {
+      return false;
+    }
+    value.assign(reinterpret_cast<const char*>(data + payload + 4), length);
+    return true;
+  }
+
+  // An array property: its element type and count, and its elements if stored uncompressed
+  bool get_array(const FbxNode& node, char& type, uint32_t& count, const unsigned char*& elements) const {
+    size_t payload = 0;
+    if (!find_property(node, 0, type, payload) || payload + 12 > node.children) {
+      return false;
+    }
+    count = read_le32(data + payload);
+    uint32_t encoding = read_le32(data + payload + 4);
+    uint32_t stored_bytes = read_le32(data + payload + 8);
+    if (payload + 12 + stored_bytes > node.children) {
+      return false;
+    }
+    size_t element_size = type == 'd' || type == 'l' ? 8 : type == 'b' ? 1 : 4;
+    elements = encoding == 0 && stored_bytes == count * element_size ? data + payload + 12 : nullptr;
+    return true;
+  }
+
+ private:
+  const unsigned char* data;
+  bool wide;
+};
+
+void read_fbx_geometry(const FbxReader& reader, const FbxNode& geometry, ModelMetadata& metadata) {
+  // Blend shapes are Geometry nodes too, but they only offset a mesh's vertices
+  std::string geometry_type;
+  if (!reader.get_string(geometry, 2, geometry_type) || geometry_type != "Mesh") {
+    return;
+  }
+  size_t position = geometry.children;
+  FbxNode child;
+  while (reader.next(position, geometry.end, child)) {
+    char type = 0;
+    uint32_t count = 0;
+    const unsigned char* elements = nullptr;
+    if (child.name == "Vertices" && reader.get_array(child, type, count, elements) && (type == 'd' || type == 'f')) {
+      metadata.vertex_count += count / 3;
+      if (!elements) {
+        continue;
+      }
+      for (uint32_t i = 0; i + 2 < count; i += 3) {
+        float point[3];
+        for (int axis = 0; axis < 3; axis++) {
+          const unsigned char* element = elements + static_cast<size_t>(i + axis) * (type == 'd' ? 8 : 4);
+          if (type == 'd') {
+            double value;
+            uint64_t bits = read_le64(element);
+            std::memcpy(&value, &bits, sizeof(value));
+            point[axis] = static_cast<float>(value);
+          } else {
+            uint32_t bits = read_le32(element);
+            std::memcpy(&point[axis], &bits, sizeof(float));
+          }
+        }
+        extend_bounds(metadata, point, point);
+      }
+    } else if (child.name == "PolygonVertexIndex" && reader.get_array(child, type, count, elements) &&
+               type == 'i') {
+      if (!elements) {
+        metadata.triangle_count += count / 3;
+        continue;
+      }
+      // The last index of each polygon is stored as its ones' complement; a polygon of n corners is n - 2
+      // triangles
+      uint64_t polygons = 0;
+      for (uint32_t i = 0; i < count; i++) {
+        polygons += read_le32(elements + static_cast<size_t>(i) * 4) >> 31;
+      }
+      metadata.triangle_count += count >= 2 * polygons ? count - 2 * polygons : 0;
+    }
+  }
+}
+
+void read_fbx_texture(const FbxReader& reader, const FbxNode& texture, ModelMetadata& metadata) {
+  std::string file_name;
+  std::string relative_name;
+  size_t position = texture.children;
+  FbxNode child;
+  while (reader.next(position, texture.end, child)) {
+    if (child.name == "FileName") {
+      reader.get_string(child, 0, file_name);
+    } else if (child.name == "RelativeFilename") {
+      reader.get_string(child, 0, relative_name);
+    }
+  }
+  add_unique(metadata.texture_paths, relative_name.empty() ? file_name : relative_name);
+}
+
+std::string get_extension(const std::string& path) {
+  std::string extension = std::filesystem::u8path(path).extension().u8string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return static_cast<char>(std::tolower(static_cast<int>(c))); });
+  return extension;
+}
+
+}  // namespace
+
+bool has_model_metadata(const std::string& extension) {
+  return extension == ".obj" || extension == ".gltf" || extension == ".glb" || extension == ".fbx";
+}
+
+bool read_obj_metadata(const unsigned char* data, size_t size, ModelMetadata& metadata,
+                       std::vector<std::string>& material_libraries) {
+  std::unordered_set<std::string> materials;
+  for_each_line(data, size, [&](const char* begin, const char* end) {
+    if (end - begin < 2) {
+      return;
+    }
+    if (begin[0] == 'v' && is_space(begin[1])) {
+      // Positions; vt, vn and vp lines fail the second test
+      float point[3] = {};
+      const char* position = begin + 2;
+      int axis = 0;
+      for (; axis < 3; axis++) {
+        while (position < end && is_space(*position)) {
+          position++;
+        }
+        auto result = std::from_chars(position, end, point[axis]);
+        if (result.ec != std::errc()) {
+          break;
+        }
+        position = result.ptr;
+      }
+      metadata.vertex_count++;
+      if (axis == 3) {
+        extend_bounds(metadata, point, point);
+      }
+    } else if (begin[0] == 'f' && is_space(begin[1])) {
+      LineFields fields(begin + 2, end);
+      const char* field = nullptr;
+      size_t length = 0;
+      uint64_t corners = 0;
+      while (fields.next(field, length)) {
+        corners++;
+      }
+      metadata.triangle_count += corners >= 3 ? corners - 2 : 0;
+    } else if (starts_with(begin, end, "usemtl")) {
+      materials.insert(LineFields(begin + 6, end).rest());
+    } else if (starts_with(begin, end, "mtllib")) {
+      LineFields fields(begin + 6, end);
+      const char* field = nullptr;
+      size_t length = 0;
+      while (fields.next(field, length)) {
+        add_unique(material_libraries, std::string(field, length));
+      }
+    }
+  });
+  metadata.material_count = static_cast<uint32_t>(materials.size());
+  return true;
+}
+
+void read_mtl_textures(const unsigned char* data, size_t size, std::vector<std::string>& texture_paths) {
+  for_each_line(data, size, [&](const char* begin, const char* end) {
+    LineFields fields(begin, end);
+    const char* keyword = nullptr;
+    size_t keyword_length = 0;
+    if (!fields.next(keyword, keyword_length)) {
+      return;
+    }
+    std::string name(keyword, keyword_length);
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(static_cast<int>(c))); });
+    if (name.compare(0, 4, "map_") != 0 && name != "bump" && name != "disp" && name != "decal" && name != "refl" &&
+        name != "norm") {
+      return;
+    }
+    // Options such as -s 1 1 1 come first; the file name is last
+    const char* field = nullptr;
+    size_t length = 0;
+    std::string path;
+    while (fields.next(field, length)) {
+      path.assign(field, length);
+    }
+    add_unique(texture_paths, path);
+  });
+}
+
+bool read_gltf_metadata(const unsigned char* data, size_t size, ModelMetadata& metadata) {
+  const char* text = reinterpret_cast<const char*>(data);
+  JsonValue root;
+  return JsonParser(text, text + size).parse(root) && read_gltf_json(root, metadata);
+}
+
+bool read_glb_metadata(const unsigned char* data, size_t size, ModelMetadata& metadata) {
+  if (size < 20 || read_le32(data) != GLB_MAGIC || read_le32(data + 16) != GLB_JSON_CHUNK) {
+    return false;
+  }
+  size_t json_size = read_le32(data + 12);
+  if (json_size > size - 20) {
+    return false;
+  }
+  // The JSON chunk may be padded with spaces, which the parser skips
+  return read_gltf_metadata(data + 20, json_size, metadata);
+}
+
+bool read_fbx_metadata(const unsigned char* data, size_t size, ModelMetadata& metadata) {
+  if (size < FBX_HEADER_SIZE || std::memcmp(data, FBX_MAGIC, sizeof(FBX_MAGIC) - 1) != 0) {
+    return false;
+  }
+  FbxReader reader(data, read_le32(data + 23) >= FBX_WIDE_VERSION);
+  size_t position = FBX_HEADER_SIZE;
+  FbxNode node;
+  while (reader.next(position, size, node)) {
+    if (node.name != "Objects") {
+      continue;
+    }
+    size_t child_position = node.children;
+    FbxNode object;
+    while (reader.next(child_position, node.end, object)) {
+      if (object.name == "Geometry") {
+        read_fbx_geometry(reader, object, metadata);
+      } else if (object.name == "Material") {
+        metadata.material_count++;
+      } else if (object.name == "Texture") {
+        read_fbx_texture(reader, object, metadata);
+      }
+    }
+    return true;
+  }
+  // A file without objects is an empty scene
+  return true;
+}
+
+bool read_model_metadata(const std::string& path, MappedFile& file, ModelMetadata& metadata) {
+  metadata = ModelMetadata();
+  std::string extension = get_extension(path);
+  if (extension == ".gltf") {
+    return read_gltf_metadata(file.data(), file.size(), metadata);
+  }
+  if (extension == ".glb") {
+    return read_glb_metadata(file.data(), file.size(), metadata);
+  }
+  if (extension == ".fbx") {
+    return read_fbx_metadata(file.data(), file.size(), metadata);
+  }
+  if (extension != ".obj") {
+    return false;
+  }
+
+  file.advise_sequential();
+  std::vector<std::string> material_libraries;
+  if (!read_obj_metadata(file.data(), file.size(), metadata, material_libraries)) {
+    return false;
+  }
+  std::filesystem::path directory = std::filesystem::u8path(path).parent_path();
+  for (const auto& library : material_libraries) {
+    MappedFile library_file;
+    if (library_file.open((directory / std::filesystem::u8path(library)).u8string())) {
+      read_mtl_textures(library_file.data(), library_file.size(), metadata.texture_paths);
+    }
+  }
+  return true;
+}
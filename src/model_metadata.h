@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class MappedFile;
+
+// What a model file says about its geometry, read without loading the model
+struct ModelMetadata {
+  uint64_t vertex_count = 0;
+  uint64_t triangle_count = 0;  // Polygons count as the triangles they'd be split into
+  uint32_t material_count = 0;
+  bool has_bounds = false;  // Missing for empty meshes and for FBX files whose vertex arrays are compressed
+  float bounds_min[3] = {};
+  float bounds_max[3] = {};
+  std::vector<std::string> texture_paths;  // As written in the file, so relative ones are relative to it
+};
+
+// Whether metadata can be read from files with this (lowercase) extension: .obj, .gltf, .glb and .fbx
+bool has_model_metadata(const std::string& extension);
+
+// Stream through an OBJ file: positions, faces, material names and the material libraries it loads
+bool read_obj_metadata(const unsigned char* data, size_t size, ModelMetadata& metadata,
+                       std::vector<std::string>& material_libraries);
+
+// Texture maps of an OBJ material library, added to `texture_paths` unless already there
+void read_mtl_textures(const unsigned char* data, size_t size, std::vector<std::string>& texture_paths);
+
+// Read the JSON of a glTF file, or of the first chunk of a GLB, without touching any buffer data. Meshes are
+// counted once each, however often the scene instances them; bounds come from the POSITION accessors.
+bool read_gltf_metadata(const unsigned char* data, size_t size, ModelMetadata& metadata);
+bool read_glb_metadata(const unsigned char* data, size_t size, ModelMetadata& metadata);
+
+// Walk the node tree of a binary FBX file. Counts come from the array headers of each mesh's Vertices and
+// PolygonVertexIndex; arrays stored uncompressed also give bounds and exact triangle counts, while compressed
+// index arrays are taken to hold triangles. ASCII FBX files aren't read.
+bool read_fbx_metadata(const unsigned char* data, size_t size, ModelMetadata& metadata);
+
+// Read the metadata of the model at `path`, mapped in `file`. OBJ files are read front to back, and their
+// material libraries are mapped from beside them for the texture paths.
+bool read_model_metadata(const std::string& path, MappedFile& file, ModelMetadata& metadata);
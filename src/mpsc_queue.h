@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <optional>
+#include <utility>
+
+// Unbounded multi-producer, single-consumer queue (Vyukov). push() is wait-free and may be called from any
+// thread; pop() and empty() belong to the one consumer thread. A push that is still in progress can hide the
+// entries queued after it for a moment, so the consumer must not treat a failed pop() as final; it simply
+// retries on its next pass.
+template <typename T>
+class MpscQueue {
+ public:
+  MpscQueue() : head(&stub), tail(&stub) {}
+
+  ~MpscQueue() {
+    Node* node = tail;
+    while (node) {
+      Node* next = node->next.load(std::memory_order_relaxed);
+      if (node != &stub) {
+        delete node;
+      }
+      node = next;
+    }
+  }
+
+  MpscQueue(const MpscQueue&) = delete;
+  MpscQueue& operator=(const MpscQueue&) = delete;
+
+  void push(T value) {
+    Node* node = new Node(std::move(value));
+    Node* previous = head.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+  }
+
+  bool pop(T& value) {
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (!next) {
+      return false;
+    }
+    value = std::move(*next->value);
+    next->value.reset();
+    if (tail != &stub) {
+      delete tail;
+    }
+    tail = next;
+    return true;
+  }
+
+  bool empty() const { return tail->next.load(std::memory_order_acquire) == nullptr; }
+
+ private:
+  struct Node {
+    std::atomic<Node*> next;
+    std::optional<T> value;  // Empty for the stub and for the node the consumer has already taken from
+
+    Node() : next(nullptr) {}
+    explicit Node(T v) : next(nullptr), value(std::move(v)) {}
+  };
+
+  Node stub;
+
+  // Producers and the consumer work on opposite ends; keep them on separate cache lines
+  alignas(64) std::atomic<Node*> head;
+  alignas(64) Node* tail;
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <string>
+
+// What counts as "below a directory" wherever paths are compared as strings: the watcher, the database, the
+// metadata store, the asset list and the thumbnail caches all use these, so they agree on what a subtree is.
+// '/' separates components on every platform, since archive entries are joined with it, and so does the
+// platform's own separator. On Windows that adds '\\'; elsewhere '\\' is an ordinary file name character.
+
+// Separators that can follow a directory in a path; both are '/' where that is the platform's own
+constexpr char PATH_SEPARATORS[] = {'/', static_cast<char>(std::filesystem::path::preferred_separator)};
+constexpr size_t PATH_SEPARATOR_COUNT = PATH_SEPARATORS[0] == PATH_SEPARATORS[1] ? 1 : 2;
+
+inline bool is_path_separator(char c) { return c == PATH_SEPARATORS[0] || c == PATH_SEPARATORS[1]; }
+
+// Whether `path` is strictly below `directory`
+inline bool is_path_under(const std::string& path, const std::string& directory) {
+  return path.size() > directory.size() && is_path_separator(path[directory.size()]) &&
+         path.compare(0, directory.size(), directory) == 0;
+}
+
+// `path` without its last component, or an empty string if it has only one
+inline std::string parent_path_of(const std::string& path) {
+  for (size_t pos = path.size(); pos > 0; pos--) {
+    if (is_path_separator(path[pos - 1])) {
+      return path.substr(0, pos - 1);
+    }
+  }
+  return std::string();
+}
+
+// Key ranges [lower, upper) that together hold every path strictly below a directory in byte order, one per
+// separator, so a sorted index finds a subtree with one range scan each. Both ranges are the same where the
+// platform's separator is '/'.
+struct SubtreeBounds {
+  std::string lower[2];
+  std::string upper[2];
+};
+
+inline SubtreeBounds get_subtree_bounds(const std::string& directory) {
+  SubtreeBounds bounds;
+  for (int i = 0; i < 2; i++) {
+    bounds.lower[i] = directory + PATH_SEPARATORS[i];
+    bounds.upper[i] = directory + static_cast<char>(PATH_SEPARATORS[i] + 1);
+  }
+  return bounds;
+}
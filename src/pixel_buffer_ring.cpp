@@ -0,0 +1,189 @@
+#include "pixel_buffer_ring.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <GL/gl.h>
+#include <GLFW/glfw3.h>
+
+#include <cstring>
+#include <iostream>
+
+// Buffer objects, persistent mapping and fences postdate the GL 1.1 that gl.h declares, so they are looked up
+// at run time
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#endif
+#ifndef GL_MAP_WRITE_BIT
+#define GL_MAP_WRITE_BIT 0x0002
+#endif
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#endif
+#ifndef GL_TIMEOUT_EXPIRED
+#define GL_TIMEOUT_EXPIRED 0x911B
+#endif
+#ifndef GL_WAIT_FAILED
+#define GL_WAIT_FAILED 0x911D
+#endif
+
+namespace {
+
+// Offsets into the ring are aligned like this, which keeps drivers on their fast transfer path
+constexpr size_t UPLOAD_ALIGNMENT = 256;
+
+// How long end_frame() waits for the GPU to release a segment before giving up on the ring
+constexpr uint64_t FENCE_TIMEOUT_NS = 1000000000;
+
+struct BufferFunctions {
+  void(APIENTRY* gen_buffers)(GLsizei count, GLuint* buffers) = nullptr;
+  void(APIENTRY* delete_buffers)(GLsizei count, const GLuint* buffers) = nullptr;
+  void(APIENTRY* bind_buffer)(GLenum target, GLuint buffer) = nullptr;
+  void(APIENTRY* buffer_storage)(GLenum target, std::ptrdiff_t size, const void* data, GLbitfield flags) = nullptr;
+  void*(APIENTRY* map_buffer_range)(GLenum target, std::ptrdiff_t offset, std::ptrdiff_t length,
+                                    GLbitfield access) = nullptr;
+  GLboolean(APIENTRY* unmap_buffer)(GLenum target) = nullptr;
+  void*(APIENTRY* fence_sync)(GLenum condition, GLbitfield flags) = nullptr;
+  GLenum(APIENTRY* client_wait_sync)(void* sync, GLbitfield flags, uint64_t timeout) = nullptr;
+  void(APIENTRY* delete_sync)(void* sync) = nullptr;
+};
+
+BufferFunctions g_gl;
+
+template <typename Function>
+bool load_function(Function& function, const char* name) {
+  function = reinterpret_cast<Function>(glfwGetProcAddress(name));
+  return function != nullptr;
+}
+
+bool load_buffer_functions() {
+  return load_function(g_gl.gen_buffers, "glGenBuffers") && load_function(g_gl.delete_buffers, "glDeleteBuffers") &&
+         load_function(g_gl.bind_buffer, "glBindBuffer") && load_function(g_gl.buffer_storage, "glBufferStorage") &&
+         load_function(g_gl.map_buffer_range, "glMapBufferRange") &&
+         load_function(g_gl.unmap_buffer, "glUnmapBuffer") && load_function(g_gl.fence_sync, "glFenceSync") &&
+         load_function(g_gl.client_wait_sync, "glClientWaitSync") && load_function(g_gl.delete_sync, "glDeleteSync");
+}
+
+bool has_buffer_storage() {
+  GLFWwindow* window = glfwGetCurrentContext();
+  if (!window) {
+    return false;
+  }
+  int major = glfwGetWindowAttrib(window, GLFW_CONTEXT_VERSION_MAJOR);
+  int minor = glfwGetWindowAttrib(window, GLFW_CONTEXT_VERSION_MINOR);
+  return major > 4 || (major == 4 && minor >= 4) || glfwExtensionSupported("GL_ARB_buffer_storage");
+}
+
+}  // namespace
+
+PixelBufferRing::PixelBufferRing(size_t segment_bytes, int segments)
+    : segment_size(segment_bytes),
+      segment_count(segments),
+      buffer(0),
+      mapped(nullptr),
+      segment(0),
+      offset(0),
+      streamed_bytes(0) {}
+
+PixelBufferRing::~PixelBufferRing() { shutdown(); }
+
+bool PixelBufferRing::initialize() {
+  if (mapped) {
+    return true;
+  }
+  if (segment_size == 0 || segment_count <= 0 || !has_buffer_storage() || !load_buffer_functions()) {
+    std::cerr << "Persistently mapped pixel buffers aren't supported; uploading textures directly\n";
+    return false;
+  }
+
+  std::ptrdiff_t size = static_cast<std::ptrdiff_t>(segment_size * segment_count);
+  GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+  g_gl.gen_buffers(1, &buffer);
+  g_gl.bind_buffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+  g_gl.buffer_storage(GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+  mapped = static_cast<unsigned char*>(g_gl.map_buffer_range(GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+  g_gl.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  if (!mapped) {
+    std::cerr << "Failed to map the pixel buffer; uploading textures directly\n";
+    g_gl.delete_buffers(1, &buffer);
+    buffer = 0;
+    return false;
+  }
+
+  fences.assign(static_cast<size_t>(segment_count), nullptr);
+  segment = 0;
+  offset = 0;
+  return true;
+}
+
+void PixelBufferRing::shutdown() {
+  if (!mapped) {
+    return;
+  }
+  for (void*& fence : fences) {
+    if (fence) {
+      g_gl.delete_sync(fence);
+      fence = nullptr;
+    }
+  }
+  g_gl.bind_buffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+  g_gl.unmap_buffer(GL_PIXEL_UNPACK_BUFFER);
+  g_gl.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+  g_gl.delete_buffers(1, &buffer);
+  buffer = 0;
+  mapped = nullptr;
+}
+
+bool PixelBufferRing::is_active() const { return mapped != nullptr; }
+
+bool PixelBufferRing::upload(unsigned int texture_id, int x, int y, int width, int height,
+                             const unsigned char* pixels) {
+  size_t bytes = static_cast<size_t>(width) * height * 4;
+  size_t start = (offset + UPLOAD_ALIGNMENT - 1) / UPLOAD_ALIGNMENT * UPLOAD_ALIGNMENT;
+  if (!mapped || start + bytes > segment_size) {
+    return false;
+  }
+
+  size_t ring_offset = static_cast<size_t>(segment) * segment_size + start;
+  std::memcpy(mapped + ring_offset, pixels, bytes);
+  glBindTexture(GL_TEXTURE_2D, texture_id);
+  g_gl.bind_buffer(GL_PIXEL_UNPACK_BUFFER, buffer);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE,
+                  reinterpret_cast<const void*>(ring_offset));
+  g_gl.bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+  offset = start + bytes;
+  streamed_bytes += bytes;
+  return true;
+}
+
+void PixelBufferRing::end_frame() {
+  if (!mapped || offset == 0) {
+    return;  // Nothing written; the segment can be used again next frame
+  }
+  fences[static_cast<size_t>(segment)] = g_gl.fence_sync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  segment = (segment + 1) % segment_count;
+  offset = 0;
+
+  void*& fence = fences[static_cast<size_t>(segment)];
+  if (fence) {
+    GLenum status = g_gl.client_wait_sync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT_NS);
+    g_gl.delete_sync(fence);
+    fence = nullptr;
+    if (status == GL_TIMEOUT_EXPIRED || status == GL_WAIT_FAILED) {
+      std::cerr << "Pixel buffer fence didn't signal; uploading textures directly\n";
+      shutdown();
+    }
+  }
+}
+
+uint64_t PixelBufferRing::get_streamed_bytes() const { return streamed_bytes; }
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Streams texture updates through a persistently mapped pixel unpack buffer. Pixels are copied into the ring
+// and glTexSubImage2D reads them from there, so the driver can transfer them asynchronously instead of copying
+// them out of client memory before the call returns. The ring is split into one segment per frame in flight;
+// each segment is fenced at the end of its frame and only written again once the GPU is done reading it.
+//
+// Needs GL 4.4 or ARB_buffer_storage for the persistent mapping; initialize() fails without it, and callers
+// upload directly. Must be used from the thread owning the GL context.
+class PixelBufferRing {
+ public:
+  // Bytes a frame may stream; uploads past that fall back to direct ones
+  static constexpr size_t DEFAULT_SEGMENT_BYTES = 8 * 1024 * 1024;
+  static constexpr int DEFAULT_SEGMENTS = 3;
+
+  explicit PixelBufferRing(size_t segment_size = DEFAULT_SEGMENT_BYTES, int segment_count = DEFAULT_SEGMENTS);
+  ~PixelBufferRing();
+
+  PixelBufferRing(const PixelBufferRing&) = delete;
+  PixelBufferRing& operator=(const PixelBufferRing&) = delete;
+
+  // Create and map the buffer. Needs a current GL context; returns false if it lacks persistent mapping.
+  bool initialize();
+  void shutdown();
+  bool is_active() const;
+
+  // Update a region of an RGBA8 texture through the ring. Returns false, doing nothing, if the ring isn't
+  // active or this frame's segment is full; the caller then uploads directly.
+  bool upload(unsigned int texture_id, int x, int y, int width, int height, const unsigned char* pixels);
+
+  // Fence what this frame wrote and move to the next segment, waiting for the GPU if it still reads from it
+  void end_frame();
+
+  uint64_t get_streamed_bytes() const;
+
+ private:
+  size_t segment_size;
+  int segment_count;
+  unsigned int buffer;
+  unsigned char* mapped;
+  std::vector<void*> fences;  // By segment; null when the segment isn't in flight
+  int segment;
+  size_t offset;  // Into the current segment
+  uint64_t streamed_bytes;
+};
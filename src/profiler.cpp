@@ -0,0 +1,212 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+// Single-producer, single-consumer ring of samples: the owning thread advances write_index and the main thread
+// advances read_index. Indices only grow; a slot is the index modulo the capacity.
+struct Profiler::ThreadRing {
+  std::vector<ProfileSample> samples;
+  std::atomic<size_t> write_index{0};
+  std::atomic<size_t> read_index{0};
+  std::atomic<uint64_t> dropped{0};
+
+  ThreadRing() : samples(RING_CAPACITY) {}
+};
+
+namespace {
+
+std::atomic<uint64_t> g_next_profiler_id(1);
+
+// Rings this thread records into, by profiler id. Almost always a single entry.
+thread_local std::vector<std::pair<uint64_t, void*>> t_rings;
+
+// Nearest-rank percentile of sorted values
+double get_percentile(const std::vector<float>& sorted, double fraction) {
+  if (sorted.empty()) {
+    return 0.0;
+  }
+  size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+  return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+}  // namespace
+
+Profiler::Profiler()
+    : id(g_next_profiler_id++),
+      epoch(std::chrono::steady_clock::now()),
+      last_frame_ns(0),
+      history_size(0),
+      history_next(0) {
+  get_zone(FRAME_ZONE);
+}
+
+Profiler::~Profiler() = default;
+
+int64_t Profiler::now_ns() const {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+Profiler::ThreadRing* Profiler::get_thread_ring() {
+  for (const auto& entry : t_rings) {
+    if (entry.first == id) {
+      return static_cast<ThreadRing*>(entry.second);
+    }
+  }
+
+  auto ring = std::make_unique<ThreadRing>();
+  ThreadRing* pointer = ring.get();
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    rings.push_back(std::move(ring));
+  }
+  t_rings.emplace_back(id, pointer);
+  return pointer;
+}
+
+void Profiler::record(const char* zone, int64_t start_ns, int64_t end_ns) {
+  ThreadRing* ring = get_thread_ring();
+  size_t write = ring->write_index.load(std::memory_order_relaxed);
+  if (write - ring->read_index.load(std::memory_order_acquire) >= RING_CAPACITY) {
+    ring->dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  ProfileSample& sample = ring->samples[write % RING_CAPACITY];
+  sample.zone = zone;
+  sample.start_ns = start_ns;
+  sample.duration_ns = end_ns - start_ns;
+  ring->write_index.store(write + 1, std::memory_order_release);
+}
+
+size_t Profiler::get_zone(const char* zone) {
+  auto by_pointer = zones_by_pointer.find(zone);
+  if (by_pointer != zones_by_pointer.end()) {
+    return by_pointer->second;
+  }
+
+  auto by_name = zones_by_name.find(zone);
+  size_t index = 0;
+  if (by_name != zones_by_name.end()) {
+    index = by_name->second;
+  } else {
+    index = zone_names.size();
+    zone_names.emplace_back(zone);
+    zones_by_name.emplace(zone, index);
+    history.emplace_back(HISTORY_FRAMES, 0.0f);
+    frame_totals.push_back(0.0f);
+  }
+  zones_by_pointer.emplace(zone, index);
+  return index;
+}
+
+void Profiler::begin_frame() { last_frame_ns = now_ns(); }
+
+void Profiler::end_frame() {
+  int64_t now = now_ns();
+  frame_totals[0] = static_cast<float>(now - last_frame_ns) / 1e6f;
+  last_frame_ns = now;
+
+  std::vector<ThreadRing*> current_rings;
+  {
+    std::lock_guard<std::mutex> lock(rings_mutex);
+    for (const auto& ring : rings) {
+      current_rings.push_back(ring.get());
+    }
+  }
+
+  uint64_t dropped = 0;
+  for (ThreadRing* ring : current_rings) {
+    size_t read = ring->read_index.load(std::memory_order_relaxed);
+    size_t write = ring->write_index.load(std::memory_order_acquire);
+    for (; read != write; read++) {
+      const ProfileSample& sample = ring->samples[read % RING_CAPACITY];
+      frame_totals[get_zone(sample.zone)] += static_cast<float>(sample.duration_ns) / 1e6f;
+      stats.samples++;
+    }
+    ring->read_index.store(read, std::memory_order_release);
+    dropped += ring->dropped.load(std::memory_order_relaxed);
+  }
+  stats.dropped = dropped;
+  stats.threads = current_rings.size();
+
+  for (size_t zone = 0; zone < history.size(); zone++) {
+    history[zone][history_next] = frame_totals[zone];
+    frame_totals[zone] = 0.0f;
+  }
+  history_next = (history_next + 1) % HISTORY_FRAMES;
+  history_size = std::min(history_size + 1, HISTORY_FRAMES);
+  stats.frames++;
+}
+
+size_t Profiler::get_zone_count() const { return zone_names.size(); }
+
+const std::string& Profiler::get_zone_name(size_t zone) const { return zone_names[zone]; }
+
+std::vector<float> Profiler::get_history(size_t zone) const {
+  std::vector<float> values;
+  values.reserve(history_size);
+  size_t first = (history_next + HISTORY_FRAMES - history_size) % HISTORY_FRAMES;
+  for (size_t i = 0; i < history_size; i++) {
+    values.push_back(history[zone][(first + i) % HISTORY_FRAMES]);
+  }
+  return values;
+}
+
+ZoneStats Profiler::get_zone_stats(size_t zone) const {
+  ZoneStats zone_stats;
+  zone_stats.name = zone_names[zone];
+  std::vector<float> values = get_history(zone);
+  if (values.empty()) {
+    return zone_stats;
+  }
+  zone_stats.last_ms = values.back();
+  std::sort(values.begin(), values.end());
+  zone_stats.p50_ms = get_percentile(values, 0.50);
+  zone_stats.p95_ms = get_percentile(values, 0.95);
+  zone_stats.p99_ms = get_percentile(values, 0.99);
+  zone_stats.max_ms = values.back();
+  return zone_stats;
+}
+
+ProfilerStats Profiler::get_stats() const { return stats; }
+
+bool Profiler::dump(const std::string& path) const {
+  std::ofstream file(path);
+  if (!file) {
+    std::cerr << "Failed to write profile: " << path << '\n';
+    return false;
+  }
+
+  file << "frame";
+  for (const auto& name : zone_names) {
+    file << ',' << name;
+  }
+  file << '\n';
+
+  std::vector<std::vector<float>> columns;
+  for (size_t zone = 0; zone < zone_names.size(); zone++) {
+    columns.push_back(get_history(zone));
+  }
+  uint64_t first_frame = stats.frames - history_size;
+  for (size_t row = 0; row < history_size; row++) {
+    file << first_frame + row;
+    for (const auto& column : columns) {
+      file << ',' << column[row];
+    }
+    file << '\n';
+  }
+  return static_cast<bool>(file);
+}
+
+ProfileScope::ProfileScope(Profiler* owner, const char* name)
+    : profiler(owner), zone(name), start_ns(owner ? owner->now_ns() : 0) {}
+
+ProfileScope::~ProfileScope() {
+  if (profiler) {
+    profiler->record(zone, start_ns, profiler->now_ns());
+  }
+}
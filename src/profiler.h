@@ -0,0 +1,121 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// One timed scope, as recorded by the thread that ran it
+struct ProfileSample {
+  const char* zone = nullptr;  // Names the scope; must be a string literal or otherwise outlive the profiler
+  int64_t start_ns = 0;        // Since the profiler was created
+  int64_t duration_ns = 0;
+};
+
+// Distribution of a zone's time per frame over the history. Frames in which the zone didn't run count as 0.
+struct ZoneStats {
+  std::string name;
+  double last_ms = 0.0;  // The most recent frame
+  double p50_ms = 0.0;
+  double p95_ms = 0.0;
+  double p99_ms = 0.0;
+  double max_ms = 0.0;
+};
+
+struct ProfilerStats {
+  uint64_t frames = 0;   // Frames closed with end_frame()
+  uint64_t samples = 0;  // Samples drained from the threads' rings
+  uint64_t dropped = 0;  // Samples lost because a ring was full
+  size_t threads = 0;    // Threads that have recorded a sample
+};
+
+// Scoped timing for the main loop and the threads working for it. Each thread records into a ring buffer of its
+// own, which only that thread writes and only the main thread reads, so recording takes no lock: two clock reads
+// and a store. Once per frame the main thread drains every ring and adds each zone's time to that frame's row of
+// a fixed-size history, which the overlay graphs and the dump writes out. Work finishing on other threads, like
+// decodes, is counted in the frame that drains it.
+//
+// record() may be called from any thread; everything else belongs to the main thread.
+class Profiler {
+ public:
+  // Samples a thread can record between two end_frame() calls before new ones are dropped
+  static constexpr size_t RING_CAPACITY = 4096;
+
+  // Frames kept for graphs, percentiles and dumps
+  static constexpr size_t HISTORY_FRAMES = 600;
+
+  // Zone end_frame() records the frame's time under: since begin_frame(), or since the previous end_frame()
+  static constexpr const char* FRAME_ZONE = "Frame";
+
+  Profiler();
+  ~Profiler();
+
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  // Nanoseconds since the profiler was created
+  int64_t now_ns() const;
+
+  // Record a scope that ran on the calling thread
+  void record(const char* zone, int64_t start_ns, int64_t end_ns);
+
+  // Start timing the current frame here rather than where the last one ended, e.g. after waiting for input
+  void begin_frame();
+
+  // Close the current frame: time it, and move every thread's samples into the history
+  void end_frame();
+
+  // Zones in the order they were first seen; the frame zone is always 0
+  size_t get_zone_count() const;
+  const std::string& get_zone_name(size_t zone) const;
+
+  // Milliseconds per frame spent in a zone, oldest frame first
+  std::vector<float> get_history(size_t zone) const;
+
+  ZoneStats get_zone_stats(size_t zone) const;
+  ProfilerStats get_stats() const;
+
+  // Write the history as CSV: a header naming the zones, then a row per frame with each zone's milliseconds
+  bool dump(const std::string& path) const;
+
+ private:
+  struct ThreadRing;
+
+  const uint64_t id;  // Tells the rings of this profiler apart in a thread's cache
+  const std::chrono::steady_clock::time_point epoch;
+  int64_t last_frame_ns;
+
+  std::mutex rings_mutex;  // Only taken when a thread records its first sample, and to list the rings
+  std::vector<std::unique_ptr<ThreadRing>> rings;
+
+  std::vector<std::string> zone_names;
+  std::unordered_map<const char*, size_t> zones_by_pointer;
+  std::unordered_map<std::string, size_t> zones_by_name;  // The same name may have several addresses
+  std::vector<std::vector<float>> history;                // By zone, then by frame modulo HISTORY_FRAMES
+  std::vector<float> frame_totals;                        // By zone, for the frame being closed
+  size_t history_size;                                    // Frames in the history, up to HISTORY_FRAMES
+  size_t history_next;                                    // Slot the next frame goes into
+  ProfilerStats stats;
+
+  ThreadRing* get_thread_ring();
+  size_t get_zone(const char* zone);
+};
+
+// Times the enclosing scope, e.g. `ProfileScope scope(profiler, "Filter");`. A null profiler records nothing.
+class ProfileScope {
+ public:
+  ProfileScope(Profiler* owner, const char* name);
+  ~ProfileScope();
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+ private:
+  Profiler* profiler;
+  const char* zone;
+  int64_t start_ns;
+};
@@ -0,0 +1,299 @@
+#include "search_filter.h"
+
+#include <algorithm>
+#include <queue>
+#include <thread>
+
+#include "fuzzy_match.h"
+
+// Below this many candidates a check is quicker than starting threads
+constexpr size_t PARALLEL_THRESHOLD = 32768;
+
+namespace {
+
+// Run `function(chunk, begin, end)` over `count` items split into `chunk_count` contiguous chunks, one thread each
+template <typename Function>
+void for_each_chunk(size_t count, size_t chunk_count, Function function) {
+  if (chunk_count <= 1) {
+    function(0, 0, count);
+    return;
+  }
+  std::vector<std::thread> threads;
+  threads.reserve(chunk_count - 1);
+  size_t chunk_size = (count + chunk_count - 1) / chunk_count;
+  for (size_t chunk = 1; chunk < chunk_count; chunk++) {
+    size_t begin = std::min(count, chunk * chunk_size);
+    size_t end = std::min(count, begin + chunk_size);
+    threads.emplace_back(function, chunk, begin, end);
+  }
+  function(0, 0, std::min(count, chunk_size));
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+// Every result for `terms` is also a result for `narrower` if each term is part of some term of `narrower`
+bool narrows(const std::vector<std::string>& narrower, const std::vector<std::string>& terms) {
+  for (const std::string& term : terms) {
+    bool contained = std::any_of(narrower.begin(), narrower.end(), [&](const std::string& candidate) {
+      return candidate.find(term) != std::string::npos;
+    });
+    if (!contained) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Every fuzzy match for `terms` is also one for `narrower` if each term is a subsequence of some term of
+// `narrower`
+bool fuzzy_narrows(const std::vector<std::string>& narrower, const std::vector<std::string>& terms) {
+  for (const std::string& term : terms) {
+    bool contained = std::any_of(narrower.begin(), narrower.end(), [&](const std::string& candidate) {
+      size_t matched = 0;
+      for (size_t i = 0; i < candidate.size() && matched < term.size(); i++) {
+        if (candidate[i] == term[matched]) {
+          matched++;
+        }
+      }
+      return matched == term.size();
+    });
+    if (!contained) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// A fuzzy result; better ones have a higher score, then a shorter key, then come first in the list
+struct RankedAsset {
+  int score;
+  size_t key_length;
+  size_t position;
+};
+
+struct RanksBetter {
+  bool operator()(const RankedAsset& a, const RankedAsset& b) const {
+    if (a.score != b.score) {
+      return a.score > b.score;
+    }
+    if (a.key_length != b.key_length) {
+      return a.key_length < b.key_length;
+    }
+    return a.position < b.position;
+  }
+};
+
+bool is_space(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r'; }
+
+}  // namespace
+
+std::vector<std::string> split_search_terms(const std::string& query) {
+  std::vector<std::string> terms;
+  size_t i = 0;
+  while (i < query.size()) {
+    while (i < query.size() && is_space(query[i])) {
+      i++;
+    }
+    size_t start = i;
+    while (i < query.size() && !is_space(query[i])) {
+      i++;
+    }
+    if (i > start) {
+      terms.emplace_back();
+      append_lowercase(terms.back(), std::string_view(query).substr(start, i - start));
+    }
+  }
+  return terms;
+}
+
+SearchFilter::SearchFilter(size_t thread_count)
+    : thread_count(thread_count), mode(SearchMode::Substring), result_limit(0), dirty(true), narrowed(false) {
+  if (this->thread_count == 0) {
+    this->thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+}
+
+void SearchFilter::set_assets(const std::vector<FileInfo>& assets) {
+  index.update(assets);
+  dirty = true;
+}
+
+void SearchFilter::splice_assets(const std::vector<FileInfo>& assets, const std::vector<size_t>& removed,
+                                 const std::vector<size_t>& inserted) {
+  if (removed.empty() && inserted.empty()) {
+    return;
+  }
+  index.splice(assets, removed, inserted);
+  dirty = true;
+}
+
+void SearchFilter::set_mode(SearchMode new_mode) {
+  if (new_mode != mode) {
+    mode = new_mode;
+    dirty = true;
+  }
+}
+
+SearchMode SearchFilter::get_mode() const { return mode; }
+
+void SearchFilter::set_result_limit(size_t limit) {
+  if (limit != result_limit) {
+    result_limit = limit;
+    dirty = true;
+  }
+}
+
+bool SearchFilter::update(const std::string& new_query) {
+  if (!dirty && new_query == query) {
+    return false;
+  }
+
+  std::vector<std::string> new_terms = split_search_terms(new_query);
+  query = new_query;
+  if (!dirty && new_terms == terms) {
+    return false;  // Only whitespace changed
+  }
+
+  if (mode == SearchMode::Fuzzy) {
+    narrowed = !dirty && fuzzy_narrows(new_terms, terms);
+    rank(narrowed ? &fuzzy_matches : nullptr, new_terms);
+    terms = std::move(new_terms);
+    dirty = false;
+    return true;
+  }
+
+  // Check whichever of the trigram candidates and the previous result is smaller
+  fuzzy_matches.clear();
+  std::vector<size_t> candidates;
+  bool indexed = index.get_candidates(new_terms, candidates);
+  size_t candidate_count = indexed ? candidates.size() : index.size();
+  narrowed = !dirty && results.size() <= candidate_count && narrows(new_terms, terms);
+  if (narrowed) {
+    results = match(&results, new_terms);
+  } else {
+    results = match(indexed ? &candidates : nullptr, new_terms);
+  }
+  terms = std::move(new_terms);
+  dirty = false;
+  return true;
+}
+
+const std::vector<size_t>& SearchFilter::get_results() const { return results; }
+
+size_t SearchFilter::get_match_count() const {
+  return mode == SearchMode::Fuzzy ? fuzzy_matches.size() : results.size();
+}
+
+bool SearchFilter::was_narrowed() const { return narrowed; }
+
+SearchIndexStats SearchFilter::get_index_stats() const { return index.get_stats(); }
+
+std::vector<size_t> SearchFilter::match(const std::vector<size_t>* candidates,
+                                        const std::vector<std::string>& new_terms) const {
+  size_t candidate_count = candidates ? candidates->size() : index.size();
+  if (new_terms.empty() && !candidates) {
+    std::vector<size_t> everything(candidate_count);
+    for (size_t i = 0; i < candidate_count; i++) {
+      everything[i] = i;
+    }
+    return everything;
+  }
+
+  size_t chunk_count = candidate_count >= PARALLEL_THRESHOLD ? thread_count : 1;
+  std::vector<std::vector<size_t>> chunk_results(chunk_count);
+  for_each_chunk(candidate_count, chunk_count, [&](size_t chunk, size_t begin, size_t end) {
+    std::vector<size_t>& matches = chunk_results[chunk];
+    for (size_t i = begin; i < end; i++) {
+      size_t position = candidates ? (*candidates)[i] : i;
+      if (index.matches(position, new_terms)) {
+        matches.push_back(position);
+      }
+    }
+  });
+
+  if (chunk_count == 1) {
+    return std::move(chunk_results[0]);
+  }
+  size_t total = 0;
+  for (const std::vector<size_t>& matches : chunk_results) {
+    total += matches.size();
+  }
+  std::vector<size_t> merged;
+  merged.reserve(total);
+  for (const std::vector<size_t>& matches : chunk_results) {
+    merged.insert(merged.end(), matches.begin(), matches.end());
+  }
+  return merged;
+}
+
+void SearchFilter::rank(const std::vector<size_t>* candidates, const std::vector<std::string>& new_terms) {
+  size_t candidate_count = candidates ? candidates->size() : index.size();
+  if (new_terms.empty()) {
+    // Nothing to rank by: everything, in list order
+    fuzzy_matches = match(candidates, new_terms);
+    results = fuzzy_matches;
+    return;
+  }
+
+  uint64_t query_mask = 0;
+  for (const std::string& term : new_terms) {
+    query_mask |= get_character_mask(term);
+  }
+
+  struct Shard {
+    std::vector<size_t> matches;
+    std::priority_queue<RankedAsset, std::vector<RankedAsset>, RanksBetter> best;  // Worst of the best on top
+  };
+  size_t chunk_count = candidate_count >= PARALLEL_THRESHOLD ? thread_count : 1;
+  std::vector<Shard> shards(chunk_count);
+  for_each_chunk(candidate_count, chunk_count, [&](size_t chunk, size_t begin, size_t end) {
+    Shard& shard = shards[chunk];
+    for (size_t i = begin; i < end; i++) {
+      size_t position = candidates ? (*candidates)[i] : i;
+      if ((index.get_key_mask(position) & query_mask) != query_mask) {
+        continue;  // Some character of the query isn't in the key at all
+      }
+      std::string_view key = index.get_key(position);
+      KeyLayout layout = index.get_key_layout(position);
+      int total = 0;
+      bool all_match = true;
+      for (const std::string& term : new_terms) {
+        int score = 0;
+        if (!fuzzy_match(key, layout, term, score)) {
+          all_match = false;
+          break;
+        }
+        total += score;
+      }
+      if (!all_match) {
+        continue;
+      }
+      shard.matches.push_back(position);
+      RankedAsset ranked{total, key.size(), position};
+      if (result_limit == 0 || shard.best.size() < result_limit) {
+        shard.best.push(ranked);
+      } else if (RanksBetter()(ranked, shard.best.top())) {
+        shard.best.pop();
+        shard.best.push(ranked);
+      }
+    }
+  });
+
+  // Merge the shards: matches stay in list order, and the best of every shard compete for the result limit
+  fuzzy_matches.clear();
+  std::vector<RankedAsset> ranked;
+  for (Shard& shard : shards) {
+    fuzzy_matches.insert(fuzzy_matches.end(), shard.matches.begin(), shard.matches.end());
+    while (!shard.best.empty()) {
+      ranked.push_back(shard.best.top());
+      shard.best.pop();
+    }
+  }
+  size_t kept = result_limit == 0 ? ranked.size() : std::min(result_limit, ranked.size());
+  std::partial_sort(ranked.begin(), ranked.begin() + kept, ranked.end(), RanksBetter());
+  results.resize(kept);
+  for (size_t i = 0; i < kept; i++) {
+    results[i] = ranked[i].position;
+  }
+}
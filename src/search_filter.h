@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "asset_index.h"
+#include "search_index.h"
+
+// Split a search query into lowercase, whitespace-separated terms
+std::vector<std::string> split_search_terms(const std::string& query);
+
+enum class SearchMode {
+  Substring,  // Every term is a substring of the name, extension or path; results in list order
+  Fuzzy       // Every term is a subsequence; results ranked by fuzzy_match() score, best first
+};
+
+// The assets matching the search box, as indices into the asset list. Matching is case-insensitive.
+//
+// Filtering only runs when the query, the mode or the assets change. In substring mode, candidates come from
+// the trigram index, or, when the query only adds to the previous one (more characters or more terms) and that
+// left fewer, from the previous result. Queries too short for trigrams scan every asset, split across threads
+// when there are many.
+//
+// Fuzzy mode scores every asset whose characters cover the query, or only the previous matches when the query
+// extends the previous one. Large scans are split into shards that each keep their best results in a heap, and
+// the shards are merged, so only the result limit is ever sorted.
+//
+// Not thread safe: it belongs to the UI thread.
+class SearchFilter {
+ public:
+  // 0 picks a thread count from the number of cores
+  explicit SearchFilter(size_t thread_count = 0);
+
+  // Index a new asset list, reusing what was indexed for assets that didn't change. The next update() filters
+  // it from scratch.
+  void set_assets(const std::vector<FileInfo>& assets);
+
+  // Follow an edit of the asset list, see SearchIndex::splice(). The next update() filters from scratch only if
+  // assets were inserted or removed; in-place updates keep their keys, and so the results.
+  void splice_assets(const std::vector<FileInfo>& assets, const std::vector<size_t>& removed,
+                     const std::vector<size_t>& inserted);
+
+  void set_mode(SearchMode mode);
+  SearchMode get_mode() const;
+
+  // Keep only the best `limit` fuzzy results; 0 keeps them all. Substring results are never cut off.
+  void set_result_limit(size_t limit);
+
+  // Filter for `query` if it differs from the last one or the assets changed. Returns whether the result changed.
+  bool update(const std::string& query);
+
+  // Indices into the list passed to set_assets(): in list order for substring searches and empty queries, best
+  // first for fuzzy ones
+  const std::vector<size_t>& get_results() const;
+
+  // Number of matches, including fuzzy ones past the result limit
+  size_t get_match_count() const;
+
+  // Whether the last update() narrowed the previous result rather than starting over
+  bool was_narrowed() const;
+
+  SearchIndexStats get_index_stats() const;
+
+ private:
+  size_t thread_count;
+  SearchIndex index;
+  SearchMode mode;
+  size_t result_limit;
+  std::vector<std::string> terms;  // Terms of the current result
+  std::vector<size_t> results;
+  std::vector<size_t> fuzzy_matches;  // Every fuzzy match in list order, for narrowing
+  std::string query;
+  bool dirty;
+  bool narrowed;
+
+  // Keep the candidates whose keys contain every term of `new_terms`; all assets if `candidates` is null
+  std::vector<size_t> match(const std::vector<size_t>* candidates, const std::vector<std::string>& new_terms) const;
+
+  // Score the candidates against `new_terms`, filling fuzzy_matches and the ranked results
+  void rank(const std::vector<size_t>* candidates, const std::vector<std::string>& new_terms);
+};
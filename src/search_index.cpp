@@ -0,0 +1,420 @@
+#include "search_index.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SEARCH_INDEX_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define SEARCH_INDEX_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Trigrams are indexed with each byte folded to 6 bits, which keeps the posting lists in a flat table of 2^18
+// instead of a hash map. Letters, digits and common punctuation keep a slot of their own; other bytes share
+// slots, which only adds candidates that matches() then rejects.
+constexpr int FOLDED_BITS = 6;
+constexpr size_t TRIGRAM_COUNT = size_t(1) << (3 * FOLDED_BITS);
+
+// Compact once removed assets outnumber the live ones, and there are enough of them to be worth a rebuild
+constexpr size_t MIN_DEAD_DOCUMENTS_TO_COMPACT = 1024;
+
+namespace {
+
+const std::array<uint8_t, 256>& get_fold_table() {
+  static const std::array<uint8_t, 256> table = [] {
+    std::array<uint8_t, 256> folded{};
+    const char* own_slots = "abcdefghijklmnopqrstuvwxyz0123456789./_- ";
+    uint8_t next = 1;
+    for (const char* c = own_slots; *c; c++) {
+      folded[static_cast<unsigned char>(*c)] = next++;
+    }
+    uint8_t shared = next;
+    for (int c = 0; c < 256; c++) {
+      if (folded[c] == 0) {
+        folded[c] = static_cast<uint8_t>(shared + c % ((1 << FOLDED_BITS) - shared));
+      }
+    }
+    return folded;
+  }();
+  return table;
+}
+
+uint32_t get_trigram(const char* text, const std::array<uint8_t, 256>& fold) {
+  return (uint32_t(fold[static_cast<unsigned char>(text[0])]) << (2 * FOLDED_BITS)) |
+         (uint32_t(fold[static_cast<unsigned char>(text[1])]) << FOLDED_BITS) |
+         fold[static_cast<unsigned char>(text[2])];
+}
+
+// Lowercase path, then the name and extension if the path doesn't already contain them. Terms never contain
+// whitespace, so the separators keep a term from matching across fields.
+void build_key(const FileInfo& asset, std::string& key) {
+  key.clear();
+  append_lowercase(key, asset.full_path);
+  size_t path_length = key.size();
+  for (const std::string* field : {&asset.name, &asset.extension}) {
+    size_t start = key.size();
+    key.push_back('\n');
+    append_lowercase(key, *field);
+    std::string_view lowered(key.data() + start + 1, key.size() - start - 1);
+    if (std::string_view(key.data(), path_length).find(lowered) != std::string_view::npos) {
+      key.resize(start);
+    }
+  }
+}
+
+#if defined(SEARCH_INDEX_SSE2) || defined(SEARCH_INDEX_NEON)
+int count_trailing_zeros(uint64_t mask) {
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward64(&index, mask);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctzll(mask);
+#endif
+}
+#endif
+
+// Intersect ascending `ids` with ascending `list` in place. Looks each id up with a binary search when the
+// list is much longer, and walks both otherwise.
+void intersect(std::vector<uint32_t>& ids, const std::vector<uint32_t>& list) {
+  size_t kept = 0;
+  if (list.size() > 8 * ids.size()) {
+    auto from = list.begin();
+    for (uint32_t id : ids) {
+      from = std::lower_bound(from, list.end(), id);
+      if (from == list.end()) {
+        break;
+      }
+      if (*from == id) {
+        ids[kept++] = id;
+      }
+    }
+  } else {
+    auto other = list.begin();
+    for (uint32_t id : ids) {
+      while (other != list.end() && *other < id) {
+        ++other;
+      }
+      if (other == list.end()) {
+        break;
+      }
+      if (*other == id) {
+        ids[kept++] = id;
+      }
+    }
+  }
+  ids.resize(kept);
+}
+
+}  // namespace
+
+void append_lowercase(std::string& out, std::string_view text) {
+  size_t start = out.size();
+  out.resize(start + text.size());
+  for (size_t i = 0; i < text.size(); i++) {
+    char c = text[i];
+    out[start + i] = c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+  }
+}
+
+uint64_t get_character_mask(std::string_view text) {
+  const std::array<uint8_t, 256>& fold = get_fold_table();
+  uint64_t mask = 0;
+  for (char c : text) {
+    mask |= uint64_t(1) << fold[static_cast<unsigned char>(c)];
+  }
+  return mask;
+}
+
+KeyLayout get_key_layout(std::string_view key) {
+  std::string_view path = key.substr(0, std::min(key.find('\n'), key.size()));
+  size_t slash = path.find_last_of("/\\");
+  size_t file_name_start = slash == std::string_view::npos ? 0 : slash + 1;
+  size_t dot = path.rfind('.');
+
+  KeyLayout layout;
+  layout.path_length = static_cast<uint32_t>(path.size());
+  layout.file_name_start = static_cast<uint32_t>(file_name_start);
+  layout.extension_start =
+      static_cast<uint32_t>(dot == std::string_view::npos || dot < file_name_start ? path.size() : dot);
+  return layout;
+}
+
+size_t find_substring(std::string_view haystack, std::string_view needle) {
+  size_t length = needle.size();
+  if (length == 0) {
+    return 0;
+  }
+  if (length > haystack.size()) {
+    return std::string_view::npos;
+  }
+  if (length == 1) {
+    const void* hit = std::memchr(haystack.data(), needle[0], haystack.size());
+    return hit ? static_cast<const char*>(hit) - haystack.data() : std::string_view::npos;
+  }
+
+  // Compare the first and last character of the needle at 16 positions at once, and only compare the middle
+  // where both match
+  const char* text = haystack.data();
+  size_t last_start = haystack.size() - length;
+  size_t i = 0;
+#if defined(SEARCH_INDEX_SSE2)
+  const __m128i first = _mm_set1_epi8(needle[0]);
+  const __m128i last = _mm_set1_epi8(needle[length - 1]);
+  for (; i + 15 <= last_start; i += 16) {
+    __m128i block_first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i));
+    __m128i block_last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + i + length - 1));
+    uint64_t mask = static_cast<uint32_t>(
+        _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, block_first), _mm_cmpeq_epi8(last, block_last))));
+    while (mask != 0) {
+      size_t start = i + count_trailing_zeros(mask);
+      if (std::memcmp(text + start + 1, needle.data() + 1, length - 2) == 0) {
+        return start;
+      }
+      mask &= mask - 1;
+    }
+  }
+#elif defined(SEARCH_INDEX_NEON)
+  const uint8x16_t first = vdupq_n_u8(static_cast<uint8_t>(needle[0]));
+  const uint8x16_t last = vdupq_n_u8(static_cast<uint8_t>(needle[length - 1]));
+  for (; i + 15 <= last_start; i += 16) {
+    uint8x16_t block_first = vld1q_u8(reinterpret_cast<const uint8_t*>(text + i));
+    uint8x16_t block_last = vld1q_u8(reinterpret_cast<const uint8_t*>(text + i + length - 1));
+    uint8x16_t equal = vandq_u8(vceqq_u8(first, block_first), vceqq_u8(last, block_last));
+    // Narrow each byte of the comparison to 4 bits, since NEON has no movemask
+    uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(equal), 4)), 0);
+    while (mask != 0) {
+      int bit = count_trailing_zeros(mask);
+      size_t start = i + bit / 4;
+      if (std::memcmp(text + start + 1, needle.data() + 1, length - 2) == 0) {
+        return start;
+      }
+      mask &= ~(uint64_t(0xF) << (bit & ~3));
+    }
+  }
+#endif
+  for (; i <= last_start; i++) {
+    if (text[i] == needle[0] && text[i + length - 1] == needle[length - 1] &&
+        std::memcmp(text + i + 1, needle.data() + 1, length - 2) == 0) {
+      return i;
+    }
+  }
+  return std::string_view::npos;
+}
+
+SearchIndex::SearchIndex() : postings(TRIGRAM_COUNT), dead_documents(0) {}
+
+void SearchIndex::update(const std::vector<FileInfo>& assets) {
+  stats.added = 0;
+  stats.removed = 0;
+
+  // Walk the new list alongside the indexed one. Both come sorted by path, so unchanged assets line up and an
+  // old key that sorts before the new one is gone. If the order differs, assets are dropped and indexed again,
+  // which costs time but never changes the results.
+  std::vector<uint32_t> new_order;
+  new_order.reserve(assets.size());
+  if (order.empty()) {
+    documents.reserve(assets.size());
+  }
+  std::string key;
+  size_t old_index = 0;
+  for (size_t position = 0; position < assets.size(); position++) {
+    build_key(assets[position], key);
+    bool reused = false;
+    while (old_index < order.size()) {
+      Document& document = documents[order[old_index]];
+      int comparison = get_document_key(document).compare(key);
+      if (comparison > 0) {
+        break;
+      }
+      old_index++;
+      if (comparison == 0) {
+        document.position = static_cast<uint32_t>(position);
+        new_order.push_back(order[old_index - 1]);
+        reused = true;
+        break;
+      }
+      document.alive = false;
+      dead_documents++;
+      stats.removed++;
+    }
+    if (!reused) {
+      new_order.push_back(add_document(key, static_cast<uint32_t>(position)));
+      stats.added++;
+    }
+  }
+  for (; old_index < order.size(); old_index++) {
+    documents[order[old_index]].alive = false;
+    dead_documents++;
+    stats.removed++;
+  }
+  order.swap(new_order);
+  stats.assets = order.size();
+
+  if (dead_documents >= MIN_DEAD_DOCUMENTS_TO_COMPACT && dead_documents > order.size()) {
+    compact();
+  }
+}
+
+void SearchIndex::splice(const std::vector<FileInfo>& assets, const std::vector<size_t>& removed,
+                         const std::vector<size_t>& inserted) {
+  stats.added = 0;
+  stats.removed = 0;
+
+  std::vector<uint32_t> new_order;
+  new_order.reserve(assets.size());
+  std::string key;
+  size_t old_index = 0;
+  size_t next_removed = 0;
+  size_t next_inserted = 0;
+  for (size_t position = 0; position < assets.size(); position++) {
+    if (next_inserted < inserted.size() && inserted[next_inserted] == position) {
+      build_key(assets[position], key);
+      new_order.push_back(add_document(key, static_cast<uint32_t>(position)));
+      stats.added++;
+      next_inserted++;
+      continue;
+    }
+    for (; next_removed < removed.size() && removed[next_removed] == old_index; next_removed++, old_index++) {
+      documents[order[old_index]].alive = false;
+      dead_documents++;
+      stats.removed++;
+    }
+    documents[order[old_index]].position = static_cast<uint32_t>(position);
+    new_order.push_back(order[old_index++]);
+  }
+  for (; next_removed < removed.size(); next_removed++) {
+    documents[order[removed[next_removed]]].alive = false;
+    dead_documents++;
+    stats.removed++;
+  }
+  order.swap(new_order);
+  stats.assets = order.size();
+
+  if (dead_documents >= MIN_DEAD_DOCUMENTS_TO_COMPACT && dead_documents > order.size()) {
+    compact();
+  }
+}
+
+size_t SearchIndex::size() const { return order.size(); }
+
+std::string_view SearchIndex::get_key(size_t position) const { return get_document_key(documents[order[position]]); }
+
+uint64_t SearchIndex::get_key_mask(size_t position) const { return documents[order[position]].mask; }
+
+KeyLayout SearchIndex::get_key_layout(size_t position) const { return documents[order[position]].layout; }
+
+bool SearchIndex::matches(size_t position, const std::vector<std::string>& terms) const {
+  std::string_view key = get_key(position);
+  for (const std::string& term : terms) {
+    if (find_substring(key, term) == std::string_view::npos) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SearchIndex::get_candidates(const std::vector<std::string>& terms, std::vector<size_t>& positions) const {
+  const std::array<uint8_t, 256>& fold = get_fold_table();
+  std::vector<uint32_t> trigrams;
+  for (const std::string& term : terms) {
+    for (size_t i = 0; i + 3 <= term.size(); i++) {
+      trigrams.push_back(get_trigram(term.data() + i, fold));
+    }
+  }
+  if (trigrams.empty()) {
+    return false;
+  }
+  std::sort(trigrams.begin(), trigrams.end());
+  trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+
+  // Shortest lists first, so the intersection shrinks as early as possible
+  std::vector<const std::vector<uint32_t>*> lists;
+  lists.reserve(trigrams.size());
+  for (uint32_t trigram : trigrams) {
+    lists.push_back(&postings[trigram]);
+  }
+  std::sort(lists.begin(), lists.end(), [](const std::vector<uint32_t>* a, const std::vector<uint32_t>* b) {
+    return a->size() < b->size();
+  });
+
+  std::vector<uint32_t> ids(lists[0]->begin(), lists[0]->end());
+  for (size_t i = 1; i < lists.size() && !ids.empty(); i++) {
+    intersect(ids, *lists[i]);
+  }
+
+  positions.clear();
+  positions.reserve(ids.size());
+  for (uint32_t id : ids) {
+    if (documents[id].alive) {
+      positions.push_back(documents[id].position);
+    }
+  }
+  // Document ids follow list order except for assets added since the last compaction
+  if (!std::is_sorted(positions.begin(), positions.end())) {
+    std::sort(positions.begin(), positions.end());
+  }
+  return true;
+}
+
+SearchIndexStats SearchIndex::get_stats() const { return stats; }
+
+std::string_view SearchIndex::get_document_key(const Document& document) const {
+  return std::string_view(keys).substr(document.offset, document.length);
+}
+
+uint32_t SearchIndex::add_document(std::string_view key, uint32_t position) {
+  uint32_t id = static_cast<uint32_t>(documents.size());
+  Document document;
+  document.offset = keys.size();
+  document.length = static_cast<uint32_t>(key.size());
+  document.position = position;
+  document.mask = get_character_mask(key);
+  document.layout = ::get_key_layout(key);
+  documents.push_back(document);
+  keys.append(key);
+  stats.key_bytes = keys.size();
+
+  // A document's trigrams are added one after another, so a repeated trigram is already at the back of its list
+  const std::array<uint8_t, 256>& fold = get_fold_table();
+  for (size_t i = 0; i + 3 <= key.size(); i++) {
+    if (key[i] == '\n' || key[i + 1] == '\n' || key[i + 2] == '\n') {
+      continue;
+    }
+    std::vector<uint32_t>& list = postings[get_trigram(key.data() + i, fold)];
+    if (list.empty() || list.back() != id) {
+      list.push_back(id);
+      stats.postings++;
+    }
+  }
+  return id;
+}
+
+// Rebuild without the removed assets, numbering documents in list order again
+void SearchIndex::compact() {
+  std::string old_keys;
+  old_keys.swap(keys);
+  std::vector<Document> old_documents;
+  old_documents.swap(documents);
+  for (std::vector<uint32_t>& list : postings) {
+    list.clear();
+  }
+  stats.postings = 0;
+
+  keys.reserve(old_keys.size());
+  documents.reserve(order.size());
+  for (size_t position = 0; position < order.size(); position++) {
+    const Document& old_document = old_documents[order[position]];
+    std::string_view key = std::string_view(old_keys).substr(old_document.offset, old_document.length);
+    order[position] = add_document(key, static_cast<uint32_t>(position));
+  }
+  dead_documents = 0;
+  stats.compactions++;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "asset_index.h"
+
+// Append `text` lowercased. ASCII only, like tolower() in the "C" locale.
+void append_lowercase(std::string& out, std::string_view text);
+
+// Position of the first occurrence of `needle` in `haystack`, or std::string_view::npos. Tests 16 positions at
+// a time with SSE2 or NEON where available.
+size_t find_substring(std::string_view haystack, std::string_view needle);
+
+// Bit set of the characters in `text`, folded the way trigrams are. An asset can only contain a term, or match
+// it as a subsequence, if its key's mask has every bit of the term's.
+uint64_t get_character_mask(std::string_view text);
+
+// Where the parts of a key's path are, so matchers don't have to look for them on every query. Kept small
+// since the index holds one per asset.
+struct KeyLayout {
+  uint32_t path_length = 0;      // The path is the key's first line
+  uint32_t file_name_start = 0;  // After the last slash
+  uint32_t extension_start = 0;  // The last dot of the file name, or path_length if it has none
+};
+
+KeyLayout get_key_layout(std::string_view key);
+
+struct SearchIndexStats {
+  size_t assets = 0;
+  size_t added = 0;      // Assets indexed by the last update() or splice()
+  size_t removed = 0;    // Assets dropped by the last update() or splice()
+  size_t postings = 0;   // Entries across all posting lists, including ones for removed assets
+  size_t key_bytes = 0;  // Including the keys of removed assets
+  size_t compactions = 0;
+};
+
+// In-memory search index over the asset list. Each asset has a lowercase key (its path, plus its name and
+// extension when the path doesn't already contain them) stored back to back in one buffer, and every trigram
+// of a key has a posting list of the assets containing it. A term of three or more characters is then found by
+// intersecting the posting lists of its trigrams, which leaves a few candidates to check instead of every path.
+//
+// update() diffs the new list against the indexed one, so a watcher change only indexes the assets that were
+// added or renamed; splice() does the same for a list edit that is already known. Removed assets stay in the
+// posting lists until they outnumber the live ones and the index is compacted.
+//
+// Not thread safe for writes; const methods may be called from several threads at once.
+class SearchIndex {
+ public:
+  SearchIndex();
+
+  // Index `assets`, reusing the entries of assets whose key didn't change
+  void update(const std::vector<FileInfo>& assets);
+
+  // Follow an edit of the indexed list without walking its keys: drop the assets at `removed` (ascending
+  // positions in the old list) and index the ones at `inserted` (ascending positions in `assets`, the new list).
+  // Assets replaced in place keep their key, and with it their entry.
+  void splice(const std::vector<FileInfo>& assets, const std::vector<size_t>& removed,
+              const std::vector<size_t>& inserted);
+
+  // Number of assets in the indexed list
+  size_t size() const;
+
+  // Lowercase key of the asset at `position` in the list
+  std::string_view get_key(size_t position) const;
+
+  // Character mask of the key at `position`
+  uint64_t get_key_mask(size_t position) const;
+
+  KeyLayout get_key_layout(size_t position) const;
+
+  // Whether the key at `position` contains every term. Terms must be lowercase.
+  bool matches(size_t position, const std::vector<std::string>& terms) const;
+
+  // Positions, in list order, of the assets that may contain every term: a superset of the matches, to be
+  // confirmed with matches(). Returns false, leaving `positions` alone, if no term is long enough to narrow
+  // the search and every asset is a candidate.
+  bool get_candidates(const std::vector<std::string>& terms, std::vector<size_t>& positions) const;
+
+  SearchIndexStats get_stats() const;
+
+ private:
+  struct Document {
+    size_t offset = 0;  // Into keys
+    uint32_t length = 0;
+    uint32_t position = 0;  // In the current list
+    bool alive = true;
+    uint64_t mask = 0;
+    KeyLayout layout;
+  };
+
+  std::string keys;
+  std::vector<Document> documents;              // By document id
+  std::vector<uint32_t> order;                  // Document id at each list position
+  std::vector<std::vector<uint32_t>> postings;  // Ascending document ids by folded trigram
+  size_t dead_documents;
+  SearchIndexStats stats;
+
+  std::string_view get_document_key(const Document& document) const;
+  uint32_t add_document(std::string_view key, uint32_t position);
+  void compact();
+};
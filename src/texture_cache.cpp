@@ -0,0 +1,168 @@
+#include "texture_cache.h"
+
+#include <algorithm>
+
+#include "path_utils.h"
+
+TextureCache::TextureCache(uint64_t budget_bytes, RetryPolicy policy) : retry_policy(policy), frame(1) {
+  stats.budget = budget_bytes;
+}
+
+TextureCache::~TextureCache() { clear(); }
+
+void TextureCache::set_release_callback(ReleaseCallback callback) { release_callback = std::move(callback); }
+
+void TextureCache::set_budget(uint64_t budget_bytes) {
+  stats.budget = budget_bytes;
+  evict_to_fit(0);
+}
+
+void TextureCache::begin_frame() {
+  frame++;
+  evict_to_fit(0);
+}
+
+TextureState TextureCache::lookup(const std::string& path, CachedTexture& texture, Clock::time_point now) {
+  auto found = index.find(path);
+  if (found == index.end()) {
+    entries.emplace_front();
+    entries.front().path = path;
+    entries.front().last_frame = frame;
+    index.emplace(path, entries.begin());
+    stats.misses++;
+    stats.entries = index.size();
+    return TextureState::Pending;
+  }
+
+  Entry& entry = touch(found->second);
+  switch (entry.state) {
+    case TextureState::Loaded:
+      stats.hits++;
+      texture = entry.texture;
+      return TextureState::Loaded;
+    case TextureState::Failed:
+      if (entry.failed_attempts >= retry_policy.max_attempts || now < entry.retry_at) {
+        return TextureState::Failed;
+      }
+      entry.state = TextureState::Pending;
+      stats.misses++;
+      stats.retries++;
+      return TextureState::Pending;
+    case TextureState::Pending:
+      break;
+  }
+  return TextureState::Pending;
+}
+
+void TextureCache::make_room(uint64_t bytes) { evict_to_fit(bytes); }
+
+void TextureCache::insert(const std::string& path, const CachedTexture& texture, uint64_t bytes) {
+  auto found = index.find(path);
+  if (found != index.end()) {
+    erase(found->second);
+  }
+  evict_to_fit(bytes);
+
+  entries.emplace_front();
+  Entry& entry = entries.front();
+  entry.path = path;
+  entry.state = TextureState::Loaded;
+  entry.texture = texture;
+  entry.bytes = bytes;
+  entry.last_frame = frame;  // Requested because it was on screen
+  index.emplace(path, entries.begin());
+  stats.bytes += bytes;
+  stats.entries = index.size();
+}
+
+void TextureCache::insert_failure(const std::string& path, Clock::time_point now) {
+  int attempts = 0;
+  auto found = index.find(path);
+  if (found != index.end()) {
+    attempts = found->second->failed_attempts;
+    erase(found->second);
+  }
+
+  entries.emplace_front();
+  Entry& entry = entries.front();
+  entry.path = path;
+  entry.state = TextureState::Failed;
+  entry.last_frame = frame;
+  entry.failed_attempts = attempts + 1;
+
+  // Double the delay for each failure so far, without overflowing the shift
+  auto delay = retry_policy.initial_delay * (int64_t(1) << std::min(attempts, 20));
+  entry.retry_at = now + std::min(delay, retry_policy.max_delay);
+
+  index.emplace(path, entries.begin());
+  stats.failures++;
+  stats.entries = index.size();
+}
+
+bool TextureCache::remove(const std::string& path) {
+  auto found = index.find(path);
+  if (found == index.end()) {
+    return false;
+  }
+  erase(found->second);
+  return true;
+}
+
+void TextureCache::remove_under(const std::string& directory) {
+  for (auto it = entries.begin(); it != entries.end();) {
+    auto next = std::next(it);
+    if (is_path_under(it->path, directory)) {
+      erase(it);
+    }
+    it = next;
+  }
+}
+
+void TextureCache::evict_if(const std::function<bool(const CachedTexture&)>& predicate) {
+  for (auto it = entries.begin(); it != entries.end();) {
+    auto next = std::next(it);
+    if (it->state == TextureState::Loaded && it->last_frame != frame && predicate(it->texture)) {
+      stats.evictions++;
+      erase(it);
+    }
+    it = next;
+  }
+}
+
+void TextureCache::clear() {
+  while (!entries.empty()) {
+    erase(entries.begin());
+  }
+}
+
+TextureCacheStats TextureCache::get_stats() const { return stats; }
+
+TextureCache::Entry& TextureCache::touch(EntryList::iterator it) {
+  it->last_frame = frame;
+  entries.splice(entries.begin(), entries, it);
+  return *it;
+}
+
+void TextureCache::erase(EntryList::iterator it) {
+  if (it->state == TextureState::Loaded && release_callback) {
+    release_callback(it->texture);
+  }
+  stats.bytes -= it->bytes;
+  index.erase(it->path);
+  entries.erase(it);
+  stats.entries = index.size();
+}
+
+// Drop least recently used entries until `incoming_bytes` more fit, stopping at the first pinned entry
+void TextureCache::evict_to_fit(uint64_t incoming_bytes) {
+  while (!entries.empty() && stats.bytes + incoming_bytes > stats.budget) {
+    auto oldest = std::prev(entries.end());
+    if (oldest->last_frame == frame) {
+      return;  // Everything left was used this frame
+    }
+    if (oldest->state == TextureState::Loaded) {
+      stats.evictions++;
+    }
+    erase(oldest);
+  }
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "thumbnail_atlas.h"
+
+// A thumbnail the GPU holds for an asset
+struct CachedTexture {
+  AtlasSlot slot = INVALID_ATLAS_SLOT;
+  int width = 0;
+  int height = 0;
+};
+
+enum class TextureState {
+  Loaded,   // Ready to draw
+  Pending,  // Not loaded yet; the caller should (re)request the decode
+  Failed    // The last decode failed and its retry delay hasn't passed
+};
+
+// When to try a failed decode again. Delays double from `initial_delay` up to `max_delay`; after
+// `max_attempts` failures the file is given up on until it is invalidated.
+struct RetryPolicy {
+  std::chrono::milliseconds initial_delay{2000};
+  std::chrono::milliseconds max_delay{60000};
+  int max_attempts = 5;
+};
+
+struct TextureCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;     // Lookups that started a decode
+  uint64_t evictions = 0;  // Loaded textures dropped to stay within the budget
+  uint64_t failures = 0;
+  uint64_t retries = 0;
+  uint64_t bytes = 0;
+  uint64_t budget = 0;
+  size_t entries = 0;
+};
+
+// GPU thumbnails by asset path, kept within a byte budget. Entries are ordered by last use, and the least
+// recently used ones are evicted when an insertion goes over the budget. Entries used since begin_frame() are
+// pinned: they're on screen, so evicting them would only reload them next frame. If the pinned entries alone
+// exceed the budget, the cache stays over it until they scroll away.
+//
+// Not thread safe: it belongs to the GL thread, like the textures it tracks.
+class TextureCache {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  // Called with the slot of every loaded entry that is evicted, removed or cleared
+  using ReleaseCallback = std::function<void(const CachedTexture&)>;
+
+  explicit TextureCache(uint64_t budget_bytes, RetryPolicy retry_policy = RetryPolicy());
+  ~TextureCache();
+
+  TextureCache(const TextureCache&) = delete;
+  TextureCache& operator=(const TextureCache&) = delete;
+
+  void set_release_callback(ReleaseCallback callback);
+
+  // Change the budget, evicting unpinned entries if it shrank
+  void set_budget(uint64_t budget_bytes);
+
+  // Unpin everything used last frame and evict down to the budget
+  void begin_frame();
+
+  // Look a path up and pin it for this frame. An unknown path, or a failure whose retry delay has passed,
+  // becomes Pending and counts as a miss; `texture` is only filled in for Loaded.
+  TextureState lookup(const std::string& path, CachedTexture& texture, Clock::time_point now = Clock::now());
+
+  // Evict least recently used entries until `bytes` more fit in the budget
+  void make_room(uint64_t bytes);
+
+  // Record a finished upload costing `bytes`, evicting least recently used entries to make room
+  void insert(const std::string& path, const CachedTexture& texture, uint64_t bytes);
+
+  // Record a failed decode; it's retried according to the retry policy
+  void insert_failure(const std::string& path, Clock::time_point now = Clock::now());
+
+  // Forget a path (or everything below a directory), e.g. because the file changed. Failures start over.
+  bool remove(const std::string& path);
+  void remove_under(const std::string& directory);
+
+  // Evict the loaded textures `predicate` selects, e.g. those on one atlas page, except the pinned ones
+  void evict_if(const std::function<bool(const CachedTexture&)>& predicate);
+
+  void clear();
+
+  TextureCacheStats get_stats() const;
+
+ private:
+  struct Entry {
+    std::string path;
+    TextureState state = TextureState::Pending;
+    CachedTexture texture;
+    uint64_t bytes = 0;
+    uint64_t last_frame = 0;
+    int failed_attempts = 0;
+    Clock::time_point retry_at;
+  };
+
+  using EntryList = std::list<Entry>;
+
+  RetryPolicy retry_policy;
+  ReleaseCallback release_callback;
+  EntryList entries;  // Most recently used first
+  std::unordered_map<std::string, EntryList::iterator> index;
+  uint64_t frame;
+  TextureCacheStats stats;
+
+  Entry& touch(EntryList::iterator it);
+  void erase(EntryList::iterator it);
+  void evict_to_fit(uint64_t incoming_bytes);
+};
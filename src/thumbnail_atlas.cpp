@@ -0,0 +1,180 @@
+#include "thumbnail_atlas.h"
+
+#include <algorithm>
+#include <functional>
+
+ThumbnailAtlas::ThumbnailAtlas(AtlasBackend& atlas_backend, int slot, int page)
+    : backend(atlas_backend), slot_size(slot), page_size(page), used_slots(0) {
+  slots_per_row = std::max(0, page_size / (slot_size + 2 * SLOT_PADDING));
+}
+
+ThumbnailAtlas::~ThumbnailAtlas() { clear(); }
+
+AtlasSlot ThumbnailAtlas::allocate(const unsigned char* pixels, int width, int height) {
+  int slots = get_slots_per_page();
+  if (!pixels || width <= 0 || height <= 0 || width > slot_size || height > slot_size || slots == 0) {
+    return INVALID_ATLAS_SLOT;
+  }
+
+  // Lowest live page with room, else reuse a released page entry, else add one
+  Page* target = nullptr;
+  Page* released = nullptr;
+  for (Page& page : pages) {
+    if (page.texture_id != 0 && !page.free_slots.empty()) {
+      target = &page;
+      break;
+    }
+    if (page.texture_id == 0 && !released) {
+      released = &page;
+    }
+  }
+  if (!target) {
+    if (!released) {
+      pages.emplace_back();
+      released = &pages.back();
+    }
+    if (!create_page(*released)) {
+      return INVALID_ATLAS_SLOT;
+    }
+    target = released;
+  }
+
+  uint16_t index = target->free_slots.back();
+  target->free_slots.pop_back();
+  target->widths[index] = width;
+  target->heights[index] = height;
+  target->used++;
+  used_slots++;
+
+  int x = 0;
+  int y = 0;
+  slot_origin(index, x, y);
+  backend.upload(target->texture_id, x, y, width, height, pixels);
+
+  size_t page_index = static_cast<size_t>(target - pages.data());
+  return static_cast<AtlasSlot>(page_index * slots + index);
+}
+
+void ThumbnailAtlas::free(AtlasSlot slot) {
+  int slots = get_slots_per_page();
+  if (slot == INVALID_ATLAS_SLOT || slots == 0 || slot / slots >= pages.size()) {
+    return;
+  }
+  Page& page = pages[slot / slots];
+  uint16_t index = static_cast<uint16_t>(slot % slots);
+  if (page.texture_id == 0 || page.widths[index] == 0) {
+    return;  // Already free
+  }
+
+  page.widths[index] = 0;
+  page.heights[index] = 0;
+  page.used--;
+  used_slots--;
+
+  // Keep the stack ordered so the lowest free slot is reused first
+  page.free_slots.insert(std::upper_bound(page.free_slots.begin(), page.free_slots.end(), index, std::greater<>()),
+                         index);
+
+  size_t live_pages = get_page_count();
+  if (page.used == 0 && live_pages > 1) {
+    release_page(page);
+  }
+}
+
+bool ThumbnailAtlas::get_region(AtlasSlot slot, AtlasRegion& region) const {
+  int slots = get_slots_per_page();
+  if (slot == INVALID_ATLAS_SLOT || slots == 0 || slot / slots >= pages.size()) {
+    return false;
+  }
+  const Page& page = pages[slot / slots];
+  uint32_t index = slot % slots;
+  if (page.texture_id == 0 || page.widths[index] == 0) {
+    return false;
+  }
+
+  int x = 0;
+  int y = 0;
+  slot_origin(index, x, y);
+  float scale = 1.0f / static_cast<float>(page_size);
+  region.texture_id = page.texture_id;
+  region.width = page.widths[index];
+  region.height = page.heights[index];
+  region.u0 = x * scale;
+  region.v0 = y * scale;
+  region.u1 = (x + region.width) * scale;
+  region.v1 = (y + region.height) * scale;
+  return true;
+}
+
+void ThumbnailAtlas::clear() {
+  for (Page& page : pages) {
+    if (page.texture_id != 0) {
+      release_page(page);
+    }
+  }
+  pages.clear();
+  used_slots = 0;
+}
+
+int ThumbnailAtlas::get_slot_size() const { return slot_size; }
+
+int ThumbnailAtlas::get_slots_per_page() const {
+  // Slot indices are stored in 16 bits
+  return std::min(slots_per_row * slots_per_row, static_cast<int>(UINT16_MAX));
+}
+
+size_t ThumbnailAtlas::get_page_count() const {
+  return static_cast<size_t>(
+      std::count_if(pages.begin(), pages.end(), [](const Page& page) { return page.texture_id != 0; }));
+}
+
+size_t ThumbnailAtlas::get_used_slot_count() const { return used_slots; }
+
+uint64_t ThumbnailAtlas::get_page_bytes() const { return static_cast<uint64_t>(page_size) * page_size * 4; }
+
+uint32_t ThumbnailAtlas::get_page_of(AtlasSlot slot) const {
+  int slots = get_slots_per_page();
+  return slots == 0 ? 0 : slot / static_cast<uint32_t>(slots);
+}
+
+bool ThumbnailAtlas::get_least_used_page(uint32_t& page) const {
+  const Page* least_used = nullptr;
+  for (const Page& candidate : pages) {
+    if (candidate.texture_id != 0 && (!least_used || candidate.used < least_used->used)) {
+      least_used = &candidate;
+    }
+  }
+  if (!least_used) {
+    return false;
+  }
+  page = static_cast<uint32_t>(least_used - pages.data());
+  return true;
+}
+
+bool ThumbnailAtlas::create_page(Page& page) {
+  page.texture_id = backend.create_page(page_size);
+  if (page.texture_id == 0) {
+    return false;
+  }
+  int slots = get_slots_per_page();
+  page.free_slots.resize(slots);
+  for (int i = 0; i < slots; i++) {
+    page.free_slots[i] = static_cast<uint16_t>(slots - 1 - i);
+  }
+  page.widths.assign(slots, 0);
+  page.heights.assign(slots, 0);
+  page.used = 0;
+  return true;
+}
+
+void ThumbnailAtlas::release_page(Page& page) {
+  backend.destroy_page(page.texture_id);
+  used_slots -= page.used;
+  page = Page();
+}
+
+void ThumbnailAtlas::slot_origin(uint32_t index, int& x, int& y) const {
+  int pitch = slot_size + 2 * SLOT_PADDING;
+  x = static_cast<int>(index % slots_per_row) * pitch + SLOT_PADDING;
+  y = static_cast<int>(index / slots_per_row) * pitch + SLOT_PADDING;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Handle to one slot of the atlas
+using AtlasSlot = uint32_t;
+constexpr AtlasSlot INVALID_ATLAS_SLOT = UINT32_MAX;
+
+// Where a thumbnail lives: the page texture and the UV rectangle covering its pixels
+struct AtlasRegion {
+  unsigned int texture_id = 0;
+  float u0 = 0.0f;
+  float v0 = 0.0f;
+  float u1 = 0.0f;
+  float v1 = 0.0f;
+  int width = 0;
+  int height = 0;
+};
+
+// Texture storage behind the atlas. The application implements it with GL; tests use a fake, so the slot
+// bookkeeping runs without a GL context.
+class AtlasBackend {
+ public:
+  virtual ~AtlasBackend() = default;
+
+  // Create a `size` x `size` RGBA8 page cleared to transparent. Returns 0 on failure.
+  virtual unsigned int create_page(int size) = 0;
+  virtual void destroy_page(unsigned int texture_id) = 0;
+
+  // Copy `width` x `height` RGBA8 pixels into a page with their top-left corner at (x, y)
+  virtual void upload(unsigned int texture_id, int x, int y, int width, int height, const unsigned char* pixels) = 0;
+};
+
+// Packs thumbnails into a few large page textures split into a grid of equal slots, one thumbnail per slot.
+// Tiles drawn from the same page share a texture, so ImGui merges them into a single draw command instead of
+// binding a texture per thumbnail.
+//
+// Allocation takes the first free slot of the lowest page, keeping the pages dense; a page is released when
+// its last slot is freed, except for the last remaining one. Not thread safe: use it from the GL thread.
+class ThumbnailAtlas {
+ public:
+  static constexpr int DEFAULT_PAGE_SIZE = 2048;  // Supported by every GL 3.3 implementation
+
+  ThumbnailAtlas(AtlasBackend& backend, int slot_size, int page_size = DEFAULT_PAGE_SIZE);
+  ~ThumbnailAtlas();
+
+  ThumbnailAtlas(const ThumbnailAtlas&) = delete;
+  ThumbnailAtlas& operator=(const ThumbnailAtlas&) = delete;
+
+  // Copy an RGBA8 image of at most slot_size x slot_size into a free slot, creating a page if all are full.
+  // Returns INVALID_ATLAS_SLOT if the image doesn't fit a slot or no page could be created.
+  AtlasSlot allocate(const unsigned char* pixels, int width, int height);
+
+  // Give a slot back; its pixels are overwritten by a later allocation
+  void free(AtlasSlot slot);
+
+  bool get_region(AtlasSlot slot, AtlasRegion& region) const;
+
+  // Free every slot and release all pages
+  void clear();
+
+  int get_slot_size() const;
+  int get_slots_per_page() const;
+  size_t get_page_count() const;
+  size_t get_used_slot_count() const;
+
+  // GPU memory of one page; what the atlas really holds is this times get_page_count()
+  uint64_t get_page_bytes() const;
+
+  // Page a slot lives on, and the live page with the fewest used slots. A page is only released once it is
+  // empty, so emptying the least used one is the cheapest way to give memory back.
+  uint32_t get_page_of(AtlasSlot slot) const;
+  bool get_least_used_page(uint32_t& page) const;
+
+ private:
+  struct Page {
+    unsigned int texture_id = 0;       // 0 once the page has been released
+    std::vector<uint16_t> free_slots;  // Stack with the lowest slot on top
+    std::vector<int> widths;           // Size of the thumbnail in each slot, 0 when the slot is free
+    std::vector<int> heights;
+    int used = 0;
+  };
+
+  // Gap between slots, so linear filtering at a thumbnail's edge never picks up its neighbour
+  static constexpr int SLOT_PADDING = 1;
+
+  AtlasBackend& backend;
+  int slot_size;
+  int page_size;
+  int slots_per_row;
+  std::vector<Page> pages;
+  size_t used_slots;
+
+  bool create_page(Page& page);
+  void release_page(Page& page);
+  void slot_origin(uint32_t index, int& x, int& y) const;
+};
@@ -0,0 +1,322 @@
+#include "thumbnail_cache.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+// Oldest entries are examined in chunks of this size when making room
+static constexpr int EVICTION_BATCH = 64;
+
+ThumbnailCache::ThumbnailCache()
+    : db_(nullptr),
+      load_stmt_(nullptr),
+      touch_stmt_(nullptr),
+      store_stmt_(nullptr),
+      max_bytes_(DEFAULT_MAX_BYTES),
+      access_counter_(0) {}
+
+ThumbnailCache::~ThumbnailCache() { close(); }
+
+bool ThumbnailCache::initialize(const std::string& db_path, uint64_t max_bytes) {
+  close();
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  std::filesystem::path path(db_path);
+  if (path.has_parent_path()) {
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+  }
+
+  if (sqlite3_open(db_path.c_str(), &db_) != SQLITE_OK) {
+    print_sqlite_error("opening thumbnail cache");
+    sqlite3_close(db_);
+    db_ = nullptr;
+    return false;
+  }
+
+  // The asset database writes to the same file from another connection
+  sqlite3_busy_timeout(db_, 5000);
+  execute_sql("PRAGMA journal_mode = WAL");
+  if (!create_tables()) {
+    sqlite3_close(db_);
+    db_ = nullptr;
+    return false;
+  }
+
+  const char* load_sql =
+      "SELECT width, height, pixels FROM thumbnails WHERE full_path = ? AND file_size = ? AND last_write_time = ? "
+      "AND max_size = ? AND options = ?";
+  const char* touch_sql = "UPDATE thumbnails SET last_access = ? WHERE full_path = ?";
+  const char* store_sql = R"(
+        INSERT OR REPLACE INTO thumbnails
+        (full_path, file_size, last_write_time, max_size, options, width, height, pixels, last_access)
+        VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
+    )";
+  if (sqlite3_prepare_v2(db_, load_sql, -1, &load_stmt_, nullptr) != SQLITE_OK ||
+      sqlite3_prepare_v2(db_, touch_sql, -1, &touch_stmt_, nullptr) != SQLITE_OK ||
+      sqlite3_prepare_v2(db_, store_sql, -1, &store_stmt_, nullptr) != SQLITE_OK) {
+    print_sqlite_error("preparing thumbnail cache statements");
+    sqlite3_finalize(load_stmt_);
+    sqlite3_finalize(touch_stmt_);
+    sqlite3_finalize(store_stmt_);
+    load_stmt_ = touch_stmt_ = store_stmt_ = nullptr;
+    sqlite3_close(db_);
+    db_ = nullptr;
+    return false;
+  }
+
+  max_bytes_ = max_bytes;
+  stats_ = ThumbnailCacheStats();
+  access_counter_ = 0;
+  sqlite3_stmt* stmt = nullptr;
+  const char* totals_sql = "SELECT COALESCE(MAX(last_access), 0), COALESCE(SUM(LENGTH(pixels)), 0) FROM thumbnails";
+  if (sqlite3_prepare_v2(db_, totals_sql, -1, &stmt, nullptr) == SQLITE_OK &&
+      sqlite3_step(stmt) == SQLITE_ROW) {
+    access_counter_ = sqlite3_column_int64(stmt, 0);
+    stats_.total_bytes = static_cast<uint64_t>(sqlite3_column_int64(stmt, 1));
+  }
+  sqlite3_finalize(stmt);
+
+  // The cap may have been lowered since the last run
+  evict_to_fit(0);
+
+  std::cout << "Thumbnail cache opened: " << stats_.total_bytes / 1024 << "KB in " << db_path << '\n';
+  return true;
+}
+
+void ThumbnailCache::close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  sqlite3_finalize(load_stmt_);
+  sqlite3_finalize(touch_stmt_);
+  sqlite3_finalize(store_stmt_);
+  load_stmt_ = touch_stmt_ = store_stmt_ = nullptr;
+  if (db_) {
+    sqlite3_close(db_);
+    db_ = nullptr;
+  }
+}
+
+bool ThumbnailCache::is_open() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return db_ != nullptr;
+}
+
+bool ThumbnailCache::create_tables() {
+  // Tables of builds before the format was recorded hold thumbnails of unknown make; they are dropped, as they
+  // would all be misses anyway
+  sqlite3_stmt* stmt = nullptr;
+  bool has_table = false;
+  bool has_format = false;
+  if (sqlite3_prepare_v2(db_, "SELECT name FROM pragma_table_info('thumbnails')", -1, &stmt, nullptr) == SQLITE_OK) {
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+      has_table = true;
+      has_format = has_format || std::string(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0))) == "options";
+    }
+  }
+  sqlite3_finalize(stmt);
+  if (has_table && !has_format && !execute_sql("DROP TABLE thumbnails")) {
+    return false;
+  }
+
+  const std::string create_table_sql = R"(
+        CREATE TABLE IF NOT EXISTS thumbnails (
+            full_path TEXT PRIMARY KEY,
+            file_size INTEGER NOT NULL,
+            last_write_time INTEGER NOT NULL,
+            max_size INTEGER NOT NULL,
+            options INTEGER NOT NULL,
+            width INTEGER NOT NULL,
+            height INTEGER NOT NULL,
+            pixels BLOB NOT NULL,
+            last_access INTEGER NOT NULL
+        );
+
+        CREATE INDEX IF NOT EXISTS idx_thumbnails_last_access ON thumbnails(last_access);
+    )";
+  return execute_sql(create_table_sql);
+}
+
+bool ThumbnailCache::load(const std::string& full_path, uint64_t file_size, int64_t last_write_time,
+                          const ThumbnailFormat& format, Thumbnail& thumbnail) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!db_) {
+    return false;
+  }
+
+  sqlite3_reset(load_stmt_);
+  sqlite3_bind_text(load_stmt_, 1, full_path.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int64(load_stmt_, 2, static_cast<sqlite3_int64>(file_size));
+  sqlite3_bind_int64(load_stmt_, 3, last_write_time);
+  sqlite3_bind_int(load_stmt_, 4, format.max_size);
+  sqlite3_bind_int64(load_stmt_, 5, format.options);
+
+  bool found = false;
+  if (sqlite3_step(load_stmt_) == SQLITE_ROW) {
+    int width = sqlite3_column_int(load_stmt_, 0);
+    int height = sqlite3_column_int(load_stmt_, 1);
+    const void* blob = sqlite3_column_blob(load_stmt_, 2);
+    size_t blob_size = static_cast<size_t>(sqlite3_column_bytes(load_stmt_, 2));
+
+    // A row that doesn't hold width x height RGBA pixels is treated as a miss and rewritten later
+    if (width > 0 && height > 0 && blob && blob_size == static_cast<size_t>(width) * height * 4) {
+      const unsigned char* bytes = static_cast<const unsigned char*>(blob);
+      thumbnail.width = width;
+      thumbnail.height = height;
+      thumbnail.pixels.assign(bytes, bytes + blob_size);
+      found = true;
+    }
+  }
+  sqlite3_reset(load_stmt_);
+
+  if (!found) {
+    stats_.misses++;
+    return false;
+  }
+
+  stats_.hits++;
+  sqlite3_reset(touch_stmt_);
+  sqlite3_bind_int64(touch_stmt_, 1, ++access_counter_);
+  sqlite3_bind_text(touch_stmt_, 2, full_path.c_str(), -1, SQLITE_TRANSIENT);
+  if (sqlite3_step(touch_stmt_) != SQLITE_DONE) {
+    print_sqlite_error("updating thumbnail access time");
+  }
+  sqlite3_reset(touch_stmt_);
+  return true;
+}
+
+bool ThumbnailCache::store(const std::string& full_path, uint64_t file_size, int64_t last_write_time,
+                           const ThumbnailFormat& format, const Thumbnail& thumbnail) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  uint64_t bytes = thumbnail.pixels.size();
+  if (!db_ || bytes == 0 || bytes > max_bytes_) {
+    return false;
+  }
+
+  // Replacing an entry frees its old bytes first
+  remove_locked(full_path);
+  evict_to_fit(bytes);
+
+  sqlite3_reset(store_stmt_);
+  sqlite3_bind_text(store_stmt_, 1, full_path.c_str(), -1, SQLITE_TRANSIENT);
+  sqlite3_bind_int64(store_stmt_, 2, static_cast<sqlite3_int64>(file_size));
+  sqlite3_bind_int64(store_stmt_, 3, last_write_time);
+  sqlite3_bind_int(store_stmt_, 4, format.max_size);
+  sqlite3_bind_int64(store_stmt_, 5, format.options);
+  sqlite3_bind_int(store_stmt_, 6, thumbnail.width);
+  sqlite3_bind_int(store_stmt_, 7, thumbnail.height);
+  sqlite3_bind_blob(store_stmt_, 8, thumbnail.pixels.data(), static_cast<int>(bytes), SQLITE_STATIC);
+  sqlite3_bind_int64(store_stmt_, 9, ++access_counter_);
+  bool success = sqlite3_step(store_stmt_) == SQLITE_DONE;
+  sqlite3_reset(store_stmt_);
+  sqlite3_clear_bindings(store_stmt_);
+
+  if (!success) {
+    print_sqlite_error("storing thumbnail");
+    return false;
+  }
+  stats_.stores++;
+  stats_.total_bytes += bytes;
+  return true;
+}
+
+bool ThumbnailCache::remove(const std::string& full_path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return db_ && remove_locked(full_path);
+}
+
+bool ThumbnailCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!db_ || !execute_sql("DELETE FROM thumbnails")) {
+    return false;
+  }
+  stats_.total_bytes = 0;
+  return true;
+}
+
+ThumbnailCacheStats ThumbnailCache::get_stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+bool ThumbnailCache::remove_locked(const std::string& full_path) {
+  sqlite3_stmt* stmt = nullptr;
+  if (sqlite3_prepare_v2(db_, "DELETE FROM thumbnails WHERE full_path = ? RETURNING LENGTH(pixels)", -1, &stmt,
+                         nullptr) != SQLITE_OK) {
+    print_sqlite_error("preparing thumbnail removal");
+    return false;
+  }
+  sqlite3_bind_text(stmt, 1, full_path.c_str(), -1, SQLITE_TRANSIENT);
+
+  bool removed = false;
+  while (sqlite3_step(stmt) == SQLITE_ROW) {
+    stats_.total_bytes -= std::min<uint64_t>(stats_.total_bytes, sqlite3_column_int64(stmt, 0));
+    removed = true;
+  }
+  sqlite3_finalize(stmt);
+  return removed;
+}
+
+// Delete the least recently used entries until `incoming_bytes` more fit under the cap
+void ThumbnailCache::evict_to_fit(uint64_t incoming_bytes) {
+  while (stats_.total_bytes + incoming_bytes > max_bytes_ && stats_.total_bytes > 0) {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, "SELECT full_path, LENGTH(pixels) FROM thumbnails ORDER BY last_access LIMIT ?", -1,
+                           &stmt, nullptr) != SQLITE_OK) {
+      print_sqlite_error("selecting thumbnails to evict");
+      return;
+    }
+    sqlite3_bind_int(stmt, 1, EVICTION_BATCH);
+
+    std::vector<std::string> victims;
+    uint64_t freed = 0;
+    while (stats_.total_bytes - freed + incoming_bytes > max_bytes_ && sqlite3_step(stmt) == SQLITE_ROW) {
+      victims.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+      freed += static_cast<uint64_t>(sqlite3_column_int64(stmt, 1));
+    }
+    sqlite3_finalize(stmt);
+    if (victims.empty()) {
+      // The byte count drifted from the table; trust the table
+      stats_.total_bytes = 0;
+      return;
+    }
+
+    execute_sql("BEGIN TRANSACTION");
+    for (const auto& victim : victims) {
+      if (remove_locked(victim)) {
+        stats_.evictions++;
+      }
+    }
+    execute_sql("COMMIT");
+  }
+}
+
+bool ThumbnailCache::execute_sql(const std::string& sql) {
+  char* error_msg = nullptr;
+  int rc = sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &error_msg);
+  if (rc != SQLITE_OK) {
+    std::cerr << "SQL error: " << (error_msg ? error_msg : sqlite3_errmsg(db_)) << '\n';
+    sqlite3_free(error_msg);
+    return false;
+  }
+  return true;
+}
+
+void ThumbnailCache::print_sqlite_error(const std::string& operation) {
+  std::cerr << "SQLite error during " << operation << ": " << (db_ ? sqlite3_errmsg(db_) : "no connection") << '\n';
+}
+
+bool get_file_signature(const std::string& path, uint64_t& file_size, int64_t& last_write_time) {
+  std::error_code ec;
+  std::filesystem::path fs_path = std::filesystem::u8path(path);
+  uintmax_t size = std::filesystem::file_size(fs_path, ec);
+  if (ec) {
+    return false;
+  }
+  auto write_time = std::filesystem::last_write_time(fs_path, ec);
+  if (ec) {
+    return false;
+  }
+  file_size = size;
+  last_write_time = static_cast<int64_t>(write_time.time_since_epoch().count());
+  return true;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <sqlite3.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// A downscaled RGBA8 image
+struct Thumbnail {
+  int width = 0;
+  int height = 0;
+  std::vector<unsigned char> pixels;
+};
+
+// How a thumbnail was made. One made under different settings, e.g. by an older build or with another thumbnail
+// size, is a miss and gets replaced.
+struct ThumbnailFormat {
+  int max_size = 0;      // Side it was fitted to, 0 for full size
+  uint32_t options = 0;  // Resize options and decoder version, as packed by ThumbnailLoader
+};
+
+struct ThumbnailCacheStats {
+  uint64_t hits = 0;
+  uint64_t misses = 0;     // Not cached, or cached for a different file size, mtime or format
+  uint64_t stores = 0;
+  uint64_t evictions = 0;
+  uint64_t total_bytes = 0;  // Pixel bytes currently stored
+};
+
+// Persistent thumbnail store: a `thumbnails` blob table in the asset database file, keyed by full path and
+// validated against the file's size and modification time and the format the thumbnail was made in. Total pixel
+// bytes are capped; the least recently used thumbnails are evicted first. Uses its own connection and is safe to
+// call from several threads.
+class ThumbnailCache {
+ public:
+  static constexpr uint64_t DEFAULT_MAX_BYTES = 256ull * 1024 * 1024;
+
+  ThumbnailCache();
+  ~ThumbnailCache();
+
+  bool initialize(const std::string& db_path, uint64_t max_bytes = DEFAULT_MAX_BYTES);
+  void close();
+  bool is_open() const;
+
+  // Fetch the thumbnail of a file if one was stored for exactly this size, modification time and format
+  bool load(const std::string& full_path, uint64_t file_size, int64_t last_write_time, const ThumbnailFormat& format,
+            Thumbnail& thumbnail);
+
+  // Store or replace the thumbnail of a file, evicting old entries to stay under the cap
+  bool store(const std::string& full_path, uint64_t file_size, int64_t last_write_time, const ThumbnailFormat& format,
+             const Thumbnail& thumbnail);
+
+  bool remove(const std::string& full_path);
+  bool clear();
+
+  ThumbnailCacheStats get_stats() const;
+
+ private:
+  mutable std::mutex mutex_;
+  sqlite3* db_;
+  sqlite3_stmt* load_stmt_;
+  sqlite3_stmt* touch_stmt_;
+  sqlite3_stmt* store_stmt_;
+  uint64_t max_bytes_;
+  int64_t access_counter_;  // Monotonic stamp for last_access; larger means more recently used
+  ThumbnailCacheStats stats_;
+
+  bool create_tables();
+  bool execute_sql(const std::string& sql);
+  bool remove_locked(const std::string& full_path);
+  void evict_to_fit(uint64_t incoming_bytes);
+  void print_sqlite_error(const std::string& operation);
+};
+
+// Size and modification time of a file as used in the cache key; false if the file can't be stat'ed
+bool get_file_signature(const std::string& path, uint64_t& file_size, int64_t& last_write_time);
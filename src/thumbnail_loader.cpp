@@ -0,0 +1,295 @@
+#include "thumbnail_loader.h"
+
+#include <algorithm>
+#include <climits>
+#include <utility>
+
+#include "compressed_texture.h"
+#include "jpeg_decoder.h"
+#include "mapped_file.h"
+#include "path_utils.h"
+#include "profiler.h"
+#include "stb_image.h"
+#include "thumbnail_cache.h"
+
+// Bump when decoding or downscaling changes what a thumbnail looks like, so cached thumbnails are made again
+constexpr uint32_t THUMBNAIL_PIPELINE_VERSION = 1;
+
+// Downscale decoded RGBA8 pixels to fit `max_size` x `max_size`, or keep them at full size if that is 0
+static void make_thumbnail(const unsigned char* pixels, int width, int height, int max_size,
+                           const ResizeOptions& options, Thumbnail& thumbnail) {
+  thumbnail.width = width;
+  thumbnail.height = height;
+  if (max_size > 0) {
+    fit_within(width, height, max_size, thumbnail.width, thumbnail.height);
+  }
+  thumbnail.pixels.resize(static_cast<size_t>(thumbnail.width) * thumbnail.height * 4);
+  if (thumbnail.width == width && thumbnail.height == height) {
+    std::copy(pixels, pixels + thumbnail.pixels.size(), thumbnail.pixels.begin());
+  } else {
+    resize_rgba8(pixels, width, height, thumbnail.pixels.data(), thumbnail.width, thumbnail.height, options);
+  }
+}
+
+// The cache key part describing how thumbnails are made with these settings
+static ThumbnailFormat get_thumbnail_format(int max_size, const ResizeOptions& options) {
+  ThumbnailFormat format;
+  format.max_size = max_size;
+  format.options = THUMBNAIL_PIPELINE_VERSION << 8 | (options.gamma_correct ? 1u : 0u);
+  return format;
+}
+
+// Decode an image and downscale it to fit `max_size` x `max_size`, or keep it at full size if that is 0.
+// DDS and KTX files are decoded from their smallest mip level that still covers the thumbnail, and JPEGs from
+// their EXIF thumbnail or at a reduced scale where one covers it.
+static bool decode_thumbnail(const std::string& path, int max_size, const ResizeOptions& options,
+                             Thumbnail& thumbnail) {
+  if (is_container_texture(path)) {
+    TextureLevel level;
+    std::vector<unsigned char> pixels;
+    if (!read_texture_level(path, max_size, level) || !decode_texture_level(level, pixels)) {
+      return false;
+    }
+    make_thumbnail(pixels.data(), level.width, level.height, max_size, options, thumbnail);
+    return true;
+  }
+
+  // Map the file through its UTF-8 path rather than let stbi_load() open it, which would take it as ANSI on
+  // Windows. Mapping also spares copying the whole file when only its EXIF thumbnail is decoded.
+  MappedFile file;
+  if (!file.open(path) || file.size() == 0) {
+    return false;
+  }
+  int width = 0;
+  int height = 0;
+  if (is_jpeg_file(path)) {
+    std::vector<unsigned char> pixels;
+    if (decode_jpeg_thumbnail(file.data(), file.size(), max_size, pixels, width, height)) {
+      make_thumbnail(pixels.data(), width, height, max_size, options, thumbnail);
+      return true;
+    }
+    // Progressive JPEGs, and ones too small to decode at a reduced scale, go through stb_image like the rest
+  }
+  if (file.size() > static_cast<size_t>(INT_MAX)) {
+    return false;  // stb_image takes the length as an int
+  }
+  int channels = 0;
+  unsigned char* decoded =
+      stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &channels, 4);
+  if (!decoded) {
+    return false;
+  }
+  make_thumbnail(decoded, width, height, max_size, options, thumbnail);
+  stbi_image_free(decoded);
+  return true;
+}
+
+ThumbnailLoader::ThumbnailLoader(size_t count)
+    : worker_count(count),
+      thumbnail_size(0),
+      cache(nullptr),
+      profiler(nullptr),
+      next_sequence(1),
+      frame(0),
+      should_stop(false),
+      decoded_count(0),
+      cancelled_count(0) {
+  if (worker_count == 0) {
+    // Leave a core for the UI thread and the watcher
+    unsigned int cores = std::thread::hardware_concurrency();
+    worker_count = std::max(1u, cores > 1 ? cores - 1 : 1u);
+  }
+}
+
+ThumbnailLoader::~ThumbnailLoader() { stop(); }
+
+void ThumbnailLoader::set_thumbnail_size(int max_size) { thumbnail_size = max_size; }
+
+void ThumbnailLoader::set_resize_options(const ResizeOptions& options) { resize_options = options; }
+
+void ThumbnailLoader::set_cache(ThumbnailCache* thumbnail_cache) { cache = thumbnail_cache; }
+
+void ThumbnailLoader::set_profiler(Profiler* loader_profiler) { profiler = loader_profiler; }
+
+void ThumbnailLoader::set_result_callback(std::function<void()> callback) { result_callback = std::move(callback); }
+
+void ThumbnailLoader::start() {
+  if (!workers.empty()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    should_stop = false;
+  }
+  for (size_t i = 0; i < worker_count; i++) {
+    workers.emplace_back(&ThumbnailLoader::worker_loop, this);
+  }
+}
+
+void ThumbnailLoader::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    should_stop = true;
+    queue.clear();
+    requests.clear();
+  }
+  queue_condition.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  workers.clear();
+}
+
+void ThumbnailLoader::begin_frame() {
+  std::lock_guard<std::mutex> lock(mutex);
+  frame++;
+}
+
+void ThumbnailLoader::request(const std::string& path) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = requests.find(path);
+    if (it != requests.end()) {
+      it->second.last_frame = frame;
+      return;
+    }
+    uint64_t sequence = next_sequence++;
+    requests[path] = {sequence, frame, false};
+    queue.push_back({path, sequence});
+  }
+  queue_condition.notify_one();
+}
+
+void ThumbnailLoader::end_frame() {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto it = requests.begin(); it != requests.end();) {
+    if (!it->second.started && it->second.last_frame != frame) {
+      it = requests.erase(it);
+      cancelled_count++;
+    } else {
+      ++it;
+    }
+  }
+
+  // Keep the queue from filling up with dropped requests while the user scrolls
+  if (queue.size() > 2 * requests.size() + 64) {
+    queue.erase(std::remove_if(queue.begin(), queue.end(),
+                               [this](const QueuedRequest& queued) {
+                                 auto it = requests.find(queued.path);
+                                 return it == requests.end() || it->second.sequence != queued.sequence;
+                               }),
+                queue.end());
+  }
+}
+
+void ThumbnailLoader::cancel(const std::string& path) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (requests.erase(path) > 0) {
+    cancelled_count++;
+  }
+}
+
+void ThumbnailLoader::cancel_under(const std::string& directory) {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto it = requests.begin(); it != requests.end();) {
+    if (is_path_under(it->first, directory)) {
+      it = requests.erase(it);
+      cancelled_count++;
+    } else {
+      ++it;
+    }
+  }
+}
+
+bool ThumbnailLoader::is_pending(const std::string& path) const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return requests.count(path) > 0;
+}
+
+bool ThumbnailLoader::poll(ThumbnailResult& result) {
+  while (completions.pop(result)) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = requests.find(result.path);
+    if (it != requests.end() && it->second.sequence == result.sequence) {
+      requests.erase(it);
+      return true;
+    }
+    // Cancelled or re-requested while it was decoding; the pixels may be stale
+  }
+  return false;
+}
+
+bool ThumbnailLoader::has_results() const { return !completions.empty(); }
+
+uint64_t ThumbnailLoader::get_decoded_count() const { return decoded_count; }
+
+uint64_t ThumbnailLoader::get_cancelled_count() const { return cancelled_count; }
+
+void ThumbnailLoader::worker_loop() {
+  while (true) {
+    QueuedRequest queued;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      queue_condition.wait(lock, [this] { return should_stop || !queue.empty(); });
+      if (should_stop) {
+        return;
+      }
+      queued = std::move(queue.front());
+      queue.pop_front();
+
+      auto it = requests.find(queued.path);
+      if (it == requests.end() || it->second.sequence != queued.sequence) {
+        continue;  // Dropped before anyone started on it
+      }
+      it->second.started = true;
+    }
+
+    ThumbnailResult result;
+    result.path = queued.path;
+    result.sequence = queued.sequence;
+    load_thumbnail(queued.path, result);
+    completions.push(std::move(result));
+    if (result_callback) {
+      result_callback();
+    }
+  }
+}
+
+// Fetch a thumbnail from the cache, or decode and downscale the image and add it to the cache
+void ThumbnailLoader::load_thumbnail(const std::string& path, ThumbnailResult& result) {
+  uint64_t file_size = 0;
+  int64_t last_write_time = 0;
+  bool has_signature = cache && get_file_signature(path, file_size, last_write_time);
+  ThumbnailFormat format = get_thumbnail_format(thumbnail_size, resize_options);
+
+  Thumbnail thumbnail;
+  bool cached = false;
+  {
+    ProfileScope scope(profiler, "Thumbnail cache");
+    cached = has_signature && cache->load(path, file_size, last_write_time, format, thumbnail);
+  }
+  if (cached) {
+    result.width = thumbnail.width;
+    result.height = thumbnail.height;
+    result.pixels = std::move(thumbnail.pixels);
+    return;
+  }
+
+  bool decoded = false;
+  {
+    ProfileScope scope(profiler, "Decode");
+    decoded = decode_thumbnail(path, thumbnail_size, resize_options, thumbnail);
+  }
+  decoded_count++;
+  if (!decoded) {
+    return;
+  }
+
+  if (has_signature) {
+    ProfileScope scope(profiler, "Thumbnail cache");
+    cache->store(path, file_size, last_write_time, format, thumbnail);
+  }
+  result.width = thumbnail.width;
+  result.height = thumbnail.height;
+  result.pixels = std::move(thumbnail.pixels);
+}
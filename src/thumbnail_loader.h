@@ -0,0 +1,123 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "image_resize.h"
+#include "mpsc_queue.h"
+
+class Profiler;
+class ThumbnailCache;
+
+// A finished decode, handed back to the main thread for the GL upload
+struct ThumbnailResult {
+  std::string path;
+  uint64_t sequence = 0;              // Matches the request it answers
+  std::vector<unsigned char> pixels;  // RGBA8, empty if the decode failed
+  int width = 0;
+  int height = 0;
+};
+
+// Pool of worker threads decoding images off the main thread. The main thread requests the images it wants
+// to show every frame and polls for finished decodes; workers pick requests up in the order they were made.
+// Requests not renewed during a frame are dropped before a worker starts on them, so scrolling past a folder
+// doesn't leave a backlog of decodes nobody will see.
+//
+// All methods except the constructor and destructor are meant to be called from the main thread.
+class ThumbnailLoader {
+ public:
+  // 0 picks a worker count from the number of cores
+  explicit ThumbnailLoader(size_t worker_count = 0);
+  ~ThumbnailLoader();
+
+  ThumbnailLoader(const ThumbnailLoader&) = delete;
+  ThumbnailLoader& operator=(const ThumbnailLoader&) = delete;
+
+  // Downscale decoded images to fit `max_size` x `max_size`; 0 keeps them at full resolution.
+  // Must be set before start().
+  void set_thumbnail_size(int max_size);
+
+  // How images are downscaled, e.g. in linear light. Must be set before start().
+  void set_resize_options(const ResizeOptions& options);
+
+  // Look thumbnails up in `cache` before decoding and store new ones there. Must be set before start().
+  void set_cache(ThumbnailCache* cache);
+
+  // Time cache lookups and decodes under the "Thumbnail cache" and "Decode" zones. Must be set before start().
+  void set_profiler(Profiler* profiler);
+
+  // Called on a worker thread after each finished decode, e.g. to wake a main loop waiting for events.
+  // Must be set before start().
+  void set_result_callback(std::function<void()> callback);
+
+  void start();
+  void stop();
+
+  // Mark the start of a frame; requests made from here on count as renewed
+  void begin_frame();
+
+  // Ask for `path` to be decoded, or keep an existing request alive for this frame
+  void request(const std::string& path);
+
+  // Drop queued requests that were not renewed since begin_frame(). Decodes already running finish.
+  void end_frame();
+
+  // Forget any request for `path` (or below `directory`), e.g. because the file changed.
+  // A decode already running for it is discarded when it completes.
+  void cancel(const std::string& path);
+  void cancel_under(const std::string& directory);
+
+  bool is_pending(const std::string& path) const;
+
+  // Take the next finished decode. Results of cancelled or superseded requests are skipped.
+  bool poll(ThumbnailResult& result);
+
+  // Whether finished decodes are waiting to be polled
+  bool has_results() const;
+
+  // Counters for diagnostics
+  uint64_t get_decoded_count() const;
+  uint64_t get_cancelled_count() const;
+
+ private:
+  struct Request {
+    uint64_t sequence;
+    uint64_t last_frame;  // Frame in which the request was last renewed
+    bool started;         // A worker is decoding it; it can no longer be dropped at end_frame()
+  };
+
+  struct QueuedRequest {
+    std::string path;
+    uint64_t sequence;
+  };
+
+  size_t worker_count;
+  std::vector<std::thread> workers;
+  int thumbnail_size;
+  ResizeOptions resize_options;
+  ThumbnailCache* cache;
+  Profiler* profiler;
+  std::function<void()> result_callback;
+
+  mutable std::mutex mutex;
+  std::condition_variable queue_condition;
+  std::deque<QueuedRequest> queue;                    // May hold requests that were dropped since; workers skip them
+  std::unordered_map<std::string, Request> requests;  // Live requests by path
+  uint64_t next_sequence;
+  uint64_t frame;
+  bool should_stop;
+
+  MpscQueue<ThumbnailResult> completions;
+  std::atomic<uint64_t> decoded_count;
+  std::atomic<uint64_t> cancelled_count;
+
+  void worker_loop();
+  void load_thumbnail(const std::string& path, ThumbnailResult& result);
+};
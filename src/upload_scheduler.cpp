@@ -0,0 +1,84 @@
+#include "upload_scheduler.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "path_utils.h"
+
+UploadScheduler::UploadScheduler() : next_arrival(0) {}
+
+void UploadScheduler::set_budget(const UploadBudget& new_budget) { budget = new_budget; }
+
+void UploadScheduler::push(ThumbnailResult result) {
+  QueuedUpload& queued = queue[result.path];
+  queued.arrival = next_arrival++;
+  queued.result = std::move(result);
+}
+
+bool UploadScheduler::mark(const std::string& path, int priority) {
+  auto it = queue.find(path);
+  if (it == queue.end()) {
+    return false;
+  }
+  it->second.priority = std::min(it->second.priority, priority);
+  return true;
+}
+
+bool UploadScheduler::is_queued(const std::string& path) const { return queue.count(path) > 0; }
+
+bool UploadScheduler::has_queued() const { return !queue.empty(); }
+
+void UploadScheduler::remove(const std::string& path) { stats.dropped += queue.erase(path); }
+
+void UploadScheduler::remove_under(const std::string& directory) {
+  for (auto it = queue.begin(); it != queue.end();) {
+    if (is_path_under(it->first, directory)) {
+      it = queue.erase(it);
+      stats.dropped++;
+    } else {
+      ++it;
+    }
+  }
+}
+
+size_t UploadScheduler::run(UploadBackend& backend) {
+  std::vector<QueuedUpload*> order;
+  order.reserve(queue.size());
+  for (auto& entry : queue) {
+    order.push_back(&entry.second);
+  }
+  std::sort(order.begin(), order.end(), [](const QueuedUpload* a, const QueuedUpload* b) {
+    return a->priority != b->priority ? a->priority < b->priority : a->arrival < b->arrival;
+  });
+
+  auto deadline = std::chrono::steady_clock::now() + budget.max_time;
+  uint64_t bytes = 0;
+  size_t uploads = 0;
+  std::vector<std::string> done;
+  for (QueuedUpload* queued : order) {
+    if (uploads > 0 && (bytes >= budget.max_bytes || std::chrono::steady_clock::now() >= deadline)) {
+      stats.budget_frames++;
+      break;
+    }
+    bytes += backend.upload(queued->result);
+    uploads++;
+    done.push_back(queued->result.path);
+  }
+  for (const std::string& path : done) {
+    queue.erase(path);
+  }
+  for (auto& entry : queue) {
+    entry.second.priority = UNMARKED_PRIORITY;
+  }
+
+  stats.uploads += uploads;
+  stats.bytes += bytes;
+  return uploads;
+}
+
+UploadSchedulerStats UploadScheduler::get_stats() const {
+  UploadSchedulerStats current = stats;
+  current.queued = queue.size();
+  return current;
+}
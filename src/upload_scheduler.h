@@ -0,0 +1,82 @@
+#pragma once
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+#include "thumbnail_loader.h"
+
+// Does the actual upload of a finished decode. The application implements it on top of the atlas and the
+// texture cache; tests use a fake, so the scheduling runs without a GL context.
+class UploadBackend {
+ public:
+  virtual ~UploadBackend() = default;
+
+  // Upload a decode, or record its failure. Returns the bytes sent to the GPU, 0 if nothing was uploaded.
+  virtual uint64_t upload(ThumbnailResult& result) = 0;
+};
+
+// What run() may spend per frame. The first upload of a frame always goes ahead, so a thumbnail larger than the
+// byte budget still gets through.
+struct UploadBudget {
+  uint64_t max_bytes = 4 * 1024 * 1024;
+  std::chrono::microseconds max_time{2000};
+};
+
+struct UploadSchedulerStats {
+  uint64_t uploads = 0;
+  uint64_t bytes = 0;
+  uint64_t dropped = 0;         // Queued decodes removed before their upload, e.g. because the file changed
+  uint64_t budget_frames = 0;   // Frames that stopped at the budget with uploads left
+  size_t queued = 0;
+};
+
+// Queue between the thumbnail loader and the GPU. Finished decodes are pushed as they come, and once per frame
+// run() uploads the most wanted ones until the frame's byte or time budget is spent, leaving the rest for the
+// next frame. While building a frame the grid marks the queued thumbnails it wants with a priority: 0 for
+// tiles on screen, the row distance for prefetched ones. Unmarked decodes go last, oldest first. Scrolling fast
+// through a folder then costs a bounded amount of upload time per frame, spent on what is in view.
+//
+// Not thread safe: it belongs to the GL thread.
+class UploadScheduler {
+ public:
+  // Priority of a queued decode nobody asked for since the last run()
+  static constexpr int UNMARKED_PRIORITY = INT_MAX;
+
+  UploadScheduler();
+
+  void set_budget(const UploadBudget& budget);
+
+  // Queue a finished decode, replacing one queued for the same path
+  void push(ThumbnailResult result);
+
+  // Ask for a queued decode to go ahead of others with a larger priority in the next run(). Keeps the smallest
+  // priority it is marked with. Returns false if no decode for `path` is queued.
+  bool mark(const std::string& path, int priority);
+
+  bool is_queued(const std::string& path) const;
+  bool has_queued() const;
+
+  // Drop queued decodes for `path` (or below `directory`), e.g. because the file changed
+  void remove(const std::string& path);
+  void remove_under(const std::string& directory);
+
+  // Upload by priority within the budget, then forget this frame's marks. Returns the number of uploads.
+  size_t run(UploadBackend& backend);
+
+  UploadSchedulerStats get_stats() const;
+
+ private:
+  struct QueuedUpload {
+    ThumbnailResult result;
+    int priority = UNMARKED_PRIORITY;
+    uint64_t arrival = 0;
+  };
+
+  UploadBudget budget;
+  std::unordered_map<std::string, QueuedUpload> queue;  // By path
+  uint64_t next_arrival;
+  UploadSchedulerStats stats;
+};
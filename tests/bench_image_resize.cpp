@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/image_resize.h"
+
+// Micro-benchmark for the thumbnail downscaler: the separable SIMD kernel against its scalar fallback and a
+// naive resize that averages the source block under every destination pixel directly.
+
+// Textbook area average: for each destination pixel, walk every source pixel it covers
+void resize_naive(const unsigned char* src, int src_width, int src_height, unsigned char* dst, int dst_width,
+                  int dst_height) {
+  for (int y = 0; y < dst_height; y++) {
+    int y0 = y * src_height / dst_height;
+    int y1 = std::max(y0 + 1, (y + 1) * src_height / dst_height);
+    for (int x = 0; x < dst_width; x++) {
+      int x0 = x * src_width / dst_width;
+      int x1 = std::max(x0 + 1, (x + 1) * src_width / dst_width);
+      uint32_t sum[4] = {0, 0, 0, 0};
+      for (int sy = y0; sy < y1; sy++) {
+        for (int sx = x0; sx < x1; sx++) {
+          const unsigned char* pixel = src + (static_cast<size_t>(sy) * src_width + sx) * 4;
+          for (int c = 0; c < 4; c++) {
+            sum[c] += pixel[c];
+          }
+        }
+      }
+      uint32_t count = static_cast<uint32_t>((y1 - y0) * (x1 - x0));
+      for (int c = 0; c < 4; c++) {
+        size_t offset = (static_cast<size_t>(y) * dst_width + x) * 4 + c;
+        dst[offset] = static_cast<unsigned char>((sum[c] + count / 2) / count);
+      }
+    }
+  }
+}
+
+// Best of a few runs, in milliseconds
+template <typename Function>
+double time_best(Function function, int runs) {
+  double best = 1e30;
+  for (int i = 0; i < runs; i++) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+void report(const std::string& name, double ms, double megapixels, double baseline_ms) {
+  std::cout << "  " << std::left << std::setw(22) << name << std::right << std::fixed << std::setprecision(2)
+            << std::setw(9) << ms << " ms " << std::setw(9) << megapixels / (ms / 1000.0) << " MP/s "
+            << std::setw(6) << baseline_ms / ms << "x\n";
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Image Resize Benchmark (" << get_resize_kernel_name() << ")\n";
+  std::cout << std::string(80, '-') << '\n';
+
+  struct Case {
+    int width;
+    int height;
+  };
+  const int THUMBNAIL_SIZE = 180;
+  for (Case source : {Case{1024, 1024}, Case{3840, 2160}, Case{7680, 4320}}) {
+    std::vector<unsigned char> src(static_cast<size_t>(source.width) * source.height * 4);
+    unsigned int state = 1;
+    for (unsigned char& value : src) {
+      state = state * 1103515245u + 12345u;
+      value = static_cast<unsigned char>(state >> 24);
+    }
+
+    int width = 0;
+    int height = 0;
+    fit_within(source.width, source.height, THUMBNAIL_SIZE, width, height);
+    std::vector<unsigned char> dst(static_cast<size_t>(width) * height * 4);
+    double megapixels = source.width * static_cast<double>(source.height) / 1e6;
+    int runs = source.width > 4000 ? 3 : 10;
+
+    ResizeOptions scalar;
+    scalar.force_scalar = true;
+    ResizeOptions simd;
+    ResizeOptions gamma;
+    gamma.gamma_correct = true;
+
+    std::cout << '\n' << source.width << 'x' << source.height << " -> " << width << 'x' << height << '\n';
+    double naive_ms =
+        time_best([&] { resize_naive(src.data(), source.width, source.height, dst.data(), width, height); }, runs);
+    report("naive", naive_ms, megapixels, naive_ms);
+    report("separable scalar",
+           time_best([&] { resize_rgba8(src.data(), source.width, source.height, dst.data(), width, height, scalar); },
+                     runs),
+           megapixels, naive_ms);
+    report(std::string("separable ") + get_resize_kernel_name(),
+           time_best([&] { resize_rgba8(src.data(), source.width, source.height, dst.data(), width, height, simd); },
+                     runs),
+           megapixels, naive_ms);
+    report(std::string("gamma-correct ") + get_resize_kernel_name(),
+           time_best([&] { resize_rgba8(src.data(), source.width, source.height, dst.data(), width, height, gamma); },
+                     runs),
+           megapixels, naive_ms);
+  }
+  return 0;
+}
@@ -0,0 +1,454 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/archive_index.h"
+#include "../src/asset_database.h"
+#include "../src/asset_indexer.h"
+#include "../src/file_watcher.h"
+#include "../src/mapped_file.h"
+#include "../src/metadata_extractor.h"
+#include "../src/metadata_store.h"
+#include "test_support.h"
+
+namespace fs = std::filesystem;
+
+const std::string DB_PATH = "test_archive_index.db";
+const std::string ROOT = "test_archive_index_root";
+
+std::string root_path(const std::string& relative) { return (fs::path(ROOT) / fs::u8path(relative)).string(); }
+
+struct ZipFixtureEntry {
+  std::string name;
+  std::string data;
+};
+
+// 2020-01-02 03:04:06 in MS-DOS form, and as Unix time
+constexpr uint16_t DOS_TIME = 3 << 11 | 4 << 5 | 6 / 2;
+constexpr uint16_t DOS_DATE = (2020 - 1980) << 9 | 1 << 5 | 2;
+constexpr int64_t DOS_UNIX_TIME = 1577934246;
+
+// A ZIP of stored entries. With `zip64`, the end record is saturated and a ZIP64 record and locator hold the real
+// values, and each size is moved to a ZIP64 extra field.
+std::string make_zip(const std::vector<ZipFixtureEntry>& entries, const std::string& comment = "",
+                     bool zip64 = false) {
+  std::string local;
+  std::string central;
+  for (const auto& entry : entries) {
+    size_t local_offset = local.size();
+    append_le(local, 0x04034B50, 4);
+    append_le(local, 20, 2);
+    append_le(local, 0, 2);
+    append_le(local, 0, 2);
+    append_le(local, DOS_TIME, 2);
+    append_le(local, DOS_DATE, 2);
+    append_le(local, 0, 4);
+    append_le(local, entry.data.size(), 4);
+    append_le(local, entry.data.size(), 4);
+    append_le(local, entry.name.size(), 2);
+    append_le(local, 0, 2);
+    local += entry.name + entry.data;
+
+    std::string extra;
+    if (zip64) {
+      append_le(extra, 0x0001, 2);
+      append_le(extra, 16, 2);
+      append_le(extra, entry.data.size(), 8);
+      append_le(extra, entry.data.size(), 8);
+    }
+    append_le(central, 0x02014B50, 4);
+    append_le(central, 20, 2);
+    append_le(central, 20, 2);
+    append_le(central, 0, 2);
+    append_le(central, 0, 2);
+    append_le(central, DOS_TIME, 2);
+    append_le(central, DOS_DATE, 2);
+    append_le(central, 0, 4);
+    append_le(central, zip64 ? 0xFFFFFFFF : entry.data.size(), 4);
+    append_le(central, zip64 ? 0xFFFFFFFF : entry.data.size(), 4);
+    append_le(central, entry.name.size(), 2);
+    append_le(central, extra.size(), 2);
+    append_le(central, 0, 2);
+    append_le(central, 0, 2);
+    append_le(central, 0, 2);
+    append_le(central, 0, 4);
+    append_le(central, local_offset, 4);
+    central += entry.name + extra;
+  }
+
+  std::string zip = local + central;
+  if (zip64) {
+    size_t record_offset = zip.size();
+    append_le(zip, 0x06064B50, 4);
+    append_le(zip, 44, 8);
+    append_le(zip, 45, 2);
+    append_le(zip, 45, 2);
+    append_le(zip, 0, 4);
+    append_le(zip, 0, 4);
+    append_le(zip, entries.size(), 8);
+    append_le(zip, entries.size(), 8);
+    append_le(zip, central.size(), 8);
+    append_le(zip, local.size(), 8);
+    append_le(zip, 0x07064B50, 4);
+    append_le(zip, 0, 4);
+    append_le(zip, record_offset, 8);
+    append_le(zip, 1, 4);
+  }
+  append_le(zip, 0x06054B50, 4);
+  append_le(zip, 0, 2);
+  append_le(zip, 0, 2);
+  append_le(zip, zip64 ? 0xFFFF : entries.size(), 2);
+  append_le(zip, zip64 ? 0xFFFF : entries.size(), 2);
+  append_le(zip, zip64 ? 0xFFFFFFFF : central.size(), 4);
+  append_le(zip, zip64 ? 0xFFFFFFFF : local.size(), 4);
+  append_le(zip, comment.size(), 2);
+  return zip + comment;
+}
+
+// One ustar header block with its checksum filled in
+std::string make_tar_header(const std::string& name, char type, uint64_t size, const std::string& prefix = "") {
+  std::string header(512, '\0');
+  std::memcpy(&header[0], name.data(), std::min<size_t>(name.size(), 100));
+  std::snprintf(&header[100], 8, "%07o", 0644);
+  std::snprintf(&header[124], 12, "%011llo", static_cast<unsigned long long>(size));
+  std::snprintf(&header[136], 12, "%011llo", static_cast<unsigned long long>(DOS_UNIX_TIME));
+  header[156] = type;
+  std::memcpy(&header[257], "ustar\0" "00", 8);
+  std::memcpy(&header[345], prefix.data(), std::min<size_t>(prefix.size(), 155));
+  std::memset(&header[148], ' ', 8);
+  unsigned sum = 0;
+  for (unsigned char c : header) {
+    sum += c;
+  }
+  std::snprintf(&header[148], 8, "%06o", sum);
+  return header;
+}
+
+std::string pad_tar_data(const std::string& data) { return data + std::string((512 - data.size() % 512) % 512, '\0'); }
+
+void append_tar_entry(std::string& tar, const std::string& name, char type, const std::string& data,
+                      const std::string& prefix = "") {
+  tar += make_tar_header(name, type, data.size(), prefix) + pad_tar_data(data);
+}
+
+std::string pax_record(const std::string& key, const std::string& value) {
+  // The length counts its own digits; two digits is enough for the test records
+  std::string body = " " + key + "=" + value + "\n";
+  return std::to_string(body.size() + 2) + body;
+}
+
+std::string make_gzip(const std::string& name, uint32_t uncompressed_size) {
+  std::string gzip = std::string("\x1F\x8B\x08", 3);
+  gzip += static_cast<char>(name.empty() ? 0 : 0x08);
+  append_le(gzip, DOS_UNIX_TIME, 4);
+  gzip += std::string("\x00\x03", 2);
+  if (!name.empty()) {
+    gzip += name + std::string(1, '\0');
+  }
+  gzip += std::string("\x03\x00", 2);  // An empty final deflate block; the listing never inflates it
+  append_le(gzip, 0, 4);
+  append_le(gzip, uncompressed_size, 4);
+  return gzip;
+}
+
+bool list_file(const std::string& path, std::vector<ArchiveEntry>& entries) {
+  MappedFile file;
+  return file.open(path) && read_archive_entries(path, file, entries);
+}
+
+std::vector<std::string> get_paths(const std::vector<ArchiveEntry>& entries) {
+  std::vector<std::string> paths;
+  for (const auto& entry : entries) {
+    paths.push_back(entry.path + (entry.is_directory ? "/" : ""));
+  }
+  return paths;
+}
+
+void test_zip() {
+  std::cout << "\n=== ZIP central directory ===\n";
+  std::string zip = make_zip({{"textures/grass.png", "grass"},
+                              {"docs/", ""},
+                              {"../escape.txt", "x"},
+                              {"sounds\\wind.wav", "wind!"},
+                              {"./readme.txt", "hello"}},
+                             "a trailing comment");
+  std::vector<ArchiveEntry> entries;
+  check(read_zip_entries(bytes(zip), zip.size(), entries) && entries.size() == 5,
+        "Every central directory header is read, past the comment");
+  check(entries[0].path == "textures/grass.png" && entries[0].size == 5 && !entries[0].is_directory,
+        "Name and uncompressed size come from the header");
+  check(entries[1].is_directory && entries[1].size == 0, "Names ending in a slash are directories");
+  check(entries[0].last_modified == DOS_UNIX_TIME, "MS-DOS times are converted");
+
+  write_file(root_path("pack.zip"), zip);
+  check(list_file(root_path("pack.zip"), entries), "Listing a mapped ZIP succeeds");
+  check(get_paths(entries) == std::vector<std::string>({"docs/", "readme.txt", "sounds/", "sounds/wind.wav",
+                                                        "textures/", "textures/grass.png"}),
+        "Paths are cleaned and sorted, implied directories added, and escaping ones dropped");
+
+  std::string zip64 = make_zip({{"big.bin", "0123456789"}}, "", true);
+  check(read_zip_entries(bytes(zip64), zip64.size(), entries) && entries.size() == 1 && entries[0].size == 10,
+        "ZIP64 records and extra fields are followed");
+
+  std::string truncated = zip.substr(0, zip.size() - 40);
+  check(!read_zip_entries(bytes(truncated), truncated.size(), entries), "A file without an end record is rejected");
+  std::string damaged = zip;
+  damaged[damaged.find("PK\x01\x02")] = 'X';
+  check(!read_zip_entries(bytes(damaged), damaged.size(), entries), "A damaged central directory is rejected");
+  check(!read_zip_entries(nullptr, 0, entries), "An empty file is not a ZIP");
+}
+
+void test_tar() {
+  std::cout << "\n=== tar headers ===\n";
+  std::string long_name = std::string(120, 'l') + ".png";
+  std::string tar;
+  append_tar_entry(tar, "models/", '5', "");
+  append_tar_entry(tar, "models/tree.fbx", '0', "fbx data");
+  append_tar_entry(tar, "rock.obj", '0', "o", "deep/prefix");
+  append_tar_entry(tar, "././@LongLink", 'L', long_name + std::string(1, '\0'));
+  append_tar_entry(tar, "truncated", '0', "long");
+  append_tar_entry(tar, "PaxHeaders/x", 'x', pax_record("path", "pax/named.wav") + pax_record("size", "3"));
+  append_tar_entry(tar, "ignored", '0', "pax");
+  append_tar_entry(tar, "link", '2', "");
+  tar += std::string(1024, '\0');
+  append_tar_entry(tar, "after_end.txt", '0', "never read");
+
+  std::vector<ArchiveEntry> entries;
+  check(read_tar_entries(bytes(tar), tar.size(), entries) && entries.size() == 5,
+        "Files and directories are listed up to the end marker; links aren't");
+  check(entries[0].is_directory && entries[0].path == "models/", "Directories are listed");
+  check(entries[1].path == "models/tree.fbx" && entries[1].size == 8 && entries[1].last_modified == DOS_UNIX_TIME,
+        "Size and time come from the octal fields");
+  check(entries[2].path == "deep/prefix/rock.obj", "The ustar prefix is joined to the name");
+  check(entries[3].path == long_name && entries[3].size == 4, "GNU long names replace the header name");
+  check(entries[4].path == "pax/named.wav" && entries[4].size == 3, "pax records replace the path and size");
+
+  std::string base256 = make_tar_header("huge.bin", '0', 0);
+  std::memset(&base256[124], 0, 12);
+  base256[124] = static_cast<char>(0x80);
+  base256[135] = 2;
+  std::memset(&base256[148], ' ', 8);
+  unsigned sum = 0;
+  for (unsigned char c : base256) {
+    sum += c;
+  }
+  std::snprintf(&base256[148], 8, "%06o", sum);
+  base256 += pad_tar_data("ab");
+  check(read_tar_entries(bytes(base256), base256.size(), entries) && entries.size() == 1 && entries[0].size == 2,
+        "Base-256 sizes are read");
+
+  std::string damaged = tar;
+  damaged[0] = 'X';
+  check(!read_tar_entries(bytes(damaged), damaged.size(), entries), "A header with a bad checksum is rejected");
+}
+
+void test_gzip() {
+  std::cout << "\n=== gzip member ===\n";
+  std::vector<ArchiveEntry> entries;
+  std::string named = make_gzip("some/dir/model.obj", 123456);
+  check(read_gzip_entries(bytes(named), named.size(), "ignored.gz", entries) && entries.size() == 1,
+        "A gzip file lists its one member");
+  check(entries[0].path == "model.obj" && entries[0].size == 123456 && entries[0].last_modified == DOS_UNIX_TIME,
+        "Name, size and time come from the header and trailer");
+
+  std::string unnamed = make_gzip("", 10);
+  write_file(root_path("level.Json.GZ"), unnamed);
+  check(list_file(root_path("level.Json.GZ"), entries) && entries.size() == 1 && entries[0].path == "level.Json",
+        "Without a stored name the member is named after the archive");
+  check(!read_gzip_entries(bytes(named), 10, "short.gz", entries), "A truncated gzip file is rejected");
+  check(!has_archive_index(".7z") && !has_archive_index(".rar") && has_archive_index(".tar"),
+        "Only ZIP, tar and gzip are listed");
+}
+
+void test_store() {
+  std::cout << "\n=== Listing cache ===\n";
+  remove_database(DB_PATH);
+  MetadataStore store;
+  check(store.initialize(DB_PATH), "Store opens");
+
+  std::vector<ArchiveEntry> listing(2);
+  listing[0].path = "a.png";
+  listing[0].size = 10;
+  listing[1].path = "b";
+  listing[1].is_directory = true;
+  std::string archive = root_path("pack.zip");
+  check(store.store_archive(archive, 100, 5, &listing), "A listing is stored");
+  check(store.is_archive_current(archive, 100, 5) && !store.is_archive_current(archive, 100, 6),
+        "It is current only for the same size and modification time");
+  std::vector<ArchiveEntry> loaded;
+  check(store.load_archive(archive, loaded) && get_paths(loaded) == std::vector<std::string>({"a.png", "b/"}) &&
+            loaded[0].size == 10,
+        "It loads back in path order");
+
+  listing.pop_back();
+  store.store_archive(archive, 101, 5, &listing);
+  check(store.load_archive(archive, loaded) && loaded.size() == 1, "Storing again replaces the old entries");
+
+  std::vector<ArchiveEntry> empty;
+  store.store_archive(root_path("empty.zip"), 22, 5, &empty);
+  check(store.load_archive(root_path("empty.zip"), loaded) && loaded.empty(), "An empty archive has a listing");
+  store.store_archive(root_path("broken.zip"), 3, 5, nullptr);
+  check(store.is_archive_current(root_path("broken.zip"), 3, 5) && !store.load_archive(root_path("broken.zip"), loaded),
+        "An unreadable archive is remembered without a listing");
+
+  std::string moved = root_path("renamed.zip");
+  store.move(archive, moved);
+  check(!store.load_archive(archive, loaded) && store.load_archive(moved, loaded) && loaded.size() == 1,
+        "The listing follows a rename");
+  store.remove(ROOT);
+  check(!store.load_archive(moved, loaded) && !store.is_archive_current(moved, 101, 5),
+        "Removing the directory forgets the listing");
+  store.close();
+}
+
+bool has_change(const std::vector<AssetChange>& changes, AssetChangeType type, const std::string& path) {
+  for (const auto& change : changes) {
+    if (change.type == type && (type == AssetChangeType::Remove ? change.old_path : change.asset.full_path) == path) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void test_indexer() {
+  std::cout << "\n=== Indexing archive contents ===\n";
+  remove_database(DB_PATH);
+  fs::remove_all(ROOT);
+  write_file(root_path("pack.zip"), make_zip({{"textures/grass.png", "grass"}, {"scratch.tmp", "tmp"}}));
+  write_file(root_path("docs.7z"), "7z\xBC\xAF\x27\x1C");
+
+  AssetDatabase database;
+  check(database.initialize(DB_PATH), "Database opens");
+  MetadataStore store;
+  check(store.initialize(DB_PATH), "Store opens");
+  FileWatcher watcher;
+  WatchRootOptions options;
+  options.ignore_patterns = get_default_ignore_patterns();
+  int root_id = watcher.add_root(ROOT, options);
+
+  {
+    AssetIndexer opaque(database, watcher);
+    check(opaque.scan_root(root_id) == 2, "Without a store archives stay opaque");
+  }
+
+  AssetIndexer indexer(database, watcher);
+  indexer.set_archive_store(&store);
+  check(indexer.scan_root(root_id) == 4, "The scan adds the archive's entries, minus ignored ones");
+  FileInfo grass = database.get_asset_by_path(root_path("pack.zip/textures/grass.png"));
+  check(grass.type == AssetType::Texture && grass.size == 5 && grass.name == "grass.png",
+        "Entries get their own name, size and type");
+  check(grass.relative_path == root_path("pack.zip/textures/grass.png").substr(ROOT.size() + 1),
+        "Entries are relative to the root, below the archive");
+  check(database.get_asset_by_path(root_path("pack.zip/textures")).type == AssetType::Directory,
+        "Implied directories are indexed");
+  std::vector<FileInfo> found = database.search_assets_by_name("grass");
+  check(found.size() == 1 && found[0].full_path == grass.full_path, "Search finds assets inside archives");
+  check(indexer.get_stats().archives_listed == 1, "The archive is read once");
+
+  indexer.scan_root(root_id);
+  check(indexer.get_stats().archives_listed == 1 && !database.get_asset_by_path(grass.full_path).full_path.empty(),
+        "An unchanged archive is listed from the store on the next scan");
+
+  std::vector<AssetChange> changes;
+  indexer.set_batch_callback([&changes](uint64_t, std::vector<AssetChange>& batch) {
+    changes.insert(changes.end(), batch.begin(), batch.end());
+  });
+  write_file(root_path("pack.zip"), make_zip({{"sounds/wind.wav", "wind"}}));
+  FileEvent modified(FileEventType::Modified, root_path("pack.zip"));
+  modified.root_id = root_id;
+  indexer.push(modified);
+  indexer.start();
+  indexer.stop();
+  check(indexer.get_stats().archives_listed == 2, "A changed archive is read again");
+  check(database.get_asset_by_path(grass.full_path).full_path.empty() &&
+            database.get_asset_by_path(root_path("pack.zip/textures")).full_path.empty(),
+        "Entries of the old listing are dropped");
+  check(database.get_asset_by_path(root_path("pack.zip/sounds/wind.wav")).type == AssetType::Sound,
+        "Entries of the new listing are indexed");
+  check(has_change(changes, AssetChangeType::Update, root_path("pack.zip")) &&
+            has_change(changes, AssetChangeType::Remove, root_path("pack.zip/textures")) &&
+            has_change(changes, AssetChangeType::Insert, root_path("pack.zip/sounds/wind.wav")),
+        "The batch reports the archive update and its entries' removal and insertion");
+
+  fs::rename(root_path("pack.zip"), root_path("moved.zip"));
+  FileEvent renamed(FileEventType::Renamed, root_path("moved.zip"), root_path("pack.zip"));
+  renamed.root_id = root_id;
+  indexer.push(renamed);
+  indexer.start();
+  indexer.stop();
+  check(!database.get_asset_by_path(root_path("moved.zip/sounds/wind.wav")).full_path.empty() &&
+            database.get_asset_by_path(root_path("pack.zip/sounds/wind.wav")).full_path.empty(),
+        "Entries follow a renamed archive");
+
+  fs::remove(root_path("moved.zip"));
+  FileEvent deleted(FileEventType::Deleted, root_path("moved.zip"));
+  deleted.root_id = root_id;
+  indexer.push(deleted);
+  indexer.start();
+  indexer.stop();
+  check(database.get_asset_by_path(root_path("moved.zip/sounds")).full_path.empty(),
+        "Entries go with a deleted archive");
+
+  // As in the app, each batch also goes to the metadata extractor, which keeps the store in step
+  MetadataExtractor extractor(store, 1);
+  indexer.set_batch_callback([&changes, &extractor](uint64_t, std::vector<AssetChange>& batch) {
+    extractor.apply(batch);
+    changes.insert(changes.end(), batch.begin(), batch.end());
+  });
+  std::string nested = root_path("new/pack.zip");
+  write_file(nested, make_zip({{"a/tex.png", "tex"}, {"b.png", "b"}}));
+  FileEvent directory_created(FileEventType::DirectoryCreated, root_path("new"));
+  directory_created.root_id = root_id;
+  indexer.push(directory_created);
+  indexer.start();
+  indexer.stop();
+  MappedFile nested_file;
+  std::vector<ArchiveEntry> loaded;
+  check(nested_file.open(nested) &&
+            store.is_archive_current(nested, nested_file.size(), nested_file.get_last_write_time()) &&
+            store.load_archive(nested, loaded) && loaded.size() == 3,
+        "The listing of an archive in a new directory survives the batch that indexed it");
+
+  nested_file.close();
+  changes.clear();
+  write_file(nested, make_zip({{"b.png", "b, rewritten"}}));
+  FileEvent nested_modified(FileEventType::Modified, nested);
+  nested_modified.root_id = root_id;
+  indexer.push(nested_modified);
+  indexer.start();
+  indexer.stop();
+  check(database.get_asset_by_path(root_path("new/pack.zip/a/tex.png")).full_path.empty() &&
+            has_change(changes, AssetChangeType::Remove, root_path("new/pack.zip/a")),
+        "Entries dropped from it later are removed from the UI as well as the database");
+
+  store.close();
+  database.close();
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Archive Index Test\n";
+  std::cout << std::string(50, '-') << '\n';
+
+  fs::remove_all(ROOT);
+  test_zip();
+  test_tar();
+  test_gzip();
+  test_store();
+  test_indexer();
+  remove_database(DB_PATH);
+  fs::remove_all(ROOT);
+
+  std::cout << '\n';
+  if (g_failures == 0) {
+    std::cout << "All checks passed\n";
+    return 0;
+  }
+  std::cout << g_failures << " check(s) failed\n";
+  return 1;
+}
@@ -0,0 +1,156 @@
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/asset_database.h"
+#include "../src/asset_indexer.h"
+#include "../src/asset_store.h"
+#include "../src/file_watcher.h"
+#include "test_support.h"
+
+namespace fs = std::filesystem;
+
+const std::string DB_PATH = "test_asset_indexer.db";
+const std::string ROOT = "test_asset_indexer_root";
+
+std::string root_path(const std::string& relative) { return (fs::path(ROOT) / relative).string(); }
+
+bool is_indexed(AssetDatabase& database, const std::string& relative) {
+  return !database.get_asset_by_path(root_path(relative)).full_path.empty();
+}
+
+void test_scan() {
+  std::cout << "\n=== Initial scan ===\n";
+  remove_database(DB_PATH);
+  fs::remove_all(ROOT);
+  write_file(root_path("textures/grass.png"), "png");
+  write_file(root_path("models/tree.fbx"), "fbx");
+  write_file(root_path("scratch.tmp"), "tmp");
+  write_file(root_path(".git/HEAD"), "ref");
+
+  AssetDatabase database;
+  check(database.initialize(DB_PATH), "Database opens");
+  FileWatcher watcher;
+  WatchRootOptions options;
+  options.ignore_patterns = get_default_ignore_patterns();
+  int root_id = watcher.add_root(ROOT, options);
+  check(root_id > 0, "Root is registered");
+
+  // Left over from an earlier run; the scan replaces it
+  FileInfo stale;
+  stale.name = "gone.png";
+  stale.full_path = root_path("gone.png");
+  stale.relative_path = "gone.png";
+  database.insert_asset(stale);
+
+  AssetIndexer indexer(database, watcher);
+  size_t indexed = indexer.scan_root(root_id);
+  check(indexed == 4, "Scan indexes two files and two directories");
+  check(is_indexed(database, "textures/grass.png") && is_indexed(database, "models/tree.fbx"), "Assets are stored");
+  check(!is_indexed(database, "scratch.tmp") && !is_indexed(database, ".git/HEAD"), "Ignored paths are skipped");
+  check(!is_indexed(database, "gone.png"), "Entries no longer on disk are dropped");
+  check(database.get_asset_by_path(root_path("textures/grass.png")).relative_path ==
+            (fs::path("textures") / "grass.png").string(),
+        "Relative paths are relative to the root");
+  check(indexer.get_stats().scanned == 4, "Stats count the scanned entries");
+  check(indexer.scan_root(root_id + 1) == 0, "Unknown roots aren't scanned");
+  database.close();
+}
+
+void test_events() {
+  std::cout << "\n=== Applying events ===\n";
+  AssetDatabase database;
+  check(database.initialize(DB_PATH), "Database opens");
+  FileWatcher watcher;
+  WatchRootOptions options;
+  options.ignore_patterns = get_default_ignore_patterns();
+  int root_id = watcher.add_root(ROOT, options);
+
+  AssetIndexer indexer(database, watcher);
+  indexer.scan_root(root_id);
+  std::atomic<uint64_t> reported(0);
+  AssetStore store;
+  store.set_assets(database.get_all_assets());
+  indexer.set_batch_callback([&reported, &store](uint64_t applied, std::vector<AssetChange>& changes) {
+    reported += applied;
+    store.apply(changes);  // Only touched from the applier thread until stop()
+  });
+
+  // Pushed before start() and applied once it runs
+  write_file(root_path("textures/rock.png"), "rock");
+  FileEvent created(FileEventType::Created, root_path("textures/rock.png"));
+  created.root_id = root_id;
+  indexer.push(created);
+  indexer.start();
+  indexer.stop();
+  check(is_indexed(database, "textures/rock.png"), "Events queued before start() are applied");
+
+  // Events re-read the file system when applied, so the rest are only applied once the tree has settled
+  write_file(root_path("sounds/wind/gust.wav"), "wav");
+  FileEvent directory_created(FileEventType::DirectoryCreated, root_path("sounds"));
+  directory_created.root_id = root_id;
+  indexer.push(directory_created);
+
+  fs::remove(root_path("models/tree.fbx"));
+  FileEvent deleted(FileEventType::Deleted, root_path("models/tree.fbx"));
+  deleted.root_id = root_id;
+  indexer.push(deleted);
+
+  fs::rename(root_path("textures"), root_path("images"));
+  FileEvent renamed(FileEventType::Renamed, root_path("images"), root_path("textures"));
+  renamed.root_id = root_id;
+  indexer.push(renamed);
+  indexer.start();
+  indexer.stop();
+
+  check(is_indexed(database, "images/rock.png") && is_indexed(database, "images/grass.png"),
+        "Created file and renamed directory are applied");
+  check(!is_indexed(database, "textures/grass.png") && !is_indexed(database, "textures"),
+        "Old directory paths are gone");
+  check(is_indexed(database, "sounds/wind/gust.wav") && is_indexed(database, "sounds/wind"),
+        "New directory is indexed with its subtree");
+  check(database.get_asset_by_path(root_path("sounds/wind/gust.wav")).relative_path ==
+            (fs::path("sounds") / "wind" / "gust.wav").string(),
+        "Subtree paths are relative to the root");
+  check(!is_indexed(database, "models/tree.fbx"), "Deleted file is removed");
+
+  AssetIndexerStats stats = indexer.get_stats();
+  check(stats.events_applied == 4 && reported == 4, "Every event is applied and reported");
+  check(stats.batches == 2, "Events are applied in one batch per drain");
+
+  AssetStore reloaded;
+  reloaded.set_assets(database.get_all_assets());
+  bool same = store.get_assets().size() == reloaded.get_assets().size();
+  for (size_t i = 0; same && i < reloaded.get_assets().size(); i++) {
+    const FileInfo& applied = store.get_assets()[i];
+    const FileInfo& stored = reloaded.get_assets()[i];
+    same = applied.full_path == stored.full_path && applied.relative_path == stored.relative_path &&
+           applied.size == stored.size && applied.type == stored.type;
+  }
+  check(same, "Changes applied to the asset list match the database");
+  database.close();
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Asset Indexer Test\n";
+  std::cout << std::string(50, '-') << '\n';
+
+  test_scan();
+  test_events();
+
+  remove_database(DB_PATH);
+  fs::remove_all(ROOT);
+
+  std::cout << '\n';
+  if (g_failures == 0) {
+    std::cout << "All checks passed\n";
+    return 0;
+  }
+  std::cout << g_failures << " check(s) failed\n";
+  return 1;
+}
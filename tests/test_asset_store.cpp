@@ -0,0 +1,179 @@
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/asset_store.h"
+#include "test_support.h"
+
+const char SEPARATOR = static_cast<char>(std::filesystem::path::preferred_separator);
+
+// Join path parts with the platform separator, as the indexer's paths are
+std::string join(const std::vector<std::string>& parts) {
+  std::string path;
+  for (const std::string& part : parts) {
+    if (!path.empty()) {
+      path += SEPARATOR;
+    }
+    path += part;
+  }
+  return path;
+}
+
+FileInfo make_asset(const std::vector<std::string>& parts, uint64_t size = 0) {
+  FileInfo asset;
+  asset.relative_path = join(parts);
+  asset.full_path = join({"root", asset.relative_path});
+  asset.name = parts.back();
+  asset.size = size;
+  return asset;
+}
+
+AssetChange make_change(AssetChangeType type, const FileInfo& asset, const std::string& old_path = "") {
+  AssetChange change;
+  change.type = type;
+  change.asset = asset;
+  change.old_path = old_path;
+  return change;
+}
+
+// Relative paths of the list, in order
+std::vector<std::string> get_paths(const AssetStore& store) {
+  std::vector<std::string> paths;
+  for (const FileInfo& asset : store.get_assets()) {
+    paths.push_back(asset.relative_path);
+  }
+  return paths;
+}
+
+// Whether every asset can be found by path at its position
+bool is_consistent(const AssetStore& store) {
+  const std::vector<FileInfo>& assets = store.get_assets();
+  for (size_t position = 0; position < assets.size(); position++) {
+    if (store.find(assets[position].full_path) != position) {
+      return false;
+    }
+    if (position > 0 && !(assets[position - 1].relative_path < assets[position].relative_path)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+AssetStore make_store() {
+  AssetStore store;
+  store.set_assets({make_asset({"textures", "rock.png"}), make_asset({"models"}), make_asset({"textures"}),
+                    make_asset({"models", "tree.fbx"}), make_asset({"textures", "grass.png"})});
+  return store;
+}
+
+void test_set_assets() {
+  std::cout << "\n=== Setting the list ===\n";
+  AssetStore store = make_store();
+  std::vector<std::string> expected = {"models", join({"models", "tree.fbx"}), "textures",
+                                       join({"textures", "grass.png"}), join({"textures", "rock.png"})};
+  check(get_paths(store) == expected, "Assets are sorted by relative path");
+  check(is_consistent(store), "Every asset is found at its position");
+  check(store.find("root/nothing") == AssetStore::npos, "Unknown paths aren't found");
+}
+
+void test_update_in_place() {
+  std::cout << "\n=== Updates ===\n";
+  AssetStore store = make_store();
+  size_t position = store.find(join({"root", "textures", "grass.png"}));
+  AssetListEdit edit = store.apply({make_change(AssetChangeType::Update, make_asset({"textures", "grass.png"}, 42))});
+  check(edit.updated == 1 && edit.removed.empty() && edit.inserted.empty(), "An update is applied in place");
+  check(store.find(join({"root", "textures", "grass.png"})) == position && store.get_assets()[position].size == 42,
+        "The asset keeps its position and gets the new record");
+
+  edit = store.apply({make_change(AssetChangeType::Update, make_asset({"textures", "dirt.png"}))});
+  check(edit.inserted == std::vector<size_t>({3}) && store.find(join({"root", "textures", "dirt.png"})) == 3,
+        "Updating an unknown asset inserts it");
+}
+
+void test_insert_and_remove() {
+  std::cout << "\n=== Inserts and removals ===\n";
+  AssetStore store = make_store();
+  AssetListEdit edit =
+      store.apply({make_change(AssetChangeType::Insert, make_asset({"textures", "moss.png"})),
+                   make_change(AssetChangeType::Insert, make_asset({"audio.wav"})),
+                   make_change(AssetChangeType::Remove, FileInfo(), join({"root", "models", "tree.fbx"}))});
+  check(edit.removed == std::vector<size_t>({1}), "Removed positions refer to the old list");
+  check(edit.inserted == std::vector<size_t>({0, 4}), "Inserted positions refer to the new list");
+  std::vector<std::string> expected = {"audio.wav", "models", "textures", join({"textures", "grass.png"}),
+                                       join({"textures", "moss.png"}), join({"textures", "rock.png"})};
+  check(get_paths(store) == expected, "The batch is merged in order");
+  check(is_consistent(store), "Positions follow the merge");
+
+  edit = store.apply({make_change(AssetChangeType::Remove, FileInfo(), join({"root", "textures"}))});
+  check(edit.removed == std::vector<size_t>({2, 3, 4, 5}) && get_paths(store).size() == 2,
+        "Removing a directory removes everything below it");
+
+  edit = store.apply({make_change(AssetChangeType::Remove, FileInfo(), join({"root", "models"})),
+                      make_change(AssetChangeType::Insert, make_asset({"models"}))});
+  check(edit.removed == std::vector<size_t>({1}) && edit.inserted == std::vector<size_t>({1}) &&
+            store.find(join({"root", "models"})) == 1,
+        "Changes in a batch apply in order");
+
+  // The indexer joins archive entries with '/', which stays as is below the archive on Windows too
+  FileInfo entry = make_asset({"pack.zip", "maps"});
+  entry.relative_path += "/a.png";
+  entry.full_path += "/a.png";
+  store.set_assets({make_asset({"pack.zip"}), make_asset({"pack.zip", "maps"}), entry});
+  edit = store.apply({make_change(AssetChangeType::Remove, FileInfo(), join({"root", "pack.zip", "maps"}))});
+  check(edit.removed == std::vector<size_t>({1, 2}) && get_paths(store) == std::vector<std::string>({"pack.zip"}),
+        "Paths below a directory are found whichever separator follows it");
+}
+
+void test_move() {
+  std::cout << "\n=== Moves ===\n";
+  AssetStore store = make_store();
+  store.apply({make_change(AssetChangeType::Move, make_asset({"images"}), join({"root", "textures"}))});
+  std::vector<std::string> expected_paths = {"images", join({"images", "grass.png"}), join({"images", "rock.png"}),
+                                             "models", join({"models", "tree.fbx"})};
+  check(get_paths(store) == expected_paths, "Moving a directory moves everything below it");
+  check(store.find(join({"root", "images", "rock.png"})) == 2 &&
+            store.find(join({"root", "textures", "rock.png"})) == AssetStore::npos,
+        "Moved assets are found under their new paths only");
+  check(is_consistent(store), "Positions follow the move");
+
+  std::string old_path = join({"root", "images", "rock.png"});
+  AssetListEdit edit = store.apply({make_change(AssetChangeType::Move, make_asset({"models", "rock.png"}), old_path)});
+  check(edit.removed == std::vector<size_t>({2}) && edit.inserted == std::vector<size_t>({3}),
+        "Moving a file is a removal and an insert");
+
+  // A large batch, checked against a store built from the final list
+  std::vector<AssetChange> changes;
+  std::vector<FileInfo> expected = store.get_assets();
+  for (int i = 0; i < 200; i++) {
+    FileInfo asset = make_asset({"bulk", "mesh_" + std::to_string(i) + ".obj"});
+    changes.push_back(make_change(AssetChangeType::Insert, asset));
+    expected.push_back(asset);
+  }
+  store.apply(changes);
+  AssetStore rebuilt;
+  rebuilt.set_assets(expected);
+  check(get_paths(store) == get_paths(rebuilt) && is_consistent(store), "A large batch matches a rebuilt list");
+
+  AssetStoreStats stats = store.get_stats();
+  check(stats.batches == 3 && stats.inserted == 204, "Stats count batches and inserts");
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Asset Store Test\n";
+  std::cout << std::string(50, '-') << '\n';
+
+  test_set_assets();
+  test_update_in_place();
+  test_insert_and_remove();
+  test_move();
+
+  std::cout << '\n';
+  if (g_failures == 0) {
+    std::cout << "All checks passed\n";
+    return 0;
+  }
+  std::cout << g_failures << " check(s) failed\n";
+  return 1;
+}
@@ -0,0 +1,439 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/asset_database.h"
+#include "../src/audio_preview_loader.h"
+#include "../src/audio_metadata.h"
+#include "../src/metadata_extractor.h"
+#include "../src/metadata_store.h"
+#include "test_support.h"
+
+const std::string DB_PATH = "test_audio_metadata.db";
+const std::string TEST_DIR = "test_audio_metadata_files";
+
+void append_be(std::string& out, uint64_t value, int size) {
+  for (int i = size - 1; i >= 0; i--) {
+    out += static_cast<char>(value >> (8 * i));
+  }
+}
+
+// A RIFF WAVE file with a LIST chunk of odd size before fmt, to exercise chunk padding
+std::string make_wav(uint16_t format_tag, uint16_t channels, uint32_t sample_rate, uint16_t bits,
+                     const std::string& samples, uint32_t claimed_data_size = 0, bool extensible = false) {
+  uint16_t block_align = static_cast<uint16_t>(channels * bits / 8);
+  std::string fmt;
+  append_le(fmt, extensible ? 0xFFFE : format_tag, 2);
+  append_le(fmt, channels, 2);
+  append_le(fmt, sample_rate, 4);
+  append_le(fmt, static_cast<uint64_t>(sample_rate) * block_align, 4);
+  append_le(fmt, block_align, 2);
+  append_le(fmt, bits, 2);
+  if (extensible) {
+    append_le(fmt, 22, 2);
+    append_le(fmt, bits, 2);
+    append_le(fmt, 0x3, 4);
+    append_le(fmt, format_tag, 2);
+    fmt += std::string("\x00\x00\x00\x00\x10\x00\x80\x00\x00\xAA\x00\x38\x9B\x71", 14);
+  }
+  std::string body = "WAVE";
+  body += "LIST";
+  append_le(body, 3, 4);
+  body += std::string("abc\0", 4);
+  body += "fmt ";
+  append_le(body, fmt.size(), 4);
+  body += fmt;
+  body += "data";
+  append_le(body, claimed_data_size ? claimed_data_size : samples.size(), 4);
+  body += samples;
+  std::string wav = "RIFF";
+  append_le(wav, body.size(), 4);
+  return wav + body;
+}
+
+std::string make_samples_16(const std::vector<int16_t>& values) {
+  std::string out;
+  for (int16_t value : values) {
+    append_le(out, static_cast<uint16_t>(value), 2);
+  }
+  return out;
+}
+
+// The waveform compute_waveform() should produce for 16-bit samples, one sample at a time
+std::vector<int8_t> reference_waveform(const std::vector<int16_t>& values, uint32_t channels, size_t column_count) {
+  uint64_t frames = values.size() / channels;
+  size_t columns = static_cast<size_t>(std::min<uint64_t>(column_count, frames));
+  std::vector<int8_t> waveform;
+  for (size_t column = 0; column < columns; column++) {
+    uint64_t begin = frames * column / columns * channels;
+    uint64_t end = frames * (column + 1) / columns * channels;
+    int low = 32767;
+    int high = -32768;
+    for (uint64_t i = begin; i < end; i++) {
+      low = std::min<int>(low, values[i]);
+      high = std::max<int>(high, values[i]);
+    }
+    waveform.push_back(static_cast<int8_t>(low / 258));
+    waveform.push_back(static_cast<int8_t>(high / 258));
+  }
+  return waveform;
+}
+
+// An Ogg page holding one packet
+std::string make_ogg_page(uint32_t serial, uint64_t granule, const std::string& packet, uint8_t header_type = 0) {
+  std::string page = "OggS";
+  page += '\0';
+  page += static_cast<char>(header_type);
+  append_le(page, granule, 8);
+  append_le(page, serial, 4);
+  append_le(page, 0, 4);  // Sequence number
+  append_le(page, 0, 4);  // CRC, not checked
+  size_t segments = packet.size() / 255 + 1;
+  page += static_cast<char>(segments);
+  for (size_t i = 0; i + 1 < segments; i++) {
+    page += static_cast<char>(255);
+  }
+  page += static_cast<char>(packet.size() % 255);
+  return page + packet;
+}
+
+// MPEG 1 layer III frames at 128 kbit/s and 44.1 kHz: 417 bytes each without padding
+std::string make_mp3_frames(size_t count, const std::string& first_frame_tag = "") {
+  std::string frames;
+  for (size_t i = 0; i < count; i++) {
+    std::string frame("\xFF\xFB\x90\x00", 4);
+    frame.resize(417, '\0');
+    if (i == 0 && !first_frame_tag.empty()) {
+      frame.replace(4 + 32, first_frame_tag.size(), first_frame_tag);
+    }
+    frames += frame;
+  }
+  return frames;
+}
+
+std::string make_id3v2(size_t body_size) {
+  std::string tag("ID3\x03\x00\x00", 6);
+  for (int shift = 21; shift >= 0; shift -= 7) {
+    tag += static_cast<char>((body_size >> shift) & 0x7F);
+  }
+  return tag + std::string(body_size, '\0');
+}
+
+void test_wav() {
+  std::cout << "\n=== WAV ===\n";
+  // Stereo 16-bit: silence, then a full-scale square wave
+  std::vector<int16_t> values;
+  for (int frame = 0; frame < 1600; frame++) {
+    int16_t value = frame < 800 ? 0 : (frame % 2 ? 32767 : -32768);
+    values.push_back(value);
+    values.push_back(static_cast<int16_t>(value / 2));
+  }
+  std::string wav = make_wav(1, 2, 44100, 16, make_samples_16(values));
+  AudioMetadata metadata;
+  PcmSamples samples;
+  check(read_wav_metadata(bytes(wav), wav.size(), metadata, &samples), "PCM WAV is read");
+  check(metadata.codec == "PCM" && metadata.sample_rate == 44100 && metadata.channel_count == 2 &&
+            metadata.bits_per_sample == 16 && metadata.frame_count == 1600,
+        "Format and length come from the fmt and data chunks");
+  check(std::abs(metadata.get_duration() - 1600.0 / 44100) < 1e-9, "Duration follows from frames and rate");
+  check(samples.data && samples.frame_count == 1600 && samples.channel_count == 2, "PCM samples are located");
+
+  std::vector<int8_t> waveform;
+  compute_waveform(samples, 160, waveform);
+  check(waveform.size() == 320, "A min and max per column");
+  check(waveform[0] == 0 && waveform[1] == 0 && waveform[318] == -127 && waveform[319] == 127,
+        "Silence is flat and full scale reaches -127 and 127");
+
+  // Odd counts per column exercise the vector kernel's tail
+  std::mt19937 random(7);
+  std::uniform_int_distribution<int> distribution(-32768, 32767);
+  std::vector<int16_t> noise(3 * 12345);
+  for (auto& value : noise) {
+    value = static_cast<int16_t>(distribution(random));
+  }
+  std::string noise_bytes = make_samples_16(noise);
+  PcmSamples noise_samples;
+  noise_samples.data = bytes(noise_bytes);
+  noise_samples.frame_count = 12345;
+  noise_samples.channel_count = 3;
+  noise_samples.bits_per_sample = 16;
+  compute_waveform(noise_samples, 157, waveform);
+  check(waveform == reference_waveform(noise, 3, 157), "Vectorized min/max matches a sample-by-sample reference");
+  noise_samples.frame_count = 10;
+  compute_waveform(noise_samples, 160, waveform);
+  check(waveform.size() == 20, "Short sounds get a column per frame");
+
+  // Other sample formats are converted to 16 bits first
+  std::string pcm8 = std::string(50, '\x80') + std::string(25, '\x00') + std::string(25, '\xFF');
+  wav = make_wav(1, 1, 8000, 8, pcm8);
+  read_wav_metadata(bytes(wav), wav.size(), metadata, &samples);
+  compute_waveform(samples, 2, waveform);
+  check(waveform == std::vector<int8_t>{0, 0, -127, 126}, "8-bit samples are unsigned");
+
+  std::string pcm24;
+  append_le(pcm24, 0x7FFFFF, 3);
+  append_le(pcm24, 0x800000, 3);
+  wav = make_wav(1, 1, 96000, 24, pcm24, 0, true);
+  metadata = AudioMetadata();
+  read_wav_metadata(bytes(wav), wav.size(), metadata, &samples);
+  compute_waveform(samples, 1, waveform);
+  check(metadata.codec == "PCM" && metadata.bits_per_sample == 24 && waveform == std::vector<int8_t>{-127, 127},
+        "Extensible 24-bit PCM is read");
+
+  std::string floats;
+  for (float value : {0.5f, -2.0f, 0.25f, NAN}) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    append_le(floats, bits, 4);
+  }
+  wav = make_wav(3, 1, 48000, 32, floats);
+  metadata = AudioMetadata();
+  read_wav_metadata(bytes(wav), wav.size(), metadata, &samples);
+  compute_waveform(samples, 1, waveform);
+  check(metadata.codec == "Float" && waveform == std::vector<int8_t>{-127, 63},
+        "Float samples are clamped, and NaN ignored");
+
+  // Streaming writers leave the data size at its maximum
+  wav = make_wav(1, 2, 44100, 16, make_samples_16(values), 0xFFFFFFFF);
+  metadata = AudioMetadata();
+  check(read_wav_metadata(bytes(wav), wav.size(), metadata, &samples) && metadata.frame_count == 1600,
+        "Data size is clamped to the file");
+
+  // Compressed formats get their length from the fact chunk and no waveform
+  std::string adpcm = make_wav(2, 1, 22050, 4, std::string(256, '\0'));
+  std::string fact = "fact";
+  append_le(fact, 4, 4);
+  append_le(fact, 5000, 4);
+  adpcm.insert(adpcm.find("data"), fact);
+  samples = PcmSamples();
+  metadata = AudioMetadata();
+  check(read_wav_metadata(bytes(adpcm), adpcm.size(), metadata, &samples) && metadata.codec == "0x0002" &&
+            metadata.frame_count == 5000 && !samples.data,
+        "ADPCM is described but not sampled");
+
+  check(!read_wav_metadata(bytes(wav), 30, metadata, &samples), "A file cut off before the data chunk fails");
+}
+
+void test_flac() {
+  std::cout << "\n=== FLAC ===\n";
+  std::string info(34, '\0');
+  uint64_t packed = static_cast<uint64_t>(44100) << 44 | static_cast<uint64_t>(2 - 1) << 41 |
+                    static_cast<uint64_t>(24 - 1) << 36 | 441000;
+  for (int i = 0; i < 8; i++) {
+    info[10 + i] = static_cast<char>(packed >> (56 - 8 * i));
+  }
+  std::string flac = make_id3v2(40) + "fLaC" + std::string("\x80\x00\x00\x22", 4) + info;
+  AudioMetadata metadata;
+  check(read_flac_metadata(bytes(flac), flac.size(), metadata), "FLAC behind an ID3 tag is read");
+  check(metadata.codec == "FLAC" && metadata.sample_rate == 44100 && metadata.channel_count == 2 &&
+            metadata.bits_per_sample == 24 && metadata.frame_count == 441000,
+        "STREAMINFO gives rate, channels, depth and length");
+  check(!read_flac_metadata(bytes(flac), flac.size() - 10, metadata), "A truncated STREAMINFO fails");
+
+  // Ogg FLAC wraps the same block
+  std::string packet =
+      std::string("\x7F" "FLAC\x01\x00\x00\x01", 9) + "fLaC" + std::string("\x80\x00\x00\x22", 4) + info;
+  std::string ogg = make_ogg_page(9, 0, packet, 0x02) + make_ogg_page(9, 441000, std::string(100, 'x'), 0x04);
+  metadata = AudioMetadata();
+  check(read_ogg_metadata(bytes(ogg), ogg.size(), metadata) && metadata.codec == "FLAC" &&
+            metadata.frame_count == 441000,
+        "Ogg FLAC is read");
+}
+
+void test_ogg() {
+  std::cout << "\n=== Ogg ===\n";
+  std::string vorbis("\x01vorbis", 7);
+  append_le(vorbis, 0, 4);
+  vorbis += '\x01';
+  append_le(vorbis, 22050, 4);
+  vorbis += std::string(12, '\0') + "\xB8\x01";
+  // A page that finishes no packet, then a later page of another stream, which must be ignored
+  std::string ogg = make_ogg_page(1, 0, vorbis, 0x02) + make_ogg_page(1, 5000, std::string(3000, 'a')) +
+                    make_ogg_page(1, 44100, std::string(700, 'b'), 0x04) +
+                    make_ogg_page(1, UINT64_MAX, std::string(300, 'c')) +
+                    make_ogg_page(2, 999999, std::string(50, 'd'), 0x04);
+  AudioMetadata metadata;
+  check(read_ogg_metadata(bytes(ogg), ogg.size(), metadata), "Ogg Vorbis is read");
+  check(metadata.codec == "Vorbis" && metadata.sample_rate == 22050 && metadata.channel_count == 1 &&
+            metadata.bits_per_sample == 0,
+        "The identification header gives rate and channels");
+  check(metadata.frame_count == 44100, "Length is the last granule position of the stream");
+
+  std::string opus = "OpusHead";
+  opus += '\x01';
+  opus += '\x02';
+  append_le(opus, 312, 2);
+  append_le(opus, 44100, 4);
+  append_le(opus, 0, 3);
+  ogg = make_ogg_page(5, 0, opus, 0x02) + make_ogg_page(5, 48000 + 312, std::string(400, 'e'), 0x04);
+  metadata = AudioMetadata();
+  check(read_ogg_metadata(bytes(ogg), ogg.size(), metadata) && metadata.codec == "Opus" &&
+            metadata.sample_rate == 48000 && metadata.channel_count == 2 && metadata.frame_count == 48000,
+        "Opus runs at 48 kHz, less its pre-skip");
+
+  std::string speex = make_ogg_page(3, 0, "Speex   " + std::string(72, '\0'), 0x02);
+  check(!read_ogg_metadata(bytes(speex), speex.size(), metadata), "Other Ogg codecs are rejected");
+}
+
+void test_mp3() {
+  std::cout << "\n=== MP3 ===\n";
+  std::string mp3 = make_id3v2(100) + std::string(7, '\0') + make_mp3_frames(20) + "TAG" + std::string(125, ' ');
+  AudioMetadata metadata;
+  check(read_mp3_metadata(bytes(mp3), mp3.size(), metadata), "MP3 behind an ID3 tag and junk is read");
+  check(metadata.codec == "MP3" && metadata.sample_rate == 44100 && metadata.channel_count == 2 &&
+            metadata.bits_per_sample == 0,
+        "The first frame header gives rate and channels");
+  check(metadata.frame_count > 20 * 1152 * 99 / 100 && metadata.frame_count < 20 * 1152 * 101 / 100,
+        "Length is estimated from the bit rate without a Xing header");
+
+  std::string xing("Xing\x00\x00\x00\x01", 8);
+  append_be(xing, 1000, 4);
+  mp3 = make_mp3_frames(3, xing);
+  metadata = AudioMetadata();
+  check(read_mp3_metadata(bytes(mp3), mp3.size(), metadata) && metadata.frame_count == 1000 * 1152,
+        "A Xing header gives the exact frame count");
+
+  std::string zeros(4096, '\0');
+  check(!read_mp3_metadata(bytes(zeros), zeros.size(), metadata), "Files without frames are rejected");
+  std::string false_sync = std::string("\xFF\xFB\x90\x00", 4) + std::string(1000, '\x11');
+  check(!read_mp3_metadata(bytes(false_sync), false_sync.size(), metadata),
+        "A lone sync word not followed by another frame is rejected");
+}
+
+void test_store_and_extractor() {
+  std::cout << "\n=== Store and extractor ===\n";
+  remove_database(DB_PATH);
+  AssetDatabase database;
+  database.initialize(DB_PATH);
+  MetadataStore store;
+  check(store.initialize(DB_PATH), "Store opens");
+
+  std::string hit = (std::filesystem::path("sfx") / "hit.wav").string();
+  std::string broken = (std::filesystem::path("sfx") / "broken.wav").string();
+  std::string moved = (std::filesystem::path("sounds") / "hit.wav").string();
+  AudioMetadata metadata;
+  metadata.codec = "PCM";
+  metadata.sample_rate = 48000;
+  metadata.channel_count = 2;
+  metadata.bits_per_sample = 16;
+  metadata.frame_count = 96000;
+  metadata.waveform = {-5, 7, -127, 127, 0, 0};
+  store.store_audio(hit, 100, 1, &metadata);
+  store.store_audio(broken, 10, 1, nullptr);
+  AudioMetadata loaded;
+  check(store.is_audio_current(hit, 100, 1) && !store.is_audio_current(hit, 100, 2),
+        "Audio metadata is validated by size and time");
+  check(!store.is_model_current(hit, 100, 1), "Model and audio metadata are kept apart");
+  check(store.load_audio(hit, loaded) && loaded.codec == "PCM" && loaded.frame_count == 96000 &&
+            loaded.waveform == metadata.waveform,
+        "Audio metadata and waveform round-trip");
+  check(!store.load_audio(broken, loaded), "Unreadable sounds have no metadata");
+  store.move("sfx", "sounds");
+  check(store.load_audio(moved, loaded) && !store.load_audio(hit, loaded),
+        "Audio metadata follows moves");
+  store.remove("sounds");
+  check(!store.load_audio(moved, loaded), "And removals");
+
+  std::filesystem::create_directories(TEST_DIR);
+  std::vector<int16_t> values(44100, 16384);
+  std::vector<std::pair<std::string, std::string>> files = {
+      {"tone.wav", make_wav(1, 1, 44100, 16, make_samples_16(values))},
+      {"music.mp3", make_mp3_frames(50)},
+      {"bad.ogg", "not ogg"}};
+  std::vector<FileInfo> assets;
+  for (const auto& file : files) {
+    FileInfo asset;
+    asset.full_path = (std::filesystem::path(TEST_DIR) / file.first).string();
+    asset.name = file.first;
+    asset.extension = std::filesystem::path(file.first).extension().string();
+    asset.type = AssetType::Sound;
+    std::ofstream(asset.full_path, std::ios::binary) << file.second;
+    assets.push_back(asset);
+  }
+
+  std::mutex reported_mutex;
+  std::vector<std::string> reported;
+  MetadataExtractor extractor(store, 2);
+  extractor.set_result_callback([&](const std::string& path) {
+    std::lock_guard<std::mutex> lock(reported_mutex);
+    reported.push_back(path);
+  });
+  extractor.start();
+  extractor.enqueue(assets);
+  extractor.wait_idle();
+  check(extractor.get_stats().extracted == 3 && reported.size() == 3, "Every sound is extracted and reported");
+  check(store.load_audio(assets[0].full_path, loaded) && loaded.frame_count == 44100 &&
+            loaded.waveform.size() == 2 * WAVEFORM_COLUMN_COUNT && loaded.waveform[1] == 63,
+        "WAV files get a stored waveform");
+  check(store.load_audio(assets[1].full_path, loaded) && loaded.codec == "MP3" && loaded.waveform.empty(),
+        "MP3 files get header metadata only");
+  check(!store.load_audio(assets[2].full_path, loaded), "Unreadable sounds are stored as such");
+
+  extractor.enqueue(assets);
+  extractor.wait_idle();
+  check(extractor.get_stats().skipped == 3 && reported.size() == 3, "Unchanged sounds are neither read nor reported");
+  extractor.stop();
+
+  // What the app's sound tiles draw is loaded off their thread
+  AudioPreviewLoader loader(store);
+  std::atomic<int> callbacks(0);
+  loader.set_result_callback([&callbacks] { callbacks++; });
+  std::vector<AudioPreviewResult> previews;
+  loader.request(assets[0].full_path);
+  loader.request(assets[0].full_path);
+  loader.request(assets[2].full_path);
+  loader.start();
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (previews.size() < 2 && std::chrono::steady_clock::now() < deadline) {
+    AudioPreviewResult preview;
+    if (loader.poll(preview)) {
+      previews.push_back(std::move(preview));
+    } else {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  loader.stop();  // Joins the worker, so its callbacks have returned
+  check(previews.size() == 2 && callbacks == 2, "A path requested twice while queued is loaded once");
+  check(previews.size() == 2 && previews[0].path == assets[0].full_path && previews[0].found &&
+            previews[0].metadata.waveform.size() == 2 * WAVEFORM_COLUMN_COUNT,
+        "The stored waveform reaches the preview");
+  check(previews.size() == 2 && previews[1].path == assets[2].full_path && !previews[1].found,
+        "Sounds without metadata come back as misses");
+
+  store.close();
+  database.close();
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Audio Metadata Test\n";
+  std::cout << std::string(50, '-') << '\n';
+
+  test_wav();
+  test_flac();
+  test_ogg();
+  test_mp3();
+  test_store_and_extractor();
+  remove_database(DB_PATH);
+  std::filesystem::remove_all(TEST_DIR);
+
+  std::cout << '\n';
+  if (g_failures == 0) {
+    std::cout << "All checks passed\n";
+    return 0;
+  }
+  std::cout << g_failures << " check(s) failed\n";
+  return 1;
+}
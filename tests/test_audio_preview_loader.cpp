@@ -0,0 +1,121 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/asset_database.h"
+#include "../src/audio_preview_loader.h"
+#include "../src/metadata_store.h"
+#include "test_support.h"
+
+const std::string DB_PATH = "test_audio_preview_loader.db";
+
+AudioMetadata make_audio(uint32_t sample_rate) {
+  AudioMetadata metadata;
+  metadata.codec = "PCM";
+  metadata.sample_rate = sample_rate;
+  metadata.channel_count = 1;
+  metadata.bits_per_sample = 16;
+  metadata.frame_count = sample_rate;
+  metadata.waveform.assign(2 * WAVEFORM_COLUMN_COUNT, 10);
+  return metadata;
+}
+
+// Poll until `count` results arrived or `timeout` passed
+std::vector<AudioPreviewResult> wait_for_results(AudioPreviewLoader& loader, size_t count,
+                                                 std::chrono::milliseconds timeout = std::chrono::seconds(5)) {
+  std::vector<AudioPreviewResult> results;
+  auto deadline = std::chrono::steady_clock::now() + timeout;
+  while (results.size() < count && std::chrono::steady_clock::now() < deadline) {
+    AudioPreviewResult result;
+    if (loader.poll(result)) {
+      results.push_back(std::move(result));
+    } else {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  return results;
+}
+
+void test_requests(MetadataStore& store) {
+  std::cout << "\n=== Requests ===\n";
+  AudioMetadata stored = make_audio(44100);
+  store.store_audio("sounds/a.wav", 100, 1, &stored);
+  store.store_audio("sounds/b.wav", 100, 1, &stored);
+
+  // Queue before the worker runs, so both requests of a.wav are still waiting when the second is made
+  AudioPreviewLoader loader(store);
+  std::atomic<int> callbacks(0);
+  loader.set_result_callback([&callbacks] { callbacks++; });
+  loader.request("sounds/a.wav");
+  loader.request("sounds/a.wav");
+  loader.request("sounds/b.wav");
+  loader.request("sounds/missing.wav");
+  loader.start();
+
+  std::vector<AudioPreviewResult> results = wait_for_results(loader, 3);
+  check(results.size() == 3, "A path requested twice while queued is loaded once");
+  check(results.size() == 3 && results[0].path == "sounds/a.wav" && results[1].path == "sounds/b.wav",
+        "Paths load in request order");
+  check(results.size() == 3 && results[0].found && results[0].metadata.sample_rate == 44100 &&
+            results[0].metadata.waveform.size() == 2 * WAVEFORM_COLUMN_COUNT,
+        "Stored metadata and waveform are loaded");
+  check(results.size() == 3 && !results[2].found, "A path without metadata comes back as a miss");
+  check(wait_for_results(loader, 1, std::chrono::milliseconds(50)).empty(), "Nothing else is loaded");
+
+  // The extractor stored new metadata for a.wav; asking again loads what's stored now
+  AudioMetadata changed = make_audio(48000);
+  store.store_audio("sounds/a.wav", 200, 2, &changed);
+  loader.request("sounds/a.wav");
+  results = wait_for_results(loader, 1);
+  check(results.size() == 1 && results[0].found && results[0].metadata.sample_rate == 48000,
+        "A path requested again after loading is reloaded with the new metadata");
+
+  loader.stop();  // Joins the worker, so its callbacks have returned
+  check(callbacks == 4, "Every finished load is signalled");
+}
+
+void test_stop(MetadataStore& store) {
+  std::cout << "\n=== Stopping ===\n";
+  AudioMetadata stored = make_audio(22050);
+  store.store_audio("sounds/c.wav", 100, 1, &stored);
+
+  AudioPreviewLoader loader(store);
+  loader.request("sounds/a.wav");
+  loader.request("sounds/b.wav");
+  loader.stop();
+  loader.start();
+  check(wait_for_results(loader, 1, std::chrono::milliseconds(100)).empty(), "Stopping drops queued requests");
+
+  // Dropped paths aren't remembered as queued, so they can be requested again
+  loader.request("sounds/a.wav");
+  loader.request("sounds/c.wav");
+  std::vector<AudioPreviewResult> results = wait_for_results(loader, 2);
+  check(results.size() == 2 && results[0].path == "sounds/a.wav" && results[1].path == "sounds/c.wav" &&
+            results[1].metadata.sample_rate == 22050,
+        "A restarted loader takes new requests, including dropped paths");
+  loader.stop();
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Audio Preview Loader Test\n";
+  std::cout << std::string(80, '-') << '\n';
+
+  remove_database(DB_PATH);
+  AssetDatabase database;
+  MetadataStore store;
+  check(database.initialize(DB_PATH) && store.initialize(DB_PATH), "Store opens");
+
+  test_requests(store);
+  test_stop(store);
+
+  store.close();
+  database.close();
+  remove_database(DB_PATH);
+
+  std::cout << '\n' << (g_failures == 0 ? "All checks passed" : "Some checks failed") << '\n';
+  return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,310 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/compressed_texture.h"
+#include "test_support.h"
+
+// Builds a 128-bit BC7 block from the least significant bit on
+class BlockWriter {
+ public:
+  unsigned char data[16] = {};
+
+  void write(int value, int count) {
+    for (int i = 0; i < count; i++, position++) {
+      data[position >> 3] |= static_cast<unsigned char>(((value >> i) & 1) << (position & 7));
+    }
+  }
+
+ private:
+  int position = 0;
+};
+
+bool has_texel(const unsigned char* texels, int index, int red, int green, int blue, int alpha) {
+  const unsigned char* texel = texels + index * 4;
+  return texel[0] == red && texel[1] == green && texel[2] == blue && texel[3] == alpha;
+}
+
+void append_u32(std::vector<unsigned char>& data, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    data.push_back(static_cast<unsigned char>(value >> (8 * i)));
+  }
+}
+
+// A BC1 block of one color, given as RGB565
+void append_bc1_block(std::vector<unsigned char>& data, uint16_t color) {
+  append_u32(data, color | static_cast<uint32_t>(color) << 16);
+  append_u32(data, 0);
+}
+
+void write_file(const std::string& path, const std::vector<unsigned char>& data) {
+  std::ofstream out(path, std::ios::binary);
+  out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+}
+
+// A DDS header for a legacy FourCC or uncompressed format, without the pixel data
+std::vector<unsigned char> make_dds_header(int width, int height, int level_count, const char* fourcc,
+                                           uint32_t bit_count = 0) {
+  std::vector<unsigned char> data = {'D', 'D', 'S', ' '};
+  append_u32(data, 124);
+  append_u32(data, 0x1007 | 0x20000);  // CAPS, HEIGHT, WIDTH, PIXELFORMAT, MIPMAPCOUNT
+  append_u32(data, static_cast<uint32_t>(height));
+  append_u32(data, static_cast<uint32_t>(width));
+  append_u32(data, 0);
+  append_u32(data, 0);
+  append_u32(data, static_cast<uint32_t>(level_count));
+  for (int i = 0; i < 11; i++) {
+    append_u32(data, 0);
+  }
+  append_u32(data, 32);
+  if (fourcc) {
+    append_u32(data, 0x4);
+    data.insert(data.end(), fourcc, fourcc + 4);
+    for (int i = 0; i < 5; i++) {
+      append_u32(data, 0);
+    }
+  } else {
+    append_u32(data, 0x40 | 0x1);  // RGB with alpha, masks of BGRA8
+    append_u32(data, 0);
+    append_u32(data, bit_count);
+    append_u32(data, 0x00FF0000);
+    append_u32(data, 0x0000FF00);
+    append_u32(data, 0x000000FF);
+    append_u32(data, 0xFF000000);
+  }
+  for (int i = 0; i < 5; i++) {
+    append_u32(data, 0);
+  }
+  return data;
+}
+
+// A KTX header, without the key/value data and the levels
+std::vector<unsigned char> make_ktx_header(int width, int height, int level_count, uint32_t gl_type,
+                                           uint32_t gl_format, uint32_t internal_format) {
+  std::vector<unsigned char> data = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x31, 0x31, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+  for (uint32_t value : {0x04030201u, gl_type, gl_type ? 1u : 0u, gl_format, internal_format, gl_format,
+                         static_cast<uint32_t>(width), static_cast<uint32_t>(height), 0u, 0u, 1u,
+                         static_cast<uint32_t>(level_count), 0u}) {
+    append_u32(data, value);
+  }
+  return data;
+}
+
+void test_bc1_to_bc5() {
+  std::cout << "\n=== BC1 to BC5 blocks ===\n";
+  unsigned char texels[64];
+
+  // Red and blue endpoints; texels 0-3 use indices 0-3
+  unsigned char bc1[8] = {0x00, 0xF8, 0x1F, 0x00, 0xE4, 0x00, 0x00, 0x00};
+  check(decode_block(TextureFormat::BC1, bc1, texels), "BC1 blocks decode");
+  check(has_texel(texels, 0, 255, 0, 0, 255) && has_texel(texels, 1, 0, 0, 255, 255) &&
+            has_texel(texels, 2, 170, 0, 85, 255) && has_texel(texels, 3, 85, 0, 170, 255),
+        "BC1 interpolates two colors between its endpoints");
+  check(has_texel(texels, 15, 255, 0, 0, 255), "Texels past the given indices use the first endpoint");
+
+  unsigned char bc1_alpha[8] = {0x1F, 0x00, 0x00, 0xF8, 0xE4, 0x00, 0x00, 0x00};
+  decode_block(TextureFormat::BC1, bc1_alpha, texels);
+  check(has_texel(texels, 2, 127, 0, 127, 255) && has_texel(texels, 3, 0, 0, 0, 0),
+        "BC1 with ordered endpoints has a midpoint and transparent black");
+
+  unsigned char bc3[16] = {255, 0, 0x88, 0xC6, 0xFA, 0, 0, 0};  // Alpha indices 0, 1, 2, 3, 4, 5, 6, 7
+  bc3[8] = bc3[9] = 0xFF;
+  decode_block(TextureFormat::BC3, bc3, texels);
+  check(texels[3] == 255 && texels[7] == 0 && texels[11] == 218 && texels[31] == 36,
+        "BC3 alpha interpolates six values between its endpoints");
+  check(has_texel(texels, 0, 255, 255, 255, 255), "BC3 color never has a transparent entry");
+
+  unsigned char bc2[16] = {0x0F, 0xF0};
+  decode_block(TextureFormat::BC2, bc2, texels);
+  check(texels[3] == 255 && texels[7] == 0 && texels[11] == 0 && texels[15] == 255, "BC2 alpha is explicit");
+
+  unsigned char bc4[8] = {200, 0};
+  decode_block(TextureFormat::BC4, bc4, texels);
+  check(has_texel(texels, 5, 200, 200, 200, 255), "BC4 is shown as gray");
+
+  unsigned char bc5[16] = {128, 0, 0, 0, 0, 0, 0, 0, 128, 0};
+  decode_block(TextureFormat::BC5, bc5, texels);
+  check(has_texel(texels, 0, 128, 128, 255, 255), "BC5 reconstructs blue from a flat normal");
+
+  unsigned char bc4_signed[8] = {0x81, 0x81};  // -127
+  decode_block(TextureFormat::BC4Signed, bc4_signed, texels);
+  check(texels[0] == 0, "Signed BC4 maps -1 to black");
+  check(!decode_block(TextureFormat::RGBA8, bc4, texels), "Uncompressed formats have no blocks");
+}
+
+void test_bc7() {
+  std::cout << "\n=== BC7 blocks ===\n";
+  unsigned char texels[64];
+
+  // Mode 6: one subset, 7-bit RGBA endpoints with a p-bit each, 4-bit indices
+  BlockWriter mode6;
+  mode6.write(1 << 6, 7);
+  for (int value : {127, 0, 0, 127, 0, 0, 127, 127}) {
+    mode6.write(value, 7);
+  }
+  mode6.write(1, 1);
+  mode6.write(1, 1);
+  mode6.write(0, 3);  // Texel 0, the anchor
+  mode6.write(15, 4);
+  mode6.write(8, 4);
+  check(decode_block(TextureFormat::BC7, mode6.data, texels), "BC7 blocks decode");
+  check(has_texel(texels, 0, 255, 1, 1, 255) && has_texel(texels, 1, 1, 255, 1, 255),
+        "Mode 6 endpoints take their p-bits");
+  check(has_texel(texels, 2, 120, 136, 1, 255), "Mode 6 interpolates with 4-bit weights");
+
+  // Mode 1: two subsets split into the top and bottom half by partition 13, red above and blue below
+  BlockWriter mode1;
+  mode1.write(1 << 1, 2);
+  mode1.write(13, 6);
+  for (int value : {63, 63, 0, 0, 0, 0, 0, 0, 0, 0, 63, 63}) {
+    mode1.write(value, 6);
+  }
+  mode1.write(1, 1);
+  mode1.write(1, 1);
+  decode_block(TextureFormat::BC7, mode1.data, texels);
+  check(has_texel(texels, 7, 255, 2, 2, 255) && has_texel(texels, 8, 2, 2, 255, 255),
+        "Mode 1 colors each subset of the partition");
+
+  // Mode 5 with rotation 1 swaps red and alpha
+  BlockWriter mode5;
+  mode5.write(1 << 5, 6);
+  mode5.write(1, 2);
+  for (int value : {0, 0, 127, 127, 0, 0}) {
+    mode5.write(value, 7);
+  }
+  mode5.write(200, 8);
+  mode5.write(200, 8);
+  decode_block(TextureFormat::BC7, mode5.data, texels);
+  check(has_texel(texels, 4, 200, 255, 0, 0), "Rotation swaps alpha with a color channel");
+
+  unsigned char reserved[16] = {};
+  decode_block(TextureFormat::BC7, reserved, texels);
+  check(has_texel(texels, 0, 0, 0, 0, 0), "The reserved mode decodes to transparent black");
+}
+
+void test_dds() {
+  std::cout << "\n=== DDS ===\n";
+  // 16x12 BC1 with a full chain, each level a different color
+  std::vector<unsigned char> data = make_dds_header(16, 12, 5, "DXT1");
+  const uint16_t colors[5] = {0xF800, 0x07E0, 0x001F, 0xFFFF, 0x0000};
+  const int block_counts[5] = {12, 4, 1, 1, 1};
+  for (int level = 0; level < 5; level++) {
+    for (int i = 0; i < block_counts[level]; i++) {
+      append_bc1_block(data, colors[level]);
+    }
+  }
+  write_file("test_texture.dds", data);
+
+  TextureLevel level;
+  std::vector<unsigned char> pixels;
+  check(read_texture_level("test_texture.dds", 0, level) && level.level == 0 && level.width == 16 &&
+            level.height == 12 && level.level_count == 5,
+        "Without a size the full-size level is read");
+  check(read_texture_level("test_texture.dds", 5, level) && level.level == 1 && level.width == 8 &&
+            level.height == 6 && level.data.size() == 4 * 8,
+        "The smallest level covering the size is read");
+  check(decode_texture_level(level, pixels) && pixels.size() == 8 * 6 * 4 && pixels[1] == 255 && pixels[0] == 0,
+        "The level decodes to its own color");
+  check(read_texture_level("test_texture.dds", 2, level) && level.level == 3 && level.width == 2 &&
+            level.height == 1 && decode_texture_level(level, pixels) && pixels.size() == 2 * 4 && pixels[2] == 255,
+        "Levels smaller than a block are cropped");
+  check(read_texture_level("test_texture.dds", 100, level) && level.level == 0,
+        "A texture smaller than the size reads the full-size level");
+
+  data.resize(data.size() - 8);
+  write_file("test_texture.dds", data);
+  check(!read_texture_level("test_texture.dds", 1, level), "A truncated file fails");
+
+  // Uncompressed BGRA with a DX10-less header
+  data = make_dds_header(2, 1, 1, nullptr, 32);
+  for (unsigned char value : {10, 20, 30, 40, 50, 60, 70, 80}) {
+    data.push_back(value);
+  }
+  write_file("test_texture.dds", data);
+  check(read_texture_level("test_texture.dds", 0, level) && level.format == TextureFormat::BGRA8 &&
+            decode_texture_level(level, pixels) && pixels[0] == 30 && pixels[2] == 10 && pixels[7] == 80,
+        "Uncompressed BGRA is swizzled to RGBA");
+
+  // BC7 through the DX10 header
+  data = make_dds_header(4, 4, 1, "DX10");
+  for (uint32_t value : {98u, 3u, 0u, 1u, 0u}) {
+    append_u32(data, value);
+  }
+  std::vector<unsigned char> block(16, 0);
+  block[0] = 1 << 6;
+  data.insert(data.end(), block.begin(), block.end());
+  write_file("test_texture.dds", data);
+  check(read_texture_level("test_texture.dds", 0, level) && level.format == TextureFormat::BC7,
+        "DX10 headers give the format");
+
+  data = make_dds_header(4, 4, 1, "DX10");
+  for (uint32_t value : {95u, 3u, 0u, 1u, 0u}) {  // BC6H_UF16
+    append_u32(data, value);
+  }
+  data.insert(data.end(), block.begin(), block.end());
+  write_file("test_texture.dds", data);
+  check(!read_texture_level("test_texture.dds", 0, level), "BC6H isn't read");
+  std::remove("test_texture.dds");
+}
+
+void test_ktx() {
+  std::cout << "\n=== KTX ===\n";
+  // 8x8 BC1 with four levels
+  std::vector<unsigned char> data = make_ktx_header(8, 8, 4, 0, 0, 0x83F0);
+  const uint16_t colors[4] = {0xF800, 0x07E0, 0x001F, 0xFFFF};
+  const int block_counts[4] = {4, 1, 1, 1};
+  for (int level = 0; level < 4; level++) {
+    append_u32(data, static_cast<uint32_t>(block_counts[level] * 8));
+    for (int i = 0; i < block_counts[level]; i++) {
+      append_bc1_block(data, colors[level]);
+    }
+  }
+  write_file("test_texture.ktx", data);
+
+  TextureLevel level;
+  std::vector<unsigned char> pixels;
+  check(read_texture_level("test_texture.ktx", 2, level) && level.level == 2 && level.width == 2 &&
+            decode_texture_level(level, pixels) && pixels[2] == 255 && pixels[0] == 0,
+        "Levels are found by their sizes");
+
+  // RGB rows are padded to 4 bytes
+  data = make_ktx_header(3, 2, 1, 0x1401, 0x1907, 0x8051);
+  append_u32(data, 24);
+  for (int row = 0; row < 2; row++) {
+    for (int i = 0; i < 9; i++) {
+      data.push_back(static_cast<unsigned char>(row * 100 + i));
+    }
+    data.insert(data.end(), 3, 0);
+  }
+  write_file("test_texture.ktx", data);
+  check(read_texture_level("test_texture.ktx", 0, level) && level.format == TextureFormat::RGB8 &&
+            decode_texture_level(level, pixels) && pixels[12] == 100 && pixels[15] == 255 && pixels[22] == 108,
+        "Padded RGB rows decode");
+  std::remove("test_texture.ktx");
+
+  check(is_container_texture("textures/rock.DDS") && is_container_texture("rock.ktx") &&
+            !is_container_texture("rock.png"),
+        "DDS and KTX files are recognized by extension");
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Compressed Texture Test\n";
+  std::cout << std::string(50, '-') << '\n';
+
+  test_bc1_to_bc5();
+  test_bc7();
+  test_dds();
+  test_ktx();
+
+  std::cout << '\n';
+  if (g_failures == 0) {
+    std::cout << "All checks passed\n";
+    return 0;
+  }
+  std::cout << g_failures << " check(s) failed\n";
+  return 1;
+}
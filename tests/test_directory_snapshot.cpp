@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/directory_snapshot.h"
+#include "../src/event_coalescer.h"
+#include "../src/event_filter.h"
+#include "test_support.h"
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+const std::string ROOT = "test_directory_snapshot_root";
+
+std::string root_path(const std::string& relative) { return (fs::path(ROOT) / relative).string(); }
+
+// Directory mtimes come from a coarse clock, so a change made right after a capture could leave them equal
+void wait_for_clock_tick() { std::this_thread::sleep_for(std::chrono::milliseconds(50)); }
+
+// A fresh tree: two textures, a model in a nested directory, a temp file and an empty directory
+void make_tree() {
+  fs::remove_all(ROOT);
+  write_file(root_path("textures/grass.png"), "grass");
+  write_file(root_path("textures/rock.png"), "rock");
+  write_file(root_path("models/props/crate.fbx"), "crate");
+  write_file(root_path("models/scratch.tmp"), "tmp");
+  fs::create_directories(root_path("empty"));
+}
+
+const char* get_type_name(FileEventType type) {
+  switch (type) {
+    case FileEventType::Created:
+      return "Created";
+    case FileEventType::Modified:
+      return "Modified";
+    case FileEventType::Deleted:
+      return "Deleted";
+    case FileEventType::Renamed:
+      return "Renamed";
+    case FileEventType::DirectoryCreated:
+      return "DirectoryCreated";
+    case FileEventType::DirectoryDeleted:
+      return "DirectoryDeleted";
+  }
+  return "?";
+}
+
+// Changes as "Type path" lines, in the order they were reported
+std::vector<std::string> describe(const std::vector<SnapshotChange>& changes) {
+  std::vector<std::string> lines;
+  for (const auto& change : changes) {
+    lines.push_back(std::string(get_type_name(change.type)) + " " + change.path);
+  }
+  return lines;
+}
+
+std::vector<std::string> describe(const std::vector<FileEvent>& events) {
+  std::vector<std::string> lines;
+  for (const auto& event : events) {
+    lines.push_back(std::string(get_type_name(event.type)) + " " + event.path +
+                    (event.old_path.empty() ? "" : " from " + event.old_path));
+  }
+  std::sort(lines.begin(), lines.end());
+  return lines;
+}
+
+void print_lines(const std::vector<std::string>& lines) {
+  for (const auto& line : lines) {
+    std::cout << "         " << line << '\n';
+  }
+}
+
+bool expect_lines(const std::vector<std::string>& actual, const std::vector<std::string>& expected) {
+  if (actual != expected) {
+    std::cout << "       got:\n";
+    print_lines(actual);
+  }
+  return actual == expected;
+}
+
+void test_capture() {
+  std::cout << "\n=== Capture ===\n";
+  make_tree();
+  EventFilter filter;
+  filter.add_ignore_pattern("*.tmp");
+  DirectorySnapshot snapshot;
+  snapshot.set_filter(&filter);
+  snapshot.capture(ROOT);
+
+  check(snapshot.size() == 8, "Every entry is recorded, the root included and the ignored file left out");
+  check(snapshot.is_directory(root_path("models/props")) && !snapshot.is_directory(root_path("textures/rock.png")),
+        "Directories are told apart from files");
+  std::vector<std::string> directories = snapshot.get_directories();
+  check(directories == std::vector<std::string>({ROOT, root_path("empty"), root_path("models"),
+                                                  root_path("models/props"), root_path("textures")}),
+        "Directories are listed in path order");
+  check(snapshot.resync_subtree(ROOT).empty(), "A resync of an unchanged tree reports nothing");
+}
+
+void test_resync_subtree() {
+  std::cout << "\n=== Subtree resync ===\n";
+  make_tree();
+  DirectorySnapshot snapshot;
+  snapshot.capture(ROOT);
+  wait_for_clock_tick();
+
+  write_file(root_path("textures/grass.png"), "grass, now larger");
+  fs::remove(root_path("textures/rock.png"));
+  write_file(root_path("textures/sand.png"), "sand");
+  fs::rename(root_path("models/props"), root_path("models/set"));
+  fs::remove_all(root_path("empty"));
+  write_file(root_path("empty"), "a file where a directory was");
+
+  std::vector<SnapshotChange> changes = snapshot.resync_subtree(ROOT);
+  check(expect_lines(describe(changes), {"DirectoryDeleted " + root_path("empty"),
+                                         "Created " + root_path("empty"),
+                                         "DirectoryDeleted " + root_path("models/props"),
+                                         "Modified " + root_path("textures/grass.png"),
+                                         "Deleted " + root_path("textures/rock.png"),
+                                         "DirectoryCreated " + root_path("models/set"),
+                                         "Created " + root_path("textures/sand.png")}),
+        "Removals, type changes and modifications come first, then additions; directories count once");
+  check(snapshot.resync_subtree(ROOT).empty(), "A second resync converges to no changes");
+  check(snapshot.resync_changed_directories({}).empty(), "Nor does the directory pass find anything left");
+
+  // Only the subtree passed is looked at
+  wait_for_clock_tick();
+  write_file(root_path("textures/grass.png"), "grass, changed once more");
+  write_file(root_path("models/set/barrel.fbx"), "barrel");
+  changes = snapshot.resync_subtree(root_path("models"));
+  check(expect_lines(describe(changes), {"Created " + root_path("models/set/barrel.fbx")}),
+        "A subtree resync leaves the rest of the tree alone");
+  changes = snapshot.resync_subtree(root_path("textures"));
+  check(expect_lines(describe(changes), {"Modified " + root_path("textures/grass.png")}),
+        "The rest is found by resyncing its own subtree");
+}
+
+void test_resync_changed_directories() {
+  std::cout << "\n=== Changed directory listing ===\n";
+  make_tree();
+  DirectorySnapshot snapshot;
+  snapshot.capture(ROOT);
+  wait_for_clock_tick();
+
+  write_file(root_path("textures/grass.png"), "grass, modified in place");
+  write_file(root_path("textures/dirt.png"), "dirt");
+  fs::remove(root_path("models/props/crate.fbx"));
+  write_file(root_path("models/new/tree.fbx"), "tree");
+  fs::rename(root_path("empty"), root_path("renamed"));
+
+  std::vector<SnapshotChange> changes = snapshot.resync_changed_directories({});
+  check(expect_lines(describe(changes), {"DirectoryDeleted " + root_path("empty"),
+                                         "DirectoryCreated " + root_path("renamed"),
+                                         "DirectoryCreated " + root_path("models/new"),
+                                         "Deleted " + root_path("models/props/crate.fbx"),
+                                         "Modified " + root_path("textures/grass.png"),
+                                         "Created " + root_path("textures/dirt.png")}),
+        "Listing the directories whose mtime moved finds creates, deletes, renames and their siblings' changes");
+  check(snapshot.is_directory(root_path("models/new")) && snapshot.size() == 11,
+        "New directories are recorded with their subtree");
+  check(snapshot.resync_changed_directories({}).empty() && snapshot.resync_subtree(ROOT).empty(),
+        "A second resync converges to no changes");
+
+  wait_for_clock_tick();
+  write_file(root_path("textures/stone.png"), "stone");
+  write_file(root_path("models/pine.fbx"), "pine");
+  changes = snapshot.resync_changed_directories({root_path("models")});
+  check(expect_lines(describe(changes), {"Created " + root_path("textures/stone.png")}),
+        "Skipped subtrees aren't listed");
+}
+
+void test_apply() {
+  std::cout << "\n=== Applying delivered events ===\n";
+  make_tree();
+  DirectorySnapshot snapshot;
+  snapshot.capture(ROOT);
+  wait_for_clock_tick();
+
+  // Each change is reported to the snapshot as the watcher would deliver it
+  fs::rename(root_path("models/props"), root_path("models/set"));
+  snapshot.apply(FileEvent(FileEventType::Renamed, root_path("models/set"), root_path("models/props")));
+  check(snapshot.is_directory(root_path("models/set")) && !snapshot.is_directory(root_path("models/props")),
+        "A renamed directory moves in the snapshot");
+
+  fs::rename(root_path("textures/rock.png"), root_path("textures/boulder.png"));
+  snapshot.apply(FileEvent(FileEventType::Renamed, root_path("textures/boulder.png"), root_path("textures/rock.png")));
+
+  write_file(root_path("sounds/wind/gust.wav"), "gust");
+  snapshot.apply(FileEvent(FileEventType::DirectoryCreated, root_path("sounds")));
+  check(snapshot.is_directory(root_path("sounds/wind")), "A created directory is recorded with its subtree");
+
+  write_file(root_path("textures/grass.png"), "grass, modified");
+  snapshot.apply(FileEvent(FileEventType::Modified, root_path("textures/grass.png")));
+
+  fs::remove_all(root_path("empty"));
+  snapshot.apply(FileEvent(FileEventType::DirectoryDeleted, root_path("empty")));
+
+  check(snapshot.resync_subtree(ROOT).empty(), "After the events, the snapshot matches the disk");
+  check(snapshot.resync_changed_directories({}).empty(),
+        "Parent mtimes were recorded, so no directory is listed again for nothing");
+}
+
+void test_overflow_recovery() {
+  std::cout << "\n=== Overflow recovery ===\n";
+  auto now = Clock::now();
+  auto window = std::chrono::milliseconds(2000);
+
+  RecentDirectories recent;
+  recent.emplace_back(root_path("models/props"), now - std::chrono::milliseconds(100));
+  recent.emplace_back(root_path("models"), now - std::chrono::milliseconds(50));
+  recent.emplace_back(root_path("textures"), now - std::chrono::seconds(10));
+  check(select_resync_subtrees(ROOT, recent, now, window, 16) == std::vector<std::string>({root_path("models")}),
+        "Only the outermost recently active directories are picked");
+  check(select_resync_subtrees(ROOT, RecentDirectories(), now, window, 16) == std::vector<std::string>({ROOT}),
+        "Without recent activity the whole root is resynced");
+  recent.emplace_back(root_path("sounds"), now);
+  check(select_resync_subtrees(ROOT, recent, now, window, 1) == std::vector<std::string>({ROOT}),
+        "Too many subtrees fall back to the whole root");
+
+  // The watcher's path: the snapshot is diffed and the changes are fed through the coalescer
+  make_tree();
+  DirectorySnapshot snapshot;
+  snapshot.capture(ROOT);
+  EventCoalescer coalescer;
+  for (const auto& directory : snapshot.get_directories()) {
+    coalescer.add_known_directory(directory);
+  }
+  wait_for_clock_tick();
+
+  fs::remove_all(root_path("models/props"));
+  write_file(root_path("models/tree.fbx"), "tree");
+  write_file(root_path("readme.txt"), "readme");
+  write_file(root_path("textures/grass.png"), "grass, modified in place");
+
+  recent.clear();
+  recent.emplace_back(root_path("models"), now);
+  std::vector<std::string> subtrees = select_resync_subtrees(ROOT, recent, now, window, 16);
+  std::vector<SnapshotChange> changes = snapshot.resync(subtrees);
+  for (const auto& change : changes) {
+    coalescer.push(change.type, change.path, "", change.is_directory, now);
+  }
+  std::vector<FileEvent> events = coalescer.flush_all();
+  check(expect_lines(describe(events), {"Created " + root_path("models/tree.fbx"),
+                                        "Created " + root_path("readme.txt"),
+                                        "DirectoryDeleted " + root_path("models/props")}),
+        "The active subtree is re-stat'ed, new files elsewhere are listed, and a lost subtree is one delete");
+  check(expect_lines(describe(snapshot.resync({ROOT})), {"Modified " + root_path("textures/grass.png")}),
+        "An in-place change in a directory that wasn't active is left to a full resync");
+  check(snapshot.resync({ROOT}).empty(), "After which the snapshot has converged");
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Directory Snapshot Test\n";
+  std::cout << std::string(50, '-') << '\n';
+
+  test_capture();
+  test_resync_subtree();
+  test_resync_changed_directories();
+  test_apply();
+  test_overflow_recovery();
+  fs::remove_all(ROOT);
+
+  std::cout << '\n';
+  if (g_failures == 0) {
+    std::cout << "All checks passed\n";
+    return 0;
+  }
+  std::cout << g_failures << " check(s) failed\n";
+  return 1;
+}
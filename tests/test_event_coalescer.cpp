@@ -0,0 +1,159 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/event_coalescer.h"
+#include "test_support.h"
+
+using Clock = EventCoalescer::Clock;
+
+// Flush well after the debounce timeout so every settled entry comes out
+std::vector<FileEvent> settle(EventCoalescer& coalescer, Clock::time_point start) {
+  return coalescer.flush_ready(start + std::chrono::seconds(10));
+}
+
+bool has_event(const std::vector<FileEvent>& events, FileEventType type, const std::string& path,
+               const std::string& old_path = "") {
+  for (const auto& event : events) {
+    if (event.type == type && event.path == path && event.old_path == old_path) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void test_file_sequences() {
+  std::cout << "\n=== File sequences ===\n";
+  auto now = Clock::now();
+
+  EventCoalescer coalescer;
+  coalescer.push(FileEventType::Created, "root/a.png", "", false, now);
+  coalescer.push(FileEventType::Modified, "root/a.png", "", false, now);
+  coalescer.push(FileEventType::Modified, "root/a.png", "", false, now);
+  auto events = settle(coalescer, now);
+  check(events.size() == 1 && has_event(events, FileEventType::Created, "root/a.png"),
+        "Created + Modified* collapses to Created");
+
+  coalescer.push(FileEventType::Created, "root/tmp.txt", "", false, now);
+  coalescer.push(FileEventType::Deleted, "root/tmp.txt", "", false, now);
+  events = settle(coalescer, now);
+  check(events.empty(), "Created + Deleted cancels out");
+
+  coalescer.push(FileEventType::Deleted, "root/b.png", "", false, now);
+  coalescer.push(FileEventType::Created, "root/b.png", "", false, now);
+  events = settle(coalescer, now);
+  check(events.size() == 1 && has_event(events, FileEventType::Modified, "root/b.png"),
+        "Deleted + Created (atomic save) becomes Modified");
+
+  coalescer.push(FileEventType::Renamed, "root/b", "root/a", false, now);
+  coalescer.push(FileEventType::Renamed, "root/c", "root/b", false, now);
+  events = settle(coalescer, now);
+  check(events.size() == 1 && has_event(events, FileEventType::Renamed, "root/c", "root/a"),
+        "Rename chain A -> B -> C collapses to one rename");
+
+  coalescer.push(FileEventType::Created, "root/new", "", false, now);
+  coalescer.push(FileEventType::Renamed, "root/final", "root/new", false, now);
+  events = settle(coalescer, now);
+  check(events.size() == 1 && has_event(events, FileEventType::Created, "root/final"),
+        "Created then renamed becomes Created at the final path");
+
+  coalescer.push(FileEventType::Renamed, "root/b", "root/a", false, now);
+  coalescer.push(FileEventType::Deleted, "root/b", "", false, now);
+  events = settle(coalescer, now);
+  check(events.size() == 1 && has_event(events, FileEventType::Deleted, "root/a"),
+        "Renamed then deleted becomes Deleted at the original path");
+}
+
+void test_debounce() {
+  std::cout << "\n=== Debounce ===\n";
+  auto now = Clock::now();
+
+  EventCoalescer coalescer(std::chrono::milliseconds(500));
+  coalescer.push(FileEventType::Modified, "root/a.png", "", false, now);
+  check(coalescer.flush_ready(now + std::chrono::milliseconds(100)).empty(), "Nothing is emitted before the timeout");
+
+  coalescer.push(FileEventType::Modified, "root/a.png", "", false, now + std::chrono::milliseconds(400));
+  check(coalescer.flush_ready(now + std::chrono::milliseconds(600)).empty(), "New activity restarts the timeout");
+  check(coalescer.flush_ready(now + std::chrono::milliseconds(900)).size() == 1, "Emitted once the path is idle");
+}
+
+void test_directory_operations() {
+  std::cout << "\n=== Directory operations ===\n";
+  auto now = Clock::now();
+
+  EventCoalescer coalescer;
+  coalescer.push(FileEventType::DirectoryCreated, "root/unpacked", "", true, now);
+  for (int i = 0; i < 1000; i++) {
+    coalescer.push(FileEventType::Created, "root/unpacked/file" + std::to_string(i) + ".png", "", false, now);
+    coalescer.push(FileEventType::Modified, "root/unpacked/file" + std::to_string(i) + ".png", "", false, now);
+  }
+  auto events = settle(coalescer, now);
+  check(events.size() == 1 && has_event(events, FileEventType::DirectoryCreated, "root/unpacked"),
+        "Unpacking an archive produces a single DirectoryCreated");
+
+  coalescer.add_known_directory("root/build");
+  for (int i = 0; i < 1000; i++) {
+    coalescer.push(FileEventType::Deleted, "root/build/obj" + std::to_string(i) + ".o", "", false, now);
+  }
+  coalescer.push(FileEventType::Deleted, "root/build", "", false, now);
+  events = settle(coalescer, now);
+  check(events.size() == 1 && has_event(events, FileEventType::DirectoryDeleted, "root/build"),
+        "Deleting a known directory produces a single DirectoryDeleted");
+
+  for (int i = 0; i < 10; i++) {
+    coalescer.push(FileEventType::Deleted, "root/unknown/f" + std::to_string(i), "", false, now);
+  }
+  coalescer.push(FileEventType::Deleted, "root/unknown", "", false, now);
+  events = settle(coalescer, now);
+  check(events.size() == 1 && has_event(events, FileEventType::DirectoryDeleted, "root/unknown"),
+        "A deleted path with pending children is treated as a directory");
+
+  coalescer.push(FileEventType::DirectoryCreated, "root/scratch", "", true, now);
+  coalescer.push(FileEventType::Created, "root/scratch/x.tmp", "", false, now);
+  coalescer.push(FileEventType::Deleted, "root/scratch", "", false, now);
+  events = settle(coalescer, now);
+  check(events.empty(), "Directory created and deleted within the window cancels out");
+
+  coalescer.add_known_directory("root/textures");
+  coalescer.push(FileEventType::Modified, "root/textures/wood.png", "", false, now);
+  coalescer.push(FileEventType::Renamed, "root/materials", "root/textures", true, now);
+  events = settle(coalescer, now);
+  check(events.size() == 2 && events[0].type == FileEventType::Renamed && events[0].path == "root/materials" &&
+            events[0].old_path == "root/textures" && events[1].path == "root/materials/wood.png",
+        "Directory rename is emitted before the events it carries along");
+
+  coalescer.push(FileEventType::Modified, "root/materials", "", false, now);
+  events = settle(coalescer, now);
+  check(events.empty(), "Modifications reported on directories are dropped");
+}
+
+void test_held_children() {
+  std::cout << "\n=== Children wait for their directory ===\n";
+  auto now = Clock::now();
+
+  EventCoalescer coalescer(std::chrono::milliseconds(500));
+  coalescer.add_known_directory("root/dir");
+  coalescer.push(FileEventType::Modified, "root/dir/a.png", "", false, now);
+  coalescer.push(FileEventType::Renamed, "root/moved", "root/dir", true, now + std::chrono::milliseconds(300));
+
+  auto events = coalescer.flush_ready(now + std::chrono::milliseconds(600));
+  check(events.empty(), "Child is held while the directory rename is still settling");
+
+  events = coalescer.flush_ready(now + std::chrono::milliseconds(900));
+  check(events.size() == 2 && events[0].path == "root/moved", "Both are emitted together once settled");
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Event Coalescer Test\n";
+  std::cout << std::string(80, '-') << '\n';
+
+  test_file_sequences();
+  test_debounce();
+  test_directory_operations();
+  test_held_children();
+
+  std::cout << '\n' << (g_failures == 0 ? "All checks passed" : "Some checks failed") << '\n';
+  return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/event_filter.h"
+#include "test_support.h"
+
+uint64_t hits_for(const EventFilter& filter, const std::string& rule) {
+  for (const auto& stats : filter.get_stats()) {
+    if (stats.rule == rule) {
+      return stats.hits;
+    }
+  }
+  return 0;
+}
+
+void test_component_rules() {
+  std::cout << "\n=== Name rules ===\n";
+
+  EventFilter filter;
+  filter.add_ignore_pattern("*.tmp");
+  filter.add_ignore_pattern("~*");
+  filter.add_ignore_pattern("Thumbs.db");
+  filter.add_ignore_pattern("*.blend?");
+
+  check(filter.is_ignored("textures/wood.tmp"), "Suffix rule matches a file in a subdirectory");
+  check(filter.is_ignored("WOOD.TMP"), "Matching is case-insensitive");
+  check(filter.is_ignored("docs\\~report.docx"), "Prefix rule matches with Windows separators");
+  check(filter.is_ignored("thumbs.db"), "Exact rule matches the whole name");
+  check(!filter.is_ignored("mythumbs.db"), "Exact rule does not match a longer name");
+  check(filter.is_ignored("models/ship.blend1") && !filter.is_ignored("models/ship.blend"),
+        "Glob rule matches backups but not the original");
+  check(filter.is_ignored("cache.tmp/inner.png"), "A matching directory name also ignores its contents");
+  check(!filter.is_ignored("textures/wood.png"), "Other paths get through");
+
+  check(hits_for(filter, "*.tmp") == 3 && hits_for(filter, "~*") == 1 && hits_for(filter, "*.blend?") == 1,
+        "Hits are counted per rule");
+}
+
+void test_path_rules() {
+  std::cout << "\n=== Path rules ===\n";
+
+  EventFilter filter;
+  filter.add_ignore_pattern("**/.git/**");
+  filter.add_ignore_pattern("build/*.o");
+
+  check(filter.is_ignored(".git/objects/ab/cdef"), "'**/' matches zero directories");
+  check(filter.is_ignored("vendor/lib/.git/HEAD"), "'**/' matches nested directories");
+  check(filter.is_ignored(".git"), "Trailing '/**' matches the directory itself");
+  check(!filter.is_ignored("my.git/file"), "Partial component names do not match");
+  check(filter.is_ignored("build/main.o"), "Anchored rule matches at the root");
+  check(!filter.is_ignored("build/sub/main.o"), "'*' does not cross separators");
+  check(!filter.is_ignored("src/build/main.o"), "Anchored rule does not match deeper");
+  check(!filter.excludes("textures", true) && filter.excludes(".git", true), "excludes() agrees with the rules");
+  check(hits_for(filter, "**/.git/**") == 3, "excludes() does not count hits");
+}
+
+void test_extensions() {
+  std::cout << "\n=== Extension allow-list ===\n";
+
+  EventFilter filter;
+  filter.set_extensions({".png", "FBX"});
+
+  check(filter.accepts("textures/wood.PNG", false), "Allowed extension is accepted case-insensitively");
+  check(filter.accepts("models/ship.fbx", false), "Extension given without a dot is accepted");
+  check(!filter.accepts("notes.txt", false), "Other extensions are rejected");
+  check(!filter.accepts("v1.png/README", false), "Only the last component's extension counts");
+  check(filter.accepts("textures", true), "Directories are never rejected by extension");
+  check(hits_for(filter, "extension allow-list") == 2, "Rejections are counted on the allow-list");
+}
+
+void test_renames() {
+  std::cout << "\n=== Renames ===\n";
+
+  EventFilter filter;
+  filter.add_ignore_pattern("*.tmp");
+
+  check(filter.filter_rename("a.png", "b.png", false) == RenameFilterResult::Keep, "Plain rename is kept");
+  check(filter.filter_rename("save.tmp", "scene.png", false) == RenameFilterResult::AsCreated,
+        "Atomic save through a temp file becomes a creation");
+  check(filter.filter_rename("scene.png", "scene.tmp", false) == RenameFilterResult::AsDeleted,
+        "Renaming to an ignored name becomes a deletion");
+  check(filter.filter_rename("a.tmp", "b.tmp", false) == RenameFilterResult::Drop,
+        "Renames between ignored names are dropped");
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Event Filter Test\n";
+  std::cout << std::string(80, '-') << '\n';
+
+  test_component_rules();
+  test_path_rules();
+  test_extensions();
+  test_renames();
+
+  std::cout << '\n' << (g_failures == 0 ? "All checks passed" : "Some checks failed") << '\n';
+  return g_failures == 0 ? 0 : 1;
+}
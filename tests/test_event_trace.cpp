@@ -0,0 +1,150 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/event_trace.h"
+#include "test_support.h"
+
+using Clock = EventTraceWriter::Clock;
+
+const std::string TRACE_PATH = "test_event_trace.trace";
+
+// A short storm: a save through a temp file, a file created and modified, a known directory deleted, and a
+// late modification after everything else settled
+void write_storm(std::chrono::milliseconds debounce_timeout) {
+  EventTraceWriter writer;
+  writer.open(TRACE_PATH, debounce_timeout);
+  auto start = Clock::now();
+  auto at = [start](int ms) { return start + std::chrono::milliseconds(ms); };
+
+  writer.add_root(1, "assets", at(0));
+  writer.add_known_directory(1, "assets/old", at(0));
+  writer.record_event(1, FileEventType::Created, "assets/scene.tmp", "", false, at(10));
+  writer.record_event(1, FileEventType::Renamed, "assets/scene.png", "assets/scene.tmp", false, at(20));
+  writer.record_event(1, FileEventType::Created, "assets/textures/wood.png", "", false, at(30));
+  writer.record_event(1, FileEventType::Modified, "assets/textures/wood.png", "", false, at(40));
+  writer.record_event(1, FileEventType::Deleted, "assets/old/a.png", "", false, at(50));
+  writer.record_event(1, FileEventType::Deleted, "assets/old", "", false, at(60));
+  writer.record_overflow(1, at(70));
+  writer.record_event(1, FileEventType::Modified, "assets/scene.png", "", false, at(1000));
+  writer.remove_root(1, at(1600));
+}
+
+std::vector<TraceRecord> read_all(const std::string& path, bool& error) {
+  std::vector<TraceRecord> records;
+  EventTraceReader reader;
+  error = !reader.open(path);
+  TraceRecord record;
+  while (!error && reader.next(record)) {
+    records.push_back(record);
+  }
+  error = error || reader.has_error();
+  return records;
+}
+
+std::vector<std::string> replay(ReplaySpeed speed, ReplayStats& stats) {
+  std::vector<std::string> delivered;
+  EventTracePlayer player;
+  player.replay(TRACE_PATH, speed, [&delivered](const FileEvent& event) {
+    delivered.push_back(std::to_string(static_cast<int>(event.type)) + ' ' + event.path + ' ' + event.old_path);
+  });
+  stats = player.get_stats();
+  return delivered;
+}
+
+void test_round_trip() {
+  std::cout << "\n=== Round trip ===\n";
+  write_storm(std::chrono::milliseconds(100));
+
+  bool error = false;
+  std::vector<TraceRecord> records = read_all(TRACE_PATH, error);
+  check(!error && records.size() == 11, "All records are read back");
+  if (records.size() != 11) {
+    return;
+  }
+  check(records[0].kind == TraceRecordKind::RootAdded && records[0].path == "assets", "Root is recorded");
+  check(records[1].kind == TraceRecordKind::KnownDirectory && records[1].path == "assets/old",
+        "Known directory is recorded");
+  check(records[3].type == FileEventType::Renamed && records[3].path == "assets/scene.png" &&
+            records[3].old_path == "assets/scene.tmp",
+        "Prefix-compressed paths are restored");
+  check(records[9].offset - records[4].offset == std::chrono::milliseconds(970),
+        "Offsets are restored from the deltas");
+  check(records[8].kind == TraceRecordKind::Overflow && records[10].kind == TraceRecordKind::RootRemoved,
+        "Overflow and removal are recorded");
+
+  EventTraceReader reader;
+  reader.open(TRACE_PATH);
+  check(reader.get_debounce_timeout() == std::chrono::milliseconds(100), "Debounce timeout is stored in the header");
+}
+
+void test_replay() {
+  std::cout << "\n=== Replay ===\n";
+  write_storm(std::chrono::milliseconds(100));
+
+  ReplayStats stats;
+  std::vector<std::string> delivered = replay(ReplaySpeed::Max, stats);
+  std::vector<std::string> expected = {
+      "0 assets/scene.png ",          // Created(tmp) + rename -> Created
+      "0 assets/textures/wood.png ",  // Created + Modified -> Created
+      "5 assets/old ",                // Known directory deleted -> DirectoryDeleted, settles last
+      "1 assets/scene.png ",          // The late modification settles on its own
+  };
+  check(delivered == expected, "Net events match the coalescer's rules");
+  check(stats.raw_events == 7 && stats.delivered_events == 4 && stats.overflows == 1 && stats.records == 11,
+        "Replay counters add up");
+  check(stats.trace_duration >= std::chrono::milliseconds(1600) &&
+            stats.trace_duration < std::chrono::milliseconds(1700),
+        "Trace duration covers the recording");
+  check(stats.wall_time < std::chrono::milliseconds(500), "Max speed does not sleep");
+
+  ReplayStats second_stats;
+  check(replay(ReplaySpeed::Max, second_stats) == delivered, "Replays are deterministic");
+
+  ReplayStats original_stats;
+  check(replay(ReplaySpeed::Original, original_stats) == delivered, "Original speed delivers the same events");
+  check(original_stats.wall_time >= std::chrono::milliseconds(1000), "Original speed keeps the recorded pacing");
+}
+
+void test_malformed() {
+  std::cout << "\n=== Malformed traces ===\n";
+  write_storm(std::chrono::milliseconds(100));
+
+  // Cut the file in the middle of a record
+  std::string contents;
+  {
+    std::ifstream in(TRACE_PATH, std::ios::binary);
+    contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream out(TRACE_PATH, std::ios::binary | std::ios::trunc);
+    out.write(contents.data(), static_cast<std::streamsize>(contents.size() / 2));
+  }
+  bool error = false;
+  read_all(TRACE_PATH, error);
+  check(error, "Truncated trace is reported");
+
+  {
+    std::ofstream out(TRACE_PATH, std::ios::binary | std::ios::trunc);
+    out << "not a trace";
+  }
+  EventTracePlayer player;
+  check(!player.replay(TRACE_PATH, ReplaySpeed::Max, nullptr), "Replay refuses a file without the header");
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Event Trace Test\n";
+  std::cout << std::string(80, '-') << '\n';
+
+  test_round_trip();
+  test_replay();
+  test_malformed();
+  std::remove(TRACE_PATH.c_str());
+
+  std::cout << '\n' << (g_failures == 0 ? "All checks passed" : "Some checks failed") << '\n';
+  return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,177 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/file_watcher.h"
+#include "test_support.h"
+
+namespace fs = std::filesystem;
+
+const std::string TEXTURE_ROOT = "test_file_watcher_textures";
+const std::string SOUND_ROOT = "test_file_watcher_sounds";
+
+// Events settle after the watcher's 500 ms debounce; this is how long a test waits for them at most
+constexpr auto EVENT_TIMEOUT = std::chrono::seconds(5);
+
+std::string path_in(const std::string& root, const std::string& name) { return (fs::path(root) / name).string(); }
+
+// Events delivered by the watcher's timer thread, read from the test thread
+class EventLog {
+ public:
+  void add(const FileEvent& event) {
+    std::lock_guard<std::mutex> lock(mutex);
+    events.push_back(event);
+  }
+
+  std::vector<FileEvent> get() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return events;
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    events.clear();
+  }
+
+  std::optional<FileEvent> find(const std::string& path) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& event : events) {
+      if (event.path == path) {
+        return event;
+      }
+    }
+    return std::nullopt;
+  }
+
+  // Poll until `condition` holds or the timeout passes
+  bool wait_for(const std::function<bool()>& condition) const {
+    auto deadline = std::chrono::steady_clock::now() + EVENT_TIMEOUT;
+    while (!condition()) {
+      if (std::chrono::steady_clock::now() >= deadline) {
+        return false;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    return true;
+  }
+
+ private:
+  mutable std::mutex mutex;
+  std::vector<FileEvent> events;
+};
+
+uint64_t get_filter_hits(const std::vector<FilterRuleStats>& stats) {
+  uint64_t hits = 0;
+  for (const auto& rule : stats) {
+    hits += rule.hits;
+  }
+  return hits;
+}
+
+void test_roots() {
+  std::cout << "\n=== Roots with their own filters ===\n";
+  fs::remove_all(TEXTURE_ROOT);
+  fs::remove_all(SOUND_ROOT);
+  fs::create_directories(TEXTURE_ROOT);
+  fs::create_directories(SOUND_ROOT);
+
+  FileWatcher watcher;
+  EventLog log;
+  WatchRootOptions texture_options;
+  texture_options.extensions = {".png"};
+  int texture_root = watcher.add_root(TEXTURE_ROOT, texture_options);
+  check(texture_root > 0, "A root added before start() gets an id");
+  check(watcher.start([&log](const FileEvent& event) { log.add(event); }), "The watcher starts");
+
+  // Added while running, with different rules
+  WatchRootOptions sound_options;
+  sound_options.ignore_patterns = {"*.tmp"};
+  int sound_root = watcher.add_root(SOUND_ROOT, sound_options);
+  check(sound_root > 0 && sound_root != texture_root, "A root added while running gets an id of its own");
+  check(watcher.get_root_ids() == std::vector<int>({texture_root, sound_root}), "Both roots are listed");
+  check(watcher.get_root_path(sound_root) == SOUND_ROOT, "The root keeps its path");
+  check(watcher.add_root(path_in(SOUND_ROOT, "missing"), sound_options) < 0, "A missing directory can't be a root");
+
+  write_file(path_in(TEXTURE_ROOT, "grass.png"), "grass");
+  write_file(path_in(TEXTURE_ROOT, "notes.txt"), "not a texture");
+  write_file(path_in(SOUND_ROOT, "wind.wav"), "wind");
+  write_file(path_in(SOUND_ROOT, "export.tmp"), "scratch");
+  write_file(path_in(SOUND_ROOT, "readme.txt"), "readme");
+
+  bool delivered = log.wait_for([&log] {
+    return log.find(path_in(TEXTURE_ROOT, "grass.png")) && log.find(path_in(SOUND_ROOT, "wind.wav")) &&
+           log.find(path_in(SOUND_ROOT, "readme.txt"));
+  });
+  check(delivered, "Events arrive from both roots");
+  std::optional<FileEvent> grass = log.find(path_in(TEXTURE_ROOT, "grass.png"));
+  std::optional<FileEvent> wind = log.find(path_in(SOUND_ROOT, "wind.wav"));
+  check(grass && grass->root_id == texture_root && grass->type == FileEventType::Created,
+        "Events of the first root carry its id");
+  check(wind && wind->root_id == sound_root && wind->type == FileEventType::Created,
+        "Events of the second root carry its id");
+  check(!log.find(path_in(TEXTURE_ROOT, "notes.txt")), "The first root's extension filter applies only to it");
+  check(!log.find(path_in(SOUND_ROOT, "export.tmp")) && log.find(path_in(SOUND_ROOT, "readme.txt")),
+        "The second root's ignore pattern applies only to it");
+
+  FileWatcherStats texture_stats = watcher.get_root_stats(texture_root);
+  FileWatcherStats sound_stats = watcher.get_root_stats(sound_root);
+  FileWatcherStats total = watcher.get_stats();
+  check(texture_stats.emitted_events == 1 && sound_stats.emitted_events == 2,
+        "Delivered events are counted per root");
+  check(texture_stats.raw_events > 0 && sound_stats.raw_events > 0 &&
+            total.raw_events == texture_stats.raw_events + sound_stats.raw_events &&
+            total.emitted_events == 3,
+        "The totals are the sum of the roots");
+  check(get_filter_hits(watcher.get_filter_stats(texture_root)) > 0 &&
+            get_filter_hits(watcher.get_filter_stats(sound_root)) > 0,
+        "Each root counts what its own filter dropped");
+
+  // Removing a root silences it; the other one carries on
+  std::shared_ptr<const EventFilter> sound_filter = watcher.get_filter(sound_root);
+  check(watcher.remove_root(sound_root), "A root can be removed while running");
+  check(!watcher.remove_root(sound_root), "Removing it again fails");
+  check(sound_filter && sound_filter->excludes("later.tmp", false), "A filter handed out outlives its root");
+  check(watcher.get_root_ids() == std::vector<int>({texture_root}) && watcher.get_root_path(sound_root).empty(),
+        "The removed root is forgotten");
+  check(watcher.get_root_stats(sound_root).raw_events == 0 && !watcher.get_filter(sound_root),
+        "Nothing is reported for the removed root");
+
+  log.clear();
+  write_file(path_in(SOUND_ROOT, "gust.wav"), "gust");
+  write_file(path_in(TEXTURE_ROOT, "rock.png"), "rock");
+  check(log.wait_for([&log] { return log.find(path_in(TEXTURE_ROOT, "rock.png")).has_value(); }),
+        "The remaining root still reports");
+  // The remaining root's event settled after the removed root's would have, so waiting longer proves nothing
+  std::vector<FileEvent> events = log.get();
+  check(events.size() == 1 && events[0].root_id == texture_root, "The removed root stays quiet");
+  check(watcher.get_stats().raw_events == watcher.get_root_stats(texture_root).raw_events,
+        "The totals only cover the remaining root");
+
+  watcher.stop_watching();
+  check(watcher.get_root_ids().empty(), "Stopping forgets every root");
+  fs::remove_all(TEXTURE_ROOT);
+  fs::remove_all(SOUND_ROOT);
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory File Watcher Test\n";
+  std::cout << std::string(50, '-') << '\n';
+
+  test_roots();
+
+  std::cout << '\n';
+  if (g_failures == 0) {
+    std::cout << "All checks passed\n";
+    return 0;
+  }
+  std::cout << g_failures << " check(s) failed\n";
+  return 1;
+}
@@ -0,0 +1,62 @@
+#include <iostream>
+#include <string>
+
+#include "../src/fuzzy_match.h"
+#include "test_support.h"
+
+// Score of `term` against `key`, or -1000 if it doesn't match
+int score_of(const std::string& key, const std::string& term) {
+  int score = 0;
+  return fuzzy_match(key, term, score) ? score : -1000;
+}
+
+bool ranks_above(const std::string& better, const std::string& worse, const std::string& term) {
+  return score_of(better, term) > score_of(worse, term);
+}
+
+void test_matching() {
+  std::cout << "\n=== Subsequence matching ===\n";
+
+  int score = 0;
+  check(fuzzy_match("assets/textures/grass_albedo.png", "gab", score), "Characters in order match");
+  check(fuzzy_match("assets/textures/grass_albedo.png", "", score) && score == 0, "Empty term matches with no score");
+  check(!fuzzy_match("assets/textures/grass_albedo.png", "bag", score), "Characters out of order don't match");
+  check(!fuzzy_match("assets/rock.png", "rockk", score), "Every character must be matched separately");
+  check(fuzzy_match("assets/rock.png\nrock.png", "rock", score), "Keys with extra lines match");
+}
+
+void test_ranking() {
+  std::cout << "\n=== Ranking ===\n";
+
+  check(ranks_above("assets/textures/grass_albedo.png", "assets/textures/calibrate.png", "alb"),
+        "Word boundary beats the middle of a word");
+  check(ranks_above("assets/textures/rock.png", "assets/textures/r_o_c_k.png", "rock"),
+        "Consecutive run beats scattered characters");
+  check(ranks_above("assets/grass/rock.png", "assets/rock/grass.png", "rock"), "File name beats a directory");
+  check(ranks_above("assets/models/tower_base_end.obj", "assets/models/tablet.obj", "tbe"),
+        "Initials of words beat letters inside a word");
+  check(ranks_above("assets/textures/grass.png", "assets/png_sources/grass.tga", "png"),
+        "Matching the extension beats a directory");
+  check(ranks_above("assets/textures/grass.png", "assets/textures/grass.png.bak", ".png"),
+        "Extension with a dot matches the real extension best");
+  check(ranks_above("assets/levels/forest/trees.fbx", "assets/levels/fo/rest/trees.fbx", "forest"),
+        "Whole segment beats one split across segments");
+  check(ranks_above("assets/rock_lod2.fbx", "assets/rock_lodx2.fbx", "lod2"), "Gaps cost score");
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Fuzzy Match Test\n";
+  std::cout << std::string(50, '-') << '\n';
+
+  test_matching();
+  test_ranking();
+
+  std::cout << '\n';
+  if (g_failures == 0) {
+    std::cout << "All checks passed\n";
+    return 0;
+  }
+  std::cout << g_failures << " check(s) failed\n";
+  return 1;
+}
@@ -0,0 +1,136 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/image_resize.h"
+#include "test_support.h"
+
+// RGBA image whose channels all hold the given gray values, row by row
+std::vector<unsigned char> gray_image(const std::vector<unsigned char>& values) {
+  std::vector<unsigned char> pixels;
+  for (unsigned char value : values) {
+    pixels.insert(pixels.end(), {value, value, value, value});
+  }
+  return pixels;
+}
+
+std::vector<unsigned char> resize(const std::vector<unsigned char>& src, int src_width, int src_height,
+                                  int dst_width, int dst_height) {
+  std::vector<unsigned char> dst(static_cast<size_t>(dst_width) * dst_height * 4);
+  resize_rgba8(src.data(), src_width, src_height, dst.data(), dst_width, dst_height);
+  return dst;
+}
+
+void test_box_filter() {
+  std::cout << "\n=== Box filter ===\n";
+
+  std::vector<unsigned char> uniform(64 * 48 * 4, 77);
+  std::vector<unsigned char> out = resize(uniform, 64, 48, 7, 5);
+  bool all_same = true;
+  for (unsigned char value : out) {
+    all_same = all_same && value == 77;
+  }
+  check(all_same, "Uniform image stays uniform at any scale");
+
+  out = resize(gray_image({0, 100, 200, 40}), 2, 2, 1, 1);
+  check(out[0] == 85 && out[3] == 85, "2x2 -> 1x1 averages all four pixels");
+
+  out = resize(gray_image({10, 20, 30, 40}), 4, 1, 2, 1);
+  check(out[0] == 15 && out[4] == 35, "Halving averages neighbouring pairs");
+
+  // 3 -> 2: each output covers one and a half source pixels
+  out = resize(gray_image({0, 90, 180}), 3, 1, 2, 1);
+  check(out[0] == 30 && out[4] == 150, "Partially covered pixels are weighted by coverage");
+
+  std::vector<unsigned char> rgba = {255, 0, 0, 255, 0, 0, 255, 0};
+  out = resize(rgba, 2, 1, 1, 1);
+  check(out[0] == 128 && out[1] == 0 && out[2] == 128 && out[3] == 128, "Channels are filtered independently");
+
+  out = resize(gray_image({50, 150}), 2, 1, 4, 1);
+  check(out[0] == 50 && out[4] == 75 && out[8] == 125 && out[12] == 150, "Upscaling interpolates between neighbours");
+}
+
+void test_kernels() {
+  std::cout << "\n=== SIMD kernels (" << get_resize_kernel_name() << ") ===\n";
+
+  // Noise at odd sizes, so every kernel also runs its scalar tail
+  std::vector<unsigned char> noise(301 * 157 * 4);
+  unsigned int state = 12345;
+  for (unsigned char& value : noise) {
+    state = state * 1103515245u + 12345u;
+    value = static_cast<unsigned char>(state >> 24);
+  }
+
+  for (bool gamma_correct : {false, true}) {
+    ResizeOptions simd;
+    simd.gamma_correct = gamma_correct;
+    ResizeOptions scalar = simd;
+    scalar.force_scalar = true;
+
+    bool same = true;
+    for (int width : {37, 60, 97}) {
+      int height = width / 2 + 1;
+      std::vector<unsigned char> a(static_cast<size_t>(width) * height * 4);
+      std::vector<unsigned char> b(a.size());
+      resize_rgba8(noise.data(), 301, 157, a.data(), width, height, simd);
+      resize_rgba8(noise.data(), 301, 157, b.data(), width, height, scalar);
+      same = same && a == b;
+    }
+    check(same, gamma_correct ? "Gamma-correct SIMD output matches the scalar kernel"
+                              : "SIMD output matches the scalar kernel");
+  }
+}
+
+void test_gamma_correct() {
+  std::cout << "\n=== Gamma-correct filtering ===\n";
+
+  ResizeOptions options;
+  options.gamma_correct = true;
+  std::vector<unsigned char> black_and_white = {0, 0, 0, 255, 255, 255, 255, 255};
+  std::vector<unsigned char> out(4);
+  resize_rgba8(black_and_white.data(), 2, 1, out.data(), 1, 1, options);
+  check(out[0] >= 187 && out[0] <= 188 && out[3] == 255,
+        "Black and white average to half the light, not half the code value");
+
+  std::vector<unsigned char> transparent = {90, 90, 90, 0, 90, 90, 90, 200};
+  resize_rgba8(transparent.data(), 2, 1, out.data(), 1, 1, options);
+  check(out[0] == 90 && out[3] == 100, "Uniform colour survives the round trip and alpha is averaged linearly");
+
+  bool all_levels = true;
+  for (int level = 0; level < 256; level++) {
+    std::vector<unsigned char> uniform(8 * 8 * 4, static_cast<unsigned char>(level));
+    std::vector<unsigned char> small(2 * 2 * 4);
+    resize_rgba8(uniform.data(), 8, 8, small.data(), 2, 2, options);
+    all_levels = all_levels && small[0] == level && small[15] == level;
+  }
+  check(all_levels, "Every sRGB level converts to linear and back unchanged");
+}
+
+void test_fit_within() {
+  std::cout << "\n=== Fit within ===\n";
+
+  int width = 0;
+  int height = 0;
+  fit_within(4096, 2048, 180, width, height);
+  check(width == 180 && height == 90, "Landscape image is limited by its width");
+  fit_within(1000, 3000, 180, width, height);
+  check(width == 60 && height == 180, "Portrait image is limited by its height");
+  fit_within(100, 50, 180, width, height);
+  check(width == 100 && height == 50, "Small image is never enlarged");
+  fit_within(5000, 2, 180, width, height);
+  check(width == 180 && height == 1, "Sides never drop to zero");
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Image Resize Test\n";
+  std::cout << std::string(80, '-') << '\n';
+
+  test_box_filter();
+  test_kernels();
+  test_gamma_correct();
+  test_fit_within();
+
+  std::cout << '\n' << (g_failures == 0 ? "All checks passed" : "Some checks failed") << '\n';
+  return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,493 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../src/jpeg_decoder.h"
+#include "stb_image.h"
+#include "test_support.h"
+
+constexpr int ZIGZAG[64] = {
+    0,  1,  8,  16, 9,  2,  3,  10, 17, 24, 32, 25, 18, 11, 4,  5,  12, 19, 26, 33, 40, 48,
+    41, 34, 27, 20, 13, 6,  7,  14, 21, 28, 35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23,
+    30, 37, 44, 51, 58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63,
+};
+
+// Every quantizer is this, so the decoded pixels stay close to the encoded ones
+constexpr int QUANTIZER = 2;
+
+// An RGB test image
+struct Image {
+  int width = 0;
+  int height = 0;
+  std::vector<unsigned char> rgb;
+
+  const unsigned char* at(int x, int y) const {
+    x = std::clamp(x, 0, width - 1);
+    y = std::clamp(y, 0, height - 1);
+    return rgb.data() + (static_cast<size_t>(y) * width + x) * 3;
+  }
+};
+
+// Smooth gradients in each channel
+Image make_gradient(int width, int height) {
+  Image image;
+  image.width = width;
+  image.height = height;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      image.rgb.push_back(static_cast<unsigned char>(40 + 180 * x / width));
+      image.rgb.push_back(static_cast<unsigned char>(30 + 200 * y / height));
+      image.rgb.push_back(static_cast<unsigned char>(200 - 150 * (x + y) / (width + height)));
+    }
+  }
+  return image;
+}
+
+Image make_solid(int width, int height, unsigned char red, unsigned char green, unsigned char blue) {
+  Image image;
+  image.width = width;
+  image.height = height;
+  for (int i = 0; i < width * height; i++) {
+    image.rgb.insert(image.rgb.end(), {red, green, blue});
+  }
+  return image;
+}
+
+// Canonical Huffman codes for a list of code lengths
+struct HuffmanCodes {
+  unsigned char counts[16] = {};
+  std::vector<unsigned char> symbols;
+  uint16_t code[256] = {};
+  int length[256] = {};
+
+  void add(int code_length, unsigned char symbol) {
+    counts[code_length - 1]++;
+    symbols.push_back(symbol);
+  }
+
+  void assign() {
+    int next = 0;
+    size_t index = 0;
+    for (int code_length = 1; code_length <= 16; code_length++) {
+      for (int i = 0; i < counts[code_length - 1]; i++, index++, next++) {
+        code[symbols[index]] = static_cast<uint16_t>(next);
+        length[symbols[index]] = code_length;
+      }
+      next <<= 1;
+    }
+  }
+};
+
+class BitWriter {
+ public:
+  std::vector<unsigned char>& out;
+  explicit BitWriter(std::vector<unsigned char>& output) : out(output) {}
+
+  void write(uint32_t value, int count) {
+    for (int i = count - 1; i >= 0; i--) {
+      byte = static_cast<unsigned char>(byte << 1 | ((value >> i) & 1));
+      if (++filled == 8) {
+        emit();
+      }
+    }
+  }
+
+  // Pad the last byte with ones
+  void flush() {
+    while (filled != 0) {
+      write(1, 1);
+    }
+  }
+
+ private:
+  unsigned char byte = 0;
+  int filled = 0;
+
+  void emit() {
+    out.push_back(byte);
+    if (byte == 0xFF) {
+      out.push_back(0);
+    }
+    byte = 0;
+    filled = 0;
+  }
+};
+
+struct EncodeOptions {
+  int components = 3;
+  int luma_sampling = 1;  // 2 subsamples chroma by two in each direction
+  int restart_interval = 0;
+  std::vector<unsigned char> app1;  // Payload of an APP1 segment
+};
+
+void append_segment(std::vector<unsigned char>& data, unsigned char marker, const std::vector<unsigned char>& body) {
+  data.insert(data.end(), {0xFF, marker, static_cast<unsigned char>((body.size() + 2) >> 8),
+                           static_cast<unsigned char>(body.size() + 2)});
+  data.insert(data.end(), body.begin(), body.end());
+}
+
+int category_of(int value) {
+  int magnitude = std::abs(value);
+  int bits = 0;
+  while (magnitude > 0) {
+    bits++;
+    magnitude >>= 1;
+  }
+  return bits;
+}
+
+void encode_value(BitWriter& bits, int value, int category) {
+  if (category > 0) {
+    bits.write(static_cast<uint32_t>(value >= 0 ? value : value + (1 << category) - 1), category);
+  }
+}
+
+// A minimal baseline encoder. Its Huffman tables give some AC codes more than 9 bits, to reach the decoder's
+// slow path.
+std::vector<unsigned char> encode_jpeg(const Image& image, const EncodeOptions& options) {
+  const double pi = 3.14159265358979323846;
+  HuffmanCodes dc;
+  for (int category = 0; category <= 11; category++) {
+    dc.add(4, static_cast<unsigned char>(category));
+  }
+  HuffmanCodes ac;
+  std::vector<unsigned char> ac_symbols = {0x00, 0xF0};
+  for (int run = 0; run < 16; run++) {
+    for (int category = 1; category <= 10; category++) {
+      ac_symbols.push_back(static_cast<unsigned char>(run << 4 | category));
+    }
+  }
+  for (size_t i = 0; i < ac_symbols.size(); i++) {
+    ac.add(i < 100 ? 8 : 12, ac_symbols[i]);
+  }
+  dc.assign();
+  ac.assign();
+
+  std::vector<unsigned char> data = {0xFF, 0xD8};
+  if (!options.app1.empty()) {
+    append_segment(data, 0xE1, options.app1);
+  }
+  std::vector<unsigned char> quant = {0};
+  quant.resize(65, QUANTIZER);
+  append_segment(data, 0xDB, quant);
+
+  int sampling = options.components == 3 ? options.luma_sampling : 1;
+  std::vector<unsigned char> frame = {8,
+                                      static_cast<unsigned char>(image.height >> 8),
+                                      static_cast<unsigned char>(image.height),
+                                      static_cast<unsigned char>(image.width >> 8),
+                                      static_cast<unsigned char>(image.width),
+                                      static_cast<unsigned char>(options.components)};
+  for (int c = 0; c < options.components; c++) {
+    int factor = c == 0 ? sampling : 1;
+    frame.insert(frame.end(), {static_cast<unsigned char>(c + 1), static_cast<unsigned char>(factor << 4 | factor), 0});
+  }
+  append_segment(data, 0xC0, frame);
+
+  for (int table_class = 0; table_class < 2; table_class++) {
+    const HuffmanCodes& codes = table_class == 0 ? dc : ac;
+    std::vector<unsigned char> body = {static_cast<unsigned char>(table_class << 4)};
+    body.insert(body.end(), codes.counts, codes.counts + 16);
+    body.insert(body.end(), codes.symbols.begin(), codes.symbols.end());
+    append_segment(data, 0xC4, body);
+  }
+  if (options.restart_interval > 0) {
+    append_segment(data, 0xDD, {static_cast<unsigned char>(options.restart_interval >> 8),
+                                static_cast<unsigned char>(options.restart_interval)});
+  }
+  std::vector<unsigned char> scan = {static_cast<unsigned char>(options.components)};
+  for (int c = 0; c < options.components; c++) {
+    scan.insert(scan.end(), {static_cast<unsigned char>(c + 1), 0});
+  }
+  scan.insert(scan.end(), {0, 63, 0});
+  append_segment(data, 0xDA, scan);
+
+  // Sample of component `c` at (x, y) of its plane, averaged over the pixels it covers
+  auto sample = [&](int c, int x, int y) {
+    int step = c == 0 ? 1 : sampling;
+    double sum = 0.0;
+    for (int j = 0; j < step; j++) {
+      for (int i = 0; i < step; i++) {
+        const unsigned char* pixel = image.at(x * step + i, y * step + j);
+        double red = pixel[0];
+        double green = pixel[1];
+        double blue = pixel[2];
+        if (options.components == 1 || c == 0) {
+          sum += 0.299 * red + 0.587 * green + 0.114 * blue;
+        } else if (c == 1) {
+          sum += -0.168736 * red - 0.331264 * green + 0.5 * blue + 128.0;
+        } else {
+          sum += 0.5 * red - 0.418688 * green - 0.081312 * blue + 128.0;
+        }
+      }
+    }
+    return sum / (step * step);
+  };
+
+  BitWriter bits(data);
+  int mcu_size = 8 * sampling;
+  int mcus_x = (image.width + mcu_size - 1) / mcu_size;
+  int mcus_y = (image.height + mcu_size - 1) / mcu_size;
+  int predictors[3] = {};
+  for (int mcu = 0; mcu < mcus_x * mcus_y; mcu++) {
+    if (options.restart_interval > 0 && mcu > 0 && mcu % options.restart_interval == 0) {
+      bits.flush();
+      data.insert(data.end(), {0xFF, static_cast<unsigned char>(0xD0 + (mcu / options.restart_interval - 1) % 8)});
+      std::fill(predictors, predictors + 3, 0);
+    }
+    for (int c = 0; c < options.components; c++) {
+      int blocks = c == 0 ? sampling : 1;
+      for (int block_y = 0; block_y < blocks; block_y++) {
+        for (int block_x = 0; block_x < blocks; block_x++) {
+          int origin_x = ((mcu % mcus_x) * blocks + block_x) * 8;
+          int origin_y = ((mcu / mcus_x) * blocks + block_y) * 8;
+          int coefficients[64];
+          for (int v = 0; v < 8; v++) {
+            for (int u = 0; u < 8; u++) {
+              double sum = 0.0;
+              for (int y = 0; y < 8; y++) {
+                for (int x = 0; x < 8; x++) {
+                  sum += (sample(c, origin_x + x, origin_y + y) - 128.0) * std::cos((2 * x + 1) * u * pi / 16) *
+                         std::cos((2 * y + 1) * v * pi / 16);
+                }
+              }
+              double scale = (u == 0 ? std::sqrt(0.5) : 1.0) * (v == 0 ? std::sqrt(0.5) : 1.0) / 4;
+              coefficients[v * 8 + u] = static_cast<int>(std::lround(sum * scale / QUANTIZER));
+            }
+          }
+
+          int diff = coefficients[0] - predictors[c];
+          predictors[c] = coefficients[0];
+          int category = category_of(diff);
+          bits.write(dc.code[category], dc.length[category]);
+          encode_value(bits, diff, category);
+          int run = 0;
+          for (int k = 1; k < 64; k++) {
+            int value = coefficients[ZIGZAG[k]];
+            if (value == 0) {
+              run++;
+              continue;
+            }
+            for (; run >= 16; run -= 16) {
+              bits.write(ac.code[0xF0], ac.length[0xF0]);
+            }
+            int symbol = run << 4 | category_of(value);
+            bits.write(ac.code[symbol], ac.length[symbol]);
+            encode_value(bits, value, category_of(value));
+            run = 0;
+          }
+          if (run > 0) {
+            bits.write(ac.code[0], ac.length[0]);
+          }
+        }
+      }
+    }
+  }
+  bits.flush();
+  data.insert(data.end(), {0xFF, 0xD9});
+  return data;
+}
+
+// An EXIF APP1 payload with `thumbnail` as the JPEG of IFD1
+std::vector<unsigned char> make_exif(const std::vector<unsigned char>& thumbnail, bool little_endian) {
+  std::vector<unsigned char> data = {'E', 'x', 'i', 'f', 0, 0};
+  auto put = [&](uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+      int shift = little_endian ? 8 * i : 8 * (bytes - 1 - i);
+      data.push_back(static_cast<unsigned char>(value >> shift));
+    }
+  };
+  data.insert(data.end(), little_endian ? std::initializer_list<unsigned char>{'I', 'I'}
+                                        : std::initializer_list<unsigned char>{'M', 'M'});
+  put(42, 2);
+  put(8, 4);  // IFD0, with no entries
+  put(0, 2);
+  put(14, 4);  // IFD1
+  put(2, 2);
+  put(0x0201, 2);
+  put(4, 2);  // LONG
+  put(1, 4);
+  put(44, 4);
+  put(0x0202, 2);
+  put(4, 2);
+  put(1, 4);
+  put(static_cast<uint32_t>(thumbnail.size()), 4);
+  put(0, 4);
+  data.insert(data.end(), thumbnail.begin(), thumbnail.end());
+  return data;
+}
+
+// Mean absolute difference of decoded RGBA pixels from `image` averaged over `scale` x `scale` boxes
+double mean_error(const std::vector<unsigned char>& pixels, int width, int height, const Image& image, int scale) {
+  double error = 0.0;
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      for (int c = 0; c < 3; c++) {
+        double sum = 0.0;
+        for (int j = 0; j < scale; j++) {
+          for (int i = 0; i < scale; i++) {
+            sum += image.at(x * scale + i, y * scale + j)[c];
+          }
+        }
+        error += std::abs(sum / (scale * scale) - pixels[(static_cast<size_t>(y) * width + x) * 4 + c]);
+      }
+    }
+  }
+  return error / (static_cast<double>(width) * height * 3);
+}
+
+void test_scale_selection() {
+  std::cout << "\n=== Scale selection ===\n";
+  check(select_jpeg_scale(4000, 3000, 256) == 8, "A 4000x3000 photo is decoded at 1/8 for 256 thumbnails");
+  check(select_jpeg_scale(1024, 768, 256) == 4, "1/8 would leave 1024 wide too small, so it is 1/4");
+  check(select_jpeg_scale(600, 400, 256) == 2, "600 wide is halved");
+  check(select_jpeg_scale(300, 200, 256) == 1, "Images below twice the thumbnail size are decoded at full size");
+  check(select_jpeg_scale(100, 2048, 256) == 8, "The larger side decides");
+  check(select_jpeg_scale(2047, 10, 256) == 8, "Reduced sizes round up");
+  check(select_jpeg_scale(4000, 3000, 0) == 1, "Full-size thumbnails aren't reduced");
+
+  check(is_jpeg_file("photos/a.JPG") && is_jpeg_file("b.jpeg") && !is_jpeg_file("c.png"), "JPEG extensions");
+}
+
+void test_decoding() {
+  std::cout << "\n=== Decoding ===\n";
+  Image image = make_gradient(96, 64);
+  EncodeOptions options;
+  std::vector<unsigned char> jpeg = encode_jpeg(image, options);
+
+  JpegInfo info;
+  check(read_jpeg_info(jpeg.data(), jpeg.size(), info) && info.width == 96 && info.height == 64 &&
+            info.components == 3 && info.is_baseline,
+        "The frame header is read");
+
+  int stb_width = 0;
+  int stb_height = 0;
+  int channels = 0;
+  unsigned char* reference =
+      stbi_load_from_memory(jpeg.data(), static_cast<int>(jpeg.size()), &stb_width, &stb_height, &channels, 4);
+  std::vector<unsigned char> pixels;
+  int width = 0;
+  int height = 0;
+  check(reference && decode_jpeg(jpeg.data(), jpeg.size(), 1, pixels, width, height) && width == 96 &&
+            height == 64 && std::equal(pixels.begin(), pixels.end(), reference,
+                                       [](unsigned char a, unsigned char b) { return std::abs(a - b) <= 3; }),
+        "At full size the pixels match stb_image");
+  stbi_image_free(reference);
+
+  for (int scale : {2, 4, 8}) {
+    bool decoded = decode_jpeg(jpeg.data(), jpeg.size(), scale, pixels, width, height);
+    check(decoded && width == 96 / scale && height == 64 / scale && pixels[3] == 255 &&
+              mean_error(pixels, width, height, image, scale) < 2.0,
+          "At 1/" + std::to_string(scale) + " the pixels are the image's box averages");
+  }
+  check(!decode_jpeg(jpeg.data(), jpeg.size(), 3, pixels, width, height), "Only 1/2, 1/4 and 1/8 are supported");
+
+  // Odd sizes, subsampled chroma and restart markers
+  Image odd = make_gradient(67, 45);
+  options.luma_sampling = 2;
+  options.restart_interval = 3;
+  jpeg = encode_jpeg(odd, options);
+  check(decode_jpeg(jpeg.data(), jpeg.size(), 4, pixels, width, height) && width == 17 && height == 12,
+        "Reduced sizes round up");
+  check(mean_error(pixels, width, height, odd, 4) < 3.0, "Subsampled chroma across restart intervals");
+
+  options = EncodeOptions();
+  options.components = 1;
+  jpeg = encode_jpeg(image, options);
+  check(decode_jpeg(jpeg.data(), jpeg.size(), 8, pixels, width, height) && width == 12 && height == 8 &&
+            pixels[0] == pixels[1] && pixels[1] == pixels[2],
+        "Grayscale is decoded to gray RGBA");
+}
+
+void test_unsupported() {
+  std::cout << "\n=== Unsupported and corrupt files ===\n";
+  std::vector<unsigned char> jpeg = encode_jpeg(make_gradient(32, 32), EncodeOptions());
+  std::vector<unsigned char> pixels;
+  int width = 0;
+  int height = 0;
+
+  std::vector<unsigned char> progressive = jpeg;
+  for (size_t i = 0; i + 1 < progressive.size(); i++) {
+    if (progressive[i] == 0xFF && progressive[i + 1] == 0xC0) {
+      progressive[i + 1] = 0xC2;
+      break;
+    }
+  }
+  JpegInfo info;
+  check(read_jpeg_info(progressive.data(), progressive.size(), info) && info.width == 32 && !info.is_baseline,
+        "Progressive frames are read but not baseline");
+  check(!decode_jpeg(progressive.data(), progressive.size(), 2, pixels, width, height),
+        "Progressive images aren't decoded");
+  check(!decode_jpeg_thumbnail(progressive.data(), progressive.size(), 8, pixels, width, height),
+        "Progressive thumbnails are left to stb_image");
+
+  std::vector<unsigned char> truncated(jpeg.begin(), jpeg.begin() + static_cast<std::ptrdiff_t>(jpeg.size() / 2));
+  check(decode_jpeg(truncated.data(), truncated.size(), 2, pixels, width, height) && width == 16,
+        "Truncated scans decode what is there");
+  std::vector<unsigned char> headers(jpeg.begin(), jpeg.begin() + 20);
+  check(!decode_jpeg(headers.data(), headers.size(), 2, pixels, width, height), "Files cut in the headers fail");
+  std::vector<unsigned char> png = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+  check(!read_jpeg_info(png.data(), png.size(), info), "Other formats are rejected");
+}
+
+void test_exif_thumbnail() {
+  std::cout << "\n=== EXIF thumbnails ===\n";
+  std::vector<unsigned char> thumbnail = encode_jpeg(make_solid(160, 120, 200, 40, 40), EncodeOptions());
+  Image photo = make_solid(512, 384, 40, 40, 200);
+
+  for (bool little_endian : {true, false}) {
+    EncodeOptions options;
+    options.app1 = make_exif(thumbnail, little_endian);
+    std::vector<unsigned char> jpeg = encode_jpeg(photo, options);
+    size_t offset = 0;
+    size_t length = 0;
+    check(find_exif_thumbnail(jpeg.data(), jpeg.size(), offset, length) && length == thumbnail.size() &&
+              std::equal(thumbnail.begin(), thumbnail.end(), jpeg.begin() + static_cast<std::ptrdiff_t>(offset)),
+          std::string("The thumbnail is found in ") + (little_endian ? "little" : "big") + "-endian EXIF");
+  }
+
+  EncodeOptions options;
+  options.app1 = make_exif(thumbnail, true);
+  std::vector<unsigned char> jpeg = encode_jpeg(photo, options);
+  std::vector<unsigned char> pixels;
+  int width = 0;
+  int height = 0;
+  check(decode_jpeg_thumbnail(jpeg.data(), jpeg.size(), 128, pixels, width, height) && width == 160 &&
+            height == 120 && pixels[0] > 150 && pixels[2] < 100,
+        "A thumbnail covering the requested size is used");
+  check(decode_jpeg_thumbnail(jpeg.data(), jpeg.size(), 200, pixels, width, height) && width == 256 &&
+            height == 192 && pixels[0] < 100 && pixels[2] > 150,
+        "A smaller thumbnail falls back to a reduced decode of the image");
+  check(!decode_jpeg_thumbnail(jpeg.data(), jpeg.size(), 300, pixels, width, height),
+        "Images that can't be reduced are left to stb_image");
+
+  options.app1 = make_exif(encode_jpeg(make_solid(160, 160, 200, 40, 40), EncodeOptions()), true);
+  jpeg = encode_jpeg(photo, options);
+  check(decode_jpeg_thumbnail(jpeg.data(), jpeg.size(), 128, pixels, width, height) && width == 128 &&
+            height == 96 && pixels[2] > 150,
+        "A thumbnail of another aspect ratio is ignored");
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory JPEG Decoder Test\n";
+  std::cout << std::string(50, '-') << '\n';
+
+  test_scale_selection();
+  test_decoding();
+  test_unsupported();
+  test_exif_thumbnail();
+
+  std::cout << '\n';
+  if (g_failures == 0) {
+    std::cout << "All checks passed\n";
+    return 0;
+  }
+  std::cout << g_failures << " check(s) failed\n";
+  return 1;
+}
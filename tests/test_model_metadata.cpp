@@ -0,0 +1,471 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/asset_database.h"
+#include "../src/mapped_file.h"
+#include "../src/metadata_extractor.h"
+#include "../src/metadata_store.h"
+#include "../src/model_metadata.h"
+#include "test_support.h"
+
+const std::string DB_PATH = "test_model_metadata.db";
+const std::string TEST_DIR = "test_model_metadata_files";
+
+// Write a fixture into the test directory and return its path
+std::string write_test_file(const std::string& name, const std::string& contents) {
+  std::string path = (std::filesystem::path(TEST_DIR) / name).string();
+  write_file(path, contents);
+  return path;
+}
+
+FileInfo make_model(const std::string& path) {
+  FileInfo asset;
+  asset.full_path = path;
+  asset.relative_path = path;
+  asset.name = std::filesystem::path(path).filename().string();
+  asset.extension = std::filesystem::path(path).extension().string();
+  asset.size = std::filesystem::file_size(path);
+  asset.type = AssetType::Model;
+  return asset;
+}
+
+bool near(float a, float b) { return a - b < 1e-4f && b - a < 1e-4f; }
+
+bool has_bounds(const ModelMetadata& metadata, float x0, float y0, float z0, float x1, float y1, float z1) {
+  return metadata.has_bounds && near(metadata.bounds_min[0], x0) && near(metadata.bounds_min[1], y0) &&
+         near(metadata.bounds_min[2], z0) && near(metadata.bounds_max[0], x1) && near(metadata.bounds_max[1], y1) &&
+         near(metadata.bounds_max[2], z1);
+}
+
+// Minimal writer for binary FBX 7.4 files: nodes with 32-bit record headers, string, int64 and array properties
+class FbxWriter {
+ public:
+  struct Node {
+    std::string name;
+    std::string properties;
+    uint32_t property_count = 0;
+    std::vector<Node> children;
+
+    Node& add_string(const std::string& value) {
+      properties += 'S';
+      append32(properties, static_cast<uint32_t>(value.size()));
+      properties += value;
+      property_count++;
+      return *this;
+    }
+
+    Node& add_int64(int64_t value) {
+      properties += 'L';
+      for (int i = 0; i < 8; i++) {
+        properties += static_cast<char>(static_cast<uint64_t>(value) >> (8 * i));
+      }
+      property_count++;
+      return *this;
+    }
+
+    // An array stored raw, or with `compressed`, as opaque bytes standing in for a zlib stream
+    Node& add_array(char type, uint32_t count, const std::string& elements, bool compressed = false) {
+      properties += type;
+      append32(properties, count);
+      append32(properties, compressed ? 1 : 0);
+      append32(properties, static_cast<uint32_t>(elements.size()));
+      properties += elements;
+      property_count++;
+      return *this;
+    }
+  };
+
+  static void append32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+      out += static_cast<char>(value >> (8 * i));
+    }
+  }
+
+  static std::string doubles(const std::vector<double>& values) {
+    std::string out(values.size() * 8, '\0');
+    std::memcpy(&out[0], values.data(), out.size());
+    return out;
+  }
+
+  static std::string ints(const std::vector<int32_t>& values) {
+    std::string out(values.size() * 4, '\0');
+    std::memcpy(&out[0], values.data(), out.size());
+    return out;
+  }
+
+  static std::string write(const std::vector<Node>& nodes) {
+    std::string out("Kaydara FBX Binary  \0\x1a\0", 23);
+    append32(out, 7400);
+    write_list(out, nodes);
+    return out;
+  }
+
+ private:
+  static constexpr size_t HEADER_SIZE = 13;
+
+  static void write_list(std::string& out, const std::vector<Node>& nodes) {
+    for (const Node& node : nodes) {
+      size_t start = out.size();
+      out.append(HEADER_SIZE, '\0');
+      out[start + 12] = static_cast<char>(node.name.size());
+      out += node.name;
+      out += node.properties;
+      if (!node.children.empty()) {
+        write_list(out, node.children);
+      }
+      std::string header;
+      append32(header, static_cast<uint32_t>(out.size()));
+      append32(header, node.property_count);
+      append32(header, static_cast<uint32_t>(node.properties.size()));
+      out.replace(start, 12, header);
+    }
+    out.append(HEADER_SIZE, '\0');
+  }
+};
+
+FbxWriter::Node make_node(const std::string& name) {
+  FbxWriter::Node node;
+  node.name = name;
+  return node;
+}
+
+void test_obj() {
+  std::cout << "\n=== OBJ ===\n";
+  std::string obj =
+      "# exported\n"
+      "mtllib crate.mtl\n"
+      "v -1.0 0.0 -2.5\n"
+      "v 1.0 2.0 0.5\r\n"
+      "v 0.5 -3 1e1\n"
+      "v 0 0 0\n"
+      "vt 0.5 0.5\n"
+      "vn 0 1 0\n"
+      "usemtl wood\n"
+      "f 1/1/1 2/1/1 3/1/1\n"
+      "usemtl metal\n"
+      "f 1 2 3 4\n"
+      "usemtl wood\n"
+      "f\t1//1\t3//1\t4//1\n";
+  ModelMetadata metadata;
+  std::vector<std::string> libraries;
+  check(read_obj_metadata(bytes(obj), obj.size(), metadata, libraries), "OBJ is read");
+  check(metadata.vertex_count == 4, "Positions are counted, texture coordinates and normals aren't");
+  check(metadata.triangle_count == 4, "A quad counts as two triangles");
+  check(metadata.material_count == 2, "Materials are counted once however often they are used");
+  check(has_bounds(metadata, -1.0f, -3.0f, -2.5f, 1.0f, 2.0f, 10.0f), "Bounds cover every position");
+  check(libraries.size() == 1 && libraries[0] == "crate.mtl", "Material libraries are listed");
+
+  ModelMetadata unterminated;
+  std::string last_line = "v 1 2 3\nv 4 5 6\nf 1 2 1";
+  read_obj_metadata(bytes(last_line), last_line.size(), unterminated, libraries);
+  check(unterminated.triangle_count == 1 && has_bounds(unterminated, 1, 2, 3, 4, 5, 6),
+        "A last line without a newline is read");
+
+  std::string mtl =
+      "newmtl wood\n"
+      "Kd 0.8 0.6 0.4\n"
+      "map_Kd textures/wood.png\n"
+      "map_Bump -bm 0.5 textures/wood_normal.png\n"
+      "newmtl metal\n"
+      "map_Kd textures/wood.png\n"
+      "bump textures/metal_bump.png\n";
+  std::vector<std::string> textures;
+  read_mtl_textures(bytes(mtl), mtl.size(), textures);
+  check(textures == std::vector<std::string>{"textures/wood.png", "textures/wood_normal.png",
+                                             "textures/metal_bump.png"},
+        "Texture maps are listed once each, without their options");
+
+  // From disk, the material library is found beside the model
+  write_test_file("crate.mtl", mtl);
+  std::string path = write_test_file("crate.obj", obj);
+  MappedFile file;
+  ModelMetadata from_file;
+  check(file.open(path) && read_model_metadata(path, file, from_file), "OBJ file is mapped and read");
+  check(from_file.triangle_count == 4 && from_file.texture_paths.size() == 3,
+        "Textures come from the material library beside the model");
+}
+
+void test_gltf() {
+  std::cout << "\n=== glTF ===\n";
+  std::string gltf = R"({
+    "asset": {"version": "2.0"},
+    "meshes": [
+      {"primitives": [
+        {"attributes": {"POSITION": 0, "NORMAL": 1}, "indices": 2},
+        {"attributes": {"POSITION": 3}, "mode": 5}
+      ]},
+      {"primitives": [{"attributes": {"NORMAL": 1}}]}
+    ],
+    "accessors": [
+      {"count": 24, "type": "VEC3", "min": [-1, -1, -1], "max": [1, 1, 1]},
+      {"count": 24, "type": "VEC3"},
+      {"count": 36, "type": "SCALAR"},
+      {"count": 10, "type": "VEC3", "min": [0, 0.5, -4], "max": [2, 3, 0]}
+    ],
+    "materials": [{"name": "a"}, {"name": "b\"quoted\""}],
+    "images": [
+      {"uri": "textures/base%20color.png"},
+      {"uri": "data:image/png;base64,AAAA"},
+      {"bufferView": 3, "mimeType": "image/png"}
+    ]
+  })";
+  ModelMetadata metadata;
+  check(read_gltf_metadata(bytes(gltf), gltf.size(), metadata), "glTF is read");
+  check(metadata.vertex_count == 34, "Vertices come from the POSITION accessors");
+  check(metadata.triangle_count == 20, "Triangles come from the indices, or the vertices of a strip");
+  check(metadata.material_count == 2, "Materials are counted");
+  check(has_bounds(metadata, -1, -1, -4, 2, 3, 1), "Bounds merge the accessors' min and max");
+  check(metadata.texture_paths == std::vector<std::string>{"textures/base color.png"},
+        "Only external images are listed, with their URIs decoded");
+
+  // GLB: a 12-byte header, then the JSON chunk padded to 4 bytes, then a binary chunk that isn't read
+  std::string json = R"({"meshes":[{"primitives":[{"attributes":{"POSITION":0}}]}],"accessors":[{"count":9}]})";
+  json.append((4 - json.size() % 4) % 4, ' ');
+  std::string glb = "glTF";
+  FbxWriter::append32(glb, 2);
+  FbxWriter::append32(glb, static_cast<uint32_t>(12 + 8 + json.size() + 8 + 4));
+  FbxWriter::append32(glb, static_cast<uint32_t>(json.size()));
+  glb += "JSON" + json;
+  FbxWriter::append32(glb, 4);
+  glb += std::string("BIN\0\xff\xff\xff\xff", 8);
+  ModelMetadata binary;
+  check(read_glb_metadata(bytes(glb), glb.size(), binary), "GLB is read");
+  check(binary.vertex_count == 9 && binary.triangle_count == 3 && !binary.has_bounds,
+        "Non-indexed GLB triangles come from the vertex count");
+
+  ModelMetadata broken;
+  std::string truncated = gltf.substr(0, gltf.size() / 2);
+  check(!read_gltf_metadata(bytes(truncated), truncated.size(), broken), "Truncated JSON is rejected");
+  check(!read_glb_metadata(bytes(json), json.size(), broken), "JSON isn't taken for GLB");
+}
+
+void test_fbx() {
+  std::cout << "\n=== FBX ===\n";
+  // A quad and a triangle; the last index of each polygon is stored as its ones' complement
+  FbxWriter::Node mesh = make_node("Geometry");
+  mesh.add_int64(1).add_string(std::string("Cube\0\x01Geometry", 14)).add_string("Mesh");
+  mesh.children.push_back(make_node("Vertices"));
+  mesh.children.back().add_array(
+      'd', 15, FbxWriter::doubles({0, 0, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, -2, 0.5, 3}));
+  mesh.children.push_back(make_node("PolygonVertexIndex"));
+  mesh.children.back().add_array('i', 7, FbxWriter::ints({0, 1, 2, ~3, 0, 2, ~4}));
+
+  // Compressed arrays give counts but no bounds
+  FbxWriter::Node packed = make_node("Geometry");
+  packed.add_int64(2).add_string("Packed").add_string("Mesh");
+  packed.children.push_back(make_node("Vertices"));
+  packed.children.back().add_array('d', 300, "zlib", true);
+  packed.children.push_back(make_node("PolygonVertexIndex"));
+  packed.children.back().add_array('i', 30, "zlib", true);
+
+  // Blend shapes are geometry too but add nothing
+  FbxWriter::Node shape = make_node("Geometry");
+  shape.add_int64(3).add_string("Smile").add_string("Shape");
+  shape.children.push_back(make_node("Vertices"));
+  shape.children.back().add_array('d', 3, FbxWriter::doubles({100, 100, 100}));
+
+  FbxWriter::Node texture = make_node("Texture");
+  texture.add_int64(4).add_string("Diffuse").add_string("");
+  texture.children.push_back(make_node("FileName"));
+  texture.children.back().add_string("C:/work/textures/diffuse.tga");
+  texture.children.push_back(make_node("RelativeFilename"));
+  texture.children.back().add_string("textures/diffuse.tga");
+
+  FbxWriter::Node objects = make_node("Objects");
+  objects.children = {mesh, packed, shape, make_node("Material"), make_node("Material"), texture};
+  FbxWriter::Node header = make_node("FBXHeaderExtension");
+  header.children.push_back(make_node("FBXVersion"));
+  std::string fbx = FbxWriter::write({header, objects});
+
+  ModelMetadata metadata;
+  check(read_fbx_metadata(bytes(fbx), fbx.size(), metadata), "Binary FBX is read");
+  check(metadata.vertex_count == 105, "Vertices of every mesh are counted, blend shapes aren't");
+  check(metadata.triangle_count == 13, "Exact triangles from raw indices, estimated from compressed ones");
+  check(metadata.material_count == 2, "Materials are counted");
+  check(has_bounds(metadata, -2, 0, 0, 1, 1, 3), "Bounds come from the uncompressed vertices");
+  check(metadata.texture_paths == std::vector<std::string>{"textures/diffuse.tga"},
+        "Texture paths prefer the relative file name");
+
+  ModelMetadata broken;
+  std::string truncated = fbx.substr(0, fbx.size() - 40);
+  read_fbx_metadata(bytes(truncated), truncated.size(), broken);
+  check(broken.vertex_count <= metadata.vertex_count, "Truncated files don't read past their end");
+  std::string ascii = "; FBX 7.4.0 project file\nFBXHeaderExtension:  {\n}\n";
+  check(!read_fbx_metadata(bytes(ascii), ascii.size(), broken), "ASCII FBX is rejected");
+}
+
+void test_store() {
+  std::cout << "\n=== Store ===\n";
+  remove_database(DB_PATH);
+  AssetDatabase database;
+  database.initialize(DB_PATH);
+  MetadataStore store;
+  check(store.initialize(DB_PATH), "Store opens beside the asset table");
+
+  std::string separator(1, static_cast<char>(std::filesystem::path::preferred_separator));
+  std::vector<FileInfo> assets;
+  for (const char* name : {"small", "large", "huge", "broken"}) {
+    FileInfo asset;
+    asset.full_path = "root" + separator + "models" + separator + name + ".obj";
+    asset.name = std::string(name) + ".obj";
+    asset.extension = ".obj";
+    asset.type = AssetType::Model;
+    assets.push_back(asset);
+  }
+  database.insert_assets_batch(assets);
+
+  ModelMetadata small;
+  small.vertex_count = 8;
+  small.triangle_count = 12;
+  small.texture_paths = {"crate.png"};
+  ModelMetadata large;
+  large.vertex_count = 600000;
+  large.triangle_count = 1200000;
+  large.material_count = 3;
+  large.has_bounds = true;
+  large.bounds_min[1] = -5;
+  large.bounds_max[1] = 5;
+  large.texture_paths = {"rock/Albedo.png", "rock/normal.png"};
+  ModelMetadata huge = large;
+  huge.triangle_count = 5000000;
+  huge.texture_paths.clear();
+  store.store_model(assets[0].full_path, 100, 1, &small);
+  store.store_model(assets[1].full_path, 200, 2, &large);
+  store.store_model(assets[2].full_path, 300, 3, &huge);
+  store.store_model(assets[3].full_path, 400, 4, nullptr);
+  store.store_model("root" + separator + "gone.obj", 500, 5, &huge);
+
+  check(store.is_model_current(assets[0].full_path, 100, 1), "Stored size and time are current");
+  check(!store.is_model_current(assets[0].full_path, 100, 9) && !store.is_model_current(assets[0].full_path, 101, 1),
+        "A changed size or time isn't");
+  check(store.is_model_current(assets[3].full_path, 400, 4), "A file that couldn't be read is current too");
+
+  ModelMetadata loaded;
+  check(store.load_model(assets[1].full_path, loaded) && loaded.triangle_count == 1200000 &&
+            loaded.material_count == 3 && loaded.has_bounds && loaded.bounds_max[1] == 5 &&
+            loaded.texture_paths == large.texture_paths,
+        "Metadata round-trips");
+  check(store.load_model(assets[0].full_path, loaded) && !loaded.has_bounds, "Missing bounds stay missing");
+  check(!store.load_model(assets[3].full_path, loaded), "Unreadable files have no metadata");
+
+  ModelQuery query;
+  query.min_triangles = 1000000;
+  std::vector<ModelRecord> found = store.find_models(query);
+  check(found.size() == 2 && found[0].full_path == assets[2].full_path && found[1].full_path == assets[1].full_path,
+        "Over a million triangles, most first, and only assets still indexed");
+  query.max_triangles = 2000000;
+  check(store.find_models(query).size() == 1, "Triangle ranges are bounded on both sides");
+  query = ModelQuery();
+  query.texture = "albedo";
+  found = store.find_models(query);
+  check(found.size() == 1 && found[0].full_path == assets[1].full_path, "Texture search ignores case");
+  query = ModelQuery();
+  query.limit = 2;
+  check(store.find_models(query).size() == 2, "Results are limited");
+
+  check(store.move("root" + separator + "models", "root" + separator + "meshes"), "Directory move is applied");
+  std::string moved = "root" + separator + "meshes" + separator + "large.obj";
+  check(store.is_model_current(moved, 200, 2) && !store.is_model_current(assets[1].full_path, 200, 2),
+        "Metadata follows a directory move");
+  check(store.remove("root" + separator + "meshes"), "Directory removal is applied");
+  check(!store.is_model_current(moved, 200, 2), "Metadata below a removed directory is forgotten");
+
+  store.close();
+  database.close();
+}
+
+void test_extractor() {
+  std::cout << "\n=== Extractor ===\n";
+  remove_database(DB_PATH);
+  AssetDatabase database;
+  database.initialize(DB_PATH);
+  MetadataStore store;
+  store.initialize(DB_PATH);
+
+  std::string gltf = R"({"meshes":[{"primitives":[{"attributes":{"POSITION":0},"indices":1}]}],)"
+                     R"("accessors":[{"count":4},{"count":6}]})";
+  std::vector<FileInfo> assets = {make_model(write_test_file("tri.obj", "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n")),
+                                  make_model(write_test_file("quad.gltf", gltf)),
+                                  make_model(write_test_file("bad.glb", "not a glb"))};
+  FileInfo texture = make_model(write_test_file("skin.png", "png"));
+  texture.type = AssetType::Texture;
+  assets.push_back(texture);
+  database.insert_assets_batch(assets);
+
+  {
+    MetadataExtractor extractor(store, 2);
+    extractor.enqueue(assets);
+    check(extractor.get_queued_count() == 3, "Only model files are queued");
+    extractor.start();
+    extractor.wait_idle();
+    MetadataExtractorStats stats = extractor.get_stats();
+    check(stats.extracted == 3 && stats.skipped == 0 && stats.failed == 0, "Every model is extracted");
+    ModelMetadata metadata;
+    check(store.load_model(assets[1].full_path, metadata) && metadata.triangle_count == 2,
+          "Extracted metadata is stored");
+    check(!store.load_model(assets[2].full_path, metadata), "Unreadable models are stored as such");
+  }
+
+  // A restart only reads what changed
+  std::string grown = "v 0 0 0\nv 1 0 0\nv 0 1 0\nv 1 1 0\nf 1 2 3\nf 2 4 3\n";
+  write_test_file("tri.obj", grown);
+  MetadataExtractor extractor(store, 2);
+  extractor.start();
+  extractor.enqueue(assets);
+  extractor.wait_idle();
+  MetadataExtractorStats stats = extractor.get_stats();
+  check(stats.extracted == 1 && stats.skipped == 2, "Unchanged models are skipped");
+  ModelMetadata metadata;
+  check(store.load_model(assets[0].full_path, metadata) && metadata.triangle_count == 2, "Changed model is re-read");
+
+  // Changes from the indexer
+  std::filesystem::rename(assets[1].full_path, (std::filesystem::path(TEST_DIR) / "renamed.gltf").string());
+  AssetChange move;
+  move.type = AssetChangeType::Move;
+  move.old_path = assets[1].full_path;
+  move.asset = make_model((std::filesystem::path(TEST_DIR) / "renamed.gltf").string());
+  AssetChange remove;
+  remove.type = AssetChangeType::Remove;
+  remove.old_path = assets[0].full_path;
+  AssetChange insert;
+  insert.type = AssetChangeType::Insert;
+  insert.asset = make_model(write_test_file("new.obj", grown));
+  extractor.apply({move, remove, insert});
+  extractor.wait_idle();
+  check(store.load_model(move.asset.full_path, metadata) && !store.load_model(assets[1].full_path, metadata),
+        "Moves carry the metadata along");
+  check(!store.load_model(assets[0].full_path, metadata), "Removals drop it");
+  check(store.load_model(insert.asset.full_path, metadata) && metadata.vertex_count == 4, "Inserts are extracted");
+
+  extractor.stop();
+  store.close();
+  database.close();
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Model Metadata Test\n";
+  std::cout << std::string(50, '-') << '\n';
+
+  test_obj();
+  test_gltf();
+  test_fbx();
+  test_store();
+  test_extractor();
+  remove_database(DB_PATH);
+  std::filesystem::remove_all(TEST_DIR);
+
+  std::cout << '\n';
+  if (g_failures == 0) {
+    std::cout << "All checks passed\n";
+    return 0;
+  }
+  std::cout << g_failures << " check(s) failed\n";
+  return 1;
+}
@@ -0,0 +1,97 @@
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/mpsc_queue.h"
+#include "test_support.h"
+
+void test_single_thread() {
+  std::cout << "\n=== Single thread ===\n";
+
+  MpscQueue<std::string> queue;
+  std::string value;
+  check(queue.empty() && !queue.pop(value), "New queue is empty");
+
+  queue.push("a");
+  queue.push("b");
+  queue.push("c");
+  check(!queue.empty(), "Queue with entries is not empty");
+
+  std::string order;
+  while (queue.pop(value)) {
+    order += value;
+  }
+  check(order == "abc", "Entries come out in push order");
+  check(queue.empty(), "Queue is empty after draining");
+
+  queue.push("d");
+  check(queue.pop(value) && value == "d", "Queue is reusable after draining");
+}
+
+void test_move_only() {
+  std::cout << "\n=== Move-only values ===\n";
+
+  MpscQueue<std::unique_ptr<int>> queue;
+  queue.push(std::make_unique<int>(42));
+  queue.push(std::make_unique<int>(7));
+  std::unique_ptr<int> value;
+  check(queue.pop(value) && value && *value == 42, "Move-only values are handed over");
+  // The second entry is left in the queue and released by the destructor
+}
+
+void test_producers() {
+  std::cout << "\n=== Concurrent producers ===\n";
+
+  constexpr int PRODUCERS = 4;
+  constexpr int PER_PRODUCER = 100000;
+
+  // Each value encodes its producer and sequence number
+  MpscQueue<int> queue;
+  std::vector<std::thread> producers;
+  for (int p = 0; p < PRODUCERS; p++) {
+    producers.emplace_back([&queue, p] {
+      for (int i = 0; i < PER_PRODUCER; i++) {
+        queue.push(p * PER_PRODUCER + i);
+      }
+    });
+  }
+
+  std::vector<int> next_expected(PRODUCERS, 0);
+  bool in_order = true;
+  int received = 0;
+  while (received < PRODUCERS * PER_PRODUCER) {
+    int value = 0;
+    if (!queue.pop(value)) {
+      std::this_thread::yield();
+      continue;
+    }
+    int producer = value / PER_PRODUCER;
+    if (value % PER_PRODUCER != next_expected[producer]) {
+      in_order = false;
+    }
+    next_expected[producer] = value % PER_PRODUCER + 1;
+    received++;
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+
+  check(received == PRODUCERS * PER_PRODUCER, "Every entry is received exactly once");
+  check(in_order, "Entries of one producer keep their order");
+  check(queue.empty(), "Nothing is left behind");
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory MPSC Queue Test\n";
+  std::cout << std::string(80, '-') << '\n';
+
+  test_single_thread();
+  test_move_only();
+  test_producers();
+
+  std::cout << '\n' << (g_failures == 0 ? "All checks passed" : "Some checks failed") << '\n';
+  return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/profiler.h"
+#include "test_support.h"
+
+// Index of a zone by name, or the zone count if it was never seen
+size_t find_zone(const Profiler& profiler, const std::string& name) {
+  for (size_t zone = 0; zone < profiler.get_zone_count(); zone++) {
+    if (profiler.get_zone_name(zone) == name) {
+      return zone;
+    }
+  }
+  return profiler.get_zone_count();
+}
+
+void test_frames() {
+  std::cout << "\n=== Frame history ===\n";
+  Profiler profiler;
+  check(profiler.get_zone_count() == 1 && profiler.get_zone_name(0) == Profiler::FRAME_ZONE,
+        "Frame zone exists from the start");
+
+  // Two scopes of the same zone in one frame add up; a zone first seen later has no time in earlier frames
+  profiler.record("Filter", 0, 2000000);
+  profiler.record("Filter", 5000000, 6000000);
+  profiler.end_frame();
+  std::string upload_name = "Upload";  // A different address for the same name must land in the same zone
+  profiler.record("Upload", 0, 500000);
+  profiler.end_frame();
+  profiler.record(upload_name.c_str(), 0, 250000);
+  profiler.end_frame();
+
+  size_t filter = find_zone(profiler, "Filter");
+  size_t upload = find_zone(profiler, "Upload");
+  check(filter < profiler.get_zone_count() && upload < profiler.get_zone_count() && profiler.get_zone_count() == 3,
+        "Zones are created by name");
+  std::vector<float> filter_history = profiler.get_history(filter);
+  check(filter_history.size() == 3 && filter_history[0] == 3.0f && filter_history[1] == 0.0f,
+        "Samples are summed per frame, in milliseconds");
+  std::vector<float> upload_history = profiler.get_history(upload);
+  check(upload_history.size() == 3 && upload_history[0] == 0.0f && upload_history[1] == 0.5f &&
+            upload_history[2] == 0.25f,
+        "Zones seen later have empty earlier frames");
+
+  ProfilerStats stats = profiler.get_stats();
+  check(stats.frames == 3 && stats.samples == 4 && stats.dropped == 0 && stats.threads == 1, "Stats count samples");
+
+  // Time spent waiting for input before begin_frame() isn't part of the frame
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  profiler.begin_frame();
+  profiler.end_frame();
+  check(profiler.get_zone_stats(0).last_ms < 50.0, "begin_frame() restarts the frame clock");
+}
+
+void test_percentiles() {
+  std::cout << "\n=== Percentiles ===\n";
+  Profiler profiler;
+  for (int frame = 1; frame <= 100; frame++) {
+    profiler.record("Work", 0, static_cast<int64_t>(frame) * 1000000);
+    profiler.end_frame();
+  }
+  ZoneStats stats = profiler.get_zone_stats(find_zone(profiler, "Work"));
+  check(stats.p50_ms == 50.0 && stats.p95_ms == 95.0 && stats.p99_ms == 99.0 && stats.max_ms == 100.0,
+        "Nearest-rank percentiles over the history");
+  check(stats.last_ms == 100.0, "Last frame is reported");
+
+  for (size_t frame = 0; frame < Profiler::HISTORY_FRAMES; frame++) {
+    profiler.end_frame();
+  }
+  stats = profiler.get_zone_stats(find_zone(profiler, "Work"));
+  check(profiler.get_history(0).size() == Profiler::HISTORY_FRAMES && stats.max_ms == 0.0,
+        "History keeps only the most recent frames");
+}
+
+void test_threads() {
+  std::cout << "\n=== Threads ===\n";
+  Profiler profiler;
+  const int thread_count = 4;
+  const int samples_per_thread = 1000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < thread_count; t++) {
+    threads.emplace_back([&profiler] {
+      for (int i = 0; i < samples_per_thread; i++) {
+        ProfileScope scope(&profiler, "Decode");
+      }
+    });
+  }
+  // Drain while the threads record, as the main loop would
+  for (int frame = 0; frame < 20; frame++) {
+    profiler.end_frame();
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  profiler.end_frame();
+
+  ProfilerStats stats = profiler.get_stats();
+  check(stats.threads == thread_count, "Each thread gets a ring of its own");
+  check(stats.samples == thread_count * samples_per_thread && stats.dropped == 0, "No sample is lost or duplicated");
+
+  Profiler overflowing;
+  for (size_t i = 0; i < Profiler::RING_CAPACITY + 10; i++) {
+    overflowing.record("Busy", 0, 1);
+  }
+  overflowing.end_frame();
+  stats = overflowing.get_stats();
+  check(stats.samples == Profiler::RING_CAPACITY && stats.dropped == 10, "A full ring drops and counts new samples");
+}
+
+void test_dump() {
+  std::cout << "\n=== Dump ===\n";
+  const std::string path = "test_profiler.csv";
+  Profiler profiler;
+  profiler.record("Render", 0, 4000000);
+  profiler.end_frame();
+  profiler.end_frame();
+  check(profiler.dump(path), "Profile is written");
+
+  std::ifstream file(path);
+  std::string header, first, second, extra;
+  std::getline(file, header);
+  std::getline(file, first);
+  std::getline(file, second);
+  check(header == "frame,Frame,Render", "Header names the zones");
+  check(first.rfind("0,", 0) == 0 && first.substr(first.rfind(',')) == ",4" &&
+            second.substr(second.rfind(',')) == ",0",
+        "One row per frame with each zone's milliseconds");
+  check(!std::getline(file, extra), "Nothing but the history is written");
+  file.close();
+  std::remove(path.c_str());
+  check(!profiler.dump("no_such_directory/profile.csv"), "Unwritable paths fail");
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Profiler Test\n";
+  std::cout << std::string(50, '-') << '\n';
+
+  test_frames();
+  test_percentiles();
+  test_threads();
+  test_dump();
+
+  std::cout << '\n';
+  if (g_failures == 0) {
+    std::cout << "All checks passed\n";
+    return 0;
+  }
+  std::cout << g_failures << " check(s) failed\n";
+  return 1;
+}
@@ -0,0 +1,215 @@
+#include <cctype>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/search_filter.h"
+#include "test_support.h"
+
+FileInfo make_asset(const std::string& directory, const std::string& name, const std::string& extension) {
+  FileInfo asset;
+  asset.name = name;
+  asset.extension = extension;
+  asset.relative_path = directory + "/" + name;
+  asset.full_path = "assets/" + asset.relative_path;
+  return asset;
+}
+
+std::vector<FileInfo> make_library() {
+  return {make_asset("textures", "Grass_Albedo.png", ".png"), make_asset("textures", "grass_normal.png", ".png"),
+          make_asset("models", "Tree.fbx", ".fbx"),           make_asset("audio", "wind.wav", ".wav"),
+          make_asset("textures", "rock.tga", ".tga"),         make_asset("models/grass", "tuft.obj", ".obj")};
+}
+
+// Brute-force reference: every term in the name, extension or path
+std::vector<size_t> reference_filter(const std::vector<FileInfo>& assets, const std::string& query) {
+  std::vector<std::string> terms = split_search_terms(query);
+  std::vector<size_t> results;
+  for (size_t i = 0; i < assets.size(); i++) {
+    std::string fields[] = {assets[i].name, assets[i].extension, assets[i].full_path};
+    for (std::string& field : fields) {
+      for (char& c : field) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+      }
+    }
+    bool all_match = true;
+    for (const std::string& term : terms) {
+      bool term_matches = false;
+      for (const std::string& field : fields) {
+        term_matches = term_matches || field.find(term) != std::string::npos;
+      }
+      all_match = all_match && term_matches;
+    }
+    if (all_match) {
+      results.push_back(i);
+    }
+  }
+  return results;
+}
+
+void test_split_terms() {
+  std::cout << "\n=== Splitting queries ===\n";
+
+  check(split_search_terms("").empty(), "Empty query has no terms");
+  check(split_search_terms("   ").empty(), "Whitespace-only query has no terms");
+  check(split_search_terms("  Grass  PNG ") == std::vector<std::string>({"grass", "png"}),
+        "Terms are lowercased and split on whitespace");
+}
+
+void test_matching() {
+  std::cout << "\n=== Matching ===\n";
+
+  std::vector<FileInfo> assets = make_library();
+  SearchFilter filter(1);
+  filter.set_assets(assets);
+
+  check(filter.update("") && filter.get_results().size() == assets.size(), "Empty query matches everything");
+  check(filter.update("GRASS") && filter.get_results() == std::vector<size_t>({0, 1, 5}),
+        "Matches are case-insensitive and include directory names");
+  check(filter.update("grass png") && filter.get_results() == std::vector<size_t>({0, 1}), "All terms must match");
+  check(filter.update(".wav") && filter.get_results() == std::vector<size_t>({3}), "Extensions match");
+  check(filter.update("nothing") && filter.get_results().empty(), "Unmatched query gives no results");
+}
+
+void test_only_runs_on_change() {
+  std::cout << "\n=== Only filtering on change ===\n";
+
+  std::vector<FileInfo> assets = make_library();
+  SearchFilter filter(1);
+  filter.set_assets(assets);
+
+  check(filter.update("grass"), "First query filters");
+  check(!filter.update("grass"), "Same query again is a no-op");
+  check(!filter.update(" grass "), "Whitespace-only change is a no-op");
+
+  assets.push_back(make_asset("textures", "grass_height.png", ".png"));
+  filter.set_assets(assets);
+  check(filter.update("grass") && filter.get_results() == std::vector<size_t>({0, 1, 5, 6}),
+        "New assets are filtered with the same query");
+  check(!filter.was_narrowed(), "New assets are filtered from scratch");
+}
+
+void test_narrowing() {
+  std::cout << "\n=== Narrowing ===\n";
+
+  std::vector<FileInfo> assets = make_library();
+  SearchFilter filter(1);
+  filter.set_assets(assets);
+
+  filter.update("gr");
+  check(filter.update("gra") && filter.was_narrowed(), "Extending a term narrows");
+  check(filter.get_results() == reference_filter(assets, "gra"), "Narrowed result matches a full scan");
+  check(filter.update("gra png") && !filter.was_narrowed(),
+        "Adding a term with fewer indexed candidates uses the index");
+  check(filter.get_results() == reference_filter(assets, "gra png"), "Indexed result with two terms is right");
+
+  filter.update("g");
+  check(filter.update("g r") && filter.was_narrowed(), "Adding a term too short for the index narrows");
+  check(filter.get_results() == reference_filter(assets, "g r"), "Narrowed result with two terms is right");
+  filter.update("gra png");
+  check(filter.update("gra") && !filter.was_narrowed(), "Removing a term scans again");
+  check(filter.get_results() == reference_filter(assets, "gra"), "Widened result matches a full scan");
+  check(filter.update("tree") && !filter.was_narrowed(), "Unrelated query scans again");
+  check(filter.update("") && !filter.was_narrowed() && filter.get_results().size() == assets.size(),
+        "Clearing the query shows everything");
+}
+
+void test_parallel() {
+  std::cout << "\n=== Parallel filtering ===\n";
+
+  // Enough assets to be split across threads
+  std::vector<FileInfo> assets;
+  for (int i = 0; i < 100000; i++) {
+    std::string name = "asset_" + std::to_string(i * 7919 % 100000) + (i % 3 == 0 ? ".png" : ".wav");
+    assets.push_back(make_asset(i % 5 == 0 ? "textures" : "audio", name, i % 3 == 0 ? ".png" : ".wav"));
+  }
+
+  SearchFilter parallel(4);
+  SearchFilter serial(1);
+  parallel.set_assets(assets);
+  serial.set_assets(assets);
+
+  bool all_equal = true;
+  for (const char* query : {"", "1", "12", "123", "123 png", "textures 9", "nothing"}) {
+    parallel.update(query);
+    serial.update(query);
+    all_equal = all_equal && parallel.get_results() == serial.get_results() &&
+                parallel.get_results() == reference_filter(assets, query);
+  }
+  check(all_equal, "Threaded results match a serial scan, in list order");
+}
+
+void test_fuzzy() {
+  std::cout << "\n=== Fuzzy search ===\n";
+
+  std::vector<FileInfo> assets = make_library();
+  SearchFilter filter(1);
+  filter.set_assets(assets);
+  filter.set_mode(SearchMode::Fuzzy);
+
+  check(filter.update("") && filter.get_results().size() == assets.size(), "Empty query lists everything");
+  check(filter.update("grsalb") && filter.get_results() == std::vector<size_t>({0}), "Subsequences match");
+  check(filter.update("gras") && filter.get_results().size() == 3 && filter.get_results()[2] == 5,
+        "Matches in file names rank above directory matches");
+  check(filter.update("gras png") && filter.was_narrowed() && filter.get_match_count() == 2,
+        "Adding a term narrows the previous matches");
+  check(filter.update("tga") && filter.get_results()[0] == 4, "Extension match ranks first");
+
+  filter.set_result_limit(1);
+  check(filter.update("gras") && filter.get_results() == std::vector<size_t>({0}) && filter.get_match_count() == 3,
+        "Result limit keeps the best and still counts every match");
+
+  filter.set_mode(SearchMode::Substring);
+  check(filter.update("gras") && filter.get_results() == std::vector<size_t>({0, 1, 5}),
+        "Switching back to substring mode filters in list order again");
+}
+
+void test_fuzzy_parallel() {
+  std::cout << "\n=== Parallel fuzzy ranking ===\n";
+
+  std::vector<FileInfo> assets;
+  for (int i = 0; i < 100000; i++) {
+    std::string name = "mesh_" + std::to_string(i * 7919 % 100000) + (i % 3 == 0 ? "_lod0.fbx" : ".obj");
+    assets.push_back(make_asset(i % 5 == 0 ? "models/props" : "models/level", name, i % 3 == 0 ? ".fbx" : ".obj"));
+  }
+
+  SearchFilter parallel(4);
+  SearchFilter serial(1);
+  for (SearchFilter* filter : {&parallel, &serial}) {
+    filter->set_assets(assets);
+    filter->set_mode(SearchMode::Fuzzy);
+    filter->set_result_limit(500);
+  }
+
+  bool all_equal = true;
+  for (const char* query : {"m1", "m12", "props 77", "lod fbx 9", "zzz"}) {
+    parallel.update(query);
+    serial.update(query);
+    all_equal = all_equal && parallel.get_results() == serial.get_results() &&
+                parallel.get_match_count() == serial.get_match_count();
+  }
+  check(all_equal, "Sharded top-k matches a single shard");
+  check(serial.update("m1") && serial.get_results().size() == 500, "Results are cut off at the limit");
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Search Filter Test\n";
+  std::cout << std::string(50, '-') << '\n';
+
+  test_split_terms();
+  test_matching();
+  test_only_runs_on_change();
+  test_narrowing();
+  test_parallel();
+  test_fuzzy();
+  test_fuzzy_parallel();
+
+  std::cout << '\n';
+  if (g_failures == 0) {
+    std::cout << "All checks passed\n";
+    return 0;
+  }
+  std::cout << g_failures << " check(s) failed\n";
+  return 1;
+}
@@ -0,0 +1,207 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/search_index.h"
+#include "test_support.h"
+
+FileInfo make_asset(const std::string& relative_path) {
+  FileInfo asset;
+  asset.relative_path = relative_path;
+  asset.full_path = "assets/" + relative_path;
+  size_t slash = relative_path.rfind('/');
+  asset.name = slash == std::string::npos ? relative_path : relative_path.substr(slash + 1);
+  size_t dot = asset.name.rfind('.');
+  asset.extension = dot == std::string::npos ? "" : asset.name.substr(dot);
+  return asset;
+}
+
+// Positions matching every term, checked one by one
+std::vector<size_t> scan(const SearchIndex& index, const std::vector<std::string>& terms) {
+  std::vector<size_t> positions;
+  for (size_t i = 0; i < index.size(); i++) {
+    if (index.matches(i, terms)) {
+      positions.push_back(i);
+    }
+  }
+  return positions;
+}
+
+// Positions the candidates confirm, or every match if no term could use the index
+std::vector<size_t> search(const SearchIndex& index, const std::vector<std::string>& terms) {
+  std::vector<size_t> candidates;
+  if (!index.get_candidates(terms, candidates)) {
+    return scan(index, terms);
+  }
+  std::vector<size_t> positions;
+  for (size_t position : candidates) {
+    if (index.matches(position, terms)) {
+      positions.push_back(position);
+    }
+  }
+  return positions;
+}
+
+void test_find_substring() {
+  std::cout << "\n=== SIMD substring search ===\n";
+
+  check(find_substring("abc", "") == 0, "Empty needle is found at the start");
+  check(find_substring("ab", "abc") == std::string_view::npos, "Needle longer than haystack isn't found");
+  check(find_substring("xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxab", "ab") == 32, "Two-character needle at the very end");
+  check(find_substring("assets/textures/grass_albedo.png", ".png") == 28, "Extension at the end");
+  check(find_substring("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab", "aab") == 34, "Repeated prefix characters");
+
+  // Every needle length against every position in haystacks around the 16-byte block size, including bytes
+  // above 127
+  bool all_equal = true;
+  unsigned int state = 7;
+  for (int round = 0; round < 2000 && all_equal; round++) {
+    std::string haystack(1 + round % 70, ' ');
+    for (char& c : haystack) {
+      state = state * 1103515245u + 12345u;
+      c = static_cast<char>("ab\xe9/"[(state >> 16) % 4]);
+    }
+    size_t start = (state >> 8) % haystack.size();
+    size_t length = 1 + (state >> 4) % (haystack.size() - start);
+    std::string needle = round % 3 == 0 ? std::string(length, 'b') : haystack.substr(start, length);
+    all_equal = find_substring(haystack, needle) == haystack.find(needle);
+  }
+  check(all_equal, "Matches std::string::find on random haystacks");
+}
+
+void test_candidates() {
+  std::cout << "\n=== Trigram candidates ===\n";
+
+  std::vector<FileInfo> assets = {make_asset("textures/Grass_Albedo.png"), make_asset("textures/grass_normal.png"),
+                                  make_asset("models/Tree.fbx"), make_asset("audio/wind.wav"),
+                                  make_asset("textures/caf\xc3\xa9_sign.png")};
+  SearchIndex index;
+  index.update(assets);
+
+  std::vector<size_t> candidates;
+  check(!index.get_candidates({"gr", "a"}, candidates), "Terms shorter than three characters can't use the index");
+  check(index.get_candidates({"grass"}, candidates) && candidates == std::vector<size_t>({0, 1}),
+        "A term's candidates are the assets containing all its trigrams");
+  check(index.get_candidates({"grass", "normal"}, candidates) && candidates == std::vector<size_t>({1}),
+        "Terms intersect");
+  check(index.get_candidates({"zebra"}, candidates) && candidates.empty(), "Unknown trigram leaves no candidates");
+  check(search(index, {"assets/textures"}) == std::vector<size_t>({0, 1, 4}), "Directories are indexed");
+  check(search(index, {"caf\xc3\xa9"}) == std::vector<size_t>({4}), "Non-ASCII bytes are indexed");
+
+  bool all_equal = true;
+  for (const std::vector<std::string>& terms : std::vector<std::vector<std::string>>{
+           {"png"}, {"tex", "alb"}, {"ree.f"}, {".wav"}, {"s/g"}, {"e", "png"}}) {
+    all_equal = all_equal && search(index, terms) == scan(index, terms);
+  }
+  check(all_equal, "Indexed results match a full scan");
+}
+
+void test_incremental_update() {
+  std::cout << "\n=== Incremental updates ===\n";
+
+  std::vector<FileInfo> assets;
+  for (int i = 0; i < 100; i++) {
+    assets.push_back(make_asset("textures/tile_" + std::to_string(1000 + i) + ".png"));
+  }
+  SearchIndex index;
+  index.update(assets);
+  check(index.get_stats().added == 100 && index.get_stats().assets == 100, "First update indexes every asset");
+
+  index.update(assets);
+  check(index.get_stats().added == 0 && index.get_stats().removed == 0, "Same list again indexes nothing");
+
+  assets.insert(assets.begin() + 50, make_asset("textures/tile_1049b.png"));
+  index.update(assets);
+  check(index.get_stats().added == 1 && index.get_stats().removed == 0, "Inserting one asset indexes only it");
+  check(search(index, {"1049b"}) == std::vector<size_t>({50}), "Inserted asset is found at its position");
+  check(search(index, {"tile_1050"}) == std::vector<size_t>({51}), "Assets after it moved along");
+
+  assets[10] = make_asset("textures/tile_1010_renamed.png");
+  index.update(assets);
+  check(index.get_stats().added == 1 && index.get_stats().removed == 1, "Renaming re-indexes one asset");
+  check(search(index, {"renamed"}) == std::vector<size_t>({10}), "Renamed asset is found under its new name");
+  check(search(index, {"tile_1010.png"}).empty(), "Old name is gone");
+
+  assets.erase(assets.begin(), assets.begin() + 20);
+  index.update(assets);
+  check(index.get_stats().removed == 20 && index.size() == 81, "Deleting assets drops them");
+  check(search(index, {"tile_1005"}).empty() && search(index, {"tile_1020"}) == std::vector<size_t>({0}),
+        "Deleted assets aren't found and the rest shifted");
+}
+
+void test_splice() {
+  std::cout << "\n=== Splicing edits ===\n";
+
+  std::vector<FileInfo> assets;
+  for (int i = 0; i < 100; i++) {
+    assets.push_back(make_asset("sounds/step_" + std::to_string(1000 + i) + ".wav"));
+  }
+  SearchIndex index;
+  index.update(assets);
+
+  // Drop positions 3 and 40 of the old list and insert two assets, the way the asset store reports a batch
+  std::vector<FileInfo> edited;
+  for (int i = 0; i < 100; i++) {
+    if (i == 3 || i == 40) {
+      continue;
+    }
+    edited.push_back(assets[i]);
+    if (i == 10) {
+      edited.push_back(make_asset("sounds/step_1010b.wav"));
+    }
+  }
+  edited.push_back(make_asset("sounds/step_2000.wav"));
+  index.splice(edited, {3, 40}, {10, 99});
+  check(index.get_stats().added == 2 && index.get_stats().removed == 2 && index.size() == 100,
+        "Splicing indexes only the inserted assets");
+  check(search(index, {"1010b"}) == std::vector<size_t>({10}) && search(index, {"2000"}) == std::vector<size_t>({99}),
+        "Inserted assets are found at their positions");
+  check(search(index, {"step_1003"}).empty() && search(index, {"step_1041"}) == std::vector<size_t>({40}),
+        "Removed assets are gone and the rest shifted");
+
+  SearchIndex rebuilt;
+  rebuilt.update(edited);
+  check(search(index, {"step_10", "wav"}) == search(rebuilt, {"step_10", "wav"}),
+        "Results match an index built from the edited list");
+}
+
+void test_compaction() {
+  std::cout << "\n=== Compaction ===\n";
+
+  std::vector<FileInfo> assets;
+  for (int i = 0; i < 3000; i++) {
+    assets.push_back(make_asset("level_" + std::to_string(i % 7) + "/mesh_" + std::to_string(10000 + i) + ".obj"));
+  }
+  SearchIndex index;
+  index.update(assets);
+  size_t postings = index.get_stats().postings;
+
+  assets.resize(1000);
+  index.update(assets);
+  SearchIndexStats stats = index.get_stats();
+  check(stats.compactions == 1, "Index compacts once removed assets outnumber live ones");
+  check(stats.postings < postings / 2, "Compaction drops the postings of removed assets");
+  check(search(index, {"mesh_10999"}) == std::vector<size_t>({999}), "Assets are still found after compacting");
+  check(search(index, {"mesh_11000"}).empty(), "Removed assets stay gone after compacting");
+  check(search(index, {"level_3", "obj"}) == scan(index, {"level_3", "obj"}), "Compacted results match a scan");
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Search Index Test\n";
+  std::cout << std::string(50, '-') << '\n';
+
+  test_find_substring();
+  test_candidates();
+  test_incremental_update();
+  test_splice();
+  test_compaction();
+
+  std::cout << '\n';
+  if (g_failures == 0) {
+    std::cout << "All checks passed\n";
+    return 0;
+  }
+  std::cout << g_failures << " check(s) failed\n";
+  return 1;
+}
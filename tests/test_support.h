@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+// Helpers shared by the test executables. Each executable is one test file plus the sources it tests, so every
+// test counts its own failures.
+
+static int g_failures = 0;
+
+inline void check(bool condition, const std::string& description) {
+  std::cout << (condition ? "  [PASS] " : "  [FAIL] ") << description << '\n';
+  if (!condition) {
+    g_failures++;
+  }
+}
+
+// Delete a SQLite database along with its write-ahead log and shared-memory index
+inline void remove_database(const std::string& db_path) {
+  for (const char* suffix : {"", "-wal", "-shm"}) {
+    std::remove((db_path + suffix).c_str());
+  }
+}
+
+// Write a file, creating the directories above it
+inline void write_file(const std::string& path, const std::string& contents) {
+  std::filesystem::path parent = std::filesystem::path(path).parent_path();
+  if (!parent.empty()) {
+    std::filesystem::create_directories(parent);
+  }
+  std::ofstream(path, std::ios::binary) << contents;
+}
+
+// A binary fixture built up in a string, as the parsers under test see it
+inline const unsigned char* bytes(const std::string& data) {
+  return reinterpret_cast<const unsigned char*>(data.data());
+}
+
+// Append the low `size` bytes of `value`, least significant first
+inline void append_le(std::string& out, uint64_t value, int size) {
+  for (int i = 0; i < size; i++) {
+    out += static_cast<char>(value >> (8 * i));
+  }
+}
@@ -0,0 +1,198 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/path_utils.h"
+#include "../src/texture_cache.h"
+#include "test_support.h"
+
+using namespace std::chrono_literals;
+
+CachedTexture texture_in_slot(AtlasSlot slot) {
+  CachedTexture texture;
+  texture.slot = slot;
+  texture.width = 10;
+  texture.height = 10;
+  return texture;
+}
+
+// Look a path up and, if it's pending, complete it the way the upload path would
+TextureState show(TextureCache& cache, const std::string& path, AtlasSlot slot, uint64_t bytes = 100) {
+  CachedTexture texture;
+  TextureState state = cache.lookup(path, texture);
+  if (state == TextureState::Pending) {
+    cache.insert(path, texture_in_slot(slot), bytes);
+  }
+  return state;
+}
+
+void test_hits_and_misses() {
+  std::cout << "\n=== Hits and misses ===\n";
+
+  TextureCache cache(1000);
+  CachedTexture texture;
+  check(cache.lookup("a.png", texture) == TextureState::Pending, "Unknown path is pending");
+  check(cache.lookup("a.png", texture) == TextureState::Pending, "It stays pending until uploaded");
+  cache.insert("a.png", texture_in_slot(7), 100);
+  check(cache.lookup("a.png", texture) == TextureState::Loaded && texture.slot == 7, "Uploaded texture is a hit");
+
+  TextureCacheStats stats = cache.get_stats();
+  check(stats.hits == 1 && stats.misses == 1 && stats.bytes == 100 && stats.entries == 1,
+        "A pending path counts as one miss, not one per frame");
+}
+
+void test_eviction() {
+  std::cout << "\n=== LRU eviction ===\n";
+
+  std::vector<AtlasSlot> released;
+  TextureCache cache(300);
+  cache.set_release_callback([&released](const CachedTexture& texture) { released.push_back(texture.slot); });
+
+  // Frame 1 shows a, b and c
+  show(cache, "a", 1);
+  show(cache, "b", 2);
+  show(cache, "c", 3);
+
+  // Frame 2 shows a and d; b is the least recently used
+  cache.begin_frame();
+  show(cache, "a", 1);
+  show(cache, "d", 4);
+  CachedTexture texture;
+  check(released.size() == 1 && released[0] == 2, "Least recently used texture is evicted and its slot released");
+  check(cache.get_stats().bytes == 300 && cache.get_stats().evictions == 1, "Cache stays within its budget");
+
+  // Frame 3 shows five textures at once; on-screen ones are never evicted
+  cache.begin_frame();
+  for (int i = 0; i < 5; i++) {
+    show(cache, "screen" + std::to_string(i), 10 + i);
+  }
+  check(cache.get_stats().bytes == 500, "Pinned textures may exceed the budget");
+  bool all_loaded = true;
+  for (int i = 0; i < 5; i++) {
+    all_loaded = all_loaded && cache.lookup("screen" + std::to_string(i), texture) == TextureState::Loaded;
+  }
+  check(all_loaded, "Every texture on screen stays loaded");
+
+  // Once two of them scroll away the cache shrinks back
+  cache.begin_frame();
+  for (int i = 2; i < 5; i++) {
+    cache.lookup("screen" + std::to_string(i), texture);
+  }
+  cache.begin_frame();
+  check(cache.get_stats().bytes == 300, "Budget is restored when pinned textures scroll away");
+
+  cache.set_budget(100);
+  check(cache.get_stats().bytes == 100 && cache.get_stats().budget == 100, "Lowering the budget evicts");
+
+  size_t before = released.size();
+  cache.clear();
+  check(released.size() == before + 1 && cache.get_stats().bytes == 0, "Clear releases every loaded texture");
+}
+
+void test_failures() {
+  std::cout << "\n=== Failure retries ===\n";
+
+  RetryPolicy policy;
+  policy.initial_delay = 1000ms;
+  policy.max_delay = 3000ms;
+  policy.max_attempts = 4;
+  TextureCache cache(1000, policy);
+
+  auto start = TextureCache::Clock::now();
+  CachedTexture texture;
+  cache.lookup("broken.png", texture, start);
+  cache.insert_failure("broken.png", start);
+  check(cache.lookup("broken.png", texture, start + 999ms) == TextureState::Failed, "Failure is cached");
+  check(cache.lookup("broken.png", texture, start + 1000ms) == TextureState::Pending, "It's retried after the delay");
+
+  // Second failure doubles the delay
+  auto second = start + 1000ms;
+  cache.insert_failure("broken.png", second);
+  check(cache.lookup("broken.png", texture, second + 1999ms) == TextureState::Failed &&
+            cache.lookup("broken.png", texture, second + 2000ms) == TextureState::Pending,
+        "Delay doubles after each failure");
+
+  // Third failure is capped at the maximum delay
+  auto third = second + 2000ms;
+  cache.insert_failure("broken.png", third);
+  check(cache.lookup("broken.png", texture, third + 3000ms) == TextureState::Pending, "Delay is capped");
+
+  cache.insert_failure("broken.png", third + 3000ms);
+  check(cache.lookup("broken.png", texture, third + 1h) == TextureState::Failed, "File is given up on after the limit");
+
+  cache.remove("broken.png");
+  check(cache.lookup("broken.png", texture, third + 1h) == TextureState::Pending, "Invalidation starts over");
+
+  TextureCacheStats stats = cache.get_stats();
+  check(stats.failures == 4 && stats.retries == 3 && stats.bytes == 0, "Failures and retries are counted");
+}
+
+void test_invalidation() {
+  std::cout << "\n=== Invalidation ===\n";
+
+  std::vector<AtlasSlot> released;
+  TextureCache cache(1000);
+  cache.set_release_callback([&released](const CachedTexture& texture) { released.push_back(texture.slot); });
+  show(cache, "assets/maps/a.png", 1);
+  show(cache, "assets/maps/b.png", 2);
+  show(cache, "assets/mapsold/c.png", 3);
+
+  cache.remove_under("assets/maps");
+  CachedTexture texture;
+  check(released.size() == 2 && cache.get_stats().bytes == 100, "Directory invalidation releases what's below it");
+  check(cache.lookup("assets/mapsold/c.png", texture) == TextureState::Loaded, "Sibling with a common prefix is kept");
+  check(cache.remove("assets/mapsold/c.png") && !cache.remove("assets/mapsold/c.png"), "Removing twice is harmless");
+
+  // '\\' separates components only where it is the platform's separator, as in the database and the asset list
+  show(cache, "assets/maps\\d.png", 4);
+  cache.remove_under("assets/maps");
+  bool kept = cache.lookup("assets/maps\\d.png", texture) == TextureState::Loaded;
+  check(kept == (PATH_SEPARATOR_COUNT == 1), "A backslash counts as a separator only on Windows");
+  cache.remove("assets/maps\\d.png");
+
+  // Replacing a texture releases the old slot
+  show(cache, "x.png", 5);
+  cache.insert("x.png", texture_in_slot(6), 100);
+  check(released.back() == 5 && cache.get_stats().bytes == 100, "Replacing releases the previous texture");
+}
+
+void test_evict_if() {
+  std::cout << "\n=== Selective eviction ===\n";
+
+  std::vector<AtlasSlot> released;
+  TextureCache cache(1000);
+  cache.set_release_callback([&released](const CachedTexture& texture) { released.push_back(texture.slot); });
+  show(cache, "a", 1);
+  show(cache, "b", 2);
+  show(cache, "c", 3);
+  cache.insert_failure("broken.png");
+
+  // Frame 2 only shows c, so it's pinned
+  cache.begin_frame();
+  show(cache, "c", 3);
+  cache.evict_if([](const CachedTexture& texture) { return texture.slot != 2; });
+
+  CachedTexture texture;
+  check(released.size() == 1 && released[0] == 1, "Only selected, unpinned textures are evicted");
+  check(cache.lookup("b", texture) == TextureState::Loaded && cache.lookup("c", texture) == TextureState::Loaded,
+        "Unselected and pinned textures stay");
+  check(cache.lookup("broken.png", texture) == TextureState::Failed, "Failures are not evicted");
+
+  TextureCacheStats stats = cache.get_stats();
+  check(stats.evictions == 1 && stats.bytes == 200, "Selective evictions are counted");
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Texture Cache Test\n";
+  std::cout << std::string(80, '-') << '\n';
+
+  test_hits_and_misses();
+  test_eviction();
+  test_failures();
+  test_invalidation();
+  test_evict_if();
+
+  std::cout << '\n' << (g_failures == 0 ? "All checks passed" : "Some checks failed") << '\n';
+  return g_failures == 0 ? 0 : 1;
+}
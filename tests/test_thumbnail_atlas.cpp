@@ -0,0 +1,177 @@
+#include <iostream>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../src/thumbnail_atlas.h"
+#include "test_support.h"
+
+// Records what the atlas asks of the GPU
+class FakeBackend : public AtlasBackend {
+ public:
+  struct Upload {
+    unsigned int texture_id;
+    int x;
+    int y;
+    int width;
+    int height;
+  };
+
+  std::set<unsigned int> live_pages;
+  std::vector<Upload> uploads;
+  unsigned int next_id = 1;
+  bool fail_creation = false;
+
+  unsigned int create_page(int) override {
+    if (fail_creation) {
+      return 0;
+    }
+    live_pages.insert(next_id);
+    return next_id++;
+  }
+
+  void destroy_page(unsigned int texture_id) override { live_pages.erase(texture_id); }
+
+  void upload(unsigned int texture_id, int x, int y, int width, int height, const unsigned char*) override {
+    uploads.push_back({texture_id, x, y, width, height});
+  }
+};
+
+const std::vector<unsigned char> PIXELS(30 * 30 * 4, 255);
+
+void test_layout() {
+  std::cout << "\n=== Slot layout ===\n";
+
+  // 30px slots with a 1px gap on each side: two per row on a 64px page
+  FakeBackend backend;
+  ThumbnailAtlas atlas(backend, 30, 64);
+  check(atlas.get_slots_per_page() == 4, "Page is split into a grid of padded slots");
+
+  AtlasSlot first = atlas.allocate(PIXELS.data(), 30, 20);
+  AtlasSlot second = atlas.allocate(PIXELS.data(), 10, 30);
+  check(first != INVALID_ATLAS_SLOT && second != INVALID_ATLAS_SLOT && atlas.get_page_count() == 1,
+        "Allocations share one page");
+  check(backend.uploads.size() == 2 && backend.uploads[0].x == 1 && backend.uploads[0].y == 1 &&
+            backend.uploads[1].x == 33 && backend.uploads[1].y == 1,
+        "Pixels are uploaded to consecutive padded slots");
+
+  AtlasRegion region;
+  check(atlas.get_region(second, region) && region.texture_id == backend.uploads[1].texture_id &&
+            region.width == 10 && region.height == 30,
+        "Region reports the page texture and thumbnail size");
+  check(region.u0 == 33.0f / 64 && region.v0 == 1.0f / 64 && region.u1 == 43.0f / 64 && region.v1 == 31.0f / 64,
+        "UVs cover exactly the thumbnail's pixels");
+
+  check(atlas.allocate(PIXELS.data(), 31, 10) == INVALID_ATLAS_SLOT, "Image larger than a slot is refused");
+  check(atlas.allocate(nullptr, 10, 10) == INVALID_ATLAS_SLOT, "Missing pixels are refused");
+}
+
+void test_pages() {
+  std::cout << "\n=== Pages ===\n";
+
+  FakeBackend backend;
+  ThumbnailAtlas atlas(backend, 30, 64);
+  std::vector<AtlasSlot> slots;
+  for (int i = 0; i < 6; i++) {
+    slots.push_back(atlas.allocate(PIXELS.data(), 30, 30));
+  }
+  check(atlas.get_page_count() == 2 && atlas.get_used_slot_count() == 6, "A second page is created when one is full");
+
+  atlas.free(slots[1]);
+  check(atlas.get_used_slot_count() == 5, "Freeing gives the slot back");
+  AtlasSlot reused = atlas.allocate(PIXELS.data(), 30, 30);
+  check(reused == slots[1], "Lowest free slot on the lowest page is reused first");
+  atlas.free(slots[1]);
+  atlas.free(slots[1]);
+  check(atlas.get_used_slot_count() == 5, "Freeing twice is harmless");
+
+  AtlasRegion region;
+  check(!atlas.get_region(slots[1], region), "Freed slot has no region");
+
+  atlas.free(slots[4]);
+  atlas.free(slots[5]);
+  check(atlas.get_page_count() == 1 && backend.live_pages.size() == 1, "Empty page is released");
+
+  for (AtlasSlot slot : {slots[0], slots[2], slots[3]}) {
+    atlas.free(slot);
+  }
+  check(atlas.get_page_count() == 1 && atlas.get_used_slot_count() == 0, "Last page is kept for reuse");
+
+  atlas.allocate(PIXELS.data(), 30, 30);
+  atlas.clear();
+  check(backend.live_pages.empty() && atlas.get_used_slot_count() == 0, "Clear releases every page");
+
+  backend.fail_creation = true;
+  check(atlas.allocate(PIXELS.data(), 30, 30) == INVALID_ATLAS_SLOT, "Failed page creation fails the allocation");
+  backend.fail_creation = false;
+  AtlasSlot slot = atlas.allocate(PIXELS.data(), 30, 30);
+  check(slot == 0 && atlas.get_region(slot, region), "Atlas recovers once pages can be created again");
+}
+
+void test_page_usage() {
+  std::cout << "\n=== Page usage ===\n";
+
+  FakeBackend backend;
+  ThumbnailAtlas atlas(backend, 30, 64);
+  uint32_t page = 0;
+  check(atlas.get_page_bytes() == 64 * 64 * 4, "A page costs its full RGBA8 size");
+  check(!atlas.get_least_used_page(page), "An empty atlas has no least used page");
+
+  std::vector<AtlasSlot> slots;
+  for (int i = 0; i < 10; i++) {
+    slots.push_back(atlas.allocate(PIXELS.data(), 30, 30));
+  }
+  check(atlas.get_page_of(slots[3]) == 0 && atlas.get_page_of(slots[4]) == 1 && atlas.get_page_of(slots[9]) == 2,
+        "Slots map to the page that holds them");
+  check(atlas.get_least_used_page(page) && page == 2, "Partly filled last page is the least used");
+
+  // Leave one thumbnail on the middle page; freeing it is what gives that page back
+  for (int i = 4; i < 7; i++) {
+    atlas.free(slots[i]);
+  }
+  check(atlas.get_least_used_page(page) && page == 1, "Page with the fewest thumbnails left is the least used");
+  atlas.free(slots[7]);
+  check(atlas.get_page_count() == 2 && atlas.get_least_used_page(page) && page == 2,
+        "Emptied page is released and no longer considered");
+}
+
+void test_many_thumbnails() {
+  std::cout << "\n=== Many thumbnails ===\n";
+
+  // The application's configuration: 180px thumbnails on 2048px pages
+  FakeBackend backend;
+  ThumbnailAtlas atlas(backend, 180);
+  check(atlas.get_slots_per_page() == 121, "A page holds 121 thumbnails");
+
+  std::vector<AtlasSlot> slots;
+  for (int i = 0; i < 1000; i++) {
+    slots.push_back(atlas.allocate(PIXELS.data(), 30, 30));
+  }
+  std::set<AtlasSlot> unique(slots.begin(), slots.end());
+  check(unique.size() == 1000 && !unique.count(INVALID_ATLAS_SLOT), "Every allocation gets its own slot");
+  check(atlas.get_page_count() == 9, "1000 thumbnails fit in nine pages");
+
+  // Scattered frees followed by new allocations refill the holes before adding pages
+  for (size_t i = 0; i < slots.size(); i += 3) {
+    atlas.free(slots[i]);
+  }
+  size_t freed = (slots.size() + 2) / 3;
+  for (size_t i = 0; i < freed; i++) {
+    atlas.allocate(PIXELS.data(), 30, 30);
+  }
+  check(atlas.get_page_count() == 9 && atlas.get_used_slot_count() == 1000, "Holes are refilled before new pages");
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Thumbnail Atlas Test\n";
+  std::cout << std::string(80, '-') << '\n';
+
+  test_layout();
+  test_pages();
+  test_page_usage();
+  test_many_thumbnails();
+
+  std::cout << '\n' << (g_failures == 0 ? "All checks passed" : "Some checks failed") << '\n';
+  return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,223 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../src/thumbnail_cache.h"
+#include "../src/thumbnail_loader.h"
+#include "stb_image.h"
+#include "test_support.h"
+
+const std::string DB_PATH = "test_thumbnail_cache.db";
+
+// Thumbnails fitted to 128 pixels, made by the current pipeline
+const ThumbnailFormat FORMAT = {128, 1};
+
+Thumbnail make_thumbnail(int width, int height, unsigned char value) {
+  Thumbnail thumbnail;
+  thumbnail.width = width;
+  thumbnail.height = height;
+  thumbnail.pixels.assign(static_cast<size_t>(width) * height * 4, value);
+  return thumbnail;
+}
+
+void test_store_and_load() {
+  std::cout << "\n=== Store and load ===\n";
+  remove_database(DB_PATH);
+
+  ThumbnailCache cache;
+  check(cache.initialize(DB_PATH), "Cache opens a new database");
+  check(cache.store("assets/a.png", 100, 5, FORMAT, make_thumbnail(4, 2, 7)), "Thumbnail is stored");
+
+  Thumbnail loaded;
+  check(cache.load("assets/a.png", 100, 5, FORMAT, loaded) && loaded.width == 4 && loaded.height == 2 &&
+            loaded.pixels.size() == 32 && loaded.pixels[0] == 7,
+        "Thumbnail loads back with the same size and mtime");
+  check(!cache.load("assets/a.png", 101, 5, FORMAT, loaded), "A different file size is a miss");
+  check(!cache.load("assets/a.png", 100, 6, FORMAT, loaded), "A different modification time is a miss");
+  check(!cache.load("assets/b.png", 100, 5, FORMAT, loaded), "Unknown path is a miss");
+  check(!cache.load("assets/a.png", 100, 5, {64, 1}, loaded) && !cache.load("assets/a.png", 100, 5, {128, 2}, loaded),
+        "A thumbnail made at another size or with other options is a miss");
+
+  check(cache.store("assets/a.png", 120, 9, FORMAT, make_thumbnail(2, 2, 9)), "Newer version replaces the entry");
+  check(cache.load("assets/a.png", 120, 9, FORMAT, loaded) && loaded.pixels[0] == 9 &&
+            cache.get_stats().total_bytes == 16,
+        "Replacing frees the old bytes");
+
+  ThumbnailCacheStats stats = cache.get_stats();
+  check(stats.hits == 2 && stats.misses == 5 && stats.stores == 2, "Hits, misses and stores are counted");
+
+  // Entries survive reopening
+  cache.close();
+  ThumbnailCache reopened;
+  reopened.initialize(DB_PATH);
+  check(reopened.load("assets/a.png", 120, 9, FORMAT, loaded) && reopened.get_stats().total_bytes == 16,
+        "Thumbnails persist across runs");
+}
+
+void test_upgrade() {
+  std::cout << "\n=== Upgrading ===\n";
+  remove_database(DB_PATH);
+
+  // The table as builds before the format was recorded left it
+  sqlite3* db = nullptr;
+  sqlite3_open(DB_PATH.c_str(), &db);
+  sqlite3_exec(db,
+               "CREATE TABLE thumbnails (full_path TEXT PRIMARY KEY, file_size INTEGER NOT NULL, "
+               "last_write_time INTEGER NOT NULL, width INTEGER NOT NULL, height INTEGER NOT NULL, "
+               "pixels BLOB NOT NULL, last_access INTEGER NOT NULL);"
+               "INSERT INTO thumbnails VALUES ('assets/a.png', 100, 5, 1, 1, x'01020304', 1);",
+               nullptr, nullptr, nullptr);
+  sqlite3_close(db);
+
+  ThumbnailCache cache;
+  Thumbnail loaded;
+  check(cache.initialize(DB_PATH) && cache.get_stats().total_bytes == 0, "Thumbnails of unknown make are dropped");
+  check(!cache.load("assets/a.png", 100, 5, FORMAT, loaded), "They aren't served");
+  check(cache.store("assets/a.png", 100, 5, FORMAT, make_thumbnail(2, 2, 1)) &&
+            cache.load("assets/a.png", 100, 5, FORMAT, loaded),
+        "New ones are stored in their place");
+}
+
+void test_eviction() {
+  std::cout << "\n=== LRU eviction ===\n";
+  remove_database(DB_PATH);
+
+  // Room for three 2x2 thumbnails
+  ThumbnailCache cache;
+  cache.initialize(DB_PATH, 48);
+  cache.store("a", 1, 1, FORMAT, make_thumbnail(2, 2, 1));
+  cache.store("b", 1, 1, FORMAT, make_thumbnail(2, 2, 2));
+  cache.store("c", 1, 1, FORMAT, make_thumbnail(2, 2, 3));
+
+  Thumbnail loaded;
+  cache.load("a", 1, 1, FORMAT, loaded);  // `b` is now the least recently used
+  cache.store("d", 1, 1, FORMAT, make_thumbnail(2, 2, 4));
+
+  check(!cache.load("b", 1, 1, FORMAT, loaded), "Least recently used entry is evicted");
+  check(cache.load("a", 1, 1, FORMAT, loaded) && cache.load("c", 1, 1, FORMAT, loaded) &&
+            cache.load("d", 1, 1, FORMAT, loaded),
+        "Recently used entries are kept");
+  check(cache.get_stats().total_bytes == 48 && cache.get_stats().evictions == 1, "Cache stays within its cap");
+  check(!cache.store("huge", 1, 1, FORMAT, make_thumbnail(8, 8, 0)), "Thumbnail larger than the cap is refused");
+
+  // A lower cap on the next run trims the table
+  cache.close();
+  ThumbnailCache smaller;
+  smaller.initialize(DB_PATH, 16);
+  check(smaller.get_stats().total_bytes == 16 && smaller.load("d", 1, 1, FORMAT, loaded), "Lowered cap evicts on open");
+}
+
+// Write a binary PPM the decoder can read
+void write_image(const std::string& path, int width, int height) {
+  std::ofstream out(path, std::ios::binary);
+  out << "P6\n" << width << ' ' << height << "\n255\n";
+  for (int i = 0; i < width * height; i++) {
+    out.put(static_cast<char>(200)).put(static_cast<char>(100)).put(static_cast<char>(50));
+  }
+}
+
+// Request every path and wait for all results
+std::vector<ThumbnailResult> load_all(ThumbnailLoader& loader, const std::vector<std::string>& paths) {
+  loader.begin_frame();
+  for (const auto& path : paths) {
+    loader.request(path);
+  }
+  loader.end_frame();
+
+  std::vector<ThumbnailResult> results;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (results.size() < paths.size() && std::chrono::steady_clock::now() < deadline) {
+    ThumbnailResult result;
+    if (loader.poll(result)) {
+      results.push_back(std::move(result));
+    } else {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  return results;
+}
+
+void test_loader_integration() {
+  std::cout << "\n=== Loader integration ===\n";
+  remove_database(DB_PATH);
+  std::vector<std::string> paths = {"test_thumbnail_wide.ppm", "test_thumbnail_small.ppm"};
+  write_image(paths[0], 64, 32);
+  write_image(paths[1], 8, 8);
+
+  {
+    ThumbnailCache cache;
+    cache.initialize(DB_PATH);
+    ThumbnailLoader loader(2);
+    loader.set_thumbnail_size(16);
+    loader.set_cache(&cache);
+    loader.start();
+
+    std::vector<ThumbnailResult> results = load_all(loader, paths);
+    bool sizes_ok = results.size() == 2;
+    for (const auto& result : results) {
+      bool wide = result.path == paths[0];
+      sizes_ok = sizes_ok && result.width == (wide ? 16 : 8) && result.height == 8 && result.pixels[0] == 200;
+    }
+    check(sizes_ok, "Images are downscaled to fit the thumbnail size, small ones are left alone");
+    check(loader.get_decoded_count() == 2 && cache.get_stats().stores == 2, "First visit decodes and stores");
+  }
+
+  // A later run over the same folder
+  ThumbnailCache cache;
+  cache.initialize(DB_PATH);
+  ThumbnailLoader loader(2);
+  loader.set_thumbnail_size(16);
+  loader.set_cache(&cache);
+  loader.start();
+  std::vector<ThumbnailResult> results = load_all(loader, paths);
+  check(results.size() == 2 && loader.get_decoded_count() == 0 && cache.get_stats().hits == 2,
+        "Revisiting a folder needs no decodes");
+
+  // Rewriting a file with a different size invalidates its entry
+  loader.stop();
+  write_image(paths[1], 4, 4);
+  loader.start();
+  results = load_all(loader, {paths[1]});
+  check(results.size() == 1 && results[0].width == 4 && loader.get_decoded_count() == 1,
+        "Changed file is decoded again");
+
+  // As are thumbnails made with other settings, e.g. by a build that didn't downscale in linear light
+  loader.stop();
+  ResizeOptions gamma_correct;
+  gamma_correct.gamma_correct = true;
+  loader.set_resize_options(gamma_correct);
+  loader.start();
+  results = load_all(loader, {paths[0]});
+  check(results.size() == 1 && loader.get_decoded_count() == 2, "Changing the resize options decodes again");
+  loader.stop();
+  loader.set_thumbnail_size(8);
+  loader.start();
+  results = load_all(loader, {paths[0]});
+  check(results.size() == 1 && results[0].width == 8 && loader.get_decoded_count() == 3,
+        "Changing the thumbnail size decodes again");
+
+  for (const auto& path : paths) {
+    std::remove(path.c_str());
+  }
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Thumbnail Cache Test\n";
+  std::cout << std::string(80, '-') << '\n';
+
+  test_store_and_load();
+  test_upgrade();
+  test_eviction();
+  test_loader_integration();
+  remove_database(DB_PATH);
+
+  std::cout << '\n' << (g_failures == 0 ? "All checks passed" : "Some checks failed") << '\n';
+  return g_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,143 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../src/thumbnail_loader.h"
+#include "stb_image.h"
+#include "test_support.h"
+
+// Non-ASCII names, in UTF-8 as the indexer passes them, must reach the decoder intact
+const std::string ACCENTED_NAME = "test_thumbnail_\xc3\xa9t\xc3\xa9.ppm";
+
+// Write a small binary PPM, which the decoder reads like any other image
+std::string write_image(const std::string& name, int width, int height) {
+  std::ofstream out(std::filesystem::u8path(name), std::ios::binary);
+  out << "P6\n" << width << ' ' << height << "\n255\n";
+  for (int i = 0; i < width * height; i++) {
+    out.put(static_cast<char>(i * 40)).put(static_cast<char>(255)).put(static_cast<char>(0));
+  }
+  return name;
+}
+
+// Poll until `count` results arrived or a generous timeout passed
+std::vector<ThumbnailResult> wait_for_results(ThumbnailLoader& loader, size_t count) {
+  std::vector<ThumbnailResult> results;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (results.size() < count && std::chrono::steady_clock::now() < deadline) {
+    ThumbnailResult result;
+    if (loader.poll(result)) {
+      results.push_back(std::move(result));
+    } else {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  return results;
+}
+
+void test_decode() {
+  std::cout << "\n=== Decoding ===\n";
+  std::string a = write_image("test_thumbnail_a.ppm", 4, 2);
+  std::string accented = write_image(ACCENTED_NAME, 2, 2);
+  std::string missing = "test_thumbnail_missing.ppm";
+  std::string empty = "test_thumbnail_empty.ppm";
+  std::ofstream(empty, std::ios::binary).close();
+
+  ThumbnailLoader loader(2);
+  std::atomic<int> callbacks(0);
+  loader.set_result_callback([&callbacks] { callbacks++; });
+  loader.start();
+  loader.begin_frame();
+  loader.request(a);
+  loader.request(a);
+  loader.request(accented);
+  loader.request(missing);
+  loader.request(empty);
+  loader.end_frame();
+  check(loader.is_pending(a), "Request is pending until its result is polled");
+
+  std::vector<ThumbnailResult> results = wait_for_results(loader, 4);
+  check(results.size() == 4, "Each path is decoded once even if requested twice");
+  for (const auto& result : results) {
+    if (result.path == a) {
+      const unsigned char* pixels = result.pixels.data();
+      check(!result.pixels.empty() && result.width == 4 && result.height == 2 && pixels[4] == 40 && pixels[7] == 255,
+            "Decoded pixels are RGBA");
+    } else if (result.path == accented) {
+      check(result.width == 2 && result.height == 2, "A non-ASCII path is decoded");
+    } else if (result.path == empty) {
+      check(result.pixels.empty(), "Empty file reports a failed decode");
+    } else {
+      check(result.pixels.empty(), "Missing file reports a failed decode");
+    }
+  }
+  check(!loader.is_pending(a), "Polled result is no longer pending");
+  loader.stop();  // Joins the workers, so their callbacks have returned
+  check(callbacks == 4 && !loader.has_results(), "Every finished decode is signalled");
+}
+
+void test_cancellation() {
+  std::cout << "\n=== Cancellation ===\n";
+  std::string a = write_image("test_thumbnail_a.ppm", 2, 2);
+  std::string b = write_image("test_thumbnail_b.ppm", 2, 2);
+  std::string c = write_image("test_thumbnail_c.ppm", 2, 2);
+
+  // Queue requests before any worker runs, so nothing has started yet
+  ThumbnailLoader loader(1);
+  loader.begin_frame();
+  loader.request(a);
+  loader.request(b);
+  loader.request(c);
+  loader.end_frame();
+
+  // Next frame only `a` and `b` are still visible, and `b` changed on disk
+  loader.begin_frame();
+  loader.request(a);
+  loader.request(b);
+  loader.end_frame();
+  loader.cancel(b);
+  check(!loader.is_pending(c), "Requests not renewed during a frame are dropped");
+  check(!loader.is_pending(b), "Cancelled request is dropped");
+  check(loader.get_cancelled_count() == 2, "Dropped requests are counted");
+
+  loader.start();
+  std::vector<ThumbnailResult> results = wait_for_results(loader, 1);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  ThumbnailResult extra;
+  check(results.size() == 1 && results[0].path == a && !loader.poll(extra), "Only the live request is decoded");
+  check(loader.get_decoded_count() == 1, "Dropped requests cost no decode");
+
+  // A result that completes after its path was cancelled is discarded
+  loader.begin_frame();
+  loader.request(b);
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (loader.get_decoded_count() < 2 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  loader.cancel(b);
+  ThumbnailResult result;
+  check(!loader.poll(result), "Result of a cancelled request is discarded");
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Thumbnail Loader Test\n";
+  std::cout << std::string(80, '-') << '\n';
+
+  test_decode();
+  test_cancellation();
+  std::remove("test_thumbnail_a.ppm");
+  std::remove("test_thumbnail_b.ppm");
+  std::remove("test_thumbnail_c.ppm");
+  std::remove("test_thumbnail_empty.ppm");
+  std::filesystem::remove(std::filesystem::u8path(ACCENTED_NAME));
+
+  std::cout << '\n' << (g_failures == 0 ? "All checks passed" : "Some checks failed") << '\n';
+  return g_failures == 0 ? 0 : 1;
+}
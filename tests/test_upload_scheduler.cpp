@@ -0,0 +1,164 @@
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/upload_scheduler.h"
+#include "test_support.h"
+
+const char SEPARATOR = static_cast<char>(std::filesystem::path::preferred_separator);
+
+// Records what it is asked to upload instead of talking to a GPU
+class FakeBackend : public UploadBackend {
+ public:
+  std::vector<std::string> uploaded;
+  std::chrono::milliseconds delay{0};  // Time each upload takes
+
+  uint64_t upload(ThumbnailResult& result) override {
+    if (delay.count() > 0) {
+      std::this_thread::sleep_for(delay);
+    }
+    uploaded.push_back(result.path);
+    return result.pixels.size();
+  }
+};
+
+ThumbnailResult make_result(const std::string& path, size_t bytes = 16) {
+  ThumbnailResult result;
+  result.path = path;
+  result.pixels.assign(bytes, 0);
+  result.width = 2;
+  result.height = static_cast<int>(bytes / 8);
+  return result;
+}
+
+// A budget that never stops a frame
+UploadBudget make_unlimited_budget() {
+  UploadBudget budget;
+  budget.max_bytes = UINT64_MAX;
+  budget.max_time = std::chrono::seconds(60);
+  return budget;
+}
+
+void test_priority_order() {
+  std::cout << "\n=== Priority order ===\n";
+  UploadScheduler scheduler;
+  scheduler.set_budget(make_unlimited_budget());
+  for (const char* path : {"a.png", "b.png", "c.png", "d.png", "e.png"}) {
+    scheduler.push(make_result(path));
+  }
+  check(scheduler.mark("d.png", 0) && scheduler.mark("b.png", 2) && scheduler.mark("e.png", 0),
+        "Queued decodes can be marked");
+  check(scheduler.mark("b.png", 1), "Marking again keeps the smaller priority");
+  check(!scheduler.mark("z.png", 0), "Marking an unknown path fails");
+
+  FakeBackend backend;
+  check(scheduler.run(backend) == 5, "An unlimited budget uploads everything");
+  std::vector<std::string> expected = {"d.png", "e.png", "b.png", "a.png", "c.png"};
+  check(backend.uploaded == expected, "Visible tiles go first, then prefetched ones, then the rest by arrival");
+  check(!scheduler.has_queued() && !scheduler.is_queued("a.png"), "Uploaded decodes leave the queue");
+}
+
+void test_byte_budget() {
+  std::cout << "\n=== Byte budget ===\n";
+  UploadScheduler scheduler;
+  UploadBudget budget = make_unlimited_budget();
+  budget.max_bytes = 100;
+  scheduler.set_budget(budget);
+  for (int i = 0; i < 5; i++) {
+    scheduler.push(make_result("tile_" + std::to_string(i) + ".png", 40));
+  }
+
+  FakeBackend backend;
+  check(scheduler.run(backend) == 3, "A frame stops once its bytes reach the budget");
+  check(scheduler.run(backend) == 2 && backend.uploaded.size() == 5, "The rest goes in the next frame");
+  check(scheduler.get_stats().budget_frames == 1, "Frames stopped by the budget are counted");
+
+  scheduler.push(make_result("huge.png", 1000));
+  check(scheduler.run(backend) == 1, "A decode larger than the budget still goes through");
+  check(scheduler.get_stats().bytes == 1200, "Uploaded bytes are counted");
+}
+
+void test_time_budget() {
+  std::cout << "\n=== Time budget ===\n";
+  UploadScheduler scheduler;
+  UploadBudget budget = make_unlimited_budget();
+  budget.max_time = std::chrono::milliseconds(1);
+  scheduler.set_budget(budget);
+  for (int i = 0; i < 3; i++) {
+    scheduler.push(make_result("slow_" + std::to_string(i) + ".png"));
+  }
+
+  FakeBackend backend;
+  backend.delay = std::chrono::milliseconds(5);
+  check(scheduler.run(backend) == 1, "A frame stops once its time is spent");
+  check(scheduler.get_stats().queued == 2, "The rest stays queued");
+}
+
+void test_marks_reset() {
+  std::cout << "\n=== Marks last one frame ===\n";
+  UploadScheduler scheduler;
+  UploadBudget budget = make_unlimited_budget();
+  budget.max_bytes = 1;
+  scheduler.set_budget(budget);
+  for (const char* path : {"a.png", "b.png", "c.png"}) {
+    scheduler.push(make_result(path));
+  }
+  scheduler.mark("c.png", 0);
+  scheduler.mark("b.png", 0);
+
+  FakeBackend backend;
+  scheduler.run(backend);
+  scheduler.run(backend);
+  check(backend.uploaded == std::vector<std::string>({"b.png", "a.png"}),
+        "Marks not renewed after a run() no longer count");
+}
+
+void test_push_and_remove() {
+  std::cout << "\n=== Replacing and removing ===\n";
+  UploadScheduler scheduler;
+  scheduler.set_budget(make_unlimited_budget());
+  scheduler.push(make_result("a.png", 16));
+  scheduler.push(make_result("b.png", 16));
+  scheduler.push(make_result("a.png", 32));
+  check(scheduler.get_stats().queued == 2, "Pushing a path again replaces its decode");
+
+  FakeBackend backend;
+  scheduler.run(backend);
+  check(backend.uploaded == std::vector<std::string>({"b.png", "a.png"}) && scheduler.get_stats().bytes == 48,
+        "The newer decode is uploaded, in its own arrival order");
+
+  std::string directory = std::string("textures") + SEPARATOR + "rocks";
+  scheduler.push(make_result(directory + SEPARATOR + "granite.png"));
+  scheduler.push(make_result(directory + SEPARATOR + "basalt.png"));
+  scheduler.push(make_result(directory + "_old.png"));
+  scheduler.push(make_result("c.png"));
+  scheduler.remove("c.png");
+  scheduler.remove("missing.png");
+  scheduler.remove_under(directory);
+  check(scheduler.get_stats().queued == 1 && scheduler.is_queued(directory + "_old.png"),
+        "Removing a directory only drops decodes below it");
+  check(scheduler.get_stats().dropped == 3, "Dropped decodes are counted");
+}
+
+int main() {
+  std::cout << '\n';
+  std::cout << "Asset Inventory Upload Scheduler Test\n";
+  std::cout << std::string(50, '-') << '\n';
+
+  test_priority_order();
+  test_byte_budget();
+  test_time_budget();
+  test_marks_reset();
+  test_push_and_remove();
+
+  std::cout << '\n';
+  if (g_failures == 0) {
+    std::cout << "All checks passed\n";
+    return 0;
+  }
+  std::cout << g_failures << " check(s) failed\n";
+  return 1;
+}